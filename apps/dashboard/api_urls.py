@@ -4,8 +4,9 @@ File: apps/dashboard/api_urls.py
 """
 
 from django.urls import path
-from apps.dashboard.api_views import DashboardStatsView
+from apps.dashboard.api_views import DashboardStatsView, DashboardPerformanceView
 
 urlpatterns = [
     path('stats/', DashboardStatsView.as_view(), name='api-dashboard-stats'),
+    path('performance/', DashboardPerformanceView.as_view(), name='api-dashboard-performance'),
 ]
\ No newline at end of file
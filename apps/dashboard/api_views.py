@@ -8,12 +8,13 @@ REST API endpoints for dashboard statistics and data.
 from rest_framework.views import APIView
 from rest_framework.response import Response
 from rest_framework.permissions import AllowAny
+from rest_framework import status
 from django.utils import timezone
 from datetime import timedelta
 
 from apps.device_management.models import Device
 from apps.data_processing.models import DeviceMessage
-from apps.dashboard.serializers import DashboardStatsSerializer
+from apps.dashboard.serializers import DashboardStatsSerializer, DashboardPerformanceSerializer
 
 
 class DashboardStatsView(APIView):
@@ -72,4 +73,81 @@ class DashboardStatsView(APIView):
 
         # Serialize and return
         serializer = DashboardStatsSerializer(stats)
-        return Response(serializer.data)
\ No newline at end of file
+        return Response(serializer.data)
+
+
+class DashboardPerformanceView(APIView):
+    """
+    GET /api/v1/dashboard/performance/?hours=24
+
+    Returns fleet-wide timing of device operations (signing, HTTP, sensor...)
+    from the profiling counters in heartbeats received in the last `hours`
+    (default 24, max 720). No authentication required (public data).
+
+    Per operation: number of devices reporting it, total samples, the
+    sample-weighted average, the overall min/max and worst_window_p99_us -
+    the highest p99 any single heartbeat window reported. Windows hold only
+    a few samples, so that is close to the worst sample rather than a fleet
+    p99 (heartbeats carry no histograms to merge).
+    """
+    permission_classes = [AllowAny]  # Public endpoint
+
+    DEFAULT_HOURS = 24
+    MAX_HOURS = 720
+
+    def get(self, request):
+        """Aggregate heartbeat performance counters."""
+        try:
+            hours = int(request.query_params.get('hours', self.DEFAULT_HOURS))
+        except ValueError:
+            hours = 0
+        if not 1 <= hours <= self.MAX_HOURS:
+            return Response(
+                {'error': f'hours must be between 1 and {self.MAX_HOURS}'},
+                status=status.HTTP_400_BAD_REQUEST
+            )
+
+        since = timezone.now() - timedelta(hours=hours)
+        heartbeats = DeviceMessage.objects.filter(
+            message_type='heartbeat',
+            recieved_at__gte=since,
+            performance__isnull=False
+        ).values_list('device_id', 'performance')
+
+        totals = {}
+        heartbeat_count = 0
+        for device_id, performance in heartbeats.iterator():
+            heartbeat_count += 1
+            for operation, counters in performance.items():
+                count = counters.get('count', 0)
+                if count <= 0:
+                    continue
+                entry = totals.setdefault(operation, {
+                    'devices': set(), 'samples': 0, 'total_us': 0,
+                    'min_us': counters['min_us'], 'max_us': 0, 'worst_window_p99_us': 0,
+                })
+                entry['devices'].add(device_id)
+                entry['samples'] += count
+                entry['total_us'] += counters['avg_us'] * count
+                entry['min_us'] = min(entry['min_us'], counters['min_us'])
+                entry['max_us'] = max(entry['max_us'], counters['max_us'])
+                entry['worst_window_p99_us'] = max(entry['worst_window_p99_us'], counters['p99_us'])
+
+        operations = {
+            operation: {
+                'devices': len(entry['devices']),
+                'samples': entry['samples'],
+                'avg_us': entry['total_us'] // entry['samples'],
+                'min_us': entry['min_us'],
+                'max_us': entry['max_us'],
+                'worst_window_p99_us': entry['worst_window_p99_us'],
+            }
+            for operation, entry in totals.items()
+        }
+
+        serializer = DashboardPerformanceSerializer({
+            'hours': hours,
+            'heartbeats': heartbeat_count,
+            'operations': operations,
+        })
+        return Response(serializer.data)
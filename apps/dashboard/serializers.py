@@ -61,4 +61,40 @@ class DashboardStatsSerializer(serializers.Serializer):
         child=serializers.DictField(),
         required=False,
         help_text="Message count for last 7 days"
-    )
\ No newline at end of file
+    )
+
+
+class DashboardPerformanceSerializer(serializers.Serializer):
+    """
+    Serializer for fleet-wide device performance.
+
+    Aggregates the profiling counters that devices send in heartbeats
+    (DeviceMessage.performance) over a time window. worst_window_p99_us is
+    the highest p99 of a single heartbeat window, not a fleet percentile.
+
+    Used by:
+    - GET /api/v1/dashboard/performance/
+
+    Example output:
+    {
+        "hours": 24,
+        "heartbeats": 1440,
+        "operations": {
+            "ecdsa_sign": {
+                "devices": 12,
+                "samples": 2880,
+                "avg_us": 9400,
+                "min_us": 8900,
+                "max_us": 412000,
+                "worst_window_p99_us": 11264
+            },
+            ...
+        }
+    }
+    """
+    hours = serializers.IntegerField()
+    heartbeats = serializers.IntegerField()
+    operations = serializers.DictField(
+        child=serializers.DictField(child=serializers.IntegerField()),
+        help_text="Aggregated counters per profiled operation (microseconds)"
+    )
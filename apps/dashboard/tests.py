@@ -136,4 +136,44 @@ class DashboardViewTest(TestCase):
         self.assertEqual(response.status_code, 200)
         self.assertEqual(response.context['messages'].count(), 0)
         
-        print("Test dashboard filter by date PASSED")
\ No newline at end of file
+        print("Test dashboard filter by date PASSED")
+
+
+class DashboardPerformanceAPITest(TestCase):
+    """Test suite for the fleet performance API"""
+
+    def setUp(self):
+        """Create two devices with profiled heartbeats"""
+        self.client = Client()
+        self.url = '/api/v1/dashboard/performance/'
+
+        user = User.objects.create_user(username='perfadmin', password='testpass')
+        for name, counters in [
+            ('Perf Device 1', {'count': 1, 'min_us': 9000, 'avg_us': 9000, 'max_us': 9000, 'p99_us': 9000}),
+            ('Perf Device 2', {'count': 3, 'min_us': 8000, 'avg_us': 10000, 'max_us': 12000, 'p99_us': 12000}),
+        ]:
+            device = Device.objects.create(name=name, status=DeviceStatus.ACTIVE, created_by=user)
+            DeviceMessage.objects.create(
+                device=device,
+                message_type='heartbeat',
+                timestamp=datetime(2024, 12, 13, 10, 0, 0, tzinfo=pytz.UTC),
+                data={'status': 'online'},
+                performance={'ecdsa_sign': counters},
+            )
+
+    def test_performance_aggregated_across_devices(self):
+        """Test that counters are combined with a sample-weighted average"""
+        response = self.client.get(self.url)
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(response.json()['heartbeats'], 2)
+        self.assertEqual(response.json()['operations']['ecdsa_sign'], {
+            'devices': 2, 'samples': 4, 'avg_us': 9750,
+            'min_us': 8000, 'max_us': 12000, 'worst_window_p99_us': 12000,
+        })
+
+        # Window out of range
+        self.assertEqual(self.client.get(self.url, {'hours': '0'}).status_code, 400)
+
+        print("Test performance aggregated across devices PASSED.")
+
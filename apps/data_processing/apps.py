@@ -5,4 +5,6 @@ class DataProcessingConfig(AppConfig):
     default_auto_field = "django.db.models.BigAutoField"
     name = "apps.data_processing"
 
-    
\ No newline at end of file
+    def ready(self):
+        # Connects the Device signals that invalidate the certificate cache
+        from . import certificate_cache  # noqa: F401
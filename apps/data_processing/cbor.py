@@ -0,0 +1,384 @@
+"""
+Minimal CBOR (RFC 8949) support for the compact device wire format.
+
+Devices can send messages as CBOR instead of JSON
+(Content-Type: application/cbor). The payload is a tagged map with
+integer keys, epoch-second timestamps and fixed-point numbers, which
+decode_device_payload() converts back into the same dictionary shape as
+the JSON format, so the rest of DeviceMessageView is format independent.
+
+Schema (tag DEVICE_MESSAGE_CBOR_TAG, version 1):
+    0: schema version        3: timestamp (epoch seconds)
+    1: device_id (text)      4: data (map, keys depend on message type)
+    2: message_type (0 = heartbeat, 1 = alert)
+
+    Data (both types): 0 time_synced (only sent as false, while the
+                       device clock is not yet synchronized)
+    Heartbeat data: 1 status (1 = online), 2 uptime, 3 wifi_rssi,
+                    4 free_memory, 5 power_mode (optional, see POWER_MODES),
+                    6 estimated_energy_mwh_per_hour (optional, modelled
+                      from idle time, not measured),
+                    7 performance (optional, map of PROFILE_POINTS index to
+                      [count, min, avg, max, p99] in microseconds),
+                    8 memory (optional, [min free heap, largest free block,
+                      fragmentation %, min free stack] - same array as JSON),
+                    9 firmware_version (optional, text)
+    Alert data:     1 event (1 = ultrasonic_detection),
+                    2 sensor_type (1 = HC-SR04), 3 detected distance (mm),
+                    4 detection_duration_seconds,
+                    5 first_detected_at (epoch seconds), 6 confidence (%),
+                    7 per-sensor distances (optional, array of mm with
+                      0 = no echo, sent by nodes with several sensors),
+                    8 detection_state (see DETECTION_STATES), 9 closest
+                      distance (mm)
+                    A detection is reported as a session: "opened" sends
+                    1-6, "update" only 3-4 and "closed" 4, 5 and 9.
+                    Without key 8 the alert is a full (opened) alert.
+
+A batch is a CBOR array of tagged messages.
+"""
+import struct
+from datetime import datetime, timezone as dt_timezone
+
+
+CBOR_CONTENT_TYPE = 'application/cbor'
+
+# Must match CBOR_SCHEMA_TAG / CBOR_SCHEMA_VERSION in the device firmware (cbor.h)
+DEVICE_MESSAGE_CBOR_TAG = 50133
+DEVICE_MESSAGE_SCHEMA_VERSION = 1
+
+MAX_NESTING_DEPTH = 8
+
+MESSAGE_TYPES = {0: 'heartbeat', 1: 'alert'}
+HEARTBEAT_STATUSES = {0: 'offline', 1: 'online'}
+POWER_MODES = {0: 'active', 1: 'modem_sleep', 2: 'light_sleep'}
+ALERT_EVENTS = {1: 'ultrasonic_detection'}
+SENSOR_TYPES = {1: 'HC-SR04'}
+# Must match enum DetectionEvent in the device firmware (hardware.h)
+DETECTION_STATES = {1: 'opened', 2: 'update', 3: 'closed'}
+
+# Must match enum ProfilePoint in the device firmware (profiling.h)
+PROFILE_POINTS = (
+    'measure_distance', 'create_payload', 'sha256', 'ecdsa_sign',
+    'der_base64', 'http_connect', 'http_round_trip',
+)
+
+
+class CBORDecodeError(ValueError):
+    """Raised when a body is not valid CBOR or does not match the device schema."""
+
+
+class CBORTag:
+    """Tagged CBOR value (major type 6)."""
+
+    def __init__(self, tag, value):
+        self.tag = tag
+        self.value = value
+
+    def __eq__(self, other):
+        return isinstance(other, CBORTag) and (self.tag, self.value) == (other.tag, other.value)
+
+    def __repr__(self):
+        return f'CBORTag({self.tag}, {self.value!r})'
+
+
+# =============================================================================
+# Generic decoder / encoder
+# =============================================================================
+
+class _Decoder:
+    def __init__(self, data):
+        self.data = data
+        self.position = 0
+
+    def read(self, length):
+        if self.position + length > len(self.data):
+            raise CBORDecodeError('Unexpected end of CBOR data')
+        chunk = self.data[self.position:self.position + length]
+        self.position += length
+        return chunk
+
+    def read_argument(self, info):
+        if info < 24:
+            return info
+        if info == 24:
+            return self.read(1)[0]
+        if info == 25:
+            return struct.unpack('>H', self.read(2))[0]
+        if info == 26:
+            return struct.unpack('>I', self.read(4))[0]
+        if info == 27:
+            return struct.unpack('>Q', self.read(8))[0]
+        raise CBORDecodeError('Indefinite-length and reserved items are not supported')
+
+    def decode_item(self, depth=0):
+        if depth > MAX_NESTING_DEPTH:
+            raise CBORDecodeError('CBOR nesting too deep')
+
+        initial = self.read(1)[0]
+        major, info = initial >> 5, initial & 0x1F
+
+        if major == 7:
+            return self.decode_simple(info)
+
+        argument = self.read_argument(info)
+
+        if major == 0:
+            return argument
+        if major == 1:
+            return -1 - argument
+        if major == 2:
+            return bytes(self.read(argument))
+        if major == 3:
+            try:
+                return self.read(argument).decode('utf-8')
+            except UnicodeDecodeError:
+                raise CBORDecodeError('Invalid UTF-8 in CBOR text string')
+        if major == 4:
+            return [self.decode_item(depth + 1) for _ in range(argument)]
+        if major == 5:
+            result = {}
+            for _ in range(argument):
+                key = self.decode_item(depth + 1)
+                if isinstance(key, (list, dict, CBORTag)):
+                    raise CBORDecodeError('Unsupported CBOR map key type')
+                result[key] = self.decode_item(depth + 1)
+            return result
+        return CBORTag(argument, self.decode_item(depth + 1))
+
+    def decode_simple(self, info):
+        if info == 20:
+            return False
+        if info == 21:
+            return True
+        if info in (22, 23):
+            return None
+        if info == 25:
+            return struct.unpack('>e', self.read(2))[0]
+        if info == 26:
+            return struct.unpack('>f', self.read(4))[0]
+        if info == 27:
+            return struct.unpack('>d', self.read(8))[0]
+        raise CBORDecodeError('Unsupported CBOR simple value')
+
+
+def loads(data):
+    """
+    Decode a single CBOR data item.
+
+    Args:
+        data: CBOR bytes
+
+    Returns:
+        Decoded value (int, bytes, str, list, dict, bool, None, float or CBORTag)
+
+    Raises:
+        CBORDecodeError: If the data is malformed or has trailing bytes
+    """
+    decoder = _Decoder(bytes(data))
+    value = decoder.decode_item()
+    if decoder.position != len(decoder.data):
+        raise CBORDecodeError('Trailing bytes after CBOR data item')
+    return value
+
+
+def _encode_head(major, argument):
+    if argument < 24:
+        return bytes([(major << 5) | argument])
+    if argument < 0x100:
+        return bytes([(major << 5) | 24, argument])
+    if argument < 0x10000:
+        return bytes([(major << 5) | 25]) + struct.pack('>H', argument)
+    if argument < 0x100000000:
+        return bytes([(major << 5) | 26]) + struct.pack('>I', argument)
+    return bytes([(major << 5) | 27]) + struct.pack('>Q', argument)
+
+
+def dumps(value):
+    """
+    Encode a value as CBOR (ints, str, bytes, list, dict, bool, None, float, CBORTag).
+
+    Used by tests and tools to produce device-format payloads.
+    """
+    if value is False:
+        return b'\xf4'
+    if value is True:
+        return b'\xf5'
+    if value is None:
+        return b'\xf6'
+    if isinstance(value, int):
+        return _encode_head(0, value) if value >= 0 else _encode_head(1, -1 - value)
+    if isinstance(value, float):
+        return b'\xfb' + struct.pack('>d', value)
+    if isinstance(value, bytes):
+        return _encode_head(2, len(value)) + value
+    if isinstance(value, str):
+        encoded = value.encode('utf-8')
+        return _encode_head(3, len(encoded)) + encoded
+    if isinstance(value, (list, tuple)):
+        return _encode_head(4, len(value)) + b''.join(dumps(item) for item in value)
+    if isinstance(value, dict):
+        return _encode_head(5, len(value)) + b''.join(dumps(k) + dumps(v) for k, v in value.items())
+    if isinstance(value, CBORTag):
+        return _encode_head(6, value.tag) + dumps(value.value)
+    raise TypeError(f'Cannot encode {type(value).__name__} as CBOR')
+
+
+# =============================================================================
+# Device message schema
+# =============================================================================
+
+def _epoch_to_iso(seconds):
+    try:
+        return datetime.fromtimestamp(seconds, tz=dt_timezone.utc).strftime('%Y-%m-%dT%H:%M:%SZ')
+    except (OverflowError, OSError, ValueError):
+        raise CBORDecodeError(f'Invalid epoch timestamp: {seconds}')
+
+
+def _require_int(data, key, name):
+    value = data.get(key)
+    if not isinstance(value, int) or isinstance(value, bool):
+        raise CBORDecodeError(f'Missing or invalid field: {name}')
+    return value
+
+
+def _decode_heartbeat_data(data):
+    decoded = {
+        'status': HEARTBEAT_STATUSES.get(data.get(1), 'unknown'),
+        'uptime': _require_int(data, 2, 'uptime'),
+        'wifi_rssi': _require_int(data, 3, 'wifi_rssi'),
+        'free_memory': _require_int(data, 4, 'free_memory'),
+    }
+    # Power fields were added later - older firmware omits them
+    if 5 in data:
+        decoded['power_mode'] = POWER_MODES.get(data[5], 'unknown')
+    if 6 in data:
+        decoded['estimated_energy_mwh_per_hour'] = _require_int(data, 6, 'estimated_energy_mwh_per_hour')
+    if 7 in data:
+        decoded['performance'] = _decode_performance(data[7])
+    if 8 in data:
+        decoded['memory'] = _decode_memory(data[8])
+    if 9 in data:
+        if not isinstance(data[9], str):
+            raise CBORDecodeError('Invalid field: firmware_version')
+        decoded['firmware_version'] = data[9]
+    return decoded
+
+
+def _decode_memory(memory):
+    if (not isinstance(memory, list) or len(memory) != 4
+            or not all(isinstance(v, int) and not isinstance(v, bool) for v in memory)):
+        raise CBORDecodeError('Invalid field: memory')
+    return memory
+
+
+def _decode_performance(performance):
+    if not isinstance(performance, dict):
+        raise CBORDecodeError('Invalid field: performance')
+
+    decoded = {}
+    for point, values in performance.items():
+        if not isinstance(point, int) or not 0 <= point < len(PROFILE_POINTS):
+            raise CBORDecodeError(f'Unknown profile point: {point}')
+        if (not isinstance(values, list) or len(values) != 5
+                or not all(isinstance(v, int) and not isinstance(v, bool) for v in values)):
+            raise CBORDecodeError(f'Invalid counters for {PROFILE_POINTS[point]}')
+        decoded[PROFILE_POINTS[point]] = values
+    return decoded
+
+
+def _decode_alert_data(data):
+    state = DETECTION_STATES.get(data.get(8, 1))
+    if state is None:
+        raise CBORDecodeError(f'Unknown detection state: {data.get(8)}')
+
+    if state == 'update':
+        # Delta - the context was sent with the opened alert
+        decoded = {
+            'detection_state': state,
+            'detected_distance_cm': _require_int(data, 3, 'detected_distance_mm') / 10.0,
+            'detection_duration_seconds': _require_int(data, 4, 'detection_duration_seconds'),
+        }
+    elif state == 'closed':
+        return {
+            'detection_state': state,
+            'closest_distance_cm': _require_int(data, 9, 'closest_distance_mm') / 10.0,
+            'detection_duration_seconds': _require_int(data, 4, 'detection_duration_seconds'),
+            'first_detected_at': _epoch_to_iso(_require_int(data, 5, 'first_detected_at')),
+        }
+    else:
+        decoded = {
+            'event': ALERT_EVENTS.get(data.get(1), 'unknown'),
+            'sensor_type': SENSOR_TYPES.get(data.get(2), 'unknown'),
+            'detected_distance_cm': _require_int(data, 3, 'detected_distance_mm') / 10.0,
+            'detection_duration_seconds': _require_int(data, 4, 'detection_duration_seconds'),
+            'first_detected_at': _epoch_to_iso(_require_int(data, 5, 'first_detected_at')),
+            'confidence': _require_int(data, 6, 'confidence') / 100.0,
+        }
+        if 8 in data:
+            decoded['detection_state'] = state
+
+    # Multi-sensor nodes only - same shape as the JSON sensor_readings_cm array
+    if 7 in data:
+        decoded['sensor_readings_cm'] = _decode_sensor_readings(data[7])
+    return decoded
+
+
+def _decode_sensor_readings(readings):
+    if (not isinstance(readings, list)
+            or not all(isinstance(r, int) and not isinstance(r, bool) and r >= 0 for r in readings)):
+        raise CBORDecodeError('Invalid field: sensor_readings_mm')
+    return [r / 10.0 if r > 0 else None for r in readings]
+
+
+def _decode_message(item):
+    if not isinstance(item, CBORTag) or item.tag != DEVICE_MESSAGE_CBOR_TAG:
+        raise CBORDecodeError('Missing device message schema tag')
+
+    fields = item.value
+    if not isinstance(fields, dict):
+        raise CBORDecodeError('Device message must be a CBOR map')
+    if fields.get(0) != DEVICE_MESSAGE_SCHEMA_VERSION:
+        raise CBORDecodeError(f'Unsupported schema version: {fields.get(0)}')
+
+    message_type = MESSAGE_TYPES.get(fields.get(2))
+    if message_type is None:
+        raise CBORDecodeError(f'Unknown message type: {fields.get(2)}')
+
+    data = fields.get(4, {})
+    if not isinstance(data, dict):
+        raise CBORDecodeError('Message data must be a CBOR map')
+
+    if message_type == 'heartbeat':
+        decoded_data = _decode_heartbeat_data(data)
+    else:
+        decoded_data = _decode_alert_data(data)
+
+    if data.get(0) is False:
+        decoded_data['time_synced'] = False
+
+    return {
+        'device_id': fields.get(1),
+        'message_type': message_type,
+        'timestamp': _epoch_to_iso(_require_int(fields, 3, 'timestamp')),
+        'data': decoded_data,
+    }
+
+
+def decode_device_payload(body):
+    """
+    Decode a CBOR request body into the JSON message format.
+
+    Args:
+        body: Raw request body bytes
+
+    Returns:
+        dict for a single message, or list of dicts for a batch
+
+    Raises:
+        CBORDecodeError: If the body is not a valid device message (or batch)
+    """
+    value = loads(body)
+    if isinstance(value, list):
+        return [_decode_message(item) for item in value]
+    return _decode_message(value)
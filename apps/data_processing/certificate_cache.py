@@ -0,0 +1,165 @@
+"""
+Process-local caches for device certificate authentication.
+
+DeviceMessageView verifies a device certificate against the CA on first
+contact. Without caching, every certificate-authenticated message re-reads
+the CA certificate from disk, re-parses and re-verifies the device
+certificate and looks the device up in the database.
+
+- The CA certificate is loaded once per process (get_ca_certificate()).
+- Verified certificates are kept in an LRU cache keyed by the SHA-256
+  fingerprint of the certificate header, together with the device status.
+
+Only the certificate check is cached: the body signature is still verified
+on every message. Entries are dropped whenever the device is saved or
+deleted (e.g. revoked by remove_device or the API), in the process that
+made the change. Other worker processes pick the change up after at most
+DEVICE_CERT_CACHE_TTL seconds.
+"""
+import hashlib
+import threading
+import time
+from collections import OrderedDict
+
+from cryptography import x509
+from django.conf import settings
+from django.db.models.signals import post_delete, post_save
+from django.dispatch import receiver
+
+from apps.device_management.models import Device
+
+
+_ca_certificate = None
+_ca_certificate_lock = threading.Lock()
+
+
+def get_ca_certificate():
+    """
+    Load the CA certificate from settings.CA_CERTIFICATE_PATH (once per process).
+
+    Returns:
+        x509.Certificate: CA certificate
+
+    Raises:
+        Exception: If the file cannot be read or parsed (retried on the next call)
+
+    A replaced CA certificate is picked up after a restart.
+    """
+    global _ca_certificate
+
+    if _ca_certificate is None:
+        with _ca_certificate_lock:
+            if _ca_certificate is None:
+                with open(settings.CA_CERTIFICATE_PATH, 'rb') as f:
+                    _ca_certificate = x509.load_pem_x509_certificate(f.read())
+    return _ca_certificate
+
+
+def certificate_fingerprint(cert_pem):
+    """
+    Cache key for a device certificate.
+
+    Args:
+        cert_pem: PEM bytes as sent in the X-Device-Certificate header
+
+    Returns:
+        str: Hex SHA-256 of the PEM bytes
+    """
+    return hashlib.sha256(cert_pem).hexdigest()
+
+
+class CertificateCache:
+    """
+    Thread-safe LRU cache of verified device certificates.
+
+    Entries are auth dicts as built by DeviceMessageView (device_id,
+    public_key, certificate_serial, certificate_not_before,
+    certificate_not_after) plus the device_status read from the database.
+    Size and lifetime come from DEVICE_CERT_CACHE_SIZE and
+    DEVICE_CERT_CACHE_TTL; a size of 0 disables the cache.
+    """
+
+    def __init__(self):
+        self._entries = OrderedDict()  # fingerprint -> (stored_at, entry)
+        self._lock = threading.Lock()
+
+    def get(self, fingerprint):
+        """
+        Look up a verified certificate.
+
+        Args:
+            fingerprint: Key from certificate_fingerprint()
+
+        Returns:
+            dict: Cached entry, or None if missing or older than the TTL
+        """
+        with self._lock:
+            cached = self._entries.get(fingerprint)
+            if cached is None:
+                return None
+
+            stored_at, entry = cached
+            if time.monotonic() - stored_at > settings.DEVICE_CERT_CACHE_TTL:
+                del self._entries[fingerprint]
+                return None
+
+            self._entries.move_to_end(fingerprint)
+            return entry
+
+    def put(self, fingerprint, entry):
+        """
+        Store a verified certificate, evicting the least recently used ones.
+
+        Args:
+            fingerprint: Key from certificate_fingerprint()
+            entry: Auth dict including device_status
+        """
+        max_size = settings.DEVICE_CERT_CACHE_SIZE
+        if max_size <= 0:
+            return
+
+        with self._lock:
+            self._entries[fingerprint] = (time.monotonic(), entry)
+            self._entries.move_to_end(fingerprint)
+            while len(self._entries) > max_size:
+                self._entries.popitem(last=False)
+
+    def invalidate_device(self, device_id):
+        """
+        Drop every cached certificate of a device.
+
+        Args:
+            device_id: Device UUID (or its string form)
+        """
+        device_id = str(device_id)
+        with self._lock:
+            stale = [
+                fingerprint for fingerprint, (_, entry) in self._entries.items()
+                if str(entry['device_id']) == device_id
+            ]
+            for fingerprint in stale:
+                del self._entries[fingerprint]
+
+    def clear(self):
+        with self._lock:
+            self._entries.clear()
+
+    def __len__(self):
+        with self._lock:
+            return len(self._entries)
+
+
+certificate_cache = CertificateCache()
+
+
+@receiver(post_save, sender=Device)
+@receiver(post_delete, sender=Device)
+def invalidate_device_certificates(sender, instance, **kwargs):
+    """
+    Drop cached certificates when a device changes.
+
+    Covers revocation (status set to REVOKED by remove_device or the API),
+    activation and certificate regeneration. QuerySet.update() does not send
+    signals - call certificate_cache.invalidate_device() after using it.
+    """
+    certificate_cache.invalidate_device(instance.id)
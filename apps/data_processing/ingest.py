@@ -0,0 +1,212 @@
+"""
+Buffered storage of verified device messages.
+
+DeviceMessageView hands every accepted message to store_messages() instead
+of creating DeviceMessage rows one by one:
+
+- Messages are written with bulk_create (one INSERT per batch).
+- Device.last_seen is updated with one UPDATE per flush for all devices in it
+  (to the receive time of each device's newest message).
+
+By default the request's messages are flushed before the response is sent,
+so a 200 means the messages are in the database. With
+DEVICE_INGEST_WRITE_BEHIND = True the request only inserts them into the
+QueuedDeviceMessage staging table (one INSERT into an unindexed table) and
+the device is acknowledged once that has committed. A background thread
+moves staged rows to DeviceMessage every DEVICE_INGEST_FLUSH_MESSAGES
+messages or DEVICE_INGEST_FLUSH_INTERVAL_MS milliseconds, so the indexed
+inserts and the last_seen updates are off the request path during bursts.
+
+Staged rows are durable: rows left behind by a worker that stopped are moved
+by the next flush of any worker, or by "python manage.py
+flush_device_messages" (e.g. after switching write-behind off).
+"""
+import atexit
+import threading
+
+from django.conf import settings
+from django.db import close_old_connections, connection, transaction
+from django.db.models import Case, DateTimeField, Value, When
+
+from apps.device_management.models import Device
+from .models import DeviceMessage, QueuedDeviceMessage
+
+
+def write_messages(messages):
+    """
+    Store messages and update the last_seen time of their devices.
+
+    last_seen is the recieved_at of the device's newest message - for staged
+    messages the time they were queued, so rows moved long after a worker
+    stopped do not make their devices look recently seen.
+
+    Args:
+        messages: List of unsaved DeviceMessage instances
+
+    Returns:
+        int: Number of messages stored
+    """
+    if not messages:
+        return 0
+
+    try:
+        with transaction.atomic():
+            DeviceMessage.objects.bulk_create(messages)
+        saved_count = len(messages)
+    except Exception as e:
+        # One bad row fails the whole INSERT - store the others individually
+        print(f'error: Bulk insert of {len(messages)} messages failed: {str(e)}')
+        saved_count = 0
+        for message in messages:
+            try:
+                # Savepoint - also called inside the flush transaction
+                with transaction.atomic():
+                    message.pk = None
+                    message.save()
+                saved_count += 1
+            except Exception as e:
+                print(f'error: Failed to store message: {str(e)}')
+
+    last_seen = {}
+    for message in messages:
+        if message.device_id not in last_seen or message.recieved_at > last_seen[message.device_id]:
+            last_seen[message.device_id] = message.recieved_at
+
+    # QuerySet.update() sends no post_save, so the certificate cache is kept
+    Device.objects.filter(id__in=last_seen).update(last_seen=Case(
+        *[When(id=device_id, then=Value(seen)) for device_id, seen in last_seen.items()],
+        output_field=DateTimeField(),
+    ))
+    return saved_count
+
+
+def flush_queued_messages():
+    """
+    Move every staged message to DeviceMessage.
+
+    Each batch of up to DEVICE_INGEST_FLUSH_MESSAGES rows is written and
+    removed from the staging table in one transaction, so a message is never
+    lost between the two. Concurrent flushes in other workers skip locked
+    rows where the database supports it (PostgreSQL); on SQLite the database
+    lock serializes them.
+
+    Returns:
+        int: Number of messages stored
+    """
+    batch_size = max(1, settings.DEVICE_INGEST_FLUSH_MESSAGES)
+    saved_count = 0
+
+    while True:
+        with transaction.atomic():
+            staged = QueuedDeviceMessage.objects.order_by('id')
+            if connection.features.has_select_for_update_skip_locked:
+                staged = staged.select_for_update(skip_locked=True)
+            staged = list(staged[:batch_size])
+            if not staged:
+                break
+
+            # Devices deleted since the message was accepted: foreign keys are only
+            # checked at commit (PostgreSQL), which would fail the batch every time
+            known_devices = set(Device.objects.filter(
+                id__in={row.device_id for row in staged}
+            ).values_list('id', flat=True))
+            messages = [row.to_message() for row in staged if row.device_id in known_devices]
+            if len(messages) < len(staged):
+                print(f'error: Dropped {len(staged) - len(messages)} queued messages of deleted devices')
+
+            saved_count += write_messages(messages)
+            QueuedDeviceMessage.objects.filter(id__in=[row.id for row in staged]).delete()
+
+        if len(staged) < batch_size:
+            break
+
+    return saved_count
+
+
+class IngestBuffer:
+    """
+    Write-behind queue: the QueuedDeviceMessage table, flushed by a background thread.
+
+    The thread starts with the first submitted message. Staged messages are
+    also flushed when the process exits normally.
+    """
+
+    def __init__(self):
+        self._submitted = 0  # Messages staged by this process since its last flush
+        self._condition = threading.Condition()
+        self._thread = None
+
+    def submit(self, messages):
+        """
+        Stage messages for the next flush.
+
+        Args:
+            messages: List of unsaved DeviceMessage instances
+
+        Raises:
+            DatabaseError: If the messages could not be staged (nothing was staged)
+        """
+        QueuedDeviceMessage.objects.bulk_create(
+            [QueuedDeviceMessage.from_message(message) for message in messages]
+        )
+
+        with self._condition:
+            self._submitted += len(messages)
+            if self._thread is None:
+                self._thread = threading.Thread(target=self._run, name='device-ingest', daemon=True)
+                self._thread.start()
+                atexit.register(self.flush)
+            if self._submitted >= settings.DEVICE_INGEST_FLUSH_MESSAGES:
+                self._condition.notify()
+
+    def flush(self):
+        """
+        Write all staged messages now (including those of other processes).
+
+        Returns:
+            int: Number of messages stored
+        """
+        with self._condition:
+            self._submitted = 0
+        return flush_queued_messages()
+
+    def __len__(self):
+        return QueuedDeviceMessage.objects.count()
+
+    def _run(self):
+        interval = settings.DEVICE_INGEST_FLUSH_INTERVAL_MS / 1000.0
+        while True:
+            with self._condition:
+                if self._submitted < settings.DEVICE_INGEST_FLUSH_MESSAGES:
+                    self._condition.wait(timeout=interval)
+                if self._submitted == 0:
+                    continue  # Nothing staged here - no query while idle
+            try:
+                close_old_connections()
+                self.flush()
+            except Exception as e:
+                print(f'error: Message flush failed: {str(e)}')
+
+
+ingest_buffer = IngestBuffer()
+
+
+def store_messages(messages):
+    """
+    Store the messages of one request.
+
+    Args:
+        messages: List of unsaved DeviceMessage instances
+
+    Returns:
+        int: Number of messages stored - with DEVICE_INGEST_WRITE_BEHIND the
+        number staged for the next flush (all or none)
+    """
+    if settings.DEVICE_INGEST_WRITE_BEHIND:
+        try:
+            ingest_buffer.submit(messages)
+        except Exception as e:
+            print(f'error: Failed to queue {len(messages)} messages: {str(e)}')
+            return 0
+        return len(messages)
+    return write_messages(messages)
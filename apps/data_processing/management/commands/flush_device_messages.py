@@ -0,0 +1,15 @@
+from django.core.management.base import BaseCommand
+from apps.data_processing.ingest import flush_queued_messages
+from apps.data_processing.models import QueuedDeviceMessage
+
+
+class Command(BaseCommand):
+    help = (
+        'Write device messages staged by DEVICE_INGEST_WRITE_BEHIND to the database '
+        '(workers do this in the background - use after switching write-behind off)'
+    )
+
+    def handle(self, *args, **options):
+        staged = QueuedDeviceMessage.objects.count()
+        saved = flush_queued_messages()
+        self.stdout.write(self.style.SUCCESS(f'Stored {saved} of {staged} queued messages'))
@@ -0,0 +1,69 @@
+from django.conf import settings
+from django.core.management.base import BaseCommand, CommandError
+from django.db import close_old_connections
+from apps.data_processing.mqtt_ingest import MQTTMessageHandler
+
+
+class Command(BaseCommand):
+    help = (
+        'Subscribe to the MQTT broker and store device messages published by '
+        'TRANSPORT_MQTT firmware (same verification as /api/device/message/)'
+    )
+
+    def add_arguments(self, parser):
+        parser.add_argument('--host', default=settings.MQTT_BROKER_HOST, help='MQTT broker host')
+        parser.add_argument('--port', type=int, default=settings.MQTT_BROKER_PORT, help='MQTT broker port')
+        parser.add_argument('--topic-prefix', default=settings.MQTT_TOPIC_PREFIX, help='Device topic prefix')
+        parser.add_argument(
+            '--client-id',
+            default='c3ds-backend',
+            help='MQTT client ID - the broker queues QoS 1 messages for it while the subscriber is down',
+        )
+
+    def handle(self, *args, **options):
+        try:
+            import paho.mqtt.client as mqtt
+        except ImportError:
+            raise CommandError('paho-mqtt is not installed (pip install -r requirements/base.txt)')
+
+        handler = MQTTMessageHandler(options['topic_prefix'])
+
+        def on_connect(client, userdata, flags, reason_code, properties):
+            if reason_code.is_failure:
+                self.stderr.write(f'Broker refused connection: {reason_code}')
+                return
+            for topic in handler.subscriptions():
+                client.subscribe(topic, qos=1)
+            self.stdout.write(self.style.SUCCESS(f'Subscribed to {", ".join(handler.subscriptions())}'))
+
+        def on_message(client, userdata, message):
+            # Long-running process: drop connections the database has closed
+            close_old_connections()
+            try:
+                response = handler.handle(message.topic, message.payload)
+            except Exception as e:
+                self.stderr.write(f'error: Failed to process {message.topic}: {str(e)}')
+                return
+
+            if response is not None and response.status_code != 200:
+                self.stderr.write(f'{message.topic}: {response.status_code} {response.data.get("error", "")}')
+
+        # Persistent session: QoS 1 messages published while we are down are delivered on reconnect
+        client = mqtt.Client(
+            mqtt.CallbackAPIVersion.VERSION2,
+            client_id=options['client_id'],
+            clean_session=False,
+        )
+        client.on_connect = on_connect
+        client.on_message = on_message
+
+        self.stdout.write(f'Connecting to {options["host"]}:{options["port"]}...')
+        try:
+            client.connect(options['host'], options['port'], keepalive=60)
+        except OSError as e:
+            raise CommandError(f'Cannot connect to MQTT broker: {str(e)}')
+
+        try:
+            client.loop_forever()
+        except KeyboardInterrupt:
+            client.disconnect()
@@ -0,0 +1,17 @@
+# Generated by Django 4.2.7 on 2026-10-14 09:00
+
+from django.db import migrations, models
+
+
+class Migration(migrations.Migration):
+    dependencies = [
+        ("data_processing", "0001_initial"),
+    ]
+
+    operations = [
+        migrations.AddField(
+            model_name="devicemessage",
+            name="performance",
+            field=models.JSONField(blank=True, null=True),
+        ),
+    ]
@@ -0,0 +1,24 @@
+# Generated by Django 4.2.7 on 2026-10-15 09:00
+
+from django.core.management import call_command
+from django.db import migrations
+
+
+def create_cache_table(apps, schema_editor):
+    """
+    Create the table of the database cache (settings.CACHES), which holds the
+    device sessions shared by all worker processes. Does nothing for other
+    cache backends or if the table already exists.
+    """
+    call_command('createcachetable', database=schema_editor.connection.alias, verbosity=0)
+
+
+class Migration(migrations.Migration):
+    dependencies = [
+        ("data_processing", "0002_devicemessage_performance"),
+    ]
+
+    operations = [
+        # The table is left in place on reverse - it only holds cached data
+        migrations.RunPython(create_cache_table, migrations.RunPython.noop),
+    ]
@@ -0,0 +1,41 @@
+# Generated by Django 4.2.7 on 2026-10-15 10:00
+
+from django.db import migrations, models
+
+
+class Migration(migrations.Migration):
+    dependencies = [
+        ("data_processing", "0003_create_cache_table"),
+    ]
+
+    operations = [
+        migrations.CreateModel(
+            name="QueuedDeviceMessage",
+            fields=[
+                (
+                    "id",
+                    models.BigAutoField(
+                        auto_created=True,
+                        primary_key=True,
+                        serialize=False,
+                        verbose_name="ID",
+                    ),
+                ),
+                ("device_id", models.UUIDField()),
+                ("message_type", models.CharField(max_length=50)),
+                ("timestamp", models.DateTimeField()),
+                ("data", models.JSONField(default=dict)),
+                ("performance", models.JSONField(blank=True, null=True)),
+                ("ip_address", models.GenericIPAddressField(blank=True, null=True)),
+                (
+                    "certificate_serial",
+                    models.CharField(blank=True, max_length=40, null=True),
+                ),
+                ("queued_at", models.DateTimeField(auto_now_add=True)),
+            ],
+            options={
+                "verbose_name": "Queued Device Message",
+                "verbose_name_plural": "Queued Device Messages",
+            },
+        ),
+    ]
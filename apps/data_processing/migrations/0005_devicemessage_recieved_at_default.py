@@ -0,0 +1,18 @@
+# Generated by Django 4.2.7 on 2026-10-15 12:00
+
+from django.db import migrations, models
+import django.utils.timezone
+
+
+class Migration(migrations.Migration):
+    dependencies = [
+        ("data_processing", "0004_queueddevicemessage"),
+    ]
+
+    operations = [
+        migrations.AlterField(
+            model_name="devicemessage",
+            name="recieved_at",
+            field=models.DateTimeField(default=django.utils.timezone.now, editable=False),
+        ),
+    ]
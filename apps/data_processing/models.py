@@ -1,4 +1,5 @@
 from django.db import models
+from django.utils import timezone
 from apps.device_management.models import Device
 
 # Create your models here.
@@ -19,8 +20,13 @@ class DeviceMessage(models.Model):
     timestamp = models.DateTimeField(db_index=True)
     data = models.JSONField(default=dict)
 
+    # Heartbeat profiling counters per operation, e.g.
+    # {"ecdsa_sign": {"count": 2, "min_us": ..., "avg_us": ..., "max_us": ..., "p99_us": ...}}
+    performance = models.JSONField(null=True, blank=True)
+
     # Logging trail
-    recieved_at = models.DateTimeField(auto_now_add=True)
+    # Set in code rather than auto_now_add, so write-behind can keep the time the message was queued
+    recieved_at = models.DateTimeField(default=timezone.now, editable=False)
     ip_address = models.GenericIPAddressField(null=True, blank=True)
     certificate_serial = models.CharField(max_length=40, null=True, blank=True)
 
@@ -31,3 +37,43 @@ class DeviceMessage(models.Model):
 
     def __str__(self):
         return f"Message from {self.device.name} - {self.message_type} at {self.timestamp}"
+
+
+class QueuedDeviceMessage(models.Model):
+    """
+    Accepted device message waiting to be written as a DeviceMessage.
+
+    Only used with DEVICE_INGEST_WRITE_BEHIND (see ingest.py): the request
+    inserts its messages here before the device gets its response, so an
+    acknowledged message survives a worker restart. Rows are moved to
+    DeviceMessage and deleted by the next flush.
+    """
+    # Plain column instead of a foreign key - no index or FK check on the request path
+    device_id = models.UUIDField()
+    message_type = models.CharField(max_length=50)
+    timestamp = models.DateTimeField()
+    data = models.JSONField(default=dict)
+    performance = models.JSONField(null=True, blank=True)
+    ip_address = models.GenericIPAddressField(null=True, blank=True)
+    certificate_serial = models.CharField(max_length=40, null=True, blank=True)
+    queued_at = models.DateTimeField(auto_now_add=True)
+
+    class Meta:
+        verbose_name = 'Queued Device Message'
+        verbose_name_plural = 'Queued Device Messages'
+
+    # Fields copied to and from DeviceMessage
+    MESSAGE_FIELDS = ('device_id', 'message_type', 'timestamp', 'data', 'performance',
+                      'ip_address', 'certificate_serial')
+
+    @classmethod
+    def from_message(cls, message):
+        return cls(**{field: getattr(message, field) for field in cls.MESSAGE_FIELDS})
+
+    def to_message(self):
+        # Received when it was queued, not when it was flushed
+        return DeviceMessage(recieved_at=self.queued_at,
+                             **{field: getattr(self, field) for field in self.MESSAGE_FIELDS})
+
+    def __str__(self):
+        return f"Queued {self.message_type} from {self.device_id} at {self.timestamp}"
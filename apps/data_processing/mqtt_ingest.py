@@ -0,0 +1,180 @@
+"""
+Device messages received over MQTT (devices built with TRANSPORT_MQTT).
+
+Topics (see mqtt.h in the firmware):
+    <MQTT_TOPIC_PREFIX>/<device_id>/certificate
+        Base64 PEM certificate (the X-Device-Certificate header value),
+        retained and re-published by the device on every connection
+    <MQTT_TOPIC_PREFIX>/<device_id>/messages/json (or .../messages/cbor)
+        b"<base64 signature>\\n<body>" - body is exactly what the device
+        would POST to /api/device/message/ (one message or a batch array)
+
+Each message goes through the same certificate check, signature
+verification and storage as DeviceMessageView. No session is issued:
+the certificate is sent once per MQTT connection anyway.
+"""
+import base64
+
+from django.core.exceptions import ValidationError
+from rest_framework import status
+from rest_framework.response import Response
+
+from apps.device_management.models import Device
+from .cbor import CBOR_CONTENT_TYPE
+from .views import DeviceMessageView
+
+MQTT_CERTIFICATE_TOPIC = 'certificate'
+MQTT_MESSAGE_TOPIC = 'messages'
+MQTT_CONTENT_TYPES = {
+    'json': 'application/json',
+    'cbor': CBOR_CONTENT_TYPE,
+}
+
+
+class MQTTMessageHandler:
+    """
+    Feed MQTT publishes from devices into DeviceMessageView.process_message().
+
+    Keeps the latest certificate published by each device. Anyone on the
+    broker can publish to a device's certificate topic, so a certificate is
+    only kept if it passes the CA check and names the topic device. A device
+    whose certificate was not seen (e.g. the retained message was cleared) is
+    checked against the certificate stored on its Device record.
+    """
+
+    def __init__(self, topic_prefix):
+        self.topic_prefix = topic_prefix.rstrip('/') + '/'
+        self.view = DeviceMessageView()
+        self.certificates = {}  # device_id -> base64 PEM certificate
+
+    def subscriptions(self):
+        """
+        Topic filters to subscribe to.
+
+        Returns:
+            list: MQTT topic filters
+        """
+        return [
+            f'{self.topic_prefix}+/{MQTT_CERTIFICATE_TOPIC}',
+            f'{self.topic_prefix}+/{MQTT_MESSAGE_TOPIC}/+',
+        ]
+
+    def handle(self, topic, payload):
+        """
+        Process one MQTT publish.
+
+        Args:
+            topic: Topic the message was published to
+            payload: Message payload bytes
+
+        Returns:
+            Response: Result for a device message, or None for a certificate
+            or a topic that is not ours
+        """
+        if not topic.startswith(self.topic_prefix):
+            return None
+
+        parts = topic[len(self.topic_prefix):].split('/')
+        device_id = parts[0]
+
+        if parts[1:] == [MQTT_CERTIFICATE_TOPIC]:
+            # A rejected certificate keeps the previous one in place
+            try:
+                certificate = payload.decode('ascii')
+            except UnicodeDecodeError:
+                return None
+            auth, error_response = self._verify_certificate(device_id, certificate)
+            if error_response is None:
+                self.certificates[device_id] = certificate
+            return None
+
+        if len(parts) != 3 or parts[1] != MQTT_MESSAGE_TOPIC or parts[2] not in MQTT_CONTENT_TYPES:
+            return None
+
+        return self._handle_device_message(device_id, MQTT_CONTENT_TYPES[parts[2]], payload)
+
+    def _verify_certificate(self, device_id, cert_header):
+        """
+        Check a certificate against the CA and the topic device.
+
+        Args:
+            device_id: Device ID from the topic
+            cert_header: Base64 PEM certificate
+
+        Returns:
+            tuple: (auth dict, None) on success or (None, error Response)
+        """
+        auth, error_response = self.view._authenticate_certificate(cert_header)
+        if error_response is not None:
+            return None, error_response
+
+        # Anyone can publish a device's (public) certificate - the topic must match it
+        if str(auth['device_id']) != device_id:
+            return None, Response(
+                {'error': 'Certificate does not belong to the topic device'},
+                status=status.HTTP_403_FORBIDDEN
+            )
+
+        return auth, None
+
+    def _stored_certificate(self, device_id):
+        """
+        Certificate stored on the device record.
+
+        Args:
+            device_id: Device ID from the topic
+
+        Returns:
+            str: Base64 PEM certificate, or None if there is none
+        """
+        try:
+            cert_pem = Device.objects.filter(id=device_id).values_list('certificate_pem', flat=True).first()
+        except (ValueError, ValidationError):
+            return None
+        if not cert_pem:
+            return None
+
+        return base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8')
+
+    def _authenticate_device(self, device_id):
+        """
+        Authenticate a device's messages with its published certificate,
+        falling back to the stored one if that no longer verifies (e.g. it
+        expired since it was published).
+
+        Args:
+            device_id: Device ID from the topic
+
+        Returns:
+            tuple: (auth dict, None) on success or (None, error Response)
+        """
+        certificate = self.certificates.get(device_id)
+        if certificate:
+            auth, error_response = self._verify_certificate(device_id, certificate)
+            if error_response is None:
+                return auth, None
+            del self.certificates[device_id]
+
+        certificate = self._stored_certificate(device_id)
+        if certificate is None:
+            return None, Response({'error': 'No certificate published for device'}, status=status.HTTP_401_UNAUTHORIZED)
+
+        auth, error_response = self._verify_certificate(device_id, certificate)
+        if error_response is None:
+            self.certificates[device_id] = certificate
+        return auth, error_response
+
+    def _handle_device_message(self, device_id, content_type, payload):
+        try:
+            signature_b64, message_body = payload.split(b'\n', 1)
+            signature = base64.b64decode(signature_b64, validate=True)
+        except ValueError as e:
+            return Response({'error': f'Invalid MQTT payload: {str(e)}'}, status=status.HTTP_400_BAD_REQUEST)
+
+        auth, error_response = self._authenticate_device(device_id)
+        if error_response is not None:
+            return error_response
+
+        return self.view.process_message(
+            auth, signature, message_body, content_type, client_ip=None, issue_session=False
+        )
@@ -80,10 +80,15 @@ class DeviceMessageDetailSerializer(serializers.ModelSerializer):
             "temperature": 22.5,
             "location": {"lat": 54.687, "lng": 25.279}
         },
+        "performance": null,
         "recieved_at": "2024-01-14T10:30:05Z",
         "certificate_serial": "1a2b3c4d5e6f"
     }
 
+    performance holds the heartbeat profiling counters (null for other
+    messages), e.g. {"ecdsa_sign": {"count": 2, "min_us": 9100, "avg_us": 9400,
+    "max_us": 9700, "p99_us": 9700}}.
+
     Security note: ip_address field is intentionally excluded from serialization
     to prevent leaking device location/network information to frontend clients.
     IP addresses are still logged in the database for audit purposes.
@@ -101,6 +106,7 @@ class DeviceMessageDetailSerializer(serializers.ModelSerializer):
             'message_type',
             'timestamp',
             'data',
+            'performance',
             'recieved_at',
             'certificate_serial',
         ]
\ No newline at end of file
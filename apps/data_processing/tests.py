@@ -2,6 +2,7 @@ from django.test import TestCase, Client
 from django.contrib.auth.models import User
 from apps.device_management.models import Device, DeviceStatus
 from apps.data_processing.models import DeviceMessage
+from apps.data_processing.certificate_cache import certificate_cache
 from cryptography import x509
 from cryptography.hazmat.primitives import hashes, serialization
 from cryptography.hazmat.primitives.asymmetric import padding, ec
@@ -62,6 +63,9 @@ class DeviceMessageAPITest(TestCase):
         self.user = User.objects.create_user(username='testadmin', password='testpass')
         self.device = Device.objects.create(name='Test API Device', created_by=self.user)
 
+        # Verified certificates are cached per process - start every test empty
+        certificate_cache.clear()
+
     def test_successful_message_submission(self):
         """Test that a valid certificate and signature results in saved message"""
         from apps.device_management.utils import generate_device_certificate
@@ -116,6 +120,7 @@ class DeviceMessageAPITest(TestCase):
         # Check response
         self.assertEqual(response.status_code, 200)
         self.assertTrue(response.json()['saved'])
+        self.assertFalse(response.json()['queued'])
         
         # Verify message was saved
         self.assertEqual(DeviceMessage.objects.count(), 1)
@@ -222,4 +227,811 @@ class DeviceMessageAPITest(TestCase):
         # Verify message was NOT saved
         self.assertEqual(DeviceMessage.objects.count(), 0)
         
-        print("Test invalid signature rejected PASSED")
\ No newline at end of file
+        print("Test invalid signature rejected PASSED")
+
+    def test_batched_messages_submission(self):
+        """Test that a JSON array signed once is stored as individual messages"""
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+
+        # Generate certificate
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        # Create batch (array of messages) and sign it once
+        batch = [
+            {'message_type': 'alert', 'timestamp': '2024-12-13T10:30:00Z', 'data': {'detected_distance_cm': 12.5}},
+            {'message_type': 'alert', 'timestamp': '2024-12-13T10:30:10Z', 'data': {'detected_distance_cm': 11.0}},
+            {'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:30:20Z', 'data': {'status': 'online'}},
+        ]
+        message_body = json.dumps(batch).encode('utf-8')
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        signature = sign_message_with_key(private_key, message_body, self.device.certificate_algorithm)
+
+        # Send request
+        cert_header = base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8')
+        signature_header = base64.b64encode(signature).decode('utf-8')
+
+        response = self.client.post(
+            self.url,
+            data=message_body,
+            content_type='application/json',
+            HTTP_X_DEVICE_CERTIFICATE=cert_header,
+            HTTP_X_DEVICE_SIGNATURE=signature_header
+        )
+
+        # Check response
+        self.assertEqual(response.status_code, 200)
+        self.assertTrue(response.json()['saved'])
+        self.assertEqual(response.json()['message_count'], 3)
+        self.assertEqual(response.json()['saved_count'], 3)
+
+        # Verify every message in the batch was saved
+        self.assertEqual(DeviceMessage.objects.filter(message_type='alert').count(), 2)
+        self.assertEqual(DeviceMessage.objects.filter(message_type='heartbeat').count(), 1)
+
+        # One last_seen update for the whole batch
+        self.device.refresh_from_db()
+        self.assertIsNotNone(self.device.last_seen)
+
+        print("Test batched messages submission PASSED.")
+
+    def test_oversized_batch_rejected(self):
+        """Test that batches larger than DEVICE_MESSAGE_MAX_BATCH_SIZE are rejected"""
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+        from django.test import override_settings
+
+        # Generate certificate
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        # Create and sign batch
+        batch = [{'message_type': 'test', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}] * 3
+        message_body = json.dumps(batch).encode('utf-8')
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        signature = sign_message_with_key(private_key, message_body, self.device.certificate_algorithm)
+
+        # Send request
+        cert_header = base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8')
+        signature_header = base64.b64encode(signature).decode('utf-8')
+
+        with override_settings(DEVICE_MESSAGE_MAX_BATCH_SIZE=2):
+            response = self.client.post(
+                self.url,
+                data=message_body,
+                content_type='application/json',
+                HTTP_X_DEVICE_CERTIFICATE=cert_header,
+                HTTP_X_DEVICE_SIGNATURE=signature_header
+            )
+
+        # Should be rejected with 400 and nothing saved
+        self.assertEqual(response.status_code, 400)
+        self.assertEqual(DeviceMessage.objects.count(), 0)
+
+        print("Test oversized batch rejected PASSED.")
+
+    def test_session_replaces_certificate(self):
+        """Test that the session ID from the first response authenticates later messages"""
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+
+        # Generate certificate
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        # First contact: full certificate
+        first_body = json.dumps({'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}).encode('utf-8')
+        first_signature = sign_message_with_key(private_key, first_body, self.device.certificate_algorithm)
+
+        response = self.client.post(
+            self.url,
+            data=first_body,
+            content_type='application/json',
+            HTTP_X_DEVICE_CERTIFICATE=base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8'),
+            HTTP_X_DEVICE_SIGNATURE=base64.b64encode(first_signature).decode('utf-8')
+        )
+
+        self.assertEqual(response.status_code, 200)
+        session_id = response.json()['session_id']
+        self.assertTrue(session_id)
+
+        # Later message: session ID only, no certificate
+        second_body = json.dumps({'message_type': 'alert', 'timestamp': '2024-12-13T10:30:20Z', 'data': {}}).encode('utf-8')
+        second_signature = sign_message_with_key(private_key, second_body, self.device.certificate_algorithm)
+
+        response = self.client.post(
+            self.url,
+            data=second_body,
+            content_type='application/json',
+            HTTP_X_DEVICE_SESSION=session_id,
+            HTTP_X_DEVICE_SIGNATURE=base64.b64encode(second_signature).decode('utf-8')
+        )
+
+        self.assertEqual(response.status_code, 200)
+        self.assertTrue(response.json()['saved'])
+        self.assertEqual(response.json()['session_id'], session_id)
+        self.assertEqual(DeviceMessage.objects.count(), 2)
+
+        print("Test session replaces certificate PASSED.")
+
+    def test_unknown_session_rejected(self):
+        """Test that an unknown session ID returns 401 so the device re-sends its certificate"""
+        message_body = json.dumps({'message_type': 'test', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}})
+
+        response = self.client.post(
+            self.url,
+            data=message_body,
+            content_type='application/json',
+            HTTP_X_DEVICE_SESSION='not-a-real-session',
+            HTTP_X_DEVICE_SIGNATURE=base64.b64encode(b'signature').decode('utf-8')
+        )
+
+        self.assertEqual(response.status_code, 401)
+        self.assertTrue(response.json()['session_expired'])
+        self.assertEqual(DeviceMessage.objects.count(), 0)
+
+        print("Test unknown session rejected PASSED.")
+
+    def test_cbor_message_submission(self):
+        """Test that a signed CBOR payload is decoded and stored like JSON"""
+        from apps.device_management.utils import generate_device_certificate
+        from apps.data_processing.cbor import CBORTag, DEVICE_MESSAGE_CBOR_TAG, dumps
+        from cryptography.hazmat.backends import default_backend
+
+        # Generate certificate
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        # Alert in compact encoding: integer keys, epoch seconds, distance in mm
+        message_body = dumps(CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1,
+            1: str(self.device.id),
+            2: 1,
+            3: 1734085800,
+            4: {1: 1, 2: 1, 3: 125, 4: 12, 5: 1734085788, 6: 100},
+        }))
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        signature = sign_message_with_key(private_key, message_body, self.device.certificate_algorithm)
+
+        # Send request
+        cert_header = base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8')
+        signature_header = base64.b64encode(signature).decode('utf-8')
+
+        response = self.client.post(
+            self.url,
+            data=message_body,
+            content_type='application/cbor',
+            HTTP_X_DEVICE_CERTIFICATE=cert_header,
+            HTTP_X_DEVICE_SIGNATURE=signature_header
+        )
+
+        # Check response
+        self.assertEqual(response.status_code, 200)
+        self.assertTrue(response.json()['saved'])
+
+        # Verify message was decoded into the JSON field layout
+        saved_message = DeviceMessage.objects.get()
+        self.assertEqual(saved_message.message_type, 'alert')
+        self.assertEqual(saved_message.timestamp.isoformat(), '2024-12-13T10:30:00+00:00')
+        self.assertEqual(saved_message.data['detected_distance_cm'], 12.5)
+        self.assertEqual(saved_message.data['detection_duration_seconds'], 12)
+        self.assertEqual(saved_message.data['first_detected_at'], '2024-12-13T10:29:48Z')
+        self.assertEqual(saved_message.data['sensor_type'], 'HC-SR04')
+
+        print("Test CBOR message submission PASSED.")
+
+    def _post_with_certificate(self, cert_pem, private_key, message_type='heartbeat'):
+        """Send one message authenticated with the full certificate"""
+        body = json.dumps({'message_type': message_type, 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}).encode('utf-8')
+        signature = sign_message_with_key(private_key, body, self.device.certificate_algorithm)
+
+        return self.client.post(
+            self.url,
+            data=body,
+            content_type='application/json',
+            HTTP_X_DEVICE_CERTIFICATE=base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8'),
+            HTTP_X_DEVICE_SIGNATURE=base64.b64encode(signature).decode('utf-8')
+        )
+
+    def test_certificate_cache_skips_verification(self):
+        """Test that a repeated certificate is not parsed again but its body signature is still checked"""
+        from unittest import mock
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        # First message verifies the certificate and caches it
+        response = self._post_with_certificate(cert_pem, private_key)
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(len(certificate_cache), 1)
+
+        # Second message: no certificate parsing, no device lookup
+        with mock.patch.object(x509, 'load_pem_x509_certificate', wraps=x509.load_pem_x509_certificate) as load_pem, \
+                mock.patch.object(Device.objects, 'only', wraps=Device.objects.only) as device_lookup:
+            response = self._post_with_certificate(cert_pem, private_key, message_type='alert')
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(load_pem.call_count, 0)
+        self.assertEqual(device_lookup.call_count, 0)
+        self.assertEqual(DeviceMessage.objects.count(), 2)
+
+        # A bad body signature is still rejected for a cached certificate
+        body = json.dumps({'message_type': 'test', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}).encode('utf-8')
+        response = self.client.post(
+            self.url,
+            data=body,
+            content_type='application/json',
+            HTTP_X_DEVICE_CERTIFICATE=base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8'),
+            HTTP_X_DEVICE_SIGNATURE=base64.b64encode(b'not a signature').decode('utf-8')
+        )
+        self.assertEqual(response.status_code, 401)
+
+        print("Test certificate cache skips verification PASSED.")
+
+    def test_revocation_invalidates_certificate_cache(self):
+        """Test that revoking a device takes effect while its certificate is cached"""
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        response = self._post_with_certificate(cert_pem, private_key)
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(len(certificate_cache), 1)
+
+        # Revoke the same way remove_device and the API do
+        self.device.status = DeviceStatus.REVOKED
+        self.device.save()
+        self.assertEqual(len(certificate_cache), 0)
+
+        response = self._post_with_certificate(cert_pem, private_key)
+        self.assertEqual(response.status_code, 403)
+        self.assertEqual(DeviceMessage.objects.count(), 1)
+
+        print("Test revocation invalidates certificate cache PASSED.")
+
+    def test_write_behind_queues_messages(self):
+        """Test that write-behind acknowledges on enqueue and stores the messages on flush"""
+        from django.test import override_settings
+        from datetime import timedelta
+        from django.utils import timezone
+        from apps.data_processing.ingest import IngestBuffer, ingest_buffer
+        from apps.data_processing.models import QueuedDeviceMessage
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        # Thresholds the background thread cannot reach during the test
+        with override_settings(DEVICE_INGEST_WRITE_BEHIND=True,
+                               DEVICE_INGEST_FLUSH_MESSAGES=1000,
+                               DEVICE_INGEST_FLUSH_INTERVAL_MS=600000):
+            for message_type in ('heartbeat', 'alert'):
+                response = self._post_with_certificate(cert_pem, private_key, message_type=message_type)
+                self.assertEqual(response.status_code, 200)
+                # Staged until flushed - not reported as saved
+                self.assertFalse(response.json()['saved'])
+                self.assertTrue(response.json()['queued'])
+
+            self.assertEqual(DeviceMessage.objects.count(), 0)
+            self.assertEqual(len(ingest_buffer), 2)
+
+            # Left behind by a stopped worker and moved much later
+            queued_at = timezone.now() - timedelta(hours=2)
+            QueuedDeviceMessage.objects.update(queued_at=queued_at)
+
+            # Staged in the database: a restarted worker (new buffer) still writes them
+            self.assertEqual(IngestBuffer().flush(), 2)
+
+        self.assertEqual(len(ingest_buffer), 0)
+        self.assertEqual(QueuedDeviceMessage.objects.count(), 0)
+        self.assertEqual(DeviceMessage.objects.filter(device=self.device).count(), 2)
+        # Receive time and last_seen come from the queue time, not the flush time
+        self.assertEqual(DeviceMessage.objects.filter(device=self.device, recieved_at=queued_at).count(), 2)
+        self.device.refresh_from_db()
+        self.assertEqual(self.device.last_seen, queued_at)
+
+        print("Test write-behind queues messages PASSED.")
+
+    def test_write_behind_failure_not_acknowledged(self):
+        """Test that messages which could not be staged are answered with 503 so the device retries"""
+        from unittest import mock
+        from django.db import DatabaseError
+        from django.test import override_settings
+        from apps.data_processing.models import QueuedDeviceMessage
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.status = DeviceStatus.ACTIVE
+        self.device.save()
+
+        private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+
+        with override_settings(DEVICE_INGEST_WRITE_BEHIND=True), \
+                mock.patch.object(QueuedDeviceMessage.objects, 'bulk_create', side_effect=DatabaseError('disk full')):
+            response = self._post_with_certificate(cert_pem, private_key, message_type='alert')
+
+        self.assertEqual(response.status_code, 503)
+        self.assertFalse(response.json()['queued'])
+        self.assertEqual(QueuedDeviceMessage.objects.count(), 0)
+
+        print("Test write-behind failure not acknowledged PASSED.")
+
+
+class MQTTMessageHandlerTest(TestCase):
+    """Test suite for device messages received over MQTT"""
+
+    @classmethod
+    def setUpTestData(cls):
+        """Set up CA for all tests"""
+        from django.core.management import call_command
+        from django.conf import settings
+        import os
+
+        if not os.path.exists(settings.CA_CERTIFICATE_PATH):
+            call_command('create_ca')
+
+    def setUp(self):
+        """Create an active device with a certificate"""
+        from apps.data_processing.mqtt_ingest import MQTTMessageHandler
+        from apps.device_management.utils import generate_device_certificate
+        from cryptography.hazmat.backends import default_backend
+
+        certificate_cache.clear()
+        self.user = User.objects.create_user(username='testadmin', password='testpass')
+        self.device = Device.objects.create(name='Test MQTT Device', created_by=self.user, status=DeviceStatus.ACTIVE)
+
+        cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(self.device)
+        self.device.certificate_pem = cert_pem
+        self.device.certificate_serial = serial_hex
+        self.device.certificate_expiry = expiry_date
+        self.device.save()
+
+        self.cert_b64 = base64.b64encode(cert_pem.encode('utf-8'))
+        self.private_key = serialization.load_pem_private_key(
+            key_pem.encode('utf-8'),
+            password=None,
+            backend=default_backend()
+        )
+        self.handler = MQTTMessageHandler('c3ds/devices')
+        self.topic = f'c3ds/devices/{self.device.id}'
+
+    def _signed_payload(self, body):
+        signature = sign_message_with_key(self.private_key, body, self.device.certificate_algorithm)
+        return base64.b64encode(signature) + b'\n' + body
+
+    def test_published_message_stored(self):
+        """Test that a message published after the certificate is verified and stored"""
+        self.assertIsNone(self.handler.handle(f'{self.topic}/certificate', self.cert_b64))
+
+        batch = [
+            {'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:30:00Z', 'data': {'status': 'online'}},
+            {'message_type': 'alert', 'timestamp': '2024-12-13T10:30:10Z', 'data': {'detected_distance_cm': 11.0}},
+        ]
+        payload = self._signed_payload(json.dumps(batch).encode('utf-8'))
+
+        response = self.handler.handle(f'{self.topic}/messages/json', payload)
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(response.data['saved_count'], 2)
+        self.assertIsNone(response.data['session_id'])
+        self.assertEqual(DeviceMessage.objects.filter(device=self.device).count(), 2)
+        self.assertIsNone(DeviceMessage.objects.first().ip_address)
+
+        print("Test published message stored PASSED.")
+
+    def test_stored_certificate_used_without_publish(self):
+        """Test that the device record's certificate is used if none was published"""
+        body = json.dumps({'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}).encode('utf-8')
+
+        response = self.handler.handle(f'{self.topic}/messages/json', self._signed_payload(body))
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(DeviceMessage.objects.count(), 1)
+
+        print("Test stored certificate used without publish PASSED.")
+
+    def test_invalid_mqtt_messages_rejected(self):
+        """Test that bad signatures, payloads and topics are not stored"""
+        self.handler.handle(f'{self.topic}/certificate', self.cert_b64)
+        body = json.dumps({'message_type': 'alert', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}).encode('utf-8')
+
+        # Signature of a different body
+        payload = self._signed_payload(b'{}').split(b'\n', 1)[0] + b'\n' + body
+        self.assertEqual(self.handler.handle(f'{self.topic}/messages/json', payload).status_code, 401)
+
+        # No signature line
+        self.assertEqual(self.handler.handle(f'{self.topic}/messages/json', body).status_code, 400)
+
+        # Certificate of this device published under another device's topic (not kept)
+        other = Device.objects.create(name='Other MQTT Device', created_by=self.user, status=DeviceStatus.ACTIVE)
+        self.handler.handle(f'c3ds/devices/{other.id}/certificate', self.cert_b64)
+        self.assertNotIn(str(other.id), self.handler.certificates)
+        response = self.handler.handle(f'c3ds/devices/{other.id}/messages/json', self._signed_payload(body))
+        self.assertEqual(response.status_code, 401)
+
+        # Topics outside the device schema are ignored
+        self.assertIsNone(self.handler.handle('other/topic', self._signed_payload(body)))
+        self.assertIsNone(self.handler.handle(f'{self.topic}/messages/xml', self._signed_payload(body)))
+
+        self.assertEqual(DeviceMessage.objects.count(), 0)
+
+        print("Test invalid MQTT messages rejected PASSED.")
+
+    def test_foreign_certificate_does_not_silence_device(self):
+        """Test that another device's certificate published to this device's topic is ignored"""
+        from apps.device_management.utils import generate_device_certificate
+
+        self.handler.handle(f'{self.topic}/certificate', self.cert_b64)
+
+        other = Device.objects.create(name='Other MQTT Device', created_by=self.user, status=DeviceStatus.ACTIVE)
+        other_cert_pem, _, _, _ = generate_device_certificate(other)
+        self.handler.handle(f'{self.topic}/certificate', base64.b64encode(other_cert_pem.encode('utf-8')))
+        self.handler.handle(f'{self.topic}/certificate', b'not a certificate')
+
+        body = json.dumps({'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}).encode('utf-8')
+        response = self.handler.handle(f'{self.topic}/messages/json', self._signed_payload(body))
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(DeviceMessage.objects.filter(device=self.device).count(), 1)
+
+        print("Test foreign certificate does not silence device PASSED.")
+
+    def test_failing_cached_certificate_falls_back_to_stored(self):
+        """Test that a cached certificate that no longer verifies is replaced by the stored one"""
+        self.handler.certificates[str(self.device.id)] = 'bm90IGEgY2VydGlmaWNhdGU='
+
+        body = json.dumps({'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:30:00Z', 'data': {}}).encode('utf-8')
+        response = self.handler.handle(f'{self.topic}/messages/json', self._signed_payload(body))
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(self.handler.certificates[str(self.device.id)], self.cert_b64.decode('ascii'))
+
+        print("Test failing cached certificate falls back to stored PASSED.")
+
+    def test_heartbeat_records_firmware_version(self):
+        """Test that the version of the last signed heartbeat is stored on the device"""
+        batch = [
+            {'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:30:00Z', 'data': {'firmware_version': '1.0.0'}},
+            {'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:31:00Z', 'data': {'firmware_version': '1.1.0'}},
+            {'message_type': 'alert', 'timestamp': '2024-12-13T10:31:10Z', 'data': {'firmware_version': '9.9.9'}},
+        ]
+        response = self.handler.handle(f'{self.topic}/messages/json', self._signed_payload(json.dumps(batch).encode('utf-8')))
+        self.assertEqual(response.status_code, 200)
+
+        self.device.refresh_from_db()
+        self.assertEqual(self.device.firmware_version, '1.1.0')
+
+        # Rejected signature: version unchanged
+        body = json.dumps({'message_type': 'heartbeat', 'timestamp': '2024-12-13T10:32:00Z',
+                           'data': {'firmware_version': '6.6.6'}}).encode('utf-8')
+        payload = self._signed_payload(b'{}').split(b'\n', 1)[0] + b'\n' + body
+        self.assertEqual(self.handler.handle(f'{self.topic}/messages/json', payload).status_code, 401)
+
+        self.device.refresh_from_db()
+        self.assertEqual(self.device.firmware_version, '1.1.0')
+
+        print("Test heartbeat records firmware version PASSED.")
+
+
+class CBORDecodingTest(TestCase):
+    """Test suite for the compact CBOR device message format"""
+
+    def test_heartbeat_batch_decoding(self):
+        """Test that a CBOR array of heartbeats decodes to a list of messages"""
+        from apps.data_processing.cbor import CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        heartbeat = CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1, 1: 'device', 2: 0, 3: 1734085800,
+            4: {1: 1, 2: 3600, 3: -67, 4: 31000},
+        })
+
+        messages = decode_device_payload(dumps([heartbeat, heartbeat]))
+
+        self.assertEqual(len(messages), 2)
+        self.assertEqual(messages[0]['message_type'], 'heartbeat')
+        self.assertEqual(messages[0]['data'], {
+            'status': 'online', 'uptime': 3600, 'wifi_rssi': -67, 'free_memory': 31000,
+        })
+
+        print("Test CBOR heartbeat batch decoding PASSED.")
+
+    def test_heartbeat_power_fields_decoded(self):
+        """Test that the optional power mode and energy estimate are decoded"""
+        from apps.data_processing.cbor import CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        heartbeat = CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1, 1: 'device', 2: 0, 3: 1734085800,
+            4: {1: 1, 2: 3600, 3: -67, 4: 31000, 5: 2, 6: 42},
+        })
+
+        message = decode_device_payload(dumps(heartbeat))
+
+        self.assertEqual(message['data']['power_mode'], 'light_sleep')
+        self.assertEqual(message['data']['estimated_energy_mwh_per_hour'], 42)
+
+        print("Test CBOR heartbeat power fields decoded PASSED.")
+
+    def test_heartbeat_performance_decoded(self):
+        """Test that profiling counters are decoded with operation names"""
+        from apps.data_processing.cbor import CBORDecodeError, CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        heartbeat = CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1, 1: 'device', 2: 0, 3: 1734085800,
+            4: {1: 1, 2: 3600, 3: -67, 4: 31000, 7: {3: [2, 9100, 9400, 9700, 9700]}},
+        })
+
+        message = decode_device_payload(dumps(heartbeat))
+
+        self.assertEqual(message['data']['performance'], {'ecdsa_sign': [2, 9100, 9400, 9700, 9700]})
+
+        # Unknown profile point
+        heartbeat.value[4][7] = {99: [1, 1, 1, 1, 1]}
+        with self.assertRaises(CBORDecodeError):
+            decode_device_payload(dumps(heartbeat))
+
+        print("Test CBOR heartbeat performance decoded PASSED.")
+
+    def test_heartbeat_memory_decoded(self):
+        """Test that memory statistics decode to the same array as the JSON format"""
+        from apps.data_processing.cbor import CBORDecodeError, CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        heartbeat = CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1, 1: 'device', 2: 0, 3: 1734085800,
+            4: {1: 1, 2: 3600, 3: -67, 4: 31000, 8: [29500, 18200, 23, 1400]},
+        })
+
+        message = decode_device_payload(dumps(heartbeat))
+
+        self.assertEqual(message['data']['memory'], [29500, 18200, 23, 1400])
+
+        # Wrong length
+        heartbeat.value[4][8] = [29500, 18200]
+        with self.assertRaises(CBORDecodeError):
+            decode_device_payload(dumps(heartbeat))
+
+        print("Test CBOR heartbeat memory decoded PASSED.")
+
+    def test_heartbeat_firmware_version_decoded(self):
+        """Test that the firmware version decodes to the JSON field"""
+        from apps.data_processing.cbor import CBORDecodeError, CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        heartbeat = CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1, 1: 'device', 2: 0, 3: 1734085800,
+            4: {1: 1, 2: 3600, 3: -67, 4: 31000, 9: '1.1.0'},
+        })
+
+        self.assertEqual(decode_device_payload(dumps(heartbeat))['data']['firmware_version'], '1.1.0')
+
+        heartbeat.value[4][9] = 110
+        with self.assertRaises(CBORDecodeError):
+            decode_device_payload(dumps(heartbeat))
+
+        print("Test CBOR heartbeat firmware version decoded PASSED.")
+
+    def test_alert_sensor_readings_decoded(self):
+        """Test that the per-sensor distances of a multi-sensor alert are decoded"""
+        from apps.data_processing.cbor import CBORDecodeError, CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        alert = CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1, 1: 'device', 2: 1, 3: 1734085800,
+            4: {1: 1, 2: 1, 3: 210, 4: 12, 5: 1734085788, 6: 100, 7: [1000, 210, 0]},
+        })
+
+        message = decode_device_payload(dumps(alert))
+
+        self.assertEqual(message['data']['detected_distance_cm'], 21.0)
+        self.assertEqual(message['data']['sensor_readings_cm'], [100.0, 21.0, None])
+
+        # Single-sensor alerts carry no vector
+        del alert.value[4][7]
+        self.assertNotIn('sensor_readings_cm', decode_device_payload(dumps(alert))['data'])
+
+        # Negative distance
+        alert.value[4][7] = [-1]
+        with self.assertRaises(CBORDecodeError):
+            decode_device_payload(dumps(alert))
+
+        print("Test CBOR alert sensor readings decoded PASSED.")
+
+    def test_alert_detection_session_decoded(self):
+        """Test that opened, update and closed alerts of a detection session are decoded"""
+        from apps.data_processing.cbor import CBORDecodeError, CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        def alert(data):
+            return dumps(CBORTag(DEVICE_MESSAGE_CBOR_TAG, {0: 1, 1: 'device', 2: 1, 3: 1734085800, 4: data}))
+
+        opened = decode_device_payload(alert({1: 1, 2: 1, 3: 183, 4: 0, 5: 1734085800, 6: 100, 8: 1}))
+        self.assertEqual(opened['data']['detection_state'], 'opened')
+        self.assertEqual(opened['data']['sensor_type'], 'HC-SR04')
+
+        update = decode_device_payload(alert({3: 120, 4: 40, 8: 2}))
+        self.assertEqual(update['data'], {
+            'detection_state': 'update', 'detected_distance_cm': 12.0, 'detection_duration_seconds': 40,
+        })
+
+        closed = decode_device_payload(alert({4: 300, 5: 1734085500, 8: 3, 9: 95}))
+        self.assertEqual(closed['data'], {
+            'detection_state': 'closed', 'closest_distance_cm': 9.5, 'detection_duration_seconds': 300,
+            'first_detected_at': '2024-12-13T10:25:00Z',
+        })
+
+        # Unknown state
+        with self.assertRaises(CBORDecodeError):
+            decode_device_payload(alert({3: 120, 4: 40, 8: 7}))
+
+        print("Test CBOR alert detection session decoded PASSED.")
+
+    def test_unsynced_time_flag_decoded(self):
+        """Test that the time_synced flag is kept and an unset device clock is replaced"""
+        from apps.data_processing.cbor import CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+        from django.utils import timezone
+        from apps.data_processing.views import parse_message_timestamp
+
+        heartbeat = CBORTag(DEVICE_MESSAGE_CBOR_TAG, {
+            0: 1, 1: 'device', 2: 0, 3: 0,
+            4: {0: False, 1: 1, 2: 5, 3: -67, 4: 31000},
+        })
+
+        message = decode_device_payload(dumps(heartbeat))
+
+        self.assertIs(message['data']['time_synced'], False)
+        self.assertEqual(message['timestamp'], '1970-01-01T00:00:00Z')
+
+        # Clock never set - stored with the receive time instead of 1970
+        before = timezone.now()
+        self.assertGreaterEqual(parse_message_timestamp(message['timestamp']), before)
+        self.assertEqual(parse_message_timestamp('2025-01-18T14:30:45Z').year, 2025)
+
+        print("Test CBOR unsynced time flag decoded PASSED.")
+
+    def test_malformed_payloads_rejected(self):
+        """Test that truncated, untagged or unknown-schema payloads raise CBORDecodeError"""
+        from apps.data_processing.cbor import CBORDecodeError, CBORTag, DEVICE_MESSAGE_CBOR_TAG, decode_device_payload, dumps
+
+        valid = dumps(CBORTag(DEVICE_MESSAGE_CBOR_TAG, {0: 1, 2: 0, 3: 0, 4: {1: 1, 2: 0, 3: 0, 4: 0}}))
+
+        invalid_payloads = [
+            valid[:-1],                                                    # Truncated
+            valid + b'\x00',                                               # Trailing bytes
+            dumps({0: 1, 2: 0, 3: 0}),                                     # Missing schema tag
+            dumps(CBORTag(DEVICE_MESSAGE_CBOR_TAG, {0: 99, 2: 0, 3: 0})),  # Unknown schema version
+            b'\x9f\xff',                                                   # Indefinite-length array
+        ]
+
+        for payload in invalid_payloads:
+            with self.assertRaises(CBORDecodeError):
+                decode_device_payload(payload)
+
+        print("Test CBOR malformed payloads rejected PASSED.")
+
+
+class PerformanceCounterTest(TestCase):
+    """Test suite for heartbeat profiling counters and memory statistics"""
+
+    def test_performance_counters_extracted(self):
+        """Test that counters move out of data into named fields, skipping bad entries"""
+        from apps.data_processing.views import extract_performance_counters
+
+        data = {
+            'status': 'online',
+            'performance': {
+                'sha256': [3, 210, 230, 260, 260],
+                'http_connect': [1, 2],          # Wrong length
+                'ecdsa_sign': [1, -5, 0, 0, 0],  # Negative
+            },
+        }
+
+        counters = extract_performance_counters(data)
+
+        self.assertEqual(data, {'status': 'online'})
+        self.assertEqual(counters, {
+            'sha256': {'count': 3, 'min_us': 210, 'avg_us': 230, 'max_us': 260, 'p99_us': 260},
+        })
+        self.assertIsNone(extract_performance_counters({'status': 'online'}))
+
+        print("Test performance counters extracted PASSED.")
+
+    def test_memory_stats_named(self):
+        """Test that the memory array is replaced by named fields, dropping bad arrays"""
+        from apps.data_processing.views import name_memory_stats
+
+        data = {'status': 'online', 'memory': [29500, 18200, 23, 1400]}
+        name_memory_stats(data)
+        self.assertEqual(data, {
+            'status': 'online',
+            'memory': {
+                'min_free_heap': 29500, 'max_free_block': 18200,
+                'heap_fragmentation': 23, 'min_free_stack': 1400,
+            },
+        })
+
+        data = {'status': 'online', 'memory': [29500, -1, 23, 1400]}
+        name_memory_stats(data)
+        self.assertEqual(data, {'status': 'online'})
+
+        print("Test memory stats named PASSED.")
+
@@ -1,6 +1,8 @@
 from django.urls import path
+from apps.device_management.views import firmware_update
 from .views import DeviceMessageView
 
 urlpatterns = [
     path('message/', DeviceMessageView.as_view(), name='device-message'),
+    path('firmware/', firmware_update, name='device-firmware'),
 ]
\ No newline at end of file
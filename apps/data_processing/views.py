@@ -13,49 +13,197 @@ from django.conf import settings
 from datetime import datetime
 import pytz
 from .models import DeviceMessage
+from .cbor import CBOR_CONTENT_TYPE, CBORDecodeError, decode_device_payload
+from .ingest import store_messages
+from .certificate_cache import certificate_cache, certificate_fingerprint, get_ca_certificate
 from dateutil import parser as date_parser
+from django.core.cache import cache
+import secrets
 
 from apps.device_management.models import Device, DeviceStatus
 
 
+# Cache key prefix for device sessions (see DeviceMessageView._create_session)
+DEVICE_SESSION_CACHE_PREFIX = 'device_session:'
+
+# Devices report 1970 timestamps until their clock has been set
+MIN_VALID_MESSAGE_YEAR = 2020
+
+# Firmware profiling entries: [count, min, avg, max, p99] in microseconds
+PERFORMANCE_COUNTER_FIELDS = ('count', 'min_us', 'avg_us', 'max_us', 'p99_us')
+
+# Firmware memory statistics (memstats.h): bytes, except heap_fragmentation (%)
+MEMORY_STATS_FIELDS = ('min_free_heap', 'max_free_block', 'heap_fragmentation', 'min_free_stack')
+
+# Device.firmware_version max_length
+FIRMWARE_VERSION_MAX_LENGTH = 32
+
+
+def parse_message_timestamp(message_timestamp):
+    """
+    Parse the ISO 8601 timestamp sent by a device.
+
+    Args:
+        message_timestamp: Timestamp string from the message (may be None)
+
+    Returns:
+        datetime: Parsed timestamp, or the current time if missing/invalid
+    """
+    if message_timestamp:
+        try:
+            parsed = date_parser.isoparse(message_timestamp)
+        except Exception as e:
+            return timezone.now()
+        # Device clock never set (no SNTP answer and no cached time yet)
+        if parsed.year < MIN_VALID_MESSAGE_YEAR:
+            return timezone.now()
+        return parsed
+    return timezone.now()
+
+
+def extract_performance_counters(data):
+    """
+    Take the profiling counters out of a heartbeat's data.
+
+    Devices send data['performance'] as {operation: [count, min, avg, max, p99]}
+    (microseconds since the previous heartbeat). They are stored separately in
+    DeviceMessage.performance, keyed by PERFORMANCE_COUNTER_FIELDS.
+
+    Args:
+        data: Message data dict ('performance' is removed from it)
+
+    Returns:
+        dict: Counters per operation, or None if the message has none
+    """
+    if not isinstance(data, dict):
+        return None
+
+    performance = data.pop('performance', None)
+    if not isinstance(performance, dict):
+        return None
+
+    counters = {}
+    for operation, values in performance.items():
+        # Skip malformed entries rather than rejecting the heartbeat
+        if (isinstance(values, list)
+                and len(values) == len(PERFORMANCE_COUNTER_FIELDS)
+                and all(isinstance(v, int) and not isinstance(v, bool) and v >= 0 for v in values)):
+            counters[str(operation)] = dict(zip(PERFORMANCE_COUNTER_FIELDS, values))
+
+    return counters or None
+
+
+def name_memory_stats(data):
+    """
+    Replace the memory array of a heartbeat's data with named fields.
+
+    Devices send data['memory'] as [min free heap since boot, smallest
+    largest-free-block and highest fragmentation since the previous heartbeat,
+    min free stack since boot]. The named dict stays in the message data.
+
+    Args:
+        data: Message data dict (updated in place; a malformed array is removed)
+    """
+    if not isinstance(data, dict) or 'memory' not in data:
+        return
+
+    memory = data.pop('memory')
+    if (isinstance(memory, list)
+            and len(memory) == len(MEMORY_STATS_FIELDS)
+            and all(isinstance(v, int) and not isinstance(v, bool) and v >= 0 for v in memory)):
+        data['memory'] = dict(zip(MEMORY_STATS_FIELDS, memory))
+
+
+def record_firmware_version(device_id, messages):
+    """
+    Store the firmware version reported by the last heartbeat of a message batch.
+
+    Only called for signed messages - the unauthenticated firmware update
+    check does not record versions.
+
+    Args:
+        device_id: Device the messages were authenticated for
+        messages: Message dicts of the batch
+    """
+    firmware_version = None
+    for message in messages:
+        data = message.get('data')
+        if message.get('message_type') == 'heartbeat' and isinstance(data, dict):
+            version = data.get('firmware_version')
+            if isinstance(version, str) and 0 < len(version) <= FIRMWARE_VERSION_MAX_LENGTH:
+                firmware_version = version
+
+    if firmware_version is not None:
+        # Conditional update: no write while the version is unchanged
+        Device.objects.filter(id=device_id).exclude(firmware_version=firmware_version).update(
+            firmware_version=firmware_version
+        )
+
+
 # Create your views here.
 class DeviceMessageView(APIView):
     """
     API endpoint for devices to send authenticated messages.
     
     Expected headers:
-    - X-Device-Certificate: Base64-encoded PEM certificate
+    - X-Device-Certificate: Base64-encoded PEM certificate (first contact)
+      or X-Device-Session: session ID returned by an earlier response
     - X-Device-Signature: Base64-encoded signature of message body
+
+    A certificate-authenticated request returns a session_id (valid for
+    DEVICE_SESSION_TTL seconds). Later requests send only that ID, so the
+    certificate is not re-sent, re-parsed and re-verified every time.
+    An unknown or expired session returns 401 with session_expired=True.
+    Sessions are kept in the default cache, which all worker processes
+    share (see CACHES in the settings).
+    Verified certificates and the device status are cached per process
+    (see certificate_cache.py); the body signature is checked every time.
+
+    The body is either a single message object or a batch: a JSON array
+    of message objects covered by one signature. With
+    Content-Type: application/cbor the body uses the compact CBOR schema
+    (see cbor.py) and is decoded into the same message format.
     """
     permission_classes = []  # Disable default authentication - uses certificate auth
     
-    def post(self, request):
-        # Extract headers
-        cert_header = request.headers.get('X-Device-Certificate')
-        signature_header = request.headers.get('X-Device-Signature')
+    def _authenticate_certificate(self, cert_header):
+        """
+        Verify a device certificate against the CA (first contact).
 
-        if not cert_header or not signature_header:
-            return Response({'error': 'Missing required headers.'}, status=status.HTTP_401_UNAUTHORIZED)
-        
+        Args:
+            cert_header: Base64-encoded PEM certificate header value
+
+        Returns:
+            tuple: (auth dict, None) on success or (None, error Response)
+        """
         try:
-            # Decode and load certificate
             cert_pem = base64.b64decode(cert_header)
-            device_cert = x509.load_pem_x509_certificate(cert_pem)
         except Exception as e:
-            return Response({'error': f'Invalid certificate format: {str(e)}'}, status=status.HTTP_400_BAD_REQUEST)
+            return None, Response({'error': f'Invalid certificate format: {str(e)}'}, status=status.HTTP_400_BAD_REQUEST)
+
+        # Certificate verified by an earlier message: only the validity period is re-checked
+        fingerprint = certificate_fingerprint(cert_pem)
+        cached = certificate_cache.get(fingerprint)
+        if cached is not None:
+            now = datetime.utcnow().replace(tzinfo=pytz.UTC)
+            if cached['certificate_not_before'] > now or cached['certificate_not_after'] < now:
+                return None, Response(
+                    {'error': 'Certificate expired or not yet valid'},
+                    status=status.HTTP_401_UNAUTHORIZED
+                )
+            return dict(cached, session_id=None), None
 
         try:
-            # Decode signature
-            signature = base64.b64decode(signature_header)
+            # Load certificate
+            device_cert = x509.load_pem_x509_certificate(cert_pem)
         except Exception as e:
-            return Response({'error': f'Invalid signature format: {str(e)}'}, status=status.HTTP_400_BAD_REQUEST)
-        
+            return None, Response({'error': f'Invalid certificate format: {str(e)}'}, status=status.HTTP_400_BAD_REQUEST)
+
         # Validate certificate
         try:
-            with open(settings.CA_CERTIFICATE_PATH, 'rb') as f:
-                ca_cert = x509.load_pem_x509_certificate(f.read())
+            ca_cert = get_ca_certificate()
         except Exception as e:
-            return Response(
+            return None, Response(
                 {'error': 'Server configuration error'},
                 status=status.HTTP_500_INTERNAL_SERVER_ERROR
             )
@@ -70,9 +218,9 @@ class DeviceMessageView(APIView):
                 device_cert.signature_hash_algorithm,
             )
         except InvalidSignature:
-            return Response({'error': 'Invalid device certificate.'}, status=status.HTTP_401_UNAUTHORIZED)
+            return None, Response({'error': 'Invalid device certificate.'}, status=status.HTTP_401_UNAUTHORIZED)
         except Exception as e:
-            return Response({'error': 'Certificate verification failed.'}, status=status.HTTP_401_UNAUTHORIZED)
+            return None, Response({'error': 'Certificate verification failed.'}, status=status.HTTP_401_UNAUTHORIZED)
 
         # Check certificate expiry
         now = datetime.utcnow().replace(tzinfo=pytz.UTC)
@@ -80,7 +228,7 @@ class DeviceMessageView(APIView):
         cert_not_after = device_cert.not_valid_after.replace(tzinfo=pytz.UTC)
         
         if cert_not_before > now or cert_not_after < now:
-            return Response(
+            return None, Response(
                 {'error': 'Certificate expired or not yet valid'},
                 status=status.HTTP_401_UNAUTHORIZED
             )
@@ -90,44 +238,197 @@ class DeviceMessageView(APIView):
             common_name = device_cert.subject.get_attributes_for_oid(x509.NameOID.COMMON_NAME)[0].value
             device_id = common_name
         except Exception as e:
-            return Response(
+            return None, Response(
                 {'error': 'Invalid certificate'},
                 status=status.HTTP_400_BAD_REQUEST
             )
-        
-        # Look up device in database
+
+        return {
+            'device_id': device_id,
+            'public_key': device_cert.public_key(),
+            'certificate_serial': hex(device_cert.serial_number)[2:],
+            'certificate_not_before': cert_not_before,
+            'certificate_not_after': cert_not_after,
+            'certificate_fingerprint': fingerprint,
+            'device_status': None,
+            'session_id': None,
+        }, None
+
+    def _authenticate_session(self, session_id):
+        """
+        Look up a session issued by an earlier certificate-authenticated request.
+
+        Args:
+            session_id: X-Device-Session header value
+
+        Returns:
+            tuple: (auth dict, None) on success or (None, error Response)
+        """
+        session = cache.get(DEVICE_SESSION_CACHE_PREFIX + session_id)
+        if session is None:
+            # Device falls back to sending its certificate
+            return None, Response(
+                {'error': 'Invalid or expired session', 'session_expired': True},
+                status=status.HTTP_401_UNAUTHORIZED
+            )
+
+        cert_not_after = date_parser.isoparse(session['certificate_not_after'])
+        if cert_not_after < datetime.utcnow().replace(tzinfo=pytz.UTC):
+            cache.delete(DEVICE_SESSION_CACHE_PREFIX + session_id)
+            return None, Response(
+                {'error': 'Certificate expired or not yet valid'},
+                status=status.HTTP_401_UNAUTHORIZED
+            )
+
+        # Session of a certificate that is still cached: reuse its parsed key and device status
+        fingerprint = session.get('certificate_fingerprint')
+        cached = certificate_cache.get(fingerprint) if fingerprint else None
+        if cached is not None:
+            return dict(cached, session_id=session_id), None
+
+        return {
+            'device_id': session['device_id'],
+            'public_key': serialization.load_pem_public_key(session['public_key_pem'].encode('utf-8')),
+            'certificate_serial': session['certificate_serial'],
+            'certificate_not_after': cert_not_after,
+            'certificate_fingerprint': None,
+            'device_status': None,
+            'session_id': session_id,
+        }, None
+
+    def _create_session(self, auth):
+        """
+        Issue a session ID so later requests can skip the certificate.
+
+        Args:
+            auth: Auth dict from _authenticate_certificate()
+
+        Returns:
+            str: New session ID
+        """
+        session_id = secrets.token_urlsafe(16)
+        public_key_pem = auth['public_key'].public_bytes(
+            encoding=serialization.Encoding.PEM,
+            format=serialization.PublicFormat.SubjectPublicKeyInfo
+        ).decode('utf-8')
+
+        cache.set(
+            DEVICE_SESSION_CACHE_PREFIX + session_id,
+            {
+                'device_id': str(auth['device_id']),
+                'public_key_pem': public_key_pem,
+                'certificate_serial': auth['certificate_serial'],
+                'certificate_not_after': auth['certificate_not_after'].isoformat(),
+                'certificate_fingerprint': auth['certificate_fingerprint'],
+            },
+            timeout=settings.DEVICE_SESSION_TTL
+        )
+        return session_id
+
+    def post(self, request):
+        # Extract headers
+        cert_header = request.headers.get('X-Device-Certificate')
+        session_header = request.headers.get('X-Device-Session')
+        signature_header = request.headers.get('X-Device-Signature')
+
+        if not (cert_header or session_header) or not signature_header:
+            return Response({'error': 'Missing required headers.'}, status=status.HTTP_401_UNAUTHORIZED)
+
         try:
-            device = Device.objects.get(id=device_id)
-        except Device.DoesNotExist:
+            # Decode signature
+            signature = base64.b64decode(signature_header)
+        except Exception as e:
+            return Response({'error': f'Invalid signature format: {str(e)}'}, status=status.HTTP_400_BAD_REQUEST)
+
+        # Authenticate with the session if present, otherwise with the full certificate
+        if session_header:
+            auth, error_response = self._authenticate_session(session_header)
+        else:
+            auth, error_response = self._authenticate_certificate(cert_header)
+
+        if error_response is not None:
+            return error_response
+
+        # Get request body (the message being sent)
+        try:
+            message_body = request.body
+        except Exception as e:
             return Response(
-                {'error': 'Device not found'},
-                status=status.HTTP_404_NOT_FOUND
+                {'error': 'Could not read message body'},
+                status=status.HTTP_400_BAD_REQUEST
             )
-        
+
+        # Code below was copied from https://www.geeksforgeeks.org/python/get-user-ip-address-in-django/
+        # Extract client IP address
+        # START OF COPIED CODE
+        def get_client_ip(request):
+            ip_address = request.META.get('HTTP_X_FORWARDED_FOR')
+            if ip_address:
+                ip_address = ip_address.split(',')[0]
+            else:
+                ip_address = request.META.get('REMOTE_ADDR')
+            return ip_address
+        # END OF COPIED CODE
+
+        client_ip = get_client_ip(request)
+
+        return self.process_message(auth, signature, message_body, request.content_type, client_ip)
+
+    def process_message(self, auth, signature, message_body, content_type, client_ip, issue_session=True):
+        """
+        Verify and store a signed message body from an authenticated device.
+
+        Shared by the HTTP endpoint and the MQTT subscriber
+        (management command mqtt_subscriber).
+
+        Args:
+            auth: Auth dict from _authenticate_certificate() or _authenticate_session()
+            signature: Decoded signature of message_body
+            message_body: Raw body bytes (one message or a batch array)
+            content_type: CBOR_CONTENT_TYPE for CBOR, otherwise JSON
+            client_ip: Sender address stored with the messages (may be None)
+            issue_session: Create a session for certificate-authenticated requests
+
+        Returns:
+            Response: Result to return to the device
+        """
+        device_id = auth['device_id']
+        device_status = auth['device_status']
+
+        # Look up device in database (unless the certificate cache already knows its status)
+        if device_status is None:
+            try:
+                device_status = Device.objects.only('status').get(id=device_id).status
+            except Device.DoesNotExist:
+                return Response(
+                    {'error': 'Device not found'},
+                    status=status.HTTP_404_NOT_FOUND
+                )
+
+            # Certificate just verified against the CA: cache it with the status
+            if auth['certificate_fingerprint']:
+                entry = {key: value for key, value in auth.items() if key != 'session_id'}
+                entry['device_status'] = device_status
+                certificate_cache.put(auth['certificate_fingerprint'], entry)
+
         # Check device status
-        if device.status == DeviceStatus.REVOKED:
+        if device_status == DeviceStatus.REVOKED:
+            if auth['session_id']:
+                cache.delete(DEVICE_SESSION_CACHE_PREFIX + auth['session_id'])
             return Response(
                 {'error': 'Device certificate has been revoked'},
                 status=status.HTTP_403_FORBIDDEN
             )
         
-        # Get request body (the message being sent)
-        try:
-            message_body = request.body
-            if not message_body:
-                return Response(
-                    {'error': 'Empty message body'},
-                    status=status.HTTP_400_BAD_REQUEST
-                )
-        except Exception as e:
+        if not message_body:
             return Response(
-                {'error': 'Could not read message body'},
+                {'error': 'Empty message body'},
                 status=status.HTTP_400_BAD_REQUEST
             )
 
         # Verify signature of message body using device's public key
         try:
-            device_public_key = device_cert.public_key()
+            device_public_key = auth['public_key']
 
             # Verify signature based on key type (RSA or ECDSA)
             if isinstance(device_public_key, rsa.RSAPublicKey):
@@ -162,72 +463,102 @@ class DeviceMessageView(APIView):
                 status=status.HTTP_401_UNAUTHORIZED
             )
         
-        # Parse JSON message
-        try:
-            message_data = json.loads(message_body)
-        except json.JSONDecodeError:
+        # Parse message (JSON text, or compact CBOR encoding)
+        if content_type == CBOR_CONTENT_TYPE:
+            try:
+                message_data = decode_device_payload(message_body)
+            except CBORDecodeError as e:
+                return Response(
+                    {'error': f'Invalid CBOR in message body: {str(e)}'},
+                    status=status.HTTP_400_BAD_REQUEST
+                )
+        else:
+            try:
+                message_data = json.loads(message_body)
+            except json.JSONDecodeError:
+                return Response(
+                    {'error': 'Invalid JSON in message body'},
+                    status=status.HTTP_400_BAD_REQUEST
+                )
+
+        # Batched upload: fan out the array into individual messages
+        is_batch = isinstance(message_data, list)
+        messages = message_data if is_batch else [message_data]
+
+        if (not messages
+                or len(messages) > settings.DEVICE_MESSAGE_MAX_BATCH_SIZE
+                or not all(isinstance(message, dict) for message in messages)):
             return Response(
-                {'error': 'Invalid JSON in message body'},
+                {'error': 'Invalid message batch'},
                 status=status.HTTP_400_BAD_REQUEST
             )
-        
-        # Code below was copied from https://www.geeksforgeeks.org/python/get-user-ip-address-in-django/
-        # Extract client IP address
-        # START OF COPIED CODE
-        def get_client_ip(request):
-            ip_address = request.META.get('HTTP_X_FORWARDED_FOR')
-            if ip_address:
-                ip_address = ip_address.split(',')[0]
-            else:
-                ip_address = request.META.get('REMOTE_ADDR')
-            return ip_address
-        # END OF COPIED CODE
-
-        client_ip = get_client_ip(request)
-
-        # Extract timestamp from message data
-        message_timestamp = message_data.get('timestamp')
-        if message_timestamp:
-            try:
-                parsed_timestamp = date_parser.isoparse(message_timestamp)
-            except Exception as e:
-                parsed_timestamp = timezone.now()
-        else:
-            parsed_timestamp = timezone.now()
 
         #Extract certificate serial number
-        cert_serial_number = hex(device_cert.serial_number)[2:]
+        cert_serial_number = auth['certificate_serial']
 
-        # Save message to database
-        saved_successfully = False
+        # Signature proved possession of the key - issue a session on first contact
+        session_id = auth['session_id']
+        if session_id is None and issue_session:
+            session_id = self._create_session(auth)
 
-        # Try to save the message
-        try:
-            DeviceMessage.objects.create(
-                device=device,
-                message_type=message_data.get('message_type', 'unknown'),
-                timestamp=parsed_timestamp,
-                data=message_data.get('data', {}),
+        # Save messages to database (one bulk insert, see ingest.py)
+        new_messages = []
+        for message in messages:
+            data = message.get('data', {})
+            performance = extract_performance_counters(data)
+            name_memory_stats(data)
+            new_messages.append(DeviceMessage(
+                device_id=device_id,
+                message_type=message.get('message_type', 'unknown'),
+                timestamp=parse_message_timestamp(message.get('timestamp')),
+                data=data,
+                performance=performance,
                 ip_address=client_ip,
                 certificate_serial=cert_serial_number
+            ))
+
+        # Write-behind stages the messages in the database - reported as queued, not saved, until flushed
+        queued = settings.DEVICE_INGEST_WRITE_BEHIND
+        stored_count = store_messages(new_messages)
+        if queued and stored_count == 0:
+            # Nothing was acknowledged - a 5xx makes the device keep the messages and retry
+            return Response(
+                {'error': 'Failed to queue message', 'saved': False, 'queued': False},
+                status=status.HTTP_503_SERVICE_UNAVAILABLE
             )
-            saved_successfully = True
-        except Exception as e:
-            print(f'error: Failed to store message: {str(e)}')
+        saved_count = 0 if queued else stored_count
+        saved_successfully = not queued and saved_count == len(messages)
+
+        # Firmware version from the newest heartbeat (the signature authenticates it)
+        record_firmware_version(device_id, messages)
         
         # Update device status to ACTIVE if it was PENDING or INACTIVE
-        if device.status in [DeviceStatus.PENDING, DeviceStatus.INACTIVE]:
+        # (saving the device also drops its cached certificate status)
+        if device_status in [DeviceStatus.PENDING, DeviceStatus.INACTIVE]:
+            device = Device.objects.get(id=device_id)
             device.status = DeviceStatus.ACTIVE
             device.save()
         
         response_data = {
             'status': 'success',
             'saved': saved_successfully,
-            'device_id': device.id,
-            'timestamp': timezone.now().isoformat()
+            'queued': queued,
+            'device_id': str(device_id),
+            'timestamp': timezone.now().isoformat(),
+            'session_id': session_id,
+            'session_ttl': settings.DEVICE_SESSION_TTL,
         }
 
-        if saved_successfully:
+        if is_batch:
+            response_data['message_count'] = len(messages)
+            response_data['saved_count'] = saved_count
+            if queued:
+                response_data['queued_count'] = len(messages)
+
+        if queued:
+            # Acknowledged once staged in the database - written by the next flush
+            response_data['message'] = 'Message queued for storage.'
+        elif saved_successfully:
             response_data['message'] = 'Message stored successfully.'
         else:
             response_data['message'] = 'Failed to store message.'
@@ -1,5 +1,6 @@
 from django.contrib import admin
-from .models import Device, DeviceStatus, DeviceType
+from django.db.models.functions import Length
+from .models import Device, DeviceStatus, DeviceType, FirmwareRelease
 from django.contrib import messages
 from django.http import HttpResponse
 from .utils import generate_device_certificate
@@ -88,9 +89,31 @@ class DeviceTypeAdmin(admin.ModelAdmin):
 
 @admin.register(Device)
 class DeviceAdmin(admin.ModelAdmin):
-    list_display = ('id', 'name', 'status', 'certificate_serial', 'certificate_expiry', 'created_at', 'updated_at')
-    list_filter = ('status', 'created_at', 'updated_at')
+    list_display = ('id', 'name', 'status', 'last_seen', 'firmware_version', 'certificate_serial', 'certificate_expiry', 'created_at', 'updated_at')
+    list_filter = ('status', 'firmware_version', 'created_at', 'updated_at')
     search_fields = ('name', 'id' 'certificate_serial')
-    readonly_fields = ('id', 'created_at', 'updated_at', 'created_by')
+    readonly_fields = ('id', 'last_seen', 'firmware_version', 'created_at', 'updated_at', 'created_by')
     actions = [generate_certificate_action]
 
+
+@admin.register(FirmwareRelease)
+class FirmwareReleaseAdmin(admin.ModelAdmin):
+    # Releases are created by "python manage.py build_firmware" - only activation is edited here
+    list_display = ('version', 'is_active', 'firmware_size', 'image_size', 'created_at')
+    list_filter = ('is_active',)
+    list_editable = ('is_active',)
+    search_fields = ('version',)
+    fields = ('version', 'is_active', 'firmware_size', 'image_md5', 'created_at')
+    readonly_fields = ('version', 'firmware_size', 'image_md5', 'created_at')
+
+    def get_queryset(self, request):
+        # The image BLOB is only needed for downloads - the database reports its length
+        return super().get_queryset(request).defer('image').annotate(image_length=Length('image'))
+
+    def image_size(self, obj):
+        return obj.image_length
+    image_size.short_description = 'Image size (compressed, signed)'
+    image_size.admin_order_field = 'image_length'
+
+    def has_add_permission(self, request):
+        return False
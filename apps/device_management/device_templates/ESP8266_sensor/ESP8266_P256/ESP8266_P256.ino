@@ -12,7 +12,10 @@
 // - Sends alert messages when HC-SR04 sensor detects object within 25cm (every 10s while detecting)
 // - Heartbeats are skipped during active detection (alerts provide status info)
 // - Signs all messages with ECDSA P-256 cryptographic signatures
-// - Communicates with Django backend via HTTP REST API
+// - Communicates with Django backend via HTTP REST API (non-blocking send queue)
+// - Stores alerts in flash (LittleFS) while offline and resends them after reconnecting
+// - Runs everything as cooperative scheduler tasks and sleeps between them
+// - Installs signed firmware updates from the server (credentials stay in flash)
 //
 // Hardware: ESP8266 (NodeMCU / Wemos D1 Mini)
 // Security: ECDSA P-256, X.509 certificates, signed messages
@@ -24,44 +27,283 @@
 #include "network.h"
 #include "crypto.h"
 #include "messaging.h"
+#include "storage.h"
+#include "scheduler.h"
+#include "power.h"
+#include "memstats.h"
+#include "credentials.h"
+#include "ota.h"
+#include "logging.h"
 
 // ============================================================================
 // GLOBAL STATE
 // ============================================================================
 
 bool systemReady = false;
+bool wifiWasConnected = true;  // Connection state seen by the last network task run
+bool wasPatternPlaying = false; // LED pattern state seen by the last network task run
+bool firmwareUpdatesReady = false; // Signing key parsed - the firmware task is registered
+
+// Scheduler task handles (see registerTasks())
+TaskId sensorTask = -1;
+TaskId ledTask = -1;
+TaskId heartbeatTask = -1;
+TaskId networkTask = -1;
+TaskId wifiTask = -1;
+TaskId firmwareTask = -1;
+
+// ============================================================================
+// SCHEDULER TASKS
+// ============================================================================
+
+/**
+ * Sensor task (every getSensorPollInterval(): fast while an object approaches
+ * or is detected, slow while the area is quiet)
+ * Polls the HC-SR04 and queues the alerts of a detection session.
+ * A measurement is a short burst of pings; each takes two runs: trigger,
+ * then collect the echo shortly after.
+ */
+void runSensorTask() {
+    pollSensor();  // Updates detection state internally
+
+    if (isMeasurementPending()) {
+        scheduleTaskIn(sensorTask, getMeasurementStepDelay());  // Collect the echo or send the next ping
+        return;
+    }
+
+    // Next burst at the rate the latest reading calls for
+    setTaskInterval(sensorTask, getSensorPollInterval());
+
+    // Report the detection session (opened, updates, closed)
+    DetectionEvent event = getDueDetectionEvent();
+    if (event == DETECTION_NONE) {
+        return;
+    }
+
+    if (event == DETECTION_OPENED) {
+        LOG_INFO("[MAIN] Alert triggered by object detection!");
+    }
+
+    // Queue alert message with sensor data (sent in the background)
+    bool queued;
+    if (event == DETECTION_CLOSED) {
+        const DetectionSummary& summary = getClosedDetection();
+        queued = sendAlert(event, summary.closestDistanceMm, summary.durationSeconds, summary.firstDetectedAt);
+    } else {
+        queued = sendAlert(event, getDetectedDistanceMm(), getDetectionDuration(), getFirstDetectionTimestamp());
+    }
+
+    if (queued) {
+        LOG_INFO("[MAIN] Alert message queued");
+        markAlertSent(event);  // Update timer and distance for the next update
+        triggerTask(networkTask);
+    } else {
+        LOG_ERROR("[MAIN] Alert message failed");
+        markAlertFailed(event);  // Closed summary: retried a few times, then dropped
+    }
+}
+
+/**
+ * LED task (every LED_BLINK_INTERVAL, or at the next pattern step)
+ * Plays success/error feedback and the continuous blink while detecting.
+ */
+void runLedTask() {
+    unsigned long nextUpdate = updateStatusLED();
+    if (nextUpdate < LED_BLINK_INTERVAL) {
+        scheduleTaskIn(ledTask, nextUpdate);
+    }
+}
+
+/**
+ * Heartbeat task (every HEARTBEAT_INTERVAL)
+ * Skipped when actively detecting - alerts contain all status info.
+ * Heartbeats are not stored offline - they only report current status.
+ */
+void runHeartbeatTask() {
+    if (isObjectDetected() || !isWiFiConnected()) {
+        return;
+    }
+
+    LOG_DEBUG("[MAIN] Heartbeat interval reached");
+
+    // Queue heartbeat message (sent in the background)
+    if (sendHeartbeat()) {
+        LOG_INFO("[MAIN] Heartbeat queued");
+        triggerTask(networkTask);
+    } else {
+        LOG_ERROR("[MAIN] Heartbeat failed");
+    }
+}
+
+/**
+ * Network task (every NETWORK_TASK_INTERVAL, NETWORK_BUSY_INTERVAL while sending)
+ * Advances the send pipeline, services the offline store and time sync.
+ */
+void runNetworkTask() {
+    // Start reconnecting as soon as the connection drops
+    bool connected = isWiFiConnected();
+    if (wifiWasConnected && !connected) {
+        setWiFiLED(false);
+        triggerTask(wifiTask);
+    }
+    wifiWasConnected = connected;
+
+    // Moves queued messages one step through connect → send → response,
+    // so sensor polling keeps its cadence regardless of server latency
+    processOutboundQueue();
+
+    // Start success/error feedback right away (patterns run in the LED task)
+    if (isStatusPatternPlaying() && !wasPatternPlaying) {
+        triggerTask(ledTask);
+    }
+    wasPatternPlaying = isStatusPatternPlaying();
+
+    serviceOfflineStore();   // Coalesced flash writes
+    drainOfflineStore();     // Batches into the outbound queue once back online
+    serviceTime();           // Apply SNTP updates / refresh RTC copy
+
+    // Radio stays awake while a request is in flight (sleep power modes)
+    bool sending = isSendInProgress();
+    setRadioAwake(sending);
+    if (sending) {
+        scheduleTaskIn(networkTask, NETWORK_BUSY_INTERVAL);
+    }
+}
+
+/**
+ * WiFi task (every WIFI_RECONNECT_INTERVAL, WIFI_CONNECT_POLL_INTERVAL while connecting)
+ * Starts a reconnection attempt while offline and checks on it without
+ * waiting - sensor polling continues in between and alerts go to the
+ * offline store.
+ */
+void runWiFiTask() {
+    bool attemptRunning = isWiFiConnecting();
+    if (!attemptRunning) {
+        if (isWiFiConnected()) {
+            return;
+        }
+        setWiFiLED(false);
+        LOG_INFO("\n[MAIN] WiFi disconnected! Attempting reconnection...");
+    }
+
+    if (reconnectWiFi()) {
+        LOG_INFO("[MAIN] WiFi reconnected successfully");
+        wifiWasConnected = true;
+
+        if (getOfflineMessageCount() > 0) {
+            LOG_INFO("[MAIN] %u stored alerts will be resent", (unsigned int)getOfflineMessageCount());
+        }
+        triggerTask(networkTask);
+    } else if (isWiFiConnecting()) {
+        scheduleTaskIn(wifiTask, WIFI_CONNECT_POLL_INTERVAL);  // Check on the attempt soon
+    } else {
+        LOG_ERROR("[MAIN] WiFi reconnection failed, will retry...");
+    }
+}
+
+/**
+ * Nonce task (every NONCE_POOL_REFILL_INTERVAL)
+ * Tops up the precomputed signing nonces one at a time. Each takes as long
+ * as a full signature, so it only runs while nothing time-critical is going on.
+ */
+void runNonceTask() {
+    if (isObjectDetected() || isSendInProgress() || getNoncePoolCount() >= NONCE_POOL_SIZE) {
+        return;
+    }
+
+    precomputeSigningNonce();
+}
+
+/**
+ * Firmware update task (every FIRMWARE_UPDATE_CHECK_INTERVAL)
+ * Installs a new signed image from the server and restarts. Waits for a
+ * quiet moment - the download blocks the other tasks for several seconds.
+ */
+void runFirmwareUpdateTask() {
+    if (isObjectDetected() || !isWiFiConnected() || isSendInProgress() || getOutboundQueueCount() > 0) {
+        scheduleTaskIn(firmwareTask, FIRMWARE_UPDATE_RETRY_DELAY);
+        return;
+    }
+
+    checkForFirmwareUpdate();  // Only returns if nothing was installed
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+/**
+ * Statistics task (every SCHEDULER_STATS_INTERVAL, debug builds only)
+ */
+void runStatsTask() {
+    printSchedulerStats();
+}
+#endif
+
+/**
+ * Register all periodic tasks with the scheduler
+ */
+void registerTasks() {
+    sensorTask = addTask("sensor", runSensorTask, SENSOR_POLL_INTERVAL, TASK_PRIORITY_HIGH);
+#if POWER_MODE == POWER_MODE_ACTIVE
+    networkTask = addTask("network", runNetworkTask, NETWORK_TASK_INTERVAL, TASK_PRIORITY_NORMAL);
+#else
+    // Fewer idle wake-ups - queued messages trigger the task immediately
+    networkTask = addTask("network", runNetworkTask, POWER_SAVE_NETWORK_INTERVAL, TASK_PRIORITY_NORMAL);
+#endif
+    heartbeatTask = addTask("heartbeat", runHeartbeatTask, HEARTBEAT_INTERVAL, TASK_PRIORITY_NORMAL);
+    wifiTask = addTask("wifi", runWiFiTask, WIFI_RECONNECT_INTERVAL, TASK_PRIORITY_NORMAL);
+    ledTask = addTask("led", runLedTask, LED_BLINK_INTERVAL, TASK_PRIORITY_LOW);
+    addTask("nonce", runNonceTask, NONCE_POOL_REFILL_INTERVAL, TASK_PRIORITY_LOW);
+    if (firmwareUpdatesReady) {
+        // First check shortly after boot, then every FIRMWARE_UPDATE_CHECK_INTERVAL
+        firmwareTask = addTask("firmware", runFirmwareUpdateTask, FIRMWARE_UPDATE_CHECK_INTERVAL, TASK_PRIORITY_LOW);
+        scheduleTaskIn(firmwareTask, FIRMWARE_UPDATE_RETRY_DELAY);
+    }
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+    addTask("stats", runStatsTask, SCHEDULER_STATS_INTERVAL, TASK_PRIORITY_LOW);
+#endif
+}
 
 // ============================================================================
 // SETUP - Runs once at boot
 // ============================================================================
 
 void setup() {
-    // Initialize serial communication for debugging
+    // Initialize serial communication for debugging (skipped when logging is compiled out)
+#if LOG_LEVEL > LOG_LEVEL_NONE
     Serial.begin(115200);
     delay(100);  // Allow serial to stabilize
+#endif
     
-    Serial.println("\n\n");
-    Serial.println("╔════════════════════════════════════════════════════════════╗");
-    Serial.println("║                                                            ║");
-    Serial.println("║              C3DS - IoT Sensor Node v1.0                   ║");
-    Serial.println("║     Civilian Distributed Drone Detection System            ║");
-    Serial.println("║                                                            ║");
-    Serial.println("╚════════════════════════════════════════════════════════════╝");
-    Serial.println();
-    Serial.print("Device ID: ");
-    Serial.println(DEVICE_ID);
-    Serial.print("Firmware: ESP8266 C3DS Sensor v1.0");
-    Serial.println();
-    Serial.println("Starting initialization sequence...\n");
+    LOG_INFO("\n\n");
+    LOG_INFO("╔════════════════════════════════════════════════════════════╗");
+    LOG_INFO("║                                                            ║");
+    LOG_INFO("║              C3DS - IoT Sensor Node v1.0                   ║");
+    LOG_INFO("║     Civilian Distributed Drone Detection System            ║");
+    LOG_INFO("║                                                            ║");
+    LOG_INFO("╚════════════════════════════════════════════════════════════╝");
+    LOG_INFO("");
+    LOG_INFO("Firmware: ESP8266 C3DS Sensor %s", FIRMWARE_VERSION);
+    LOG_INFO("Starting initialization sequence...\n");
     
     // ────────────────────────────────────────────────────────────────────────
     // STEP 1: Initialize Hardware
     // ────────────────────────────────────────────────────────────────────────
-    Serial.println("════════════════════════════════════════════════════════════");
-    Serial.println("STEP 1/5: Hardware Initialization");
-    Serial.println("════════════════════════════════════════════════════════════");
+    LOG_INFO("════════════════════════════════════════════════════════════");
+    LOG_INFO("STEP 1/5: Hardware Initialization");
+    LOG_INFO("════════════════════════════════════════════════════════════");
     
     initializeHardware();
+
+    // Device ID, WiFi and keys live in the credentials sector, not the sketch
+    if (!initializeCredentials()) {
+        LOG_ERROR("\nFATAL ERROR: No device credentials!");
+        LOG_ERROR("System halted. Please upload the code bundle from the portal.");
+
+        while (true) {
+            blinkStatusLED(8, 100);
+            delay(2000);
+        }
+    }
+    LOG_INFO("Device ID: %s", getCredentials().deviceId);
     
     // Visual indication: blink both LEDs
     setStatusLED(true);
@@ -71,18 +313,18 @@ void setup() {
     setWiFiLED(false);
     delay(500);
     
-    Serial.println("Hardware initialization complete\n");
+    LOG_INFO("Hardware initialization complete\n");
     
     // ────────────────────────────────────────────────────────────────────────
     // STEP 2: Connect to WiFi
     // ────────────────────────────────────────────────────────────────────────
-    Serial.println("════════════════════════════════════════════════════════════");
-    Serial.println("STEP 2/5: Network Connection");
-    Serial.println("════════════════════════════════════════════════════════════");
+    LOG_INFO("════════════════════════════════════════════════════════════");
+    LOG_INFO("STEP 2/5: Network Connection");
+    LOG_INFO("════════════════════════════════════════════════════════════");
     
     if (!initializeWiFi()) {
-        Serial.println("\nFATAL ERROR: WiFi connection failed!");
-        Serial.println("System halted. Please check configuration and reset device.");
+        LOG_ERROR("\nFATAL ERROR: WiFi connection failed!");
+        LOG_ERROR("System halted. Please check configuration and reset device.");
         
         // Indicate error with rapid LED blinking
         while (true) {
@@ -91,37 +333,30 @@ void setup() {
         }
     }
     
-    Serial.println("Network connection complete\n");
+    LOG_INFO("Network connection complete\n");
     
     // ────────────────────────────────────────────────────────────────────────
     // STEP 3: Synchronize Time (NTP)
     // ────────────────────────────────────────────────────────────────────────
-    Serial.println("════════════════════════════════════════════════════════════");
-    Serial.println("STEP 3/5: Time Synchronization");
-    Serial.println("════════════════════════════════════════════════════════════");
+    LOG_INFO("════════════════════════════════════════════════════════════");
+    LOG_INFO("STEP 3/5: Time Synchronization");
+    LOG_INFO("════════════════════════════════════════════════════════════");
     
-    if (!initializeNTP()) {
-        Serial.println("\nFATAL ERROR: Time synchronization failed!");
-        Serial.println("System halted. Please check NTP server and reset device.");
-        
-        while (true) {
-            blinkStatusLED(8, 100);
-            delay(2000);
-        }
-    }
+    // Non-blocking: runs on cached time until SNTP answers in the background
+    initializeTime();
     
-    Serial.println("Time synchronization complete\n");
+    LOG_INFO("Time synchronization started\n");
     
     // ────────────────────────────────────────────────────────────────────────
     // STEP 4: Initialize Cryptography
     // ────────────────────────────────────────────────────────────────────────
-    Serial.println("════════════════════════════════════════════════════════════");
-    Serial.println("STEP 4/5: Cryptographic Initialization");
-    Serial.println("════════════════════════════════════════════════════════════");
+    LOG_INFO("════════════════════════════════════════════════════════════");
+    LOG_INFO("STEP 4/5: Cryptographic Initialization");
+    LOG_INFO("════════════════════════════════════════════════════════════");
     
     if (!initializeCrypto()) {
-        Serial.println("\nFATAL ERROR: Cryptography initialization failed!");
-        Serial.println("System halted. Please check private key and reset device.");
+        LOG_ERROR("\nFATAL ERROR: Cryptography initialization failed!");
+        LOG_ERROR("System halted. Please check private key and reset device.");
         
         while (true) {
             blinkStatusLED(6, 100);
@@ -129,18 +364,22 @@ void setup() {
         }
     }
     
-    Serial.println("Cryptographic initialization complete\n");
+    // Cold vs. warm signing time; falls back to full signing if the
+    // precomputed path fails its self-test (not fatal)
+    benchmarkSigning();
+    
+    LOG_INFO("Cryptographic initialization complete\n");
     
     // ────────────────────────────────────────────────────────────────────────
     // STEP 5: Initialize Messaging
     // ────────────────────────────────────────────────────────────────────────
-    Serial.println("════════════════════════════════════════════════════════════");
-    Serial.println("STEP 5/5: Messaging Subsystem");
-    Serial.println("════════════════════════════════════════════════════════════");
+    LOG_INFO("════════════════════════════════════════════════════════════");
+    LOG_INFO("STEP 5/5: Messaging Subsystem");
+    LOG_INFO("════════════════════════════════════════════════════════════");
     
     if (!initializeMessaging()) {
-        Serial.println("\nFATAL ERROR: Messaging initialization failed!");
-        Serial.println("System halted. Please reset device.");
+        LOG_ERROR("\nFATAL ERROR: Messaging initialization failed!");
+        LOG_ERROR("System halted. Please reset device.");
         
         while (true) {
             blinkStatusLED(4, 100);
@@ -148,39 +387,47 @@ void setup() {
         }
     }
     
-    Serial.println("Messaging subsystem complete\n");
+    LOG_INFO("Messaging subsystem complete\n");
     
     // ────────────────────────────────────────────────────────────────────────
     // Initialization Complete
     // ────────────────────────────────────────────────────────────────────────
-    Serial.println("════════════════════════════════════════════════════════════");
-    Serial.println("ALL SYSTEMS OPERATIONAL");
-    Serial.println("════════════════════════════════════════════════════════════");
-    Serial.println();
+    LOG_INFO("════════════════════════════════════════════════════════════");
+    LOG_INFO("ALL SYSTEMS OPERATIONAL");
+    LOG_INFO("════════════════════════════════════════════════════════════");
+    LOG_INFO("");
     
     printNetworkDiagnostics();
     
-    Serial.println("╔════════════════════════════════════════════════════════════╗");
-    Serial.println("║                    DEVICE READY                            ║");
-    Serial.println("╚════════════════════════════════════════════════════════════╝");
-    Serial.println();
-    Serial.println("Operational modes:");
-    Serial.println("  → Heartbeat: Every 20 seconds (when idle)");
-    Serial.println("  → Alert: Object detected within 25cm (HC-SR04 sensor)");
-    Serial.println("  → Sensor polling: Every 500ms");
-    Serial.println("  → Alert interval: Every 10 seconds while detecting");
-    Serial.println("  → Note: Heartbeats skipped during active detection");
-    Serial.println();
-    Serial.println("Waiting for events...\n");
-    
-    systemReady = true;
+    LOG_INFO("╔════════════════════════════════════════════════════════════╗");
+    LOG_INFO("║                    DEVICE READY                            ║");
+    LOG_INFO("╚════════════════════════════════════════════════════════════╝");
+    LOG_INFO("");
+    LOG_INFO("Operational modes:");
+    LOG_INFO("  → Heartbeat: Every %lu seconds (when idle)", HEARTBEAT_INTERVAL / 1000);
+    LOG_INFO("  → Alert: Object detected within %dcm (HC-SR04 sensor)", (int)DETECTION_THRESHOLD_CM);
+    LOG_INFO("  → Sensor polling: %lums approaching, %lums recent motion, %lums idle",
+             SENSOR_POLL_INTERVAL_FAST, SENSOR_POLL_INTERVAL, SENSOR_POLL_INTERVAL_SLOW);
+    LOG_INFO("  → Detection: \"opened\" alert, \"update\" on %dcm moves (at most every %lus, at least every %lus),",
+             (int)ALERT_DELTA_DISTANCE_CM, ALERT_INTERVAL / 1000, ALERT_KEEPALIVE_INTERVAL / 1000);
+    LOG_INFO("    \"closed\" summary when the object leaves");
+    LOG_INFO("  → Note: Heartbeats skipped during active detection");
+    LOG_INFO("");
+    LOG_INFO("Waiting for events...\n");
     
     // Success indication: 3 short blinks
     blinkStatusLED(3, 200);
     
-    // Send initial heartbeat to announce device is online
-    Serial.println("[MAIN] Sending initial heartbeat...");
+    // Queue initial heartbeat to announce device is online
+    LOG_INFO("[MAIN] Queueing initial heartbeat...");
     sendHeartbeat();
+
+    // Periodic work runs from the scheduler from now on, sleeping in between
+    initializeMemoryStats();
+    initializePower();
+    firmwareUpdatesReady = initializeFirmwareUpdates();
+    registerTasks();
+    systemReady = true;
 }
 
 // ============================================================================
@@ -194,74 +441,10 @@ void loop() {
         return;
     }
     
-    // ────────────────────────────────────────────────────────────────────────
-    // Check WiFi Connection
-    // ────────────────────────────────────────────────────────────────────────
-    if (!isWiFiConnected()) {
-        Serial.println("\n[MAIN] WiFi disconnected! Attempting reconnection...");
-        setWiFiLED(false);
-        
-        if (reconnectWiFi()) {
-            Serial.println("[MAIN] WiFi reconnected successfully");
-            
-            // Re-sync time after reconnection
-            if (!initializeNTP()) {
-                Serial.println("[MAIN] Warning: Time re-sync failed");
-            }
-        } else {
-            Serial.println("[MAIN] WiFi reconnection failed, will retry...");
-            delay(5000);  // Wait before next attempt
-            return;
-        }
-    }
-    
-    // ────────────────────────────────────────────────────────────────────────
-    // Poll HC-SR04 Sensor (Check for Object Detection)
-    // ────────────────────────────────────────────────────────────────────────
-    if (isSensorPollDue()) {
-        pollSensor();  // Updates detection state internally
-    }
+    // Run due tasks (sensor, LED, heartbeat, network), then sleep until
+    // the next one is due
+    runScheduler();
 
-    // ────────────────────────────────────────────────────────────────────────
-    // Update LED Blinking Pattern (Continuous blink while detecting)
-    // ────────────────────────────────────────────────────────────────────────
-    updateDetectionLED();
-
-    // ────────────────────────────────────────────────────────────────────────
-    // Send Alert Message (If Object Detected and Alert Interval Reached)
-    // ────────────────────────────────────────────────────────────────────────
-    if (isObjectDetected() && isAlertDue()) {
-        Serial.println("[MAIN] Alert triggered by object detection!");
-
-        // Get sensor data
-        float distance = getDetectedDistance();
-        unsigned long duration = getDetectionDuration();
-        String timestamp = getFirstDetectionTimestamp();
-
-        // Send alert message with sensor data
-        if (sendAlert(distance, duration, timestamp)) {
-            Serial.println("[MAIN] Alert message sent successfully");
-            markAlertSent();  // Update timer for next alert
-        } else {
-            Serial.println("[MAIN] Alert message failed");
-        }
-    }
-    
-    // ────────────────────────────────────────────────────────────────────────
-    // Check if Heartbeat is Due (Automatic Status Update)
-    // ────────────────────────────────────────────────────────────────────────
-    // Note: Skip heartbeat when actively detecting - alerts contain all status info
-    if (isHeartbeatDue() && !isObjectDetected()) {
-        Serial.println("[MAIN] Heartbeat interval reached");
-
-        // Send heartbeat message
-        if (sendHeartbeat()) {
-            Serial.println("[MAIN] Heartbeat sent successfully");
-        } else {
-            Serial.println("[MAIN] Heartbeat failed");
-        }
-    }
-    
-    // Small delay to prevent CPU hogging
-    delay(10);
+    // Lowest free heap since boot and fragmentation for the next heartbeat
+    sampleMemory();
 }
\ No newline at end of file
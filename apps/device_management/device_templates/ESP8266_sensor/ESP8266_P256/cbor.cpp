@@ -0,0 +1,121 @@
+#include "config.h"
+#include "cbor.h"
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+// CBOR major types (high 3 bits of the initial byte)
+static const uint8_t CBOR_MAJOR_UNSIGNED = 0;
+static const uint8_t CBOR_MAJOR_NEGATIVE = 1;
+static const uint8_t CBOR_MAJOR_TEXT = 3;
+static const uint8_t CBOR_MAJOR_ARRAY = 4;
+static const uint8_t CBOR_MAJOR_MAP = 5;
+static const uint8_t CBOR_MAJOR_TAG = 6;
+static const uint8_t CBOR_MAJOR_SIMPLE = 7;
+
+// Simple values (major type 7)
+static const uint8_t CBOR_SIMPLE_FALSE = 20;
+static const uint8_t CBOR_SIMPLE_TRUE = 21;
+
+/**
+ * Append raw bytes to the output buffer
+ *
+ * @param writer Output writer
+ * @param data Bytes to append
+ * @param length Number of bytes
+ */
+static void writeBytes(CborWriter& writer, const uint8_t* data, size_t length) {
+    if (writer.overflowed || writer.length + length > writer.size) {
+        writer.overflowed = true;
+        return;
+    }
+    memcpy(writer.buffer + writer.length, data, length);
+    writer.length += length;
+    if (writer.digest != nullptr) {
+        updateMessageDigest(*writer.digest, data, length);
+    }
+}
+
+/**
+ * Write an initial byte with its argument in the shortest form
+ * (0-23 inline, then 1, 2 or 4 big-endian bytes)
+ *
+ * @param writer Output writer
+ * @param major CBOR major type
+ * @param argument Value, length or count for the item
+ */
+static void writeHead(CborWriter& writer, uint8_t major, uint32_t argument) {
+    uint8_t head[5];
+    size_t headLength;
+
+    if (argument < 24) {
+        head[0] = (major << 5) | (uint8_t)argument;
+        headLength = 1;
+    } else if (argument <= 0xFF) {
+        head[0] = (major << 5) | 24;
+        head[1] = (uint8_t)argument;
+        headLength = 2;
+    } else if (argument <= 0xFFFF) {
+        head[0] = (major << 5) | 25;
+        head[1] = (uint8_t)(argument >> 8);
+        head[2] = (uint8_t)argument;
+        headLength = 3;
+    } else {
+        head[0] = (major << 5) | 26;
+        head[1] = (uint8_t)(argument >> 24);
+        head[2] = (uint8_t)(argument >> 16);
+        head[3] = (uint8_t)(argument >> 8);
+        head[4] = (uint8_t)argument;
+        headLength = 5;
+    }
+
+    writeBytes(writer, head, headLength);
+}
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+void cborBegin(CborWriter& writer, uint8_t* buffer, size_t size, MessageDigestContext* digest) {
+    writer.buffer = buffer;
+    writer.size = size;
+    writer.length = 0;
+    writer.overflowed = false;
+    writer.digest = digest;
+}
+
+void cborWriteUnsigned(CborWriter& writer, uint32_t value) {
+    writeHead(writer, CBOR_MAJOR_UNSIGNED, value);
+}
+
+void cborWriteSigned(CborWriter& writer, int32_t value) {
+    if (value >= 0) {
+        writeHead(writer, CBOR_MAJOR_UNSIGNED, (uint32_t)value);
+    } else {
+        // Negative integers are encoded as -1 - n
+        writeHead(writer, CBOR_MAJOR_NEGATIVE, (uint32_t)(-1 - value));
+    }
+}
+
+void cborWriteText(CborWriter& writer, const char* text) {
+    size_t length = strlen(text);
+    writeHead(writer, CBOR_MAJOR_TEXT, (uint32_t)length);
+    writeBytes(writer, (const uint8_t*)text, length);
+}
+
+void cborWriteArrayHeader(CborWriter& writer, uint32_t count) {
+    writeHead(writer, CBOR_MAJOR_ARRAY, count);
+}
+
+void cborWriteMapHeader(CborWriter& writer, uint32_t pairs) {
+    writeHead(writer, CBOR_MAJOR_MAP, pairs);
+}
+
+void cborWriteTag(CborWriter& writer, uint32_t tag) {
+    writeHead(writer, CBOR_MAJOR_TAG, tag);
+}
+
+void cborWriteBool(CborWriter& writer, bool value) {
+    writeHead(writer, CBOR_MAJOR_SIMPLE, value ? CBOR_SIMPLE_TRUE : CBOR_SIMPLE_FALSE);
+}
@@ -0,0 +1,150 @@
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "crypto.h"
+
+// ============================================================================
+// CBOR MODULE
+// ============================================================================
+// This module handles:
+// - Encoding messages in CBOR (RFC 8949) - a compact binary alternative to JSON
+// - Writing straight into a caller-provided buffer (no heap allocation)
+// - Optionally hashing the bytes as they are written (for signing)
+//
+// Wire format is selected with MESSAGE_WIRE_FORMAT in config.h.
+// Message schema (must match apps/data_processing/cbor.py on the server):
+//   tag CBOR_SCHEMA_TAG( map {
+//     0: schema version, 1: device_id, 2: message_type (0 heartbeat, 1 alert),
+//     3: timestamp (epoch seconds), 4: data map
+//   })
+//   Data maps (both types): 0 time_synced (only sent as false, while unsynced)
+//   Heartbeat data: 1 status (1 = online), 2 uptime, 3 wifi_rssi, 4 free_memory,
+//                   5 power_mode (POWER_MODE value), 6 energy (mWh per hour),
+//                   7 performance (map ProfilePoint → [n, min, avg, max, p99] us),
+//                   8 memory ([min free heap, largest free block, fragmentation %,
+//                     min free stack], see memstats.h)
+//   Alert data:     1 event (1 = ultrasonic), 2 sensor_type (1 = HC-SR04),
+//                   3 distance (mm), 4 duration (s), 5 first detected (epoch s),
+//                   6 confidence (%), 7 per-sensor distances (array, mm,
+//                   0 = no echo - only sent with SENSOR_COUNT > 1),
+//                   8 detection state (1 opened, 2 update, 3 closed),
+//                   9 closest distance (mm, closed only)
+//                   Opened sends 1-6, update 3-4, closed 4, 5 and 9.
+// ============================================================================
+
+// Wire formats for MESSAGE_WIRE_FORMAT
+#define WIRE_FORMAT_JSON 0
+#define WIRE_FORMAT_CBOR 1
+
+#ifndef MESSAGE_WIRE_FORMAT
+#define MESSAGE_WIRE_FORMAT WIRE_FORMAT_JSON
+#endif
+
+// Schema identification
+#define CBOR_SCHEMA_TAG 50133
+#define CBOR_SCHEMA_VERSION 1
+
+// Top-level map keys
+#define CBOR_KEY_SCHEMA_VERSION 0
+#define CBOR_KEY_DEVICE_ID 1
+#define CBOR_KEY_MESSAGE_TYPE 2
+#define CBOR_KEY_TIMESTAMP 3
+#define CBOR_KEY_DATA 4
+
+// Data key shared by all message types
+#define CBOR_KEY_TIME_SYNCED 0
+
+// Heartbeat data keys
+#define CBOR_KEY_STATUS 1
+#define CBOR_KEY_UPTIME 2
+#define CBOR_KEY_WIFI_RSSI 3
+#define CBOR_KEY_FREE_MEMORY 4
+#define CBOR_KEY_POWER_MODE 5
+#define CBOR_KEY_ESTIMATED_ENERGY_MWH_PER_HOUR 6
+#define CBOR_KEY_PERFORMANCE 7
+#define CBOR_KEY_MEMORY 8
+#define CBOR_KEY_FIRMWARE_VERSION 9
+
+// Alert data keys
+#define CBOR_KEY_EVENT 1
+#define CBOR_KEY_SENSOR_TYPE 2
+#define CBOR_KEY_DISTANCE_MM 3
+#define CBOR_KEY_DURATION_SECONDS 4
+#define CBOR_KEY_FIRST_DETECTED_AT 5
+#define CBOR_KEY_CONFIDENCE 6
+#define CBOR_KEY_SENSOR_READINGS_MM 7
+#define CBOR_KEY_DETECTION_STATE 8
+#define CBOR_KEY_CLOSEST_DISTANCE_MM 9
+
+// Enumerated values
+#define CBOR_MESSAGE_TYPE_HEARTBEAT 0
+#define CBOR_MESSAGE_TYPE_ALERT 1
+#define CBOR_STATUS_ONLINE 1
+#define CBOR_EVENT_ULTRASONIC_DETECTION 1
+#define CBOR_SENSOR_HC_SR04 1
+
+/**
+ * CBOR output buffer
+ * All write functions stop writing once the buffer is full and set
+ * overflowed, so encoding can be checked once at the end.
+ */
+struct CborWriter {
+    uint8_t* buffer;
+    size_t size;
+    size_t length;
+    bool overflowed;
+    MessageDigestContext* digest;  // Fed with every byte written (nullptr = no hashing)
+};
+
+/**
+ * Start encoding into a buffer
+ *
+ * @param writer Writer to initialize
+ * @param buffer Output buffer
+ * @param size Size of output buffer in bytes
+ * @param digest Digest context to feed with the output (optional)
+ */
+void cborBegin(CborWriter& writer, uint8_t* buffer, size_t size, MessageDigestContext* digest = nullptr);
+
+/**
+ * Write an unsigned integer (major type 0)
+ */
+void cborWriteUnsigned(CborWriter& writer, uint32_t value);
+
+/**
+ * Write a signed integer (major type 0 or 1)
+ */
+void cborWriteSigned(CborWriter& writer, int32_t value);
+
+/**
+ * Write a UTF-8 text string (major type 3)
+ */
+void cborWriteText(CborWriter& writer, const char* text);
+
+/**
+ * Write an array header (major type 4) - items follow
+ *
+ * @param count Number of items in the array
+ */
+void cborWriteArrayHeader(CborWriter& writer, uint32_t count);
+
+/**
+ * Write a map header (major type 5) - key/value pairs follow
+ *
+ * @param pairs Number of key/value pairs in the map
+ */
+void cborWriteMapHeader(CborWriter& writer, uint32_t pairs);
+
+/**
+ * Write a tag (major type 6) - the tagged item follows
+ */
+void cborWriteTag(CborWriter& writer, uint32_t tag);
+
+/**
+ * Write a boolean (major type 7, simple value false/true)
+ */
+void cborWriteBool(CborWriter& writer, bool value);
+
+#endif // CBOR_H
@@ -0,0 +1,164 @@
+#include "config.h"
+#include "credentials.h"
+#include "logging.h"
+#include <EEPROM.h>
+
+// ============================================================================
+// RECORD LAYOUT
+// ============================================================================
+
+static const uint32_t CREDENTIALS_MAGIC = 0xC3D5C7ED;
+
+/**
+ * Credentials sector contents
+ * Unused string bytes are zero, so the checksum covers the whole record.
+ */
+struct CredentialsRecord {
+    uint32_t magic;
+    uint32_t length;                // sizeof(DeviceCredentials) - detects a changed layout
+    uint32_t checksum;              // FNV-1a over credentials
+    DeviceCredentials credentials;
+};
+
+// The core's EEPROM emulation is one flash sector
+static_assert(sizeof(CredentialsRecord) <= 4096, "Credentials record exceeds the EEPROM sector");
+
+#if CREDENTIALS_EMBEDDED
+static_assert(sizeof(ECDSA_PRIVATE_KEY) == CREDENTIALS_PRIVATE_KEY_SIZE, "ECDSA_PRIVATE_KEY must be 32 bytes");
+#endif
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static CredentialsRecord record;
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+/**
+ * Compute the integrity checksum of a record
+ *
+ * @param credentials Credentials to checksum
+ * @return 32-bit FNV-1a hash
+ */
+static uint32_t computeChecksum(const DeviceCredentials& credentials) {
+    const uint8_t* bytes = (const uint8_t*)&credentials;
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < sizeof(credentials); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * Check that the loaded record is intact
+ *
+ * @return true if the sector held valid credentials
+ */
+static bool isRecordValid() {
+    return record.magic == CREDENTIALS_MAGIC &&
+           record.length == sizeof(DeviceCredentials) &&
+           record.checksum == computeChecksum(record.credentials);
+}
+
+#if CREDENTIALS_EMBEDDED
+/**
+ * Check whether the loaded credentials are the ones in config.h
+ *
+ * @return true if every field matches
+ */
+static bool matchesEmbeddedCredentials() {
+    const DeviceCredentials& credentials = record.credentials;
+    return strcmp(credentials.deviceId, DEVICE_ID) == 0 &&
+           strcmp(credentials.wifiSsid, WIFI_SSID) == 0 &&
+           strcmp(credentials.wifiPassword, WIFI_PASSWORD) == 0 &&
+           strcmp(credentials.certificateB64, DEVICE_CERTIFICATE_B64) == 0 &&
+           memcmp(credentials.privateKey, ECDSA_PRIVATE_KEY, sizeof(credentials.privateKey)) == 0;
+}
+
+/**
+ * Copy a config.h string into a credentials field
+ *
+ * @param field Destination field
+ * @param size Field size in bytes
+ * @param value String to copy
+ * @return true if it fits, false if it would be truncated
+ */
+static bool copyField(char* field, size_t size, const char* value) {
+    return strlcpy(field, value, size) < size;
+}
+
+/**
+ * Replace the loaded record with the credentials in config.h
+ *
+ * @return true on success, false if a value does not fit its field
+ */
+static bool loadEmbeddedCredentials() {
+    DeviceCredentials& credentials = record.credentials;
+    memset(&credentials, 0, sizeof(credentials));
+
+    bool fits = copyField(credentials.deviceId, sizeof(credentials.deviceId), DEVICE_ID) &&
+                copyField(credentials.wifiSsid, sizeof(credentials.wifiSsid), WIFI_SSID) &&
+                copyField(credentials.wifiPassword, sizeof(credentials.wifiPassword), WIFI_PASSWORD) &&
+                copyField(credentials.certificateB64, sizeof(credentials.certificateB64), DEVICE_CERTIFICATE_B64);
+    if (!fits) {
+        return false;
+    }
+    memcpy(credentials.privateKey, ECDSA_PRIVATE_KEY, sizeof(credentials.privateKey));
+
+    record.magic = CREDENTIALS_MAGIC;
+    record.length = sizeof(DeviceCredentials);
+    record.checksum = computeChecksum(credentials);
+    return true;
+}
+#endif
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+bool initializeCredentials() {
+    LOG_INFO("[CRED] Loading device credentials...");
+
+    // The EEPROM library keeps a RAM copy of the sector until end()
+    EEPROM.begin(sizeof(CredentialsRecord));
+    EEPROM.get(0, record);
+    bool valid = isRecordValid();
+
+#if CREDENTIALS_EMBEDDED
+    // Provision the sector once - later boots find the same values there
+    if (!valid || !matchesEmbeddedCredentials()) {
+        if (!loadEmbeddedCredentials()) {
+            LOG_ERROR("[CRED] Credentials in config.h do not fit the credentials sector");
+            EEPROM.end();
+            return false;
+        }
+
+        EEPROM.put(0, record);
+        if (EEPROM.commit()) {
+            LOG_INFO("[CRED] Credentials from config.h written to flash");
+        } else {
+            LOG_ERROR("[CRED] Writing credentials to flash failed - using config.h values");
+        }
+        valid = true;
+    }
+#endif
+
+    EEPROM.end();
+
+    if (!valid) {
+        LOG_ERROR("[CRED] No credentials in flash - upload the code bundle from the portal over USB once");
+        return false;
+    }
+
+    LOG_INFO("[CRED] Credentials loaded (%u certificate bytes)",
+             (unsigned int)strlen(record.credentials.certificateB64));
+    return true;
+}
+
+const DeviceCredentials& getCredentials() {
+    return record.credentials;
+}
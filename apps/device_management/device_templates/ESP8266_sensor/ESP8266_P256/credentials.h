@@ -0,0 +1,58 @@
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// CREDENTIALS MODULE
+// ============================================================================
+// This module handles:
+// - The per-device values (device ID, WiFi, certificate, private key) kept
+//   in the credentials sector of the flash (the core's EEPROM sector)
+// - Provisioning that sector from the values compiled into config.h
+//   (CREDENTIALS_EMBEDDED 1, the code bundle downloaded from the portal)
+//
+// The sector lies outside the sketch, so it survives sketch uploads and OTA
+// updates. OTA images are built with CREDENTIALS_EMBEDDED 0 and carry no
+// credentials - one image serves every device.
+// ============================================================================
+
+// Field sizes are part of the stored layout: changing one invalidates the
+// credentials of every provisioned device (they must be flashed over USB again)
+#define CREDENTIALS_DEVICE_ID_SIZE 37             // UUID + null terminator
+#define CREDENTIALS_WIFI_SSID_SIZE 33             // 32-byte SSID + null terminator
+#define CREDENTIALS_WIFI_PASSWORD_SIZE 65         // 64-character PSK + null terminator
+#define CREDENTIALS_CERTIFICATE_SIZE 2048         // Base64 PEM certificate (~1.8 KB with an RSA-4096 CA) + null terminator
+#define CREDENTIALS_PRIVATE_KEY_SIZE 32           // ECDSA P-256 private key
+
+/**
+ * Per-device values (strings are null-terminated)
+ */
+struct DeviceCredentials {
+    char deviceId[CREDENTIALS_DEVICE_ID_SIZE];
+    char wifiSsid[CREDENTIALS_WIFI_SSID_SIZE];
+    char wifiPassword[CREDENTIALS_WIFI_PASSWORD_SIZE];
+    char certificateB64[CREDENTIALS_CERTIFICATE_SIZE];         // Sent in X-Device-Certificate
+    uint8_t privateKey[CREDENTIALS_PRIVATE_KEY_SIZE];
+};
+
+/**
+ * Load the credentials from the credentials sector
+ * With CREDENTIALS_EMBEDDED, the config.h values are written to the sector
+ * first if it does not hold them yet (first boot after a USB upload).
+ * Call before anything that uses getCredentials().
+ *
+ * @return true if valid credentials are available, false otherwise
+ */
+bool initializeCredentials();
+
+/**
+ * Get the device credentials
+ * Only valid after initializeCredentials() returned true.
+ *
+ * @return Credentials loaded at boot
+ */
+const DeviceCredentials& getCredentials();
+
+#endif // CREDENTIALS_H
@@ -1,12 +1,10 @@
 #include "config.h"
 #include "crypto.h"
+#include "credentials.h"
+#include "profiling.h"
+#include "logging.h"
 #include <uECC.h>
 
-// BearSSL for SHA-256 hashing (ESP8266 built-in)
-extern "C" {
-    #include "bearssl/bearssl_hash.h"
-}
-
 // ============================================================================
 // INTERNAL STATE VARIABLES
 // ============================================================================
@@ -94,43 +92,43 @@ static size_t encodeSignatureToDER(const uint8_t* raw_sig, uint8_t* der_sig) {
 // BASE64 ENCODING
 // ============================================================================
 
-String base64Encode(const uint8_t* data, size_t length) {
-    String encoded;
-    int i = 0;
-    int j = 0;
-    uint8_t char_array_3[3];
-    uint8_t char_array_4[4];
-
-    while (length--) {
-        char_array_3[i++] = *(data++);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for(i = 0; i < 4; i++)
-                encoded += base64_chars[char_array_4[i]];
-            i = 0;
+size_t base64Encode(const uint8_t* data, size_t length, char* output, size_t outputSize) {
+    // Every 3 input bytes become 4 output characters (padded), plus null terminator
+    size_t encodedLength = 4 * ((length + 2) / 3);
+    if (outputSize < encodedLength + 1) {
+        if (outputSize > 0) {
+            output[0] = '\0';
         }
+        return 0;
     }
 
-    if (i) {
-        for(j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+    size_t out = 0;
+    size_t i = 0;
 
-        for (j = 0; j < i + 1; j++)
-            encoded += base64_chars[char_array_4[j]];
+    // Full 3-byte groups
+    for (; i + 2 < length; i += 3) {
+        uint32_t triple = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+        output[out++] = base64_chars[(triple >> 18) & 0x3f];
+        output[out++] = base64_chars[(triple >> 12) & 0x3f];
+        output[out++] = base64_chars[(triple >> 6) & 0x3f];
+        output[out++] = base64_chars[triple & 0x3f];
+    }
 
-        while(i++ < 3)
-            encoded += '=';
+    // Remaining 1 or 2 bytes with '=' padding
+    size_t remaining = length - i;
+    if (remaining > 0) {
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (remaining == 2) {
+            triple |= (uint32_t)data[i + 1] << 8;
+        }
+        output[out++] = base64_chars[(triple >> 18) & 0x3f];
+        output[out++] = base64_chars[(triple >> 12) & 0x3f];
+        output[out++] = (remaining == 2) ? base64_chars[(triple >> 6) & 0x3f] : '=';
+        output[out++] = '=';
     }
 
-    return encoded;
+    output[out] = '\0';
+    return out;
 }
 
 // ============================================================================
@@ -151,44 +149,281 @@ static int RNG(uint8_t *dest, unsigned size) {
     return 1;  // Success
 }
 
+// ============================================================================
+// ARITHMETIC MODULO THE CURVE ORDER
+// ============================================================================
+// 256-bit scalars as 8 little-endian 32-bit words. Only what the precomputed
+// signing path needs: s = k⁻¹ · (z + r · d) mod n.
+
+#define SCALAR_WORDS 8
+
+// P-256 group order n (least significant word first)
+static const uint32_t curveOrder[SCALAR_WORDS] = {
+    0xFC632551, 0xF3B9CAC2, 0xA7179E84, 0xBCE6FAAD,
+    0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0xFFFFFFFF
+};
+
+// -n⁻¹ mod 2^32 (Montgomery reduction constant)
+static const uint32_t curveOrderInverse = 0xEE00BC4F;
+
+// R² mod n with R = 2^256 (converts into the Montgomery domain)
+static const uint32_t curveOrderRR[SCALAR_WORDS] = {
+    0xBE79EEA2, 0x83244C95, 0x49BD6FA6, 0x4699799C,
+    0x2B6BEC59, 0x2845B239, 0xF3D95620, 0x66E12D94
+};
+
+/**
+ * Load a big-endian 32-byte value (uECC byte order) into a scalar
+ */
+static void scalarFromBytes(const uint8_t* bytes, uint32_t* scalar) {
+    for (int i = 0; i < SCALAR_WORDS; i++) {
+        const uint8_t* word = bytes + (SCALAR_WORDS - 1 - i) * 4;
+        scalar[i] = ((uint32_t)word[0] << 24) | ((uint32_t)word[1] << 16) |
+                    ((uint32_t)word[2] << 8) | word[3];
+    }
+}
+
+/**
+ * Store a scalar as a big-endian 32-byte value (uECC byte order)
+ */
+static void scalarToBytes(const uint32_t* scalar, uint8_t* bytes) {
+    for (int i = 0; i < SCALAR_WORDS; i++) {
+        uint8_t* word = bytes + (SCALAR_WORDS - 1 - i) * 4;
+        word[0] = (uint8_t)(scalar[i] >> 24);
+        word[1] = (uint8_t)(scalar[i] >> 16);
+        word[2] = (uint8_t)(scalar[i] >> 8);
+        word[3] = (uint8_t)scalar[i];
+    }
+}
+
+static bool scalarIsZero(const uint32_t* scalar) {
+    uint32_t bits = 0;
+    for (int i = 0; i < SCALAR_WORDS; i++) {
+        bits |= scalar[i];
+    }
+    return bits == 0;
+}
+
+/**
+ * out = a - b
+ *
+ * @return Borrow (1 if a < b)
+ */
+static uint32_t scalarSubtract(const uint32_t* a, const uint32_t* b, uint32_t* out) {
+    uint32_t borrow = 0;
+    for (int i = 0; i < SCALAR_WORDS; i++) {
+        uint64_t diff = (uint64_t)a[i] - b[i] - borrow;
+        out[i] = (uint32_t)diff;
+        borrow = (uint32_t)(diff >> 32) & 1;
+    }
+    return borrow;
+}
+
+/**
+ * Reduce a value below 2^256 modulo n (n > 2^255, so one subtraction)
+ */
+static void scalarReduce(uint32_t* scalar) {
+    uint32_t reduced[SCALAR_WORDS];
+    if (scalarSubtract(scalar, curveOrder, reduced) == 0) {
+        memcpy(scalar, reduced, sizeof(reduced));
+    }
+}
+
+/**
+ * out = (a + b) mod n, for a, b < n
+ */
+static void scalarAddMod(const uint32_t* a, const uint32_t* b, uint32_t* out) {
+    uint32_t carry = 0;
+    for (int i = 0; i < SCALAR_WORDS; i++) {
+        uint64_t sum = (uint64_t)a[i] + b[i] + carry;
+        out[i] = (uint32_t)sum;
+        carry = (uint32_t)(sum >> 32);
+    }
+
+    uint32_t reduced[SCALAR_WORDS];
+    uint32_t borrow = scalarSubtract(out, curveOrder, reduced);
+    if (carry || !borrow) {
+        memcpy(out, reduced, sizeof(reduced));
+    }
+}
+
+/**
+ * Montgomery multiplication: out = a · b · R⁻¹ mod n, for a, b < n
+ * (word-by-word CIOS; out may alias a or b)
+ */
+static void montgomeryMultiply(const uint32_t* a, const uint32_t* b, uint32_t* out) {
+    uint32_t t[SCALAR_WORDS + 2] = {0};
+
+    for (int i = 0; i < SCALAR_WORDS; i++) {
+        // t += a · b[i]
+        uint64_t carry = 0;
+        for (int j = 0; j < SCALAR_WORDS; j++) {
+            carry += (uint64_t)a[j] * b[i] + t[j];
+            t[j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        carry += t[SCALAR_WORDS];
+        t[SCALAR_WORDS] = (uint32_t)carry;
+        t[SCALAR_WORDS + 1] = (uint32_t)(carry >> 32);
+
+        // t = (t + m · n) / 2^32, with m chosen so the low word cancels
+        uint32_t m = t[0] * curveOrderInverse;
+        carry = ((uint64_t)m * curveOrder[0] + t[0]) >> 32;
+        for (int j = 1; j < SCALAR_WORDS; j++) {
+            carry += (uint64_t)m * curveOrder[j] + t[j];
+            t[j - 1] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        carry += t[SCALAR_WORDS];
+        t[SCALAR_WORDS - 1] = (uint32_t)carry;
+        t[SCALAR_WORDS] = t[SCALAR_WORDS + 1] + (uint32_t)(carry >> 32);
+    }
+
+    // t < 2n here
+    uint32_t reduced[SCALAR_WORDS];
+    uint32_t borrow = scalarSubtract(t, curveOrder, reduced);
+    memcpy(out, (t[SCALAR_WORDS] || !borrow) ? reduced : t, sizeof(reduced));
+}
+
+/**
+ * out = (a · b) mod n, for a, b < n
+ */
+static void scalarMultiplyMod(const uint32_t* a, const uint32_t* b, uint32_t* out) {
+    uint32_t product[SCALAR_WORDS];
+    montgomeryMultiply(a, b, product);              // a · b · R⁻¹
+    montgomeryMultiply(product, curveOrderRR, out); // · R² · R⁻¹
+}
+
+/**
+ * out = a⁻¹ mod n, for 0 < a < n (Fermat: a^(n-2); about 400 multiplications,
+ * only done while precomputing)
+ */
+static void scalarInvertMod(const uint32_t* a, uint32_t* out) {
+    uint32_t base[SCALAR_WORDS];
+    uint32_t result[SCALAR_WORDS];
+    uint32_t one[SCALAR_WORDS] = {1};
+
+    montgomeryMultiply(a, curveOrderRR, base);      // a · R
+    montgomeryMultiply(curveOrderRR, one, result);  // 1 · R
+
+    // Exponent n - 2 (the low word of n does not borrow)
+    uint32_t exponent[SCALAR_WORDS];
+    memcpy(exponent, curveOrder, sizeof(exponent));
+    exponent[0] -= 2;
+
+    for (int bit = SCALAR_WORDS * 32 - 1; bit >= 0; bit--) {
+        montgomeryMultiply(result, result, result);
+        if ((exponent[bit / 32] >> (bit % 32)) & 1) {
+            montgomeryMultiply(result, base, result);
+        }
+    }
+
+    montgomeryMultiply(result, one, out);           // Leave the Montgomery domain
+    memset(base, 0, sizeof(base));
+    memset(result, 0, sizeof(result));
+}
+
+// ============================================================================
+// NONCE POOL (PRECOMPUTED SIGNING MATERIAL)
+// ============================================================================
+// An ECDSA signature is r = x(k·G) mod n, s = k⁻¹ · (z + r · d) mod n.
+// The scalar multiplication k·G is the slow part and does not depend on the
+// message, so it is done ahead of time with a fresh random k; signing then
+// only takes the three modular operations above.
+//
+// k comes from the hardware RNG, not RFC 6979: a deterministic nonce is
+// derived from the message hash, which is not known while precomputing.
+// Every entry is used for exactly one signature and wiped afterwards -
+// reusing a nonce would reveal the private key.
+
+struct NoncePoolEntry {
+    uint32_t r[SCALAR_WORDS];         // x(k·G) mod n
+    uint32_t kInverse[SCALAR_WORDS];  // k⁻¹ mod n
+};
+
+static NoncePoolEntry noncePool[NONCE_POOL_SIZE];
+static uint8_t noncePoolCount = 0;
+static bool noncePoolEnabled = true;  // Cleared if the self-test fails
+
+/**
+ * Sign with the full uECC_sign() (scalar multiplication inline)
+ *
+ * @param digest SHA-256 digest
+ * @param signature Output: raw signature r || s (64 bytes)
+ * @return true on success
+ */
+static bool signDigestCold(const uint8_t* digest, uint8_t* signature) {
+    return uECC_sign(getCredentials().privateKey, digest, MESSAGE_DIGEST_SIZE, signature, curve) != 0;
+}
+
+/**
+ * Sign using (and consuming) a precomputed nonce
+ *
+ * @param digest SHA-256 digest
+ * @param signature Output: raw signature r || s (64 bytes)
+ * @return true on success, false if the pool is empty
+ */
+static bool signDigestWarm(const uint8_t* digest, uint8_t* signature) {
+    if (!noncePoolEnabled || noncePoolCount == 0) {
+        return false;
+    }
+
+    NoncePoolEntry& entry = noncePool[--noncePoolCount];
+
+    uint32_t z[SCALAR_WORDS];
+    uint32_t d[SCALAR_WORDS];
+    uint32_t s[SCALAR_WORDS];
+
+    // z = digest as an integer mod n (a 256-bit hash needs no truncation)
+    scalarFromBytes(digest, z);
+    scalarReduce(z);
+    scalarFromBytes(getCredentials().privateKey, d);
+
+    // s = k⁻¹ · (z + r · d) mod n
+    scalarMultiplyMod(entry.r, d, s);
+    scalarAddMod(s, z, s);
+    scalarMultiplyMod(entry.kInverse, s, s);
+
+    bool ok = !scalarIsZero(s);  // Negligible, but then the nonce is unusable
+    if (ok) {
+        scalarToBytes(entry.r, signature);
+        scalarToBytes(s, signature + 32);
+    }
+
+    memset(&entry, 0, sizeof(entry));
+    memset(d, 0, sizeof(d));
+    return ok;
+}
+
 // ============================================================================
 // PUBLIC FUNCTIONS
 // ============================================================================
 
 bool initializeCrypto() {
-    Serial.println("\n[CRYPTO] ═══════════════════════════════════");
-    Serial.println("[CRYPTO] Initializing Cryptographic Module");
-    Serial.println("[CRYPTO] ═══════════════════════════════════");
+    LOG_DEBUG("\n[CRYPTO] ═══════════════════════════════════");
+    LOG_INFO("[CRYPTO] Initializing Cryptographic Module");
+    LOG_DEBUG("[CRYPTO] ═══════════════════════════════════");
     
     // Set the curve to P-256 (secp256r1)
     curve = uECC_secp256r1();
     
     if (curve == NULL) {
-        Serial.println("[CRYPTO] Failed to initialize curve!");
+        LOG_ERROR("[CRYPTO] Failed to initialize curve!");
         cryptoReady = false;
         return false;
     }
     
-    Serial.println("[CRYPTO] Curve: NIST P-256 (secp256r1)");
+    LOG_INFO("[CRYPTO] Curve: NIST P-256 (secp256r1)");
     
     // Set random number generator
     uECC_set_rng(&RNG);
-    Serial.println("[CRYPTO] RNG initialized (ESP8266 hardware RNG)");
+    LOG_INFO("[CRYPTO] RNG initialized (ESP8266 hardware RNG)");
     
-    // Verify private key length
-    Serial.print("[CRYPTO] Private key size: ");
-    Serial.print(sizeof(ECDSA_PRIVATE_KEY));
-    Serial.println(" bytes");
+    // Private key comes from the credentials sector (fixed 32-byte field)
+    LOG_DEBUG("[CRYPTO] Private key size: %u bytes", (unsigned int)sizeof(getCredentials().privateKey));
     
-    if (sizeof(ECDSA_PRIVATE_KEY) != 32) {
-        Serial.println("[CRYPTO] Invalid private key size! Expected 32 bytes.");
-        cryptoReady = false;
-        return false;
-    }
-    
-    Serial.println("[CRYPTO] Private key validated");
-    Serial.println("[CRYPTO] Cryptographic module ready");
-    Serial.println("[CRYPTO] ═══════════════════════════════════\n");
+    LOG_INFO("[CRYPTO] Cryptographic module ready");
+    LOG_DEBUG("[CRYPTO] ═══════════════════════════════════\n");
     
     cryptoReady = true;
     return true;
@@ -198,82 +433,207 @@ bool isCryptoReady() {
     return cryptoReady;
 }
 
-String signMessage(const String& message) {
+bool signMessage(const char* message, size_t messageLength, char* signatureOut, size_t signatureSize) {
+    return signMessageSegments(&message, &messageLength, 1, signatureOut, signatureSize);
+}
+
+void beginMessageDigest(MessageDigestContext& context) {
+    br_sha256_init(&context.sha);
+    context.hashCycles = 0;
+}
+
+void updateMessageDigest(MessageDigestContext& context, const void* data, size_t length) {
+    // Hashing is interleaved with serialization - time only the hash itself
+    uint32_t start = profileStart();
+    br_sha256_update(&context.sha, data, length);
+    context.hashCycles += ESP.getCycleCount() - start;
+}
+
+void finishMessageDigest(MessageDigestContext& context, uint8_t* digest) {
+    uint32_t start = profileStart();
+    br_sha256_out(&context.sha, digest);
+    context.hashCycles += ESP.getCycleCount() - start;
+
+    profileRecordCycles(PROFILE_SHA256, context.hashCycles);
+}
+
+bool signMessageSegments(const char* const* segments, const size_t* segmentLengths, size_t segmentCount,
+                         char* signatureOut, size_t signatureSize) {
+    if (signatureSize > 0) {
+        signatureOut[0] = '\0';
+    }
+
     if (!cryptoReady) {
-        Serial.println("[CRYPTO] Crypto not initialized!");
-        return "";
+        LOG_ERROR("[CRYPTO] Crypto not initialized!");
+        return false;
     }
     
-    Serial.println("\n[CRYPTO] ───────────────────────────────────");
-    Serial.println("[CRYPTO] Signing Message");
-    Serial.println("[CRYPTO] ───────────────────────────────────");
-    
-    // Step 1: Compute SHA-256 hash of the message
-    Serial.println("[CRYPTO] Step 1: Computing SHA-256 hash...");
-    
-    uint8_t hash[32];  // SHA-256 produces 32-byte hash
+    // Compute SHA-256 hash of the message (segments hashed in order)
+    uint8_t hash[MESSAGE_DIGEST_SIZE];
+    size_t messageLength = 0;
     
     // Use ESP8266's built-in SHA256 from BearSSL
-    br_sha256_context sha_ctx;
-    br_sha256_init(&sha_ctx);
-    br_sha256_update(&sha_ctx, message.c_str(), message.length());
-    br_sha256_out(&sha_ctx, hash);
+    MessageDigestContext sha_ctx;
+    beginMessageDigest(sha_ctx);
+    for (size_t i = 0; i < segmentCount; i++) {
+        updateMessageDigest(sha_ctx, segments[i], segmentLengths[i]);
+        messageLength += segmentLengths[i];
+    }
+    finishMessageDigest(sha_ctx, hash);
     
-    Serial.print("[CRYPTO] Message length: ");
-    Serial.print(message.length());
-    Serial.println(" bytes");
+    LOG_DEBUG("[CRYPTO] SHA-256 over %u bytes", (unsigned int)messageLength);
     
-    Serial.print("[CRYPTO] Hash (first 16 bytes): ");
-    for (int i = 0; i < 16; i++) {
-        if (hash[i] < 0x10) Serial.print("0");
-        Serial.print(hash[i], HEX);
+    return signDigest(hash, signatureOut, signatureSize);
+}
+
+bool signDigest(const uint8_t* digest, char* signatureOut, size_t signatureSize) {
+    if (signatureSize > 0) {
+        signatureOut[0] = '\0';
     }
-    Serial.println("...");
+
+    if (!cryptoReady) {
+        LOG_ERROR("[CRYPTO] Crypto not initialized!");
+        return false;
+    }
+    
+    LOG_DEBUG("\n[CRYPTO] ───────────────────────────────────");
+    LOG_DEBUG("[CRYPTO] Signing Message");
+    LOG_DEBUG("[CRYPTO] ───────────────────────────────────");
+    
+    // Step 1: SHA-256 hash of the message (computed by the caller)
+    LOG_DEBUG_HEX("[CRYPTO] Step 1: Hash (first 16 bytes): ", digest, 16);
     
     // Step 2: Sign the hash with ECDSA
-    Serial.println("[CRYPTO] Step 2: Signing hash with ECDSA...");
+    LOG_DEBUG("[CRYPTO] Step 2: Signing hash with ECDSA...");
     
     uint8_t signature[64];  // ECDSA P-256 signature is 64 bytes (r=32, s=32)
     
-    int result = uECC_sign(ECDSA_PRIVATE_KEY, hash, sizeof(hash), signature, curve);
-    
-    if (result == 0) {
-        Serial.println("[CRYPTO] Signing failed!");
-        return "";
+    // Precomputed nonce if one is ready, full uECC_sign() otherwise
+    uint32_t signStart = profileStart();
+    bool warm = signDigestWarm(digest, signature);
+    if (!warm && !signDigestCold(digest, signature)) {
+        LOG_ERROR("[CRYPTO] Signing failed!");
+        return false;
     }
+    profileEnd(PROFILE_ECDSA_SIGN, signStart);
     
-    Serial.println("[CRYPTO] Raw signature created (64 bytes)");
+    LOG_DEBUG("[CRYPTO] Raw signature created (64 bytes, %s, %u nonces left)",
+              warm ? "precomputed nonce" : "full sign", (unsigned int)noncePoolCount);
 
     // Step 3: Convert raw signature to DER format (required by server)
-    Serial.println("[CRYPTO] Step 3: Converting to DER format...");
+    LOG_DEBUG("[CRYPTO] Step 3: Converting to DER format...");
 
+    uint32_t encodeStart = profileStart();
     uint8_t der_signature[72];  // Max DER size for P-256: 2 + 2 + 33 + 2 + 33 = 72
     size_t der_len = encodeSignatureToDER(signature, der_signature);
 
-    Serial.print("[CRYPTO] DER signature length: ");
-    Serial.print(der_len);
-    Serial.println(" bytes");
-
-    Serial.print("[CRYPTO] DER signature (first 16 bytes): ");
-    for (size_t i = 0; i < 16 && i < der_len; i++) {
-        if (der_signature[i] < 0x10) Serial.print("0");
-        Serial.print(der_signature[i], HEX);
-    }
-    Serial.println("...");
+    LOG_DEBUG("[CRYPTO] DER signature length: %u bytes", (unsigned int)der_len);
+    LOG_DEBUG_HEX("[CRYPTO] DER signature (first 16 bytes): ", der_signature, 16);
 
     // Step 4: Encode DER signature to Base64
-    Serial.println("[CRYPTO] Step 4: Encoding to Base64...");
+    LOG_DEBUG("[CRYPTO] Step 4: Encoding to Base64...");
 
-    String encodedSignature = base64Encode(der_signature, der_len);
+    size_t encodedLength = base64Encode(der_signature, der_len, signatureOut, signatureSize);
+    if (encodedLength == 0) {
+        LOG_ERROR("[CRYPTO] Signature buffer too small!");
+        return false;
+    }
+    profileEnd(PROFILE_SIGNATURE_ENCODE, encodeStart);
     
-    Serial.print("[CRYPTO] Base64 signature: ");
-    Serial.println(encodedSignature);
-    Serial.print("[CRYPTO] Base64 length: ");
-    Serial.print(encodedSignature.length());
-    Serial.println(" characters");
+    LOG_DEBUG("[CRYPTO] Base64 signature: %s", signatureOut);
+    LOG_DEBUG("[CRYPTO] Base64 length: %u characters", (unsigned int)encodedLength);
     
-    Serial.println("[CRYPTO] Signing complete");
-    Serial.println("[CRYPTO] ───────────────────────────────────\n");
+    LOG_DEBUG("[CRYPTO] Signing complete");
+    LOG_DEBUG("[CRYPTO] ───────────────────────────────────\n");
     
-    return encodedSignature;
-}
\ No newline at end of file
+    return true;
+}
+
+bool precomputeSigningNonce() {
+    if (!cryptoReady || !noncePoolEnabled || noncePoolCount >= NONCE_POOL_SIZE) {
+        return false;
+    }
+
+    uint8_t k[32];
+    uint8_t point[64];  // k·G as x || y
+
+    // uECC_compute_public_key() rejects k = 0 and k >= n - draw again
+    bool found = false;
+    for (int attempt = 0; attempt < 4 && !found; attempt++) {
+        RNG(k, sizeof(k));
+        found = uECC_compute_public_key(k, point, curve) != 0;
+    }
+    if (!found) {
+        memset(k, 0, sizeof(k));
+        LOG_ERROR("[CRYPTO] Nonce precomputation failed!");
+        return false;
+    }
+
+    NoncePoolEntry& entry = noncePool[noncePoolCount];
+    uint32_t kScalar[SCALAR_WORDS];
+
+    scalarFromBytes(point, entry.r);  // x < p < 2n: one subtraction
+    scalarReduce(entry.r);
+    scalarFromBytes(k, kScalar);
+    scalarInvertMod(kScalar, entry.kInverse);
+
+    memset(k, 0, sizeof(k));
+    memset(kScalar, 0, sizeof(kScalar));
+
+    if (scalarIsZero(entry.r)) {
+        memset(&entry, 0, sizeof(entry));
+        return false;  // Would give r = 0 - skip this nonce
+    }
+
+    noncePoolCount++;
+    LOG_DEBUG("[CRYPTO] Nonce precomputed (%u/%u ready)", (unsigned int)noncePoolCount, (unsigned int)NONCE_POOL_SIZE);
+    return true;
+}
+
+uint8_t getNoncePoolCount() {
+    return noncePoolCount;
+}
+
+bool benchmarkSigning() {
+    if (!cryptoReady) {
+        return false;
+    }
+
+    // Fixed test digest
+    static const char testMessage[] = "C3DS signing benchmark";
+    uint8_t digest[MESSAGE_DIGEST_SIZE];
+    MessageDigestContext context;
+    beginMessageDigest(context);
+    updateMessageDigest(context, testMessage, sizeof(testMessage) - 1);
+    finishMessageDigest(context, digest);
+
+    uint8_t signature[64];
+    uint8_t publicKey[64];
+
+    unsigned long start = micros();
+    bool coldOk = signDigestCold(digest, signature);
+    unsigned long coldMicros = micros() - start;
+
+    start = micros();
+    bool precomputed = precomputeSigningNonce();
+    unsigned long precomputeMicros = micros() - start;
+
+    start = micros();
+    bool warmOk = precomputed && signDigestWarm(digest, signature);
+    unsigned long warmMicros = micros() - start;
+
+    // Self-test: the precomputed path must produce a valid signature
+    if (!coldOk || !warmOk ||
+        !uECC_compute_public_key(getCredentials().privateKey, publicKey, curve) ||
+        !uECC_verify(publicKey, digest, MESSAGE_DIGEST_SIZE, signature, curve)) {
+        LOG_ERROR("[CRYPTO] Precomputed signing self-test failed - using full signing only");
+        noncePoolEnabled = false;
+        noncePoolCount = 0;
+        memset(noncePool, 0, sizeof(noncePool));
+        return false;
+    }
+
+    LOG_INFO("[CRYPTO] Signing benchmark: cold %lu us, warm %lu us (precompute %lu us, done while idle)",
+             coldMicros, warmMicros, precomputeMicros);
+    return true;
+}
@@ -4,11 +4,18 @@
 #include <Arduino.h>
 #include "config.h"
 
+// BearSSL for SHA-256 hashing (ESP8266 built-in)
+extern "C" {
+    #include "bearssl/bearssl_hash.h"
+}
+
 // ============================================================================
 // CRYPTOGRAPHIC OPERATIONS MODULE
 // ============================================================================
 // This module handles:
 // - ECDSA P-256 message signing
+// - Precomputed signing nonces (fast signing on the alert path)
+// - Incremental SHA-256 digests (hash while a payload is being written)
 // - Base64 encoding of signatures
 // - Cryptographic initialization
 // ============================================================================
@@ -24,11 +31,104 @@ bool initializeCrypto();
 /**
  * Sign a message using ECDSA P-256
  * Creates a digital signature of the input message using the device's private key
+ * Output is written to the caller's buffer - no heap allocation.
  * 
  * @param message The message to sign (usually JSON payload)
- * @return Base64-encoded signature string, or empty string on failure
+ * @param messageLength Length of message in bytes
+ * @param signatureOut Output buffer for Base64-encoded DER signature
+ *                     (SIGNATURE_BUFFER_SIZE bytes)
+ * @param signatureSize Size of output buffer in bytes
+ * @return true if signed successfully, false on failure (output is empty)
+ */
+bool signMessage(const char* message, size_t messageLength, char* signatureOut, size_t signatureSize);
+
+/**
+ * Sign a message made of several segments using ECDSA P-256
+ * The segments are hashed in order as if concatenated, so a batch body can
+ * be signed once without being copied into one contiguous buffer.
+ *
+ * @param segments Pointers to the message segments
+ * @param segmentLengths Length of each segment in bytes
+ * @param segmentCount Number of segments
+ * @param signatureOut Output buffer for Base64-encoded DER signature
+ *                     (SIGNATURE_BUFFER_SIZE bytes)
+ * @param signatureSize Size of output buffer in bytes
+ * @return true if signed successfully, false on failure (output is empty)
+ */
+bool signMessageSegments(const char* const* segments, const size_t* segmentLengths, size_t segmentCount,
+                         char* signatureOut, size_t signatureSize);
+
+/**
+ * Incremental SHA-256 of a message
+ * Feed bytes while the payload is serialized, then sign the finished
+ * digest with signDigest() - no second pass over the payload.
+ */
+struct MessageDigestContext {
+    br_sha256_context sha;
+    uint32_t hashCycles;   // CPU cycles spent hashing (reported as PROFILE_SHA256)
+};
+
+/**
+ * Start a message digest
+ *
+ * @param context Digest context to initialize
+ */
+void beginMessageDigest(MessageDigestContext& context);
+
+/**
+ * Add bytes to a message digest
+ *
+ * @param context Digest context
+ * @param data Bytes to add
+ * @param length Number of bytes
+ */
+void updateMessageDigest(MessageDigestContext& context, const void* data, size_t length);
+
+/**
+ * Finish a message digest and record the hashing time (profiling.h)
+ *
+ * @param context Digest context
+ * @param digest Output: MESSAGE_DIGEST_SIZE bytes
+ */
+void finishMessageDigest(MessageDigestContext& context, uint8_t* digest);
+
+/**
+ * Sign a precomputed SHA-256 digest using ECDSA P-256
+ *
+ * @param digest SHA-256 digest of the message (MESSAGE_DIGEST_SIZE bytes)
+ * @param signatureOut Output buffer for Base64-encoded DER signature
+ *                     (SIGNATURE_BUFFER_SIZE bytes)
+ * @param signatureSize Size of output buffer in bytes
+ * @return true if signed successfully, false on failure (output is empty)
+ */
+bool signDigest(const uint8_t* digest, char* signatureOut, size_t signatureSize);
+
+/**
+ * Precompute one signing nonce (k⁻¹, r = x(k·G)) into the pool
+ * Takes about as long as a full signature - call while idle (the nonce
+ * task does). signDigest() uses a pooled nonce when one is ready and falls
+ * back to the full uECC_sign() when the pool is empty.
+ *
+ * @return true if a nonce was added, false if the pool is full or disabled
+ */
+bool precomputeSigningNonce();
+
+/**
+ * Get the number of precomputed nonces ready for signing
+ *
+ * @return Nonces in the pool (0 to NONCE_POOL_SIZE)
+ */
+uint8_t getNoncePoolCount();
+
+/**
+ * Time a full (cold) signature against one with a precomputed nonce (warm)
+ * and verify the warm signature. If verification fails the pool is disabled
+ * and all signatures use uECC_sign(). Call once in setup(), after
+ * initializeCrypto().
+ *
+ * @return true if the precomputed path passed its self-test
  */
-String signMessage(const String& message);
+bool benchmarkSigning();
 
 /**
  * Encode binary data to Base64 string
@@ -36,9 +136,11 @@ String signMessage(const String& message);
  * 
  * @param data Pointer to binary data
  * @param length Length of binary data in bytes
- * @return Base64-encoded string
+ * @param output Output buffer for null-terminated Base64 text
+ * @param outputSize Size of output buffer (needs 4 * ceil(length / 3) + 1 bytes)
+ * @return Number of characters written (excluding null), or 0 if buffer too small
  */
-String base64Encode(const uint8_t* data, size_t length);
+size_t base64Encode(const uint8_t* data, size_t length, char* output, size_t outputSize);
 
 /**
  * Get crypto module status
@@ -1,81 +1,342 @@
 #include "config.h"
 #include "hardware.h"
 #include "network.h"  // For getCurrentTimestamp()
+#include "profiling.h"
+#include "logging.h"
+
+#if SENSOR_BURST_SAMPLES < 1 || SENSOR_BURST_SAMPLES > 5
+#error "SENSOR_BURST_SAMPLES must be between 1 and 5"
+#endif
+#if SENSOR_BURST_MIN_VALID < 1 || SENSOR_BURST_MIN_VALID > SENSOR_BURST_SAMPLES
+#error "SENSOR_BURST_MIN_VALID must be between 1 and SENSOR_BURST_SAMPLES"
+#endif
+#if SENSOR_COUNT < 1 || SENSOR_COUNT > 4
+#error "SENSOR_COUNT must be between 1 and 4"
+#endif
 
 // ============================================================================
-// INTERNAL STATE VARIABLES
+// FIXED-POINT DISTANCES
+// ============================================================================
+// Distances are integer millimetres (0 = no valid reading): the LX106 has
+// no FPU, so float math would go through soft-float calls on every ping.
+// The cm settings in config.h are converted once, at compile time.
 // ============================================================================
 
-// Sensor polling timing
-static unsigned long lastSensorPoll = 0;
+/**
+ * Convert a config.h distance to millimetres (compile time only)
+ *
+ * @param cm Distance in centimeters
+ * @return Distance in millimetres, rounded
+ */
+static constexpr uint16_t cmToMm(double cm) {
+    return (uint16_t)(cm * 10.0 + 0.5);
+}
+
+static constexpr uint16_t DETECTION_THRESHOLD_MM = cmToMm(DETECTION_THRESHOLD_CM);
+static constexpr uint16_t DETECTION_RELEASE_MM = cmToMm(DETECTION_THRESHOLD_CM + DETECTION_HYSTERESIS_CM);
+static constexpr uint16_t SENSOR_MIN_DISTANCE_MM = cmToMm(SENSOR_MIN_DISTANCE_CM);
+static constexpr uint16_t SENSOR_MAX_DISTANCE_MM = cmToMm(SENSOR_MAX_DISTANCE_CM);
+static constexpr uint16_t ALERT_DELTA_DISTANCE_MM = cmToMm(ALERT_DELTA_DISTANCE_CM);
+static constexpr uint16_t SENSOR_MOTION_THRESHOLD_MM = cmToMm(SENSOR_MOTION_THRESHOLD_CM);
+static constexpr uint16_t SENSOR_APPROACH_LIMIT_MM = cmToMm(DETECTION_THRESHOLD_CM + SENSOR_APPROACH_ZONE_CM);
+
+// Echo time to distance: half the speed of sound in mm/us as Q16 fixed point
+// (331.3 m/s + 0.606 m/s per °C), so distance = (duration * factor) >> 16
+static constexpr uint32_t ECHO_MM_PER_MICROSECOND_Q16 =
+    (uint32_t)((331.3 + 0.606 * SENSOR_AIR_TEMPERATURE_C) / 2000.0 * 65536.0 + 0.5);
+
+// EMA weight of the newest median in 1/256 (filters keep 1/256 mm)
+static constexpr int32_t FILTER_ALPHA_Q8 = (int32_t)(SENSOR_FILTER_EMA_ALPHA * 256.0 + 0.5);
+
+static_assert(SENSOR_MAX_DISTANCE_CM * 10.0 < 65536.0, "SENSOR_MAX_DISTANCE_CM does not fit in uint16_t millimetres");
+static_assert(SENSOR_MIN_DISTANCE_MM > 0, "SENSOR_MIN_DISTANCE_CM must be above 0 (0 mm means no reading)");
+static_assert(SENSOR_AIR_TEMPERATURE_C >= -40 && SENSOR_AIR_TEMPERATURE_C <= 60,
+              "SENSOR_AIR_TEMPERATURE_C must be between -40 and 60");
+static_assert(FILTER_ALPHA_Q8 >= 1 && FILTER_ALPHA_Q8 <= 256, "SENSOR_FILTER_EMA_ALPHA must be between 0 and 1");
+// duration * factor must not overflow 32 bits
+static_assert((uint64_t)SENSOR_PULSE_TIMEOUT_MICROSECONDS * ECHO_MM_PER_MICROSECOND_Q16 <= 0xFFFFFFFFULL,
+              "SENSOR_PULSE_TIMEOUT_MICROSECONDS too long for the fixed-point conversion");
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
 
-// Distance measurement
-static float currentDistance = 0.0;
-static float previousDistance = 0.0;
+// Echo capture (edges timestamped by echoISR, one sensor pinged at a time)
+static volatile uint8_t activeSensor = 0;           // Sensor of the pending ping
+static volatile unsigned long echoRiseMicros = 0;  // micros() at rising edge
+static volatile unsigned long echoFallMicros = 0;  // micros() at falling edge
+static volatile bool echoRiseSeen = false;
+static volatile bool echoComplete = false;          // Both edges captured
+static bool measurementPending = false;             // Trigger sent, result not collected yet
+static unsigned long triggerMicros = 0;             // micros() when trigger pulse was sent
+static unsigned long triggerMillis = 0;             // millis() of the trigger (ping spacing)
+static uint32_t triggerCycles = 0;                  // Cycle counter at the trigger (profiling)
+
+// Distance measurement (mm)
+static uint16_t currentDistance = 0;
+static uint16_t previousDistance = 0;
 static int consecutiveValidReadings = 0;
 
+/**
+ * Per-sensor measurement state (one entry per HC-SR04 in SENSOR_TRIG_PINS)
+ */
+struct SensorState {
+    uint16_t samples[SENSOR_BURST_SAMPLES];  // Valid distances of the current burst (mm)
+    uint8_t validCount;                      // Entries used in samples
+    uint16_t reading;                        // Median of the last burst (mm, 0 = invalid)
+    int32_t filteredQ8;                      // EMA of burst medians (1/256 mm, 0 = not seeded)
+};
+
+// Burst sampling (SENSOR_BURST_SAMPLES pings per sensor and poll, round-robin)
+static SensorState sensors[SENSOR_COUNT];
+static uint8_t burstPings = 0;                      // Pings collected in the current burst (all sensors)
+
+// Adaptive poll rate (driven by the trend of the filtered distance)
+static unsigned long lastMotionTime = 0;            // millis() of the last reading that moved
+static unsigned long lastApproachTime = 0;          // millis() of the last move toward the threshold
+static bool approachSeen = false;                   // lastApproachTime is valid
+static unsigned long reportedPollInterval = 0;      // Last value of getSensorPollInterval() (logging)
+
 // Detection state tracking
 static bool detectionActive = false;
 static unsigned long firstDetectionTime = 0;      // millis() when first detected
-static String firstDetectionTimestamp = "";       // ISO timestamp when first detected
+static char firstDetectionTimestamp[TIMESTAMP_BUFFER_SIZE] = "";  // ISO timestamp when first detected
 static unsigned long lastAlertTime = 0;           // millis() when last alert sent
 
+// Detection session messages (see getDueDetectionEvent())
+static bool openedAlertSent = false;              // DETECTION_OPENED sent for this detection
+static uint16_t lastAlertDistance = 0;            // Distance in the last opened/update message (mm)
+static uint16_t closestDistance = 0;              // Closest filtered distance of this detection (mm)
+static bool closedAlertPending = false;           // DETECTION_CLOSED not sent yet
+static uint8_t closedAlertAttempts = 0;           // Failed attempts to queue DETECTION_CLOSED
+static unsigned long closedAlertRetryTime = 0;    // millis() of the last failed attempt
+static DetectionSummary closedDetection = {0, 0, ""};
+
 // LED blinking for detection
 static unsigned long lastLEDToggle = 0;
 static bool ledState = false;
-static const unsigned long LED_BLINK_INTERVAL = 300;  // 300ms on/off for continuous blink
+
+// LED feedback patterns (played by updateStatusLED(), never blocking)
+static const unsigned long SUCCESS_BLINK_MS = 1000;       // 1 long blink
+static const unsigned long ERROR_BLINK_MS = 200;          // N rapid blinks
+static const unsigned long ERROR_PATTERN_PAUSE_MS = 500;  // LED off after error pattern
+static bool patternActive = false;
+static uint8_t patternPhase = 0;            // Even = LED on, odd = LED off
+static uint8_t patternPhaseCount = 0;       // 2 phases per blink
+static unsigned long patternOnMs = 0;
+static unsigned long patternOffMs = 0;
+static unsigned long patternPauseMs = 0;    // Last off phase
+static unsigned long patternPhaseStart = 0;
 
 // ============================================================================
 // INTERNAL HELPER FUNCTIONS
 // ============================================================================
 
 /**
- * Measure distance using HC-SR04 ultrasonic sensor
+ * Echo pin interrupt handler (both edges, attached to every echo pin)
+ * Timestamps the rising and falling edge of the echo pulse of the sensor
+ * that was triggered. An edge on another echo pin (a late echo of an
+ * earlier ping) re-enters while the active echo is HIGH, so the rise is
+ * only taken once per trigger - it would otherwise shorten the pulse.
+ * Runs from IRAM and does no work beyond recording the time.
+ */
+static void IRAM_ATTR echoISR() {
+    unsigned long now = micros();
+
+    if (digitalRead(SENSOR_ECHO_PINS[activeSensor]) == HIGH) {
+        if (!echoRiseSeen) {
+            echoRiseMicros = now;
+            echoRiseSeen = true;
+        }
+    } else if (echoRiseSeen && !echoComplete) {
+        echoFallMicros = now;
+        echoComplete = true;
+    }
+}
+
+/**
+ * Start a distance measurement on one sensor
+ * Sends the 10us trigger pulse and returns immediately - the echo pulse
+ * is captured by echoISR while the main loop keeps running.
  *
- * @return Distance in centimeters, or -1 if measurement failed
+ * @param sensor Sensor index (0..SENSOR_COUNT-1)
  */
-static float measureDistance() {
+static void triggerMeasurement(uint8_t sensor) {
+    // Reset capture state before the echo can start
+    noInterrupts();
+    activeSensor = sensor;
+    echoRiseSeen = false;
+    echoComplete = false;
+    interrupts();
+
     // Send 10us pulse to trigger pin
-    digitalWrite(SENSOR_TRIG_PIN, LOW);
+    int trigPin = SENSOR_TRIG_PINS[sensor];
+    triggerCycles = profileStart();
+    digitalWrite(trigPin, LOW);
     delayMicroseconds(2);
-    digitalWrite(SENSOR_TRIG_PIN, HIGH);
+    digitalWrite(trigPin, HIGH);
     delayMicroseconds(10);
-    digitalWrite(SENSOR_TRIG_PIN, LOW);
+    digitalWrite(trigPin, LOW);
 
-    // Read echo pulse duration (timeout configured in config.h)
-    unsigned long duration = pulseIn(SENSOR_ECHO_PIN, HIGH, SENSOR_PULSE_TIMEOUT_MICROSECONDS);
+    triggerMicros = micros();
+    triggerMillis = millis();
+    measurementPending = true;
+}
 
-    // Check for timeout or invalid reading
-    if (duration == 0) {
-        return -1.0;  // No echo received
+/**
+ * Check if the pending measurement has finished (echo captured or timed out)
+ *
+ * @return true if result can be collected
+ */
+static bool isMeasurementReady() {
+    if (!measurementPending) {
+        return false;
     }
+    // Timeout covers wait for echo start plus the echo pulse itself (config.h)
+    return echoComplete || (micros() - triggerMicros) >= SENSOR_PULSE_TIMEOUT_MICROSECONDS;
+}
 
-    // Calculate distance in cm
-    // Speed of sound constant defined in config.h (343 m/s = 0.0343 cm/μs at 20°C)
-    // Distance = (duration / 2) * speed_of_sound
-    float distance = (duration / 2.0) * SPEED_OF_SOUND_CM_PER_MICROSECOND;
+/**
+ * Collect the result of the pending measurement
+ *
+ * @return Distance in millimetres, or 0 if measurement failed
+ */
+static uint16_t collectMeasurement() {
+    measurementPending = false;
+    profileEnd(PROFILE_MEASURE_DISTANCE, triggerCycles);
+
+    noInterrupts();
+    bool complete = echoComplete;
+    unsigned long duration = echoFallMicros - echoRiseMicros;
+    interrupts();
+
+    // Check for timeout (no echo, or echo longer than timeout)
+    if (!complete || duration > SENSOR_PULSE_TIMEOUT_MICROSECONDS) {
+        return 0;  // No echo received
+    }
+
+    // Distance = (duration / 2) * speed_of_sound, in fixed point (rounded)
+    uint32_t distance = (duration * ECHO_MM_PER_MICROSECOND_Q16 + 0x8000) >> 16;
 
     // Validate range (constants defined in config.h)
-    if (distance < SENSOR_MIN_DISTANCE_CM || distance > SENSOR_MAX_DISTANCE_CM) {
-        return -1.0;  // Out of reliable range
+    if (distance < SENSOR_MIN_DISTANCE_MM || distance > SENSOR_MAX_DISTANCE_MM) {
+        return 0;  // Out of reliable range
+    }
+
+    return (uint16_t)distance;
+}
+
+/**
+ * Median of a few samples (sorts them in place)
+ *
+ * @param samples Distances in mm
+ * @param count Number of samples (1..SENSOR_BURST_SAMPLES)
+ * @return Middle value, or the mean of the two middle values for an even count
+ */
+static uint16_t medianOf(uint16_t* samples, uint8_t count) {
+    // Insertion sort - at most 5 entries
+    for (uint8_t i = 1; i < count; i++) {
+        uint16_t value = samples[i];
+        int j = i - 1;
+        while (j >= 0 && samples[j] > value) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = value;
+    }
+
+    if (count % 2 == 1) {
+        return samples[count / 2];
+    }
+    return (samples[count / 2 - 1] + samples[count / 2] + 1) / 2;
+}
+
+/**
+ * Reduce each sensor's burst to one reading and update its filter
+ *
+ * @param closestSensor Output: index of the sensor with the closest reading
+ * @return Number of sensors with a valid reading
+ */
+static uint8_t finishBurst(uint8_t& closestSensor) {
+    uint8_t validSensors = 0;
+
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        SensorState& sensor = sensors[i];
+        uint8_t validCount = sensor.validCount;
+        sensor.validCount = 0;
+
+        if (validCount < SENSOR_BURST_MIN_VALID) {
+            sensor.reading = 0;
+            continue;
+        }
+
+        // The median decides detection: a single bad echo in the burst is outvoted
+        sensor.reading = medianOf(sensor.samples, validCount);
+
+        // The EMA smooths the distance reported in alerts (kept in 1/256 mm,
+        // so small steps are not lost to rounding)
+        int32_t readingQ8 = (int32_t)sensor.reading << 8;
+        if (sensor.filteredQ8 == 0) {
+            sensor.filteredQ8 = readingQ8;
+        } else {
+            sensor.filteredQ8 += FILTER_ALPHA_Q8 * (readingQ8 - sensor.filteredQ8) / 256;
+        }
+
+        if (validSensors == 0 || sensor.reading < sensors[closestSensor].reading) {
+            closestSensor = i;
+        }
+        validSensors++;
     }
 
-    return distance;
+    return validSensors;
+}
+
+/**
+ * Get the filtered distance of one sensor
+ *
+ * @param sensor Sensor state
+ * @return Distance in mm, rounded (0 = not seeded)
+ */
+static uint16_t filteredDistanceOf(const SensorState& sensor) {
+    return (uint16_t)((sensor.filteredQ8 + 128) >> 8);
+}
+
+/**
+ * Record motion and approach toward the detection zone from the distance trend
+ * Called with every valid reading, after currentDistance was updated.
+ */
+static void updateActivity() {
+    if (previousDistance == 0) {
+        return;  // First valid reading - no trend yet
+    }
+
+    int32_t change = (int32_t)previousDistance - currentDistance;  // > 0 = moving closer
+    if (abs(change) < SENSOR_MOTION_THRESHOLD_MM) {
+        return;
+    }
+
+    unsigned long now = millis();
+    lastMotionTime = now;
+
+    if (change > 0 && currentDistance <= SENSOR_APPROACH_LIMIT_MM) {
+        lastApproachTime = now;
+        approachSeen = true;
+    }
 }
 
 /**
  * Check if distance reading indicates object detected (with hysteresis)
  *
- * @param distance Current distance measurement in cm
+ * @param distance Current distance measurement in mm
  * @return true if object detected, false otherwise
  */
-static bool isDistanceInDetectionRange(float distance) {
+static bool isDistanceInDetectionRange(uint16_t distance) {
     if (detectionActive) {
         // Currently detecting - use upper threshold (hysteresis)
-        return distance <= (DETECTION_THRESHOLD_CM + DETECTION_HYSTERESIS_CM);
+        return distance <= DETECTION_RELEASE_MM;
     } else {
         // Not detecting - use lower threshold
-        return distance <= DETECTION_THRESHOLD_CM;
+        return distance <= DETECTION_THRESHOLD_MM;
     }
 }
 
@@ -84,10 +345,18 @@ static bool isDistanceInDetectionRange(float distance) {
 // ============================================================================
 
 void initializeHardware() {
-    // Configure HC-SR04 pins
-    pinMode(SENSOR_TRIG_PIN, OUTPUT);
-    pinMode(SENSOR_ECHO_PIN, INPUT);
-    digitalWrite(SENSOR_TRIG_PIN, LOW);
+    // Configure HC-SR04 pins and capture echo edges in the background
+    // instead of blocking in pulseIn()
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        pinMode(SENSOR_TRIG_PINS[i], OUTPUT);
+        pinMode(SENSOR_ECHO_PINS[i], INPUT);
+        digitalWrite(SENSOR_TRIG_PINS[i], LOW);
+        attachInterrupt(digitalPinToInterrupt(SENSOR_ECHO_PINS[i]), echoISR, CHANGE);
+
+        sensors[i].validCount = 0;
+        sensors[i].reading = 0;
+        sensors[i].filteredQ8 = 0;
+    }
 
     // Configure LED pins as outputs
     pinMode(STATUS_LED_PIN, OUTPUT);
@@ -97,47 +366,62 @@ void initializeHardware() {
     digitalWrite(STATUS_LED_PIN, LOW);      // Status LED off
     digitalWrite(BUILTIN_LED_PIN, HIGH);    // Built-in LED off (inverted logic)
 
-    Serial.println("[HW] Hardware initialized");
-    Serial.print("[HW] HC-SR04 Trigger pin: D");
-    Serial.println(SENSOR_TRIG_PIN);
-    Serial.print("[HW] HC-SR04 Echo pin: D");
-    Serial.println(SENSOR_ECHO_PIN);
-    Serial.print("[HW] Status LED pin: D");
-    Serial.println(STATUS_LED_PIN);
-    Serial.print("[HW] Built-in LED pin: D");
-    Serial.println(BUILTIN_LED_PIN);
-    Serial.print("[HW] Detection threshold: ");
-    Serial.print(DETECTION_THRESHOLD_CM);
-    Serial.println(" cm");
-    Serial.print("[HW] Detection hysteresis: ");
-    Serial.print(DETECTION_HYSTERESIS_CM);
-    Serial.println(" cm");
+    LOG_INFO("[HW] Hardware initialized");
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        LOG_DEBUG("[HW] HC-SR04 #%d Trigger pin: GPIO%d, Echo pin: GPIO%d",
+                  i, SENSOR_TRIG_PINS[i], SENSOR_ECHO_PINS[i]);
+    }
+    LOG_DEBUG("[HW] Status LED pin: GPIO%d", STATUS_LED_PIN);
+    LOG_DEBUG("[HW] Built-in LED pin: GPIO%d", BUILTIN_LED_PIN);
+    LOG_INFO("[HW] Detection threshold: %u mm", DETECTION_THRESHOLD_MM);
+    LOG_INFO("[HW] Detection hysteresis: %u mm", (unsigned int)(DETECTION_RELEASE_MM - DETECTION_THRESHOLD_MM));
+    LOG_DEBUG("[HW] Speed of sound: %u m/s (%d°C)",
+              (unsigned int)((ECHO_MM_PER_MICROSECOND_Q16 * 2000UL + 0x8000) >> 16), SENSOR_AIR_TEMPERATURE_C);
+
+    // Boot counts as recent motion: start at the normal rate
+    lastMotionTime = millis();
 }
 
-bool isSensorPollDue() {
-    return (millis() - lastSensorPoll) >= SENSOR_POLL_INTERVAL;
+bool isMeasurementPending() {
+    return measurementPending || burstPings > 0;
+}
+
+unsigned long getMeasurementStepDelay() {
+    if (measurementPending) {
+        return SENSOR_ECHO_CHECK_INTERVAL;
+    }
+
+    // Between pings of a burst - wait until the previous ping's echoes have died out
+    unsigned long sinceTrigger = millis() - triggerMillis;
+    return sinceTrigger < SENSOR_PING_SPACING ? SENSOR_PING_SPACING - sinceTrigger : 0;
 }
 
 
 /**
  * @brief Handle transition from IDLE to DETECTING state
- * @param distance Current distance measurement in cm
+ * @param distance Current distance measurement in mm
  */
-static void transitionToDetecting(float distance) {
+static void transitionToDetecting(uint16_t distance) {
     detectionActive = true;
     firstDetectionTime = millis();
-    firstDetectionTimestamp = getCurrentTimestamp();
-    lastAlertTime = 0;  // Force immediate alert
+    getCurrentTimestamp(firstDetectionTimestamp, sizeof(firstDetectionTimestamp));
+    openedAlertSent = false;  // Opened message is due immediately
     consecutiveValidReadings = 0;
 
-    Serial.println("\n[HW] ═══════════════════════════════════");
-    Serial.println("[HW] OBJECT DETECTED!");
-    Serial.print("[HW] Distance: ");
-    Serial.print(distance, 1);
-    Serial.println(" cm");
-    Serial.print("[HW] First detected at: ");
-    Serial.println(firstDetectionTimestamp);
-    Serial.println("[HW] ═══════════════════════════════════\n");
+    // Report the confirming medians, not lagging averages
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (sensors[i].reading > 0) {
+            sensors[i].filteredQ8 = (int32_t)sensors[i].reading << 8;
+        }
+    }
+    currentDistance = distance;
+    closestDistance = distance;
+
+    LOG_DEBUG("\n[HW] ═══════════════════════════════════");
+    LOG_INFO("[HW] OBJECT DETECTED!");
+    LOG_INFO("[HW] Distance: %u mm", distance);
+    LOG_INFO("[HW] First detected at: %s", firstDetectionTimestamp);
+    LOG_DEBUG("[HW] ═══════════════════════════════════\n");
 }
 
 
@@ -148,24 +432,31 @@ static void transitionToIdle() {
     detectionActive = false;
     unsigned long detectionDuration = (millis() - firstDetectionTime) / 1000;
 
-    Serial.println("\n[HW] ───────────────────────────────────");
-    Serial.println("[HW] OBJECT LEFT DETECTION ZONE");
-    Serial.print("[HW] Detection duration: ");
-    Serial.print(detectionDuration);
-    Serial.println(" seconds");
-    Serial.println("[HW] ───────────────────────────────────\n");
-
-    // Turn off LED
-    setStatusLED(false);
+    LOG_DEBUG("\n[HW] ───────────────────────────────────");
+    LOG_INFO("[HW] OBJECT LEFT DETECTION ZONE");
+    LOG_INFO("[HW] Detection duration: %lu seconds", detectionDuration);
+    LOG_DEBUG("[HW] ───────────────────────────────────\n");
+
+    // Summary for the closed message (replaces one that could not be sent)
+    closedDetection.durationSeconds = detectionDuration;
+    closedDetection.closestDistanceMm = closestDistance;
+    strlcpy(closedDetection.firstDetectedAt, firstDetectionTimestamp, sizeof(closedDetection.firstDetectedAt));
+    closedAlertPending = true;
+    closedAlertAttempts = 0;
+
+    // Turn off LED (unless a feedback pattern is playing)
+    if (!patternActive) {
+        setStatusLED(false);
+    }
 }
 
 
 /**
  * @brief Update detection state machine based on current sensor reading
- * @param distance Current distance measurement in cm
+ * @param distance Current distance measurement in mm
  * @param readingInRange Whether the reading is within detection threshold
  */
-static void updateDetectionStateMachine(float distance, bool readingInRange) {
+static void updateDetectionStateMachine(uint16_t distance, bool readingInRange) {
     static int consecutiveOutOfRange = 0;
 
     // ────────────────────────────────────────────────────────────────────────
@@ -183,7 +474,7 @@ static void updateDetectionStateMachine(float distance, bool readingInRange) {
         // Need consecutive readings to confirm object is gone
         consecutiveOutOfRange++;
 
-        if (consecutiveOutOfRange >= CONSECUTIVE_READINGS_REQUIRED) {
+        if (consecutiveOutOfRange >= CONSECUTIVE_CLEAR_READINGS_REQUIRED) {
             transitionToIdle();
             consecutiveOutOfRange = 0;
         }
@@ -195,33 +486,61 @@ static void updateDetectionStateMachine(float distance, bool readingInRange) {
 
 
 bool pollSensor() {
-    // Update poll timestamp
-    lastSensorPoll = millis();
+    // Phase 1: start the next ping of the burst - result is collected on a later pass
+    if (!measurementPending) {
+        if (burstPings > 0 && millis() - triggerMillis < SENSOR_PING_SPACING) {
+            return false;  // Echoes of the previous ping may still arrive
+        }
+        triggerMeasurement(burstPings % SENSOR_COUNT);  // Round-robin over the sensors
+        return false;
+    }
+
+    // Phase 2: wait until echo captured or timed out
+    if (!isMeasurementReady()) {
+        return false;
+    }
+
+    uint16_t sample = collectMeasurement();
+    SensorState& pinged = sensors[activeSensor];
+    if (sample > 0) {
+        pinged.samples[pinged.validCount++] = sample;
+    }
 
-    // Measure distance
-    float distance = measureDistance();
+    burstPings++;
+    if (burstPings < SENSOR_BURST_SAMPLES * SENSOR_COUNT) {
+        return false;  // Next ping after SENSOR_PING_SPACING
+    }
+
+    // Burst complete - reduce it to one reading per sensor
+    burstPings = 0;
+    uint8_t closestSensor = 0;
+    uint8_t validSensors = finishBurst(closestSensor);
 
     // Check if reading is valid
-    if (distance < 0) {
-        Serial.println("[HW] Invalid sensor reading (timeout or out of range)");
+    if (validSensors == 0) {
+        LOG_DEBUG("[HW] Invalid sensor reading (timeout or out of range)");
         consecutiveValidReadings = 0;
         return true;  // Sensor was polled (even though reading failed)
     }
 
+    // Combined reading: the closest object seen by any sensor
+    uint16_t distance = sensors[closestSensor].reading;
+
     // Valid reading obtained
     previousDistance = currentDistance;
-    currentDistance = distance;
+    currentDistance = filteredDistanceOf(sensors[closestSensor]);
+    updateActivity();
+    if (detectionActive && currentDistance < closestDistance) {
+        closestDistance = currentDistance;
+    }
 
     // Check if reading is within detection range
     bool readingInRange = isDistanceInDetectionRange(distance);
 
     // Debug output
-    Serial.print("[HW] Distance: ");
-    Serial.print(distance, 1);
-    Serial.print(" cm | Detection: ");
-    Serial.print(detectionActive ? "ACTIVE" : "IDLE");
-    Serial.print(" | Valid readings: ");
-    Serial.println(consecutiveValidReadings);
+    LOG_DEBUG("[HW] Distance: %u mm (filtered %u, sensor %d of %d valid) | Detection: %s | Valid readings: %d",
+              distance, currentDistance, closestSensor, validSensors, detectionActive ? "ACTIVE" : "IDLE",
+              consecutiveValidReadings);
 
     // Update consecutive readings counter
     if (readingInRange) {
@@ -236,23 +555,79 @@ bool pollSensor() {
     return true;
 }
 
+unsigned long getSensorPollInterval() {
+    unsigned long now = millis();
+    unsigned long interval;
+    const char* reason;
+
+    if (detectionActive) {
+        interval = SENSOR_POLL_INTERVAL_FAST;
+        reason = "detecting";
+    } else if (approachSeen && now - lastApproachTime < SENSOR_FAST_POLL_HOLD) {
+        interval = SENSOR_POLL_INTERVAL_FAST;
+        reason = "approaching";
+    } else if (now - lastMotionTime < SENSOR_IDLE_TIMEOUT) {
+        interval = SENSOR_POLL_INTERVAL;
+        reason = "recent motion";
+    } else {
+        interval = SENSOR_POLL_INTERVAL_SLOW;
+        reason = "quiet";
+    }
+
+    if (interval != reportedPollInterval) {
+        LOG_DEBUG("[HW] Sensor poll interval: %lu ms (%s)", interval, reason);
+        reportedPollInterval = interval;
+    }
+    (void)reason;  // Only logged at debug level
+
+    return interval;
+}
+
 bool isObjectDetected() {
     return detectionActive;
 }
 
-bool isAlertDue() {
+DetectionEvent getDueDetectionEvent() {
+    // A detection that ended is reported before the next one opens
+    if (closedAlertPending) {
+        if (closedAlertAttempts > 0 && millis() - closedAlertRetryTime < ALERT_INTERVAL) {
+            return DETECTION_NONE;  // Retry later (see markAlertFailed())
+        }
+        return DETECTION_CLOSED;
+    }
     if (!detectionActive) {
-        return false;  // No alert if not detecting
+        return DETECTION_NONE;
+    }
+    if (!openedAlertSent) {
+        return DETECTION_OPENED;
     }
 
-    // Check if enough time has passed since last alert
     unsigned long timeSinceLastAlert = millis() - lastAlertTime;
-    return timeSinceLastAlert >= ALERT_INTERVAL;
+    if (timeSinceLastAlert >= ALERT_KEEPALIVE_INTERVAL) {
+        return DETECTION_UPDATE;
+    }
+    // Distance changes only while in range - leaving is reported by the closed message
+    if (timeSinceLastAlert >= ALERT_INTERVAL && consecutiveValidReadings > 0 &&
+        abs((int32_t)currentDistance - lastAlertDistance) >= ALERT_DELTA_DISTANCE_MM) {
+        return DETECTION_UPDATE;
+    }
+    return DETECTION_NONE;
 }
 
-float getDetectedDistance() {
+const DetectionSummary& getClosedDetection() {
+    return closedDetection;
+}
+
+uint16_t getSensorReadingMm(uint8_t sensor) {
+    if (sensor >= SENSOR_COUNT || sensors[sensor].reading == 0) {
+        return 0;
+    }
+    return filteredDistanceOf(sensors[sensor]);
+}
+
+uint16_t getDetectedDistanceMm() {
     if (!detectionActive) {
-        return 0.0;  // No detection = no distance
+        return 0;  // No detection = no distance
     }
     return currentDistance;
 }
@@ -265,13 +640,69 @@ unsigned long getDetectionDuration() {
     return (millis() - firstDetectionTime) / 1000;  // Convert ms to seconds
 }
 
-String getFirstDetectionTimestamp() {
+const char* getFirstDetectionTimestamp() {
     return firstDetectionTimestamp;
 }
 
-void markAlertSent() {
-    lastAlertTime = millis();
-    Serial.println("[HW] Alert sent marker updated");
+void markAlertSent(DetectionEvent event) {
+    if (event == DETECTION_CLOSED) {
+        closedAlertPending = false;
+    } else {
+        openedAlertSent = true;
+        lastAlertTime = millis();
+        lastAlertDistance = currentDistance;
+    }
+    LOG_DEBUG("[HW] Alert sent marker updated");
+}
+
+void markAlertFailed(DetectionEvent event) {
+    if (event != DETECTION_CLOSED) {
+        return;  // Opened and update messages are due again on the next pass
+    }
+
+    closedAlertAttempts++;
+    closedAlertRetryTime = millis();
+    if (closedAlertAttempts >= ALERT_CLOSED_MAX_ATTEMPTS) {
+        LOG_ERROR("[HW] Closed alert dropped after %u attempts", closedAlertAttempts);
+        closedAlertPending = false;
+    }
+}
+
+/**
+ * Get the duration of a pattern phase
+ *
+ * @param phase Phase index (even = on, odd = off)
+ * @return Duration in milliseconds
+ */
+static unsigned long getPatternPhaseDuration(uint8_t phase) {
+    if (phase % 2 == 0) {
+        return patternOnMs;
+    }
+    return (phase == patternPhaseCount - 1) ? patternPauseMs : patternOffMs;
+}
+
+/**
+ * Start playing a blink pattern (replaces a pattern already playing)
+ *
+ * @param blinks Number of blinks
+ * @param onMs LED on time per blink
+ * @param offMs LED off time between blinks
+ * @param pauseMs LED off time after the last blink
+ */
+static void startStatusPattern(uint8_t blinks, unsigned long onMs, unsigned long offMs, unsigned long pauseMs) {
+    if (blinks == 0) {
+        return;
+    }
+
+    patternOnMs = onMs;
+    patternOffMs = offMs;
+    patternPauseMs = pauseMs;
+    patternPhaseCount = blinks * 2;
+    patternPhase = 0;
+    patternPhaseStart = millis();
+    patternActive = true;
+
+    setStatusLED(true);
 }
 
 void blinkStatusLED(int times, unsigned long duration_ms) {
@@ -299,30 +730,61 @@ void setWiFiLED(bool state) {
 
 void showSuccessPattern() {
     // 1 long blink = success
-    blinkStatusLED(1, 1000);
+    startStatusPattern(1, SUCCESS_BLINK_MS, 0, 0);
 }
 
 void showErrorPattern(int errorCode) {
     // Multiple rapid blinks indicate error
     // Number of blinks indicates error type
-    blinkStatusLED(errorCode, 200);
-    delay(500);  // Pause after error pattern
+    uint8_t blinks = (errorCode > 0 && errorCode < 128) ? (uint8_t)errorCode : 1;
+    startStatusPattern(blinks, ERROR_BLINK_MS, ERROR_BLINK_MS, ERROR_PATTERN_PAUSE_MS);
+}
+
+bool isStatusPatternPlaying() {
+    return patternActive;
 }
 
-void updateDetectionLED() {
+unsigned long updateStatusLED() {
+    unsigned long now = millis();
+
+    // Feedback pattern has priority over the detection blink
+    if (patternActive) {
+        unsigned long elapsed = now - patternPhaseStart;
+        unsigned long duration = getPatternPhaseDuration(patternPhase);
+
+        if (elapsed < duration) {
+            return duration - elapsed;
+        }
+
+        patternPhase++;
+        patternPhaseStart = now;
+
+        if (patternPhase < patternPhaseCount) {
+            setStatusLED(patternPhase % 2 == 0);
+            unsigned long next = getPatternPhaseDuration(patternPhase);
+            return next > 0 ? next : 1;
+        }
+
+        // Pattern finished - detection blink resumes below
+        patternActive = false;
+        setStatusLED(false);
+        lastLEDToggle = now;
+    }
+
     if (!detectionActive) {
         // Not detecting - ensure LED is off
         if (ledState) {
             setStatusLED(false);
         }
-        return;
+        return LED_BLINK_INTERVAL;
     }
 
     // Detecting - blink continuously
-    unsigned long now = millis();
-    if (now - lastLEDToggle >= LED_BLINK_INTERVAL) {
-        ledState = !ledState;
-        digitalWrite(STATUS_LED_PIN, ledState ? HIGH : LOW);
+    unsigned long sinceToggle = now - lastLEDToggle;
+    if (sinceToggle >= LED_BLINK_INTERVAL) {
+        setStatusLED(!ledState);
         lastLEDToggle = now;
+        return LED_BLINK_INTERVAL;
     }
+    return LED_BLINK_INTERVAL - sinceToggle;
 }
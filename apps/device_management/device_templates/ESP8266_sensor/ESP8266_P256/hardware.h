@@ -8,32 +8,84 @@
 // HARDWARE ABSTRACTION LAYER
 // ============================================================================
 // This module handles all physical hardware interactions:
-// - HC-SR04 ultrasonic sensor for object detection
+// - HC-SR04 ultrasonic sensors for object detection (SENSOR_COUNT, pinged
+//   one at a time)
 // - LED status indicators
 // - Hardware initialization
 // ============================================================================
 
+/**
+ * Detection session messages (one session per detection)
+ */
+enum DetectionEvent {
+    DETECTION_NONE,     // Nothing to send
+    DETECTION_OPENED,   // Detection started - full alert with all context
+    DETECTION_UPDATE,   // Compact delta: distance changed, or keep-alive
+    DETECTION_CLOSED    // Object left - summary of the whole detection
+};
+
+/**
+ * Summary of the detection that ended last (for DETECTION_CLOSED)
+ */
+struct DetectionSummary {
+    unsigned long durationSeconds;
+    uint16_t closestDistanceMm;                      // Closest filtered distance (mm)
+    char firstDetectedAt[TIMESTAMP_BUFFER_SIZE];     // ISO 8601 timestamp
+};
+
 // Initialize all hardware components (pins, sensors)
 void initializeHardware();
 
 /**
- * Check if sensor should be polled (based on polling interval)
- * @return true if it's time to read sensor, false otherwise
+ * Check if a measurement burst was started and not finished yet
+ * While pending, call pollSensor() again after getMeasurementStepDelay().
+ *
+ * @return true if a measurement is in progress, false otherwise
+ */
+bool isMeasurementPending();
+
+/**
+ * Get the time until the pending measurement can take its next step
+ * - SENSOR_ECHO_CHECK_INTERVAL while a ping waits for its echo (up to
+ *   SENSOR_PULSE_TIMEOUT_MICROSECONDS)
+ * - The rest of SENSOR_PING_SPACING between the pings of a burst
+ *
+ * @return Delay in milliseconds (0 = step now)
  */
-bool isSensorPollDue();
+unsigned long getMeasurementStepDelay();
 
 /**
- * Read distance from HC-SR04 sensor and update detection state
- * This function handles:
- * - Distance measurement
+ * Run the next step of the HC-SR04 measurement and update detection state
+ * A measurement is a burst of SENSOR_BURST_SAMPLES pings per sensor, sent
+ * round-robin over the sensors SENSOR_PING_SPACING apart (so no sensor hears
+ * another's echo). Pings are interrupt-driven and take two calls each:
+ * - First call sends the trigger pulse and returns immediately
+ * - A later call collects the echo timed by the interrupt handler
+ *
+ * When the burst is complete this function handles:
+ * - Distance calculation in integer millimetres (median of the valid pings,
+ *   EMA for the reported distance)
+ * - Combining the sensors (the closest reading decides detection)
  * - Consecutive reading validation
  * - Hysteresis logic
  * - Detection state tracking
  *
- * @return true if sensor was polled (regardless of detection state)
+ * @return true if a burst was completed (valid or not), false if the
+ *         measurement was only started or is still in progress
  */
 bool pollSensor();
 
+/**
+ * Get the sensor poll interval for the current activity
+ * - SENSOR_POLL_INTERVAL_FAST while detecting, and for SENSOR_FAST_POLL_HOLD
+ *   after the distance moved toward DETECTION_THRESHOLD_CM
+ * - SENSOR_POLL_INTERVAL while readings changed within SENSOR_IDLE_TIMEOUT
+ * - SENSOR_POLL_INTERVAL_SLOW otherwise
+ *
+ * @return Interval in milliseconds until the next measurement burst
+ */
+unsigned long getSensorPollInterval();
+
 /**
  * Check if object is currently detected (within threshold)
  * @return true if object detected, false otherwise
@@ -41,16 +93,39 @@ bool pollSensor();
 bool isObjectDetected();
 
 /**
- * Check if alert should be sent (10 second interval while detecting)
- * @return true if alert is due, false otherwise
+ * Get the detection session message that should be sent now
+ * - DETECTION_OPENED once when a detection starts
+ * - DETECTION_UPDATE when the distance moved by ALERT_DELTA_DISTANCE_CM
+ *   (at most every ALERT_INTERVAL), or after ALERT_KEEPALIVE_INTERVAL
+ * - DETECTION_CLOSED once after the detection ended (see getClosedDetection())
+ * The message stays due until markAlertSent() is called for it. A closed
+ * message that cannot be queued is retried ALERT_INTERVAL apart and dropped
+ * after ALERT_CLOSED_MAX_ATTEMPTS (see markAlertFailed()); a new detection
+ * opens after it.
+ *
+ * @return Message to send, or DETECTION_NONE
  */
-bool isAlertDue();
+DetectionEvent getDueDetectionEvent();
 
 /**
- * Get the current detected distance in centimeters
- * @return Distance in cm (0 if no valid reading or not detecting)
+ * Get the summary of the detection that ended last
+ * @return Summary (valid until the next detection ends)
  */
-float getDetectedDistance();
+const DetectionSummary& getClosedDetection();
+
+/**
+ * Get the current detected distance in millimetres (filtered)
+ * @return Distance in mm (0 if no valid reading or not detecting)
+ */
+uint16_t getDetectedDistanceMm();
+
+/**
+ * Get the latest reading of one sensor of the array (filtered)
+ *
+ * @param sensor Sensor index (0..SENSOR_COUNT-1)
+ * @return Distance in mm, or 0 if the sensor's last burst had no valid reading
+ */
+uint16_t getSensorReadingMm(uint8_t sensor);
 
 /**
  * Get how long object has been detected (in seconds)
@@ -60,18 +135,34 @@ unsigned long getDetectionDuration();
 
 /**
  * Get ISO timestamp of when object was first detected
- * @return ISO 8601 formatted timestamp string
+ * @return ISO 8601 formatted timestamp (points to internal buffer, valid
+ *         until the next detection starts)
  */
-String getFirstDetectionTimestamp();
+const char* getFirstDetectionTimestamp();
 
 /**
- * Mark that an alert was just sent
- * Updates internal timer for next alert interval
+ * Mark that a detection session message was just queued
+ * Updates the timer and distance the next update is measured against
+ *
+ * @param event Message that was sent (from getDueDetectionEvent())
  */
-void markAlertSent();
+void markAlertSent(DetectionEvent event);
+
+/**
+ * Mark that a detection session message could not be queued
+ * A closed message is retried after ALERT_INTERVAL, at most
+ * ALERT_CLOSED_MAX_ATTEMPTS times, so it cannot hold back the next
+ * detection indefinitely.
+ *
+ * @param event Message that failed (from getDueDetectionEvent())
+ */
+void markAlertFailed(DetectionEvent event);
 
 /**
  * Blink the status LED a specified number of times
+ * Blocks until done - only for setup() and fatal error loops.
+ * Use showSuccessPattern()/showErrorPattern() during operation.
+ *
  * @param times Number of blinks
  * @param duration_ms Duration of each blink in milliseconds
  */
@@ -93,21 +184,33 @@ void setWiFiLED(bool state);
 /**
  * Show success pattern on status LED
  * 1 long blink = operation successful
+ * Returns immediately - the pattern is played by updateStatusLED().
  */
 void showSuccessPattern();
 
 /**
  * Show error pattern on status LED
  * Multiple rapid blinks = error
+ * Returns immediately - the pattern is played by updateStatusLED().
  *
  * @param errorCode Number of blinks to show error type
  */
 void showErrorPattern(int errorCode);
 
 /**
- * Update LED blink pattern while object is detected
- * Call this regularly in loop() to maintain continuous blinking
+ * Check if a success/error pattern is currently playing
+ *
+ * @return true if playing, false otherwise
+ */
+bool isStatusPatternPlaying();
+
+/**
+ * Advance the status LED: plays success/error patterns and the
+ * continuous blink while an object is detected
+ * Call this again after the returned delay (done by the LED task).
+ *
+ * @return Milliseconds until the LED next needs updating
  */
-void updateDetectionLED();
+unsigned long updateStatusLED();
 
 #endif // HARDWARE_H
@@ -0,0 +1,70 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// LOGGING MODULE
+// ============================================================================
+// Serial logging with compile-time levels (LOG_LEVEL is set in config.h):
+// - LOG_LEVEL_NONE:  no serial output at all
+// - LOG_LEVEL_ERROR: failures only
+// - LOG_LEVEL_INFO:  errors + startup, state changes and message results
+// - LOG_LEVEL_DEBUG: everything (payloads, hashes, signatures, every reading)
+//
+// Disabled levels expand to an empty statement, so their arguments are never
+// evaluated and their format strings are not even stored in flash.
+// Enabled levels keep format strings in flash (PSTR) and use printf_P.
+// ============================================================================
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_DEBUG 3
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Each macro prints one line: LOG_INFO("[NET] IP: %s", ip) -> "[NET] IP: ...\n"
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) Serial.printf_P(PSTR(fmt "\n"), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) Serial.printf_P(PSTR(fmt "\n"), ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) Serial.printf_P(PSTR(fmt "\n"), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+/**
+ * Print a labelled hex dump of the first bytes of a buffer (debug level only)
+ *
+ * @param label Line prefix, e.g. "[CRYPTO] Hash (first 16 bytes): "
+ * @param data Bytes to print
+ * @param length Number of bytes to print
+ */
+static inline void logDebugHex(const char* label, const uint8_t* data, size_t length) {
+    Serial.print(label);
+    for (size_t i = 0; i < length; i++) {
+        Serial.printf_P(PSTR("%02X"), data[i]);
+    }
+    Serial.println("...");
+}
+#define LOG_DEBUG_HEX(label, data, length) logDebugHex(label, data, length)
+#else
+#define LOG_DEBUG_HEX(label, data, length) do {} while (0)
+#endif
+
+#endif // LOGGING_H
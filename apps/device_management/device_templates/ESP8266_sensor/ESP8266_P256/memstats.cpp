@@ -0,0 +1,81 @@
+#include "config.h"
+#include "memstats.h"
+#include "logging.h"
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static uint32_t minFreeHeap = UINT32_MAX;            // Since boot
+static uint32_t windowMinMaxFreeBlock = UINT32_MAX;  // Since resetMemoryWindow()
+static uint8_t windowMaxFragmentation = 0;           // Since resetMemoryWindow()
+static unsigned long lastHeapWalk = 0;               // millis() of the last getHeapStats()
+static bool heapWalked = false;                      // lastHeapWalk is valid
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+/**
+ * Walk the heap once for free total, largest block and fragmentation
+ *
+ * @return Free heap in bytes
+ */
+static uint32_t walkHeap() {
+    uint32_t freeHeap = 0;
+    uint32_t maxFreeBlock = 0;
+    uint8_t fragmentation = 0;
+    ESP.getHeapStats(&freeHeap, &maxFreeBlock, &fragmentation);
+
+    if (freeHeap < minFreeHeap) {
+        minFreeHeap = freeHeap;
+    }
+    if (maxFreeBlock < windowMinMaxFreeBlock) {
+        windowMinMaxFreeBlock = maxFreeBlock;
+    }
+    if (fragmentation > windowMaxFragmentation) {
+        windowMaxFragmentation = fragmentation;
+    }
+
+    lastHeapWalk = millis();
+    heapWalked = true;
+    return freeHeap;
+}
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+void initializeMemoryStats() {
+    uint32_t freeHeap = walkHeap();
+    LOG_INFO("[MEM] Free heap: %u bytes (largest block %u, fragmentation %u%%)",
+             (unsigned int)freeHeap, (unsigned int)windowMinMaxFreeBlock,
+             (unsigned int)windowMaxFragmentation);
+    (void)freeHeap;  // Only logged
+}
+
+void sampleMemory() {
+    if (!heapWalked || millis() - lastHeapWalk >= MEMORY_HEAP_WALK_INTERVAL) {
+        walkHeap();
+        return;
+    }
+
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < minFreeHeap) {
+        minFreeHeap = freeHeap;
+    }
+}
+
+void getMemoryStats(MemoryStats& stats) {
+    stats.freeHeap = walkHeap();
+    stats.minFreeHeap = minFreeHeap;
+    stats.maxFreeBlock = windowMinMaxFreeBlock;
+    stats.heapFragmentation = windowMaxFragmentation;
+    stats.minFreeStack = ESP.getFreeContStack();  // Painted stack - a high-water mark since boot
+}
+
+void resetMemoryWindow() {
+    windowMinMaxFreeBlock = UINT32_MAX;
+    windowMaxFragmentation = 0;
+    heapWalked = false;  // Next sample starts the window with a heap walk
+}
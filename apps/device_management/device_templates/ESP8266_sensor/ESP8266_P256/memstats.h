@@ -0,0 +1,59 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// MEMORY STATISTICS MODULE
+// ============================================================================
+// This module handles:
+// - Tracking the lowest free heap since boot (sampled every scheduler pass)
+// - Tracking heap fragmentation: the smallest largest-free-block and the
+//   highest fragmentation seen in each heartbeat window
+// - Reading the stack high-water mark of loop() (the cont stack)
+// - Memory figures for the heartbeat "memory" object and diagnostics
+//
+// Free heap is read in constant time on every pass. Largest block and
+// fragmentation walk the heap, so they are sampled at most every
+// MEMORY_HEAP_WALK_INTERVAL. Allocation failures usually come from
+// fragmentation long before the free total runs low.
+// ============================================================================
+
+/**
+ * Memory figures for one heartbeat window (bytes unless noted)
+ */
+struct MemoryStats {
+    uint32_t freeHeap;           // Now
+    uint32_t minFreeHeap;        // Lowest since boot
+    uint32_t maxFreeBlock;       // Smallest largest-free-block in the window
+    uint8_t heapFragmentation;   // Highest fragmentation in the window (%)
+    uint32_t minFreeStack;       // Unused cont stack at its deepest since boot
+};
+
+/**
+ * Start tracking (call once in setup())
+ */
+void initializeMemoryStats();
+
+/**
+ * Record the current heap state (call every scheduler pass)
+ */
+void sampleMemory();
+
+/**
+ * Get the memory figures of the current window
+ * Takes a fresh heap sample first, so the figures include the caller's
+ * current allocations.
+ *
+ * @param stats Output: memory figures
+ */
+void getMemoryStats(MemoryStats& stats);
+
+/**
+ * Start a new fragmentation window (after each heartbeat)
+ * The since-boot minimums are kept.
+ */
+void resetMemoryWindow();
+
+#endif // MEMSTATS_H
@@ -3,7 +3,14 @@
 #include "network.h"
 #include "crypto.h"
 #include "hardware.h"
-#include <ESP8266HTTPClient.h>
+#include "storage.h"
+#include "cbor.h"
+#include "power.h"
+#include "profiling.h"
+#include "memstats.h"
+#include "mqtt.h"
+#include "credentials.h"
+#include "logging.h"
 #include <WiFiClient.h>
 #include <ArduinoJson.h>
 
@@ -14,29 +21,452 @@
 static unsigned long lastHeartbeatTime = 0;
 static bool messagingReady = false;
 
+// Persistent server connection (reused across heartbeats and alerts)
+static WiFiClient serverClient;
+static char serverHost[SERVER_HOST_BUFFER_SIZE] = "";
+static uint16_t serverPort = 80;
+static const char* serverPath = "/";
+
+// Session issued by the server after a certificate-authenticated request
+// (sent as X-Device-Session instead of the ~1.5 KB certificate header)
+static char sessionId[SESSION_ID_BUFFER_SIZE] = "";
+static unsigned long sessionIssuedAt = 0;         // millis() when the session was received
+static unsigned long sessionLifetimeMs = 0;
+
+// Connection statistics (for serial diagnostics)
+static unsigned long connectCount = 0;            // TCP connections opened since boot
+static unsigned long requestCount = 0;            // HTTP requests sent since boot
+static unsigned long requestsOnConnection = 0;    // Requests sent on the current socket
+static unsigned long totalConnectMs = 0;
+static unsigned long totalRequestMs = 0;
+
+// ============================================================================
+// OUTBOUND PIPELINE STATE
+// ============================================================================
+
+// Network error codes (same numbering as ESP8266HTTPClient HTTPC_ERROR_*)
+static const int SEND_ERROR_CONNECTION_FAILED = -1;
+static const int SEND_ERROR_SEND_FAILED = -3;
+static const int SEND_ERROR_NOT_CONNECTED = -4;
+static const int SEND_ERROR_CONNECTION_LOST = -5;
+static const int SEND_ERROR_READ_TIMEOUT = -11;
+static const int SEND_ERROR_SERVER_BACKOFF = -12;     // Not sent - waiting after a failed connect (see holdServerConnections())
+static const int SEND_ERROR_SIGNING_FAILED = -100;    // Device-side error, no request was sent
+
+// Result of a publish acknowledged by the MQTT broker (PUBACK) - handled like an HTTP 200
+static const int SEND_RESULT_PUBLISHED = 200;
+
+/**
+ * Send pipeline states
+ * Each call to processOutboundQueue() advances the current message by at
+ * most one step, so loop() never waits on the network.
+ */
+enum SendState {
+    SEND_IDLE,                // Nothing in flight
+    SEND_CONNECTING,          // Ensure the persistent socket is open
+    SEND_OPENING_SESSION,     // Transport handshake on a new socket (MQTT CONNECT, certificate)
+    SEND_SENDING,             // Write request head and body as buffer space allows
+    SEND_AWAITING_RESPONSE,   // Read and parse response bytes as they arrive
+    SEND_DONE                 // Report result and release the queue slot
+};
+
+/**
+ * Progress of a transport session handshake (see MessageTransport::openSession)
+ */
+enum SessionStatus {
+    SESSION_PENDING,          // Waiting for buffer space or broker packets
+    SESSION_OPEN,             // Ready for requests
+    SESSION_FAILED            // Refused, malformed or disconnected
+};
+
+/**
+ * Position in a "Transfer-Encoding: chunked" response body
+ * (common behind reverse proxies on keep-alive connections).
+ */
+enum ChunkState {
+    CHUNK_SIZE_LINE,          // Hex chunk size (extensions after ';' ignored)
+    CHUNK_DATA,               // Chunk bytes
+    CHUNK_DATA_END,           // CRLF after the chunk bytes
+    CHUNK_TRAILER             // Trailer lines after the last (0) chunk until a blank line
+};
+
+/**
+ * Queued message waiting to be sent
+ * Fixed-size buffers - messages are built in place with no heap allocation.
+ * Messages are signed when they are sent (once per batch); a message
+ * drained from the offline store may still carry its own signature.
+ */
+struct OutboundMessage {
+    MessageType type;
+    char payload[MESSAGE_PAYLOAD_BUFFER_SIZE];
+    size_t payloadLength;
+    uint8_t digest[MESSAGE_DIGEST_SIZE];       // SHA-256 of payload, computed while serializing
+    bool hasDigest;                            // false for messages read back from the offline store
+    bool fromOfflineStore;                     // Still in flash - never stored again if the resend fails
+    char signature[SIGNATURE_BUFFER_SIZE];     // Base64 DER signature + null ("" = not signed yet)
+};
+
+/**
+ * Message transport
+ * The send pipeline signs each batch body once and hands it to the
+ * transport selected by MESSAGE_TRANSPORT. Both transports use the
+ * persistent serverClient socket and writeRequestChunk(); they differ in
+ * framing and in how the result is read back.
+ */
+struct MessageTransport {
+    const char* name;                          // Used in log lines ("HTTP 200")
+    bool (*begin)();                           // Parse configuration (initializeMessaging)
+    bool (*connect)(unsigned long& connectMs); // Open the persistent connection if needed
+    SessionStatus (*openSession)();            // Advance the handshake on a new socket (nullptr if none)
+    void (*prepare)();                         // Build request segments for the current batch
+    bool (*readReply)();                       // Consume reply bytes - true once sendResult is set
+    bool (*replyStarted)();                    // Part of a reply arrived (the server saw the request)
+    void (*maintain)();                        // Housekeeping while idle (nullptr if none)
+};
+
+static OutboundMessage outboundQueue[OUTBOUND_QUEUE_SIZE];
+static uint8_t queueHead = 0;                     // Index of the oldest queued message
+static uint8_t queueCount = 0;
+
+// Alerts built while offline (or with a full queue) go to the offline store
+static OutboundMessage offlineMessage;
+
+// Backoff after a failed resend of stored alerts (0 = last resend succeeded)
+static unsigned long offlineRetryDelay = 0;
+static unsigned long offlineRetryStart = 0;       // millis() when the last resend failed
+
+// Backoff after a failed connect to the server (0 = last connect succeeded)
+static unsigned long serverRetryDelay = 0;
+static unsigned long serverRetryStart = 0;        // millis() when the last connect failed
+
+static SendState sendState = SEND_IDLE;
+static int sendResult = 0;                        // HTTP status code or SEND_ERROR_* code
+static bool sendOnReusedSocket = false;
+static bool sendRetried = false;
+static bool sendWithSession = false;              // Current request authenticated with sessionId
+static bool sessionRetried = false;               // Already re-sent with the certificate after a 401
+static unsigned long stateStartTime = 0;          // millis() when current state was entered
+static unsigned long sendConnectMs = 0;
+static unsigned long sendRequestStart = 0;
+static uint32_t sendRequestCycles = 0;            // Cycle counter when the request started (profiling)
+
+// Batch being sent: the oldest batchCount queued messages, signed once
+static uint8_t batchCount = 0;
+static char batchSignature[SIGNATURE_BUFFER_SIZE];
+static const char* batchSignaturePtr = "";        // batchSignature, or the message's own signature
+
+// Body segments: the payload alone, or "[" p1 "," p2 ... "]" for a batch
+// (CBOR batch: array header followed by the encoded messages)
+static uint8_t batchArrayHeader[5];
+static const uint8_t MAX_BODY_SEGMENTS = 2 * MESSAGE_BATCH_MAX_SIZE + 1;
+static const char* bodySegments[MAX_BODY_SEGMENTS];
+static size_t bodySegmentLengths[MAX_BODY_SEGMENTS];
+static uint8_t bodySegmentCount = 0;
+static size_t bodyLength = 0;
+
+// Request being written (segments avoid copying certificate and payloads)
+static const uint8_t HEADER_SEGMENT_COUNT = 5;
+static const uint8_t MAX_REQUEST_SEGMENTS = HEADER_SEGMENT_COUNT + MAX_BODY_SEGMENTS;
+static char requestHead[REQUEST_HEAD_BUFFER_SIZE];
+static const char* requestSegments[MAX_REQUEST_SEGMENTS];
+static size_t requestSegmentLengths[MAX_REQUEST_SEGMENTS];
+static uint8_t requestSegmentCount = 0;
+static uint8_t requestSegmentIndex = 0;
+static size_t requestSegmentOffset = 0;
+
+// Response parser
+static char responseLine[RESPONSE_LINE_BUFFER_SIZE];
+static size_t responseLineLength = 0;
+static bool responseHeadersDone = false;
+static long responseContentLength = -1;           // -1 = not provided by server
+static long responseBodyReceived = 0;
+static bool responseKeepAlive = true;
+static bool responseChunked = false;
+static ChunkState responseChunkState = CHUNK_SIZE_LINE;
+static long responseChunkRemaining = 0;
+static char responseBody[RESPONSE_BODY_BUFFER_SIZE];
+static size_t responseBodyLength = 0;
+
+#if MESSAGE_TRANSPORT == TRANSPORT_MQTT
+// MQTT transport
+static MqttReader mqttReader;
+static char mqttMessageTopic[MQTT_TOPIC_BUFFER_SIZE];      // <prefix>/<device_id>/messages/<format>
+static char mqttCertificateTopic[MQTT_TOPIC_BUFFER_SIZE];  // <prefix>/<device_id>/certificate
+static uint16_t mqttLastPacketId = 0;
+static uint16_t mqttPublishId = 0;                // Packet identifier of the batch in flight
+static unsigned long mqttLastSendTime = 0;        // millis() of the last packet sent (keep-alive)
+static bool mqttPingOutstanding = false;
+static unsigned long mqttPingSentTime = 0;
+
+/**
+ * Steps of the session handshake on a new MQTT connection
+ */
+enum MqttSessionStep {
+    MQTT_SESSION_CONNECT,     // Write CONNECT
+    MQTT_SESSION_CONNACK,     // Read CONNACK
+    MQTT_SESSION_CERTIFICATE, // Write the retained certificate PUBLISH
+    MQTT_SESSION_PUBACK       // Read its PUBACK
+};
+
+static MqttSessionStep mqttSessionStep = MQTT_SESSION_CONNECT;
+static uint16_t mqttCertificateId = 0;            // Packet identifier of the certificate publish
+
+static_assert(MQTT_TOPIC_BUFFER_SIZE + 9 <= REQUEST_HEAD_BUFFER_SIZE,
+              "PUBLISH header (topic, packet ID, fixed header) must fit in requestHead");
+#endif
+
 // ============================================================================
 // INTERNAL HELPER FUNCTIONS
 // ============================================================================
 
+#if MESSAGE_WIRE_FORMAT == WIRE_FORMAT_CBOR
+static const char* MESSAGE_CONTENT_TYPE = "application/cbor";
+#else
+static const char* MESSAGE_CONTENT_TYPE = "application/json";
+#endif
+
+/**
+ * ArduinoJson output sink that hashes bytes as it writes them
+ * The payload lands in the message buffer and its digest is complete as
+ * soon as serialization finishes - no second pass over the payload.
+ */
+class DigestingWriter {
+public:
+    DigestingWriter(char* buffer, size_t size, MessageDigestContext* digest)
+        : buffer(buffer), size(size), length(0), overflowed(false), digest(digest) {}
+
+    size_t write(uint8_t c) {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t count) {
+        // Keep room for the null terminator
+        if (overflowed || length + count >= size) {
+            overflowed = true;
+            return 0;
+        }
+        memcpy(buffer + length, data, count);
+        length += count;
+        if (digest != nullptr) {
+            updateMessageDigest(*digest, data, count);
+        }
+        return count;
+    }
+
+    char* buffer;
+    size_t size;
+    size_t length;
+    bool overflowed;
+
+private:
+    MessageDigestContext* digest;
+};
+
+/**
+ * Count the profile points with samples in the current window
+ *
+ * @return Number of points to report
+ */
+static uint8_t countProfiledPoints() {
+    uint8_t count = 0;
+    ProfileSummary summary;
+    for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+        if (getProfileSummary((ProfilePoint)i, summary)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Close the profiling window and add the heartbeat "performance" object
+ * Each point with samples becomes [count, min, avg, max, p99] in microseconds.
+ *
+ * @param data Heartbeat data object
+ */
+static void addPerformanceJson(JsonObject data) {
+    closeProfileWindow();
+    if (countProfiledPoints() > 0) {
+        JsonObject performance = data.createNestedObject("performance");
+        ProfileSummary summary;
+        for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+            if (!getProfileSummary((ProfilePoint)i, summary)) {
+                continue;
+            }
+            JsonArray entry = performance.createNestedArray(getProfilePointName((ProfilePoint)i));
+            entry.add(summary.count);
+            entry.add(summary.minMicros);
+            entry.add(summary.avgMicros);
+            entry.add(summary.maxMicros);
+            entry.add(summary.p99Micros);
+        }
+    }
+}
+
+/**
+ * Write the heartbeat performance map (CBOR_KEY_PERFORMANCE)
+ * Map of ProfilePoint index → [count, min, avg, max, p99] in microseconds.
+ *
+ * @param writer CBOR writer
+ * @param pointCount Result of countProfiledPoints() after closeProfileWindow() (map key written if > 0)
+ */
+static void writePerformanceCbor(CborWriter& writer, uint8_t pointCount) {
+    if (pointCount > 0) {
+        cborWriteUnsigned(writer, CBOR_KEY_PERFORMANCE);
+        cborWriteMapHeader(writer, pointCount);
+        ProfileSummary summary;
+        for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+            if (!getProfileSummary((ProfilePoint)i, summary)) {
+                continue;
+            }
+            cborWriteUnsigned(writer, i);
+            cborWriteArrayHeader(writer, 5);
+            cborWriteUnsigned(writer, summary.count);
+            cborWriteUnsigned(writer, summary.minMicros);
+            cborWriteUnsigned(writer, summary.avgMicros);
+            cborWriteUnsigned(writer, summary.maxMicros);
+            cborWriteUnsigned(writer, summary.p99Micros);
+        }
+    }
+}
+
+/**
+ * Add the heartbeat "memory" array and start a new fragmentation window
+ * [min free heap, smallest largest block, highest fragmentation %, min free stack]
+ *
+ * @param data Heartbeat data object
+ */
+static void addMemoryJson(JsonObject data) {
+    MemoryStats stats;
+    getMemoryStats(stats);
+
+    JsonArray memory = data.createNestedArray("memory");
+    memory.add(stats.minFreeHeap);
+    memory.add(stats.maxFreeBlock);
+    memory.add(stats.heapFragmentation);
+    memory.add(stats.minFreeStack);
+    resetMemoryWindow();
+}
+
+/**
+ * Write the heartbeat memory array (CBOR_KEY_MEMORY) and start a new
+ * fragmentation window
+ *
+ * @param writer CBOR writer
+ */
+static void writeMemoryCbor(CborWriter& writer) {
+    MemoryStats stats;
+    getMemoryStats(stats);
+
+    cborWriteUnsigned(writer, CBOR_KEY_MEMORY);
+    cborWriteArrayHeader(writer, 4);
+    cborWriteUnsigned(writer, stats.minFreeHeap);
+    cborWriteUnsigned(writer, stats.maxFreeBlock);
+    cborWriteUnsigned(writer, stats.heapFragmentation);
+    cborWriteUnsigned(writer, stats.minFreeStack);
+    resetMemoryWindow();
+}
+
+/**
+ * Get the detection_state value of an alert
+ *
+ * @param event Detection session message
+ * @return "opened", "update" or "closed"
+ */
+static const char* getDetectionStateName(DetectionEvent event) {
+    switch (event) {
+        case DETECTION_UPDATE: return "update";
+        case DETECTION_CLOSED: return "closed";
+        default:               return "opened";
+    }
+}
+
+// Longest distance text: "6553.5" + null
+static const size_t DISTANCE_TEXT_SIZE = 8;
+
+/**
+ * Format a distance for JSON as centimetres with one decimal ("24.7")
+ * Integer formatting only - ArduinoJson would print a float through soft-float.
+ *
+ * @param distanceMm Distance in mm
+ * @param text Output buffer (DISTANCE_TEXT_SIZE bytes)
+ * @return text, to be added with serialized() while it is in scope
+ */
+static const char* formatDistanceCm(uint16_t distanceMm, char* text) {
+    snprintf(text, DISTANCE_TEXT_SIZE, "%u.%u", (unsigned int)(distanceMm / 10), (unsigned int)(distanceMm % 10));
+    return text;
+}
+
+#if SENSOR_COUNT > 1
+/**
+ * Add the per-sensor readings of a multi-sensor node (cm, null = no valid echo)
+ *
+ * @param data Alert data object
+ * @param texts Formatted readings, must outlive serialization
+ */
+static void addSensorReadingsJson(JsonObject data, char (*texts)[DISTANCE_TEXT_SIZE]) {
+    JsonArray readings = data.createNestedArray("sensor_readings_cm");
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        uint16_t reading = getSensorReadingMm(i);
+        if (reading > 0) {
+            readings.add(serialized(formatDistanceCm(reading, texts[i])));
+        } else {
+            readings.add();  // New element stays null
+        }
+    }
+}
+
+/**
+ * Write the per-sensor readings (CBOR_KEY_SENSOR_READINGS_MM, mm, 0 = no valid echo)
+ *
+ * @param writer CBOR writer
+ */
+static void writeSensorReadingsCbor(CborWriter& writer) {
+    cborWriteUnsigned(writer, CBOR_KEY_SENSOR_READINGS_MM);
+    cborWriteArrayHeader(writer, SENSOR_COUNT);
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        cborWriteUnsigned(writer, getSensorReadingMm(i));
+    }
+}
+#endif
+
 /**
  * Create JSON message payload
+ * Serializes straight into the caller's buffer - no heap allocation.
+ * The digest (if given) is fed in the same pass.
  *
+ * @param buffer Output buffer for the JSON text
+ * @param bufferSize Size of output buffer in bytes
+ * @param digest Digest context fed with the payload bytes (or nullptr)
  * @param type Message type (HEARTBEAT or ALERT)
- * @param distance Distance in cm (only for ALERT type)
+ * @param distanceMm Distance in mm (only for ALERT type; closest distance when closed)
  * @param durationSeconds Duration in seconds (only for ALERT type)
  * @param firstDetectedTimestamp ISO timestamp (only for ALERT type)
- * @return JSON string
+ * @param event Detection session message (only for ALERT type)
+ * @return Length of JSON written (excluding null), or 0 if it did not fit
  */
-static String createMessagePayload(MessageType type, float distance = 0.0,
-                                   unsigned long durationSeconds = 0,
-                                   const String& firstDetectedTimestamp = "") {
+static size_t createJsonPayload(char* buffer, size_t bufferSize,
+                                MessageDigestContext* digest, MessageType type, uint16_t distanceMm,
+                                unsigned long durationSeconds,
+                                const char* firstDetectedTimestamp, DetectionEvent event) {
     // Create JSON document
     // Size: Calculated based on expected message size
     StaticJsonDocument<MESSAGE_JSON_DOC_SIZE> doc;
     
+    // Timestamp buffer outlives serialization, so ArduinoJson can reference it
+    char timestamp[TIMESTAMP_BUFFER_SIZE];
+    getCurrentTimestamp(timestamp, sizeof(timestamp));
+    bool timeSynced = isTimeSynced();  // Flag only sent while unsynced (cached or no time)
+
+    // Distances are referenced the same way (written as numbers, see formatDistanceCm())
+    char distance[DISTANCE_TEXT_SIZE];
+#if SENSOR_COUNT > 1
+    char sensorReadings[SENSOR_COUNT][DISTANCE_TEXT_SIZE];
+#endif
+
     // Add common fields
-    doc["device_id"] = DEVICE_ID;
-    doc["timestamp"] = getCurrentTimestamp();
+    doc["device_id"] = (const char*)getCredentials().deviceId;
+    doc["timestamp"] = (const char*)timestamp;
     
     if (type == HEARTBEAT) {
         doc["message_type"] = "heartbeat";
@@ -47,25 +477,233 @@ static String createMessagePayload(MessageType type, float distance = 0.0,
         status["uptime"] = getUptimeSeconds();
         status["wifi_rssi"] = getWiFiRSSI();
         status["free_memory"] = ESP.getFreeHeap();
+        status["power_mode"] = getPowerModeName();
+        status["estimated_energy_mwh_per_hour"] = takeEstimatedEnergyPerHour();
+        status["firmware_version"] = FIRMWARE_VERSION;
+        if (!timeSynced) {
+            status["time_synced"] = false;
+        }
+        addPerformanceJson(status);
+        addMemoryJson(status);
         
     } else if (type == ALERT) {
         doc["message_type"] = "alert";
 
         // Add detection information with sensor data
         JsonObject detection = doc.createNestedObject("data");
-        detection["event"] = "ultrasonic_detection";
-        detection["sensor_type"] = "HC-SR04";
-        detection["detected_distance_cm"] = distance;
-        detection["detection_duration_seconds"] = durationSeconds;
-        detection["first_detected_at"] = firstDetectedTimestamp;
-        detection["confidence"] = 1.0;
+        detection["detection_state"] = getDetectionStateName(event);
+        formatDistanceCm(distanceMm, distance);
+        if (event == DETECTION_CLOSED) {
+            // Summary of the whole detection
+            detection["closest_distance_cm"] = serialized((const char*)distance);
+            detection["detection_duration_seconds"] = durationSeconds;
+            detection["first_detected_at"] = firstDetectedTimestamp;
+        } else if (event == DETECTION_UPDATE) {
+            // Delta only - the context went out with the opened message
+            detection["detected_distance_cm"] = serialized((const char*)distance);
+            detection["detection_duration_seconds"] = durationSeconds;
+        } else {
+            detection["event"] = "ultrasonic_detection";
+            detection["sensor_type"] = "HC-SR04";
+            detection["detected_distance_cm"] = serialized((const char*)distance);
+            detection["detection_duration_seconds"] = durationSeconds;
+            detection["first_detected_at"] = firstDetectedTimestamp;
+            detection["confidence"] = serialized("1.0");
+        }
+        if (!timeSynced) {
+            detection["time_synced"] = false;
+        }
+#if SENSOR_COUNT > 1
+        if (event != DETECTION_CLOSED) {
+            addSensorReadingsJson(detection, sensorReadings);
+        }
+#endif
     }
     
-    // Serialize to string
-    String payload;
-    serializeJson(doc, payload);
-    
-    return payload;
+    // Serialize (and hash) into caller's buffer in one pass
+    // (must fit completely, including null)
+    DigestingWriter writer(buffer, bufferSize, digest);
+    if (!doc.overflowed()) {
+        serializeJson(doc, writer);
+    }
+
+    if (doc.overflowed() || writer.overflowed) {
+        LOG_ERROR("[MSG] Payload does not fit in %u bytes!", (unsigned int)bufferSize);
+        return 0;
+    }
+
+    buffer[writer.length] = '\0';
+    return writer.length;
+}
+
+/**
+ * Create CBOR message payload (compact binary schema, see cbor.h)
+ * Integer keys, epoch-second timestamps and millimetre distances -
+ * roughly a third of the JSON size.
+ *
+ * @param buffer Output buffer for the CBOR bytes
+ * @param bufferSize Size of output buffer in bytes
+ * @param digest Digest context fed with the payload bytes (or nullptr)
+ * @param type Message type (HEARTBEAT or ALERT)
+ * @param distanceMm Distance in mm (only for ALERT type; closest distance when closed)
+ * @param durationSeconds Duration in seconds (only for ALERT type)
+ * @param event Detection session message (only for ALERT type)
+ * @return Length of CBOR written, or 0 if it did not fit
+ */
+static size_t createCborPayload(uint8_t* buffer, size_t bufferSize,
+                                MessageDigestContext* digest, MessageType type, uint16_t distanceMm,
+                                unsigned long durationSeconds, DetectionEvent event) {
+    unsigned long now = getCurrentEpochSeconds();
+    bool timeSynced = isTimeSynced();  // Flag only sent while unsynced (cached or no time)
+
+    CborWriter writer;
+    cborBegin(writer, buffer, bufferSize, digest);
+
+    // Common fields
+    cborWriteTag(writer, CBOR_SCHEMA_TAG);
+    cborWriteMapHeader(writer, 5);
+    cborWriteUnsigned(writer, CBOR_KEY_SCHEMA_VERSION);
+    cborWriteUnsigned(writer, CBOR_SCHEMA_VERSION);
+    cborWriteUnsigned(writer, CBOR_KEY_DEVICE_ID);
+    cborWriteText(writer, getCredentials().deviceId);
+    cborWriteUnsigned(writer, CBOR_KEY_MESSAGE_TYPE);
+    cborWriteUnsigned(writer, type == HEARTBEAT ? CBOR_MESSAGE_TYPE_HEARTBEAT : CBOR_MESSAGE_TYPE_ALERT);
+    cborWriteUnsigned(writer, CBOR_KEY_TIMESTAMP);
+    cborWriteUnsigned(writer, now);
+    cborWriteUnsigned(writer, CBOR_KEY_DATA);
+
+    if (type == HEARTBEAT) {
+        // Status information
+        closeProfileWindow();
+        uint8_t profiledPoints = countProfiledPoints();
+        cborWriteMapHeader(writer, (timeSynced ? 8 : 9) + (profiledPoints > 0 ? 1 : 0));
+        if (!timeSynced) {
+            cborWriteUnsigned(writer, CBOR_KEY_TIME_SYNCED);
+            cborWriteBool(writer, false);
+        }
+        cborWriteUnsigned(writer, CBOR_KEY_STATUS);
+        cborWriteUnsigned(writer, CBOR_STATUS_ONLINE);
+        cborWriteUnsigned(writer, CBOR_KEY_UPTIME);
+        cborWriteUnsigned(writer, getUptimeSeconds());
+        cborWriteUnsigned(writer, CBOR_KEY_WIFI_RSSI);
+        cborWriteSigned(writer, getWiFiRSSI());
+        cborWriteUnsigned(writer, CBOR_KEY_FREE_MEMORY);
+        cborWriteUnsigned(writer, ESP.getFreeHeap());
+        cborWriteUnsigned(writer, CBOR_KEY_POWER_MODE);
+        cborWriteUnsigned(writer, POWER_MODE);
+        cborWriteUnsigned(writer, CBOR_KEY_ESTIMATED_ENERGY_MWH_PER_HOUR);
+        cborWriteUnsigned(writer, takeEstimatedEnergyPerHour());
+        cborWriteUnsigned(writer, CBOR_KEY_FIRMWARE_VERSION);
+        cborWriteText(writer, FIRMWARE_VERSION);
+        writePerformanceCbor(writer, profiledPoints);
+        writeMemoryCbor(writer);
+
+    } else {
+        // Detection information - first detection derived from duration
+        // (no ISO string parsing)
+        unsigned long firstDetectedAt = (now > durationSeconds) ? now - durationSeconds : now;
+        bool withReadings = SENSOR_COUNT > 1 && event != DETECTION_CLOSED;
+
+        // Opened: full context, update: distance and duration, closed: summary
+        uint32_t pairs = (event == DETECTION_CLOSED) ? 4 : (event == DETECTION_UPDATE) ? 3 : 7;
+        cborWriteMapHeader(writer, pairs + (timeSynced ? 0 : 1) + (withReadings ? 1 : 0));
+        if (!timeSynced) {
+            cborWriteUnsigned(writer, CBOR_KEY_TIME_SYNCED);
+            cborWriteBool(writer, false);
+        }
+        if (event == DETECTION_OPENED) {
+            cborWriteUnsigned(writer, CBOR_KEY_EVENT);
+            cborWriteUnsigned(writer, CBOR_EVENT_ULTRASONIC_DETECTION);
+            cborWriteUnsigned(writer, CBOR_KEY_SENSOR_TYPE);
+            cborWriteUnsigned(writer, CBOR_SENSOR_HC_SR04);
+        }
+        if (event != DETECTION_CLOSED) {
+            cborWriteUnsigned(writer, CBOR_KEY_DISTANCE_MM);
+            cborWriteUnsigned(writer, distanceMm);
+        }
+        cborWriteUnsigned(writer, CBOR_KEY_DURATION_SECONDS);
+        cborWriteUnsigned(writer, durationSeconds);
+        if (event != DETECTION_UPDATE) {
+            cborWriteUnsigned(writer, CBOR_KEY_FIRST_DETECTED_AT);
+            cborWriteUnsigned(writer, firstDetectedAt);
+        }
+        if (event == DETECTION_OPENED) {
+            cborWriteUnsigned(writer, CBOR_KEY_CONFIDENCE);
+            cborWriteUnsigned(writer, 100);  // Percent
+        }
+#if SENSOR_COUNT > 1
+        if (withReadings) {
+            writeSensorReadingsCbor(writer);
+        }
+#endif
+        cborWriteUnsigned(writer, CBOR_KEY_DETECTION_STATE);
+        cborWriteUnsigned(writer, event);  // DetectionEvent value (1 opened, 2 update, 3 closed)
+        if (event == DETECTION_CLOSED) {
+            cborWriteUnsigned(writer, CBOR_KEY_CLOSEST_DISTANCE_MM);
+            cborWriteUnsigned(writer, distanceMm);
+        }
+    }
+
+    if (writer.overflowed) {
+        LOG_ERROR("[MSG] Payload does not fit in %u bytes!", (unsigned int)bufferSize);
+        return 0;
+    }
+
+    return writer.length;
+}
+
+/**
+ * Build a message payload in the configured wire format (MESSAGE_WIRE_FORMAT)
+ * Writes the payload into the message and computes its SHA-256 digest in
+ * the same pass, so signing needs no second pass over the payload.
+ *
+ * @param message Message to fill in (payload, payloadLength, digest)
+ * @param type Message type (HEARTBEAT or ALERT)
+ * @param distanceMm Distance in mm (only for ALERT type)
+ * @param durationSeconds Duration in seconds (only for ALERT type)
+ * @param firstDetectedTimestamp ISO timestamp (only for ALERT type, JSON format)
+ * @param event Detection session message (only for ALERT type)
+ * @return Length of payload written, or 0 if it did not fit
+ */
+static size_t createMessagePayload(OutboundMessage* message,
+                                   MessageType type, uint16_t distanceMm = 0,
+                                   unsigned long durationSeconds = 0,
+                                   const char* firstDetectedTimestamp = "",
+                                   DetectionEvent event = DETECTION_OPENED) {
+    uint32_t start = profileStart();
+    MessageDigestContext digest;
+    beginMessageDigest(digest);
+
+#if MESSAGE_WIRE_FORMAT == WIRE_FORMAT_CBOR
+    message->payloadLength = createCborPayload((uint8_t*)message->payload, sizeof(message->payload), &digest,
+                                               type, distanceMm, durationSeconds, event);
+#else
+    message->payloadLength = createJsonPayload(message->payload, sizeof(message->payload), &digest,
+                                               type, distanceMm, durationSeconds, firstDetectedTimestamp, event);
+#endif
+
+    message->hasDigest = message->payloadLength > 0;
+    if (message->hasDigest) {
+        finishMessageDigest(digest, message->digest);
+        profileEnd(PROFILE_CREATE_PAYLOAD, start);
+    }
+    return message->payloadLength;
+}
+
+/**
+ * Print a built payload (debug level only)
+ *
+ * @param payload Payload bytes
+ * @param payloadLength Payload length in bytes
+ */
+static void logPayload(const char* payload, size_t payloadLength) {
+#if MESSAGE_WIRE_FORMAT == WIRE_FORMAT_CBOR
+    LOG_DEBUG("[MSG] Payload: %u bytes CBOR", (unsigned int)payloadLength);
+    LOG_DEBUG_HEX("[MSG] Payload (first 16 bytes): ", (const uint8_t*)payload,
+                  payloadLength < 16 ? payloadLength : 16);
+#else
+    LOG_DEBUG("[MSG] Payload: %s", payload);
+#endif
 }
 
 /**
@@ -75,7 +713,7 @@ static String createMessagePayload(MessageType type, float distance = 0.0,
  */
 static bool handleHTTPSuccess(int httpCode) {
     if (httpCode == 200 || httpCode == 201) {
-        Serial.println("\n[MSG] SUCCESS - Message accepted by server");
+        LOG_INFO("[MSG] SUCCESS - Message accepted by server");
         showSuccessPattern();
         return true;
     }
@@ -89,23 +727,22 @@ static bool handleHTTPSuccess(int httpCode) {
  */
 static void handleHTTPClientError(int httpCode) {
     if (httpCode == 400) {
-        Serial.println("\n[MSG] BAD REQUEST (400)");
-        Serial.println("[MSG] Possible causes:");
-        Serial.println("[MSG]   - Invalid JSON payload");
-        Serial.println("[MSG]   - Missing required fields");
+        LOG_ERROR("[MSG] BAD REQUEST (400)");
+        LOG_ERROR("[MSG] Possible causes:");
+        LOG_ERROR("[MSG]   - Invalid JSON payload");
+        LOG_ERROR("[MSG]   - Missing required fields");
         showErrorPattern(3);
 
     } else if (httpCode == 401 || httpCode == 403) {
-        Serial.println("\n[MSG] AUTHENTICATION FAILED (401/403)");
-        Serial.println("[MSG] Possible causes:");
-        Serial.println("[MSG]   - Invalid certificate");
-        Serial.println("[MSG]   - Invalid signature");
-        Serial.println("[MSG]   - Certificate expired or revoked");
+        LOG_ERROR("[MSG] AUTHENTICATION FAILED (401/403)");
+        LOG_ERROR("[MSG] Possible causes:");
+        LOG_ERROR("[MSG]   - Invalid certificate");
+        LOG_ERROR("[MSG]   - Invalid signature");
+        LOG_ERROR("[MSG]   - Certificate expired or revoked");
         showErrorPattern(4);
 
     } else {
-        Serial.print("\n[MSG] CLIENT ERROR: ");
-        Serial.println(httpCode);
+        LOG_ERROR("[MSG] CLIENT ERROR: %d", httpCode);
         showErrorPattern(6);
     }
 }
@@ -116,8 +753,8 @@ static void handleHTTPClientError(int httpCode) {
  * @param httpCode HTTP response code
  */
 static void handleHTTPServerError(int httpCode) {
-    Serial.println("\n[MSG] SERVER ERROR (5xx)");
-    Serial.println("[MSG] The C3DS server encountered an error");
+    LOG_ERROR("[MSG] SERVER ERROR (5xx)");
+    LOG_ERROR("[MSG] The C3DS server encountered an error");
     showErrorPattern(5);
 }
 
@@ -127,36 +764,41 @@ static void handleHTTPServerError(int httpCode) {
  * @param errorCode HTTP client error code
  */
 static void handleNetworkError(int errorCode) {
-    Serial.println("[MSG] HTTP REQUEST FAILED");
-    Serial.print("[MSG] Error code: ");
-    Serial.println(errorCode);
+    LOG_ERROR("[MSG] HTTP REQUEST FAILED");
+    LOG_ERROR("[MSG] Error code: %d", errorCode);
 
     // Common ESP8266 HTTP error codes
     switch (errorCode) {
         case -1:
-            Serial.println("[MSG] Connection failed - Cannot reach server");
-            Serial.println("[MSG] Check:");
-            Serial.println("[MSG]   - Server is running");
-            Serial.println("[MSG]   - SERVER_URL is correct");
-            Serial.println("[MSG]   - Device and server on same network");
+            LOG_ERROR("[MSG] Connection failed - Cannot reach server");
+            LOG_ERROR("[MSG] Check:");
+            LOG_ERROR("[MSG]   - Server is running");
+            LOG_ERROR("[MSG]   - SERVER_URL is correct");
+            LOG_ERROR("[MSG]   - Device and server on same network");
             break;
         case -2:
-            Serial.println("[MSG] Send header failed");
+            LOG_ERROR("[MSG] Send header failed");
             break;
         case -3:
-            Serial.println("[MSG] Send payload failed");
+            LOG_ERROR("[MSG] Send payload failed");
             break;
         case -4:
-            Serial.println("[MSG] Not connected");
+            LOG_ERROR("[MSG] Not connected");
             break;
         case -5:
-            Serial.println("[MSG] Connection lost");
+            LOG_ERROR("[MSG] Connection lost");
             break;
         case -11:
-            Serial.println("[MSG] Read timeout");
+            LOG_ERROR("[MSG] Read timeout");
+            break;
+        case -12:
+            LOG_ERROR("[MSG] Server unreachable - not sent, waiting before the next connect");
+            break;
+        case -100:
+            LOG_ERROR("[MSG] Signing failed - request not sent");
             break;
         default:
-            Serial.println("[MSG] Unknown error");
+            LOG_ERROR("[MSG] Unknown error");
             break;
     }
 
@@ -164,199 +806,1477 @@ static void handleNetworkError(int errorCode) {
 }
 
 
+// ============================================================================
+// CONNECTION MANAGEMENT
+// ============================================================================
+
 /**
- * Send HTTP POST request with signed message
+ * Extract host, port and path from SERVER_URL
+ * Expected format: "http://host[:port]/path"
  *
- * @param payload JSON message payload
- * @param signature ECDSA signature of the payload
- * @return true if request successful (HTTP 200/201), false otherwise
+ * @return true if URL was parsed successfully, false otherwise
  */
-static bool sendHTTPRequest(const String& payload, const String& signature) {
-    WiFiClient client;
-    HTTPClient http;
-    
-    Serial.println("\n[MSG] ═══════════════════════════════════");
-    Serial.println("[MSG] Sending HTTP Request");
-    Serial.println("[MSG] ═══════════════════════════════════");
-    
-    // Begin HTTP connection
-    Serial.print("[MSG] URL: ");
-    Serial.println(SERVER_URL);
-    
-    if (!http.begin(client, SERVER_URL)) {
-        Serial.println("[MSG] Failed to begin HTTP connection");
+static bool parseServerURL() {
+    const char* host = strstr(SERVER_URL, "://");
+    host = (host != nullptr) ? host + 3 : SERVER_URL;
+
+    // Host ends at port separator or start of path
+    size_t hostLength = strcspn(host, ":/");
+    if (hostLength == 0 || hostLength >= sizeof(serverHost)) {
         return false;
     }
-    
-    // Set request headers
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-Device-Certificate", DEVICE_CERTIFICATE_B64);
-    http.addHeader("X-Device-Signature", signature);
-    
-    Serial.println("[MSG] Headers:");
-    Serial.println("[MSG]   Content-Type: application/json");
-    Serial.print("[MSG]   X-Device-Certificate: ");
-    Serial.print(String(DEVICE_CERTIFICATE_B64).substring(0, 50));
-    Serial.println("...");
-    Serial.print("[MSG]   X-Device-Signature: ");
-    Serial.println(signature);
-    
-    // Set timeout
-    http.setTimeout(HTTP_TIMEOUT);
-    
-    // Send POST request
-    Serial.println("\n[MSG] Payload:");
-    Serial.println(payload);
-    Serial.println();
-    
-    int httpResponseCode = http.POST(payload);
-    
-    // Process response
-    Serial.println("[MSG] ───────────────────────────────────");
-    Serial.println("[MSG] Server Response");
-    Serial.println("[MSG] ───────────────────────────────────");
-    
-    bool success = false;
 
-    if (httpResponseCode > 0) {
-        Serial.print("[MSG] HTTP Response Code: ");
-        Serial.println(httpResponseCode);
+    memcpy(serverHost, host, hostLength);
+    serverHost[hostLength] = '\0';
 
-        // Get response body
-        String response = http.getString();
-        Serial.println("[MSG] Response Body:");
-        Serial.println(response);
+    serverPort = 80;
+    if (host[hostLength] == ':') {
+        serverPort = (uint16_t)atoi(host + hostLength + 1);
+    }
 
-        // Handle response based on status code category
-        if (httpResponseCode >= 200 && httpResponseCode < 300) {
-            success = handleHTTPSuccess(httpResponseCode);
-        } else if (httpResponseCode >= 400 && httpResponseCode < 500) {
-            handleHTTPClientError(httpResponseCode);
-        } else if (httpResponseCode >= 500) {
-            handleHTTPServerError(httpResponseCode);
-        } else {
-            Serial.print("\n[MSG] UNEXPECTED RESPONSE: ");
-            Serial.println(httpResponseCode);
-            showErrorPattern(6);
-        }
+    const char* path = strchr(host, '/');
+    serverPath = (path != nullptr) ? path : "/";
 
-    } else {
-        // Request failed - network error
-        handleNetworkError(httpResponseCode);
-    }
-    
-    // Clean up
-    http.end();
-    Serial.println("[MSG] ═══════════════════════════════════\n");
-    
-    return success;
+    return serverPort != 0;
 }
 
-// ============================================================================
-// PUBLIC FUNCTIONS
-// ============================================================================
+/**
+ * Make sure the persistent server socket is open
+ * Reuses the existing connection if the server has kept it alive,
+ * otherwise opens a new TCP connection.
+ *
+ * Note: opening a new socket is the only pipeline step that waits, bounded
+ * by HTTP_CONNECT_TIMEOUT. With keep-alive it only happens after the server
+ * (or WiFi) dropped the previous connection, and after a failed connect no
+ * new one is tried until the backoff expires (holdServerConnections()).
+ *
+ * @param connectMs Output: time spent connecting (0 if socket was reused)
+ * @return true if a connected socket is available, false otherwise
+ */
+static bool ensureServerConnection(unsigned long& connectMs) {
+    connectMs = 0;
 
-bool initializeMessaging() {
-    Serial.println("\n[MSG] Initializing messaging subsystem...");
-    
-    if (!isCryptoReady()) {
-        Serial.println("[MSG] Crypto not ready!");
-        messagingReady = false;
-        return false;
-    }
-    
-    if (!isTimeInitialized()) {
-        Serial.println("[MSG] Time not synchronized!");
-        messagingReady = false;
-        return false;
+    if (serverClient.connected()) {
+        return true;  // Server kept the previous connection alive
     }
-    
-    Serial.println("[MSG] Messaging subsystem ready");
-    messagingReady = true;
-    lastHeartbeatTime = millis();
-    
-    return true;
-}
 
-bool sendHeartbeat() {
-    if (!messagingReady) {
-        Serial.println("[MSG] Messaging not initialized!");
-        return false;
-    }
-    
-    if (!isWiFiConnected()) {
-        Serial.println("[MSG] WiFi not connected!");
-        return false;
-    }
-    
-    Serial.println("\n[MSG] ╔═══════════════════════════════════╗");
-    Serial.println("[MSG] ║      HEARTBEAT MESSAGE            ║");
-    Serial.println("[MSG] ╚═══════════════════════════════════╝");
-    
-    // Create message payload
-    String payload = createMessagePayload(HEARTBEAT);
-    
-    // Sign the payload
-    String signature = signMessage(payload);
-    
-    if (signature.length() == 0) {
-        Serial.println("[MSG] Failed to sign message!");
+    // Socket was closed by the server (or never opened) - start fresh
+    serverClient.stop();
+    serverClient.setTimeout(HTTP_CONNECT_TIMEOUT);
+
+    unsigned long connectStart = millis();
+    uint32_t connectCycles = profileStart();
+    if (!serverClient.connect(serverHost, serverPort)) {
         return false;
     }
-    
-    // Send HTTP request
-    bool success = sendHTTPRequest(payload, signature);
+    connectMs = millis() - connectStart;
+    profileEnd(PROFILE_HTTP_CONNECT, connectCycles);
 
-    // Always update lastHeartbeatTime to prevent rapid retries on failure
-    lastHeartbeatTime = millis();
+    // Small JSON messages - send immediately instead of waiting for Nagle
+    serverClient.setNoDelay(true);
 
-    return success;
-}
+    connectCount++;
+    totalConnectMs += connectMs;
+    requestsOnConnection = 0;
 
-bool sendAlert(float distance, unsigned long durationSeconds, const String& firstDetectedTimestamp) {
-    if (!messagingReady) {
-        Serial.println("[MSG] Messaging not initialized!");
-        return false;
-    }
+    return true;
+}
 
-    if (!isWiFiConnected()) {
-        Serial.println("[MSG] WiFi not connected!");
-        return false;
-    }
+/**
+ * Close the persistent server connection
+ * Next request will open a new socket.
+ */
+static void closeServerConnection() {
+    serverClient.stop();
+}
 
-    Serial.println("\n[MSG] ╔═══════════════════════════════════╗");
-    Serial.println("[MSG] ║       ALERT MESSAGE               ║");
-    Serial.println("[MSG] ╚═══════════════════════════════════╝");
-    Serial.print("[MSG] Distance: ");
-    Serial.print(distance, 1);
-    Serial.println(" cm");
-    Serial.print("[MSG] Duration: ");
-    Serial.print(durationSeconds);
-    Serial.println(" seconds");
-    Serial.print("[MSG] First detected: ");
-    Serial.println(firstDetectedTimestamp);
+/**
+ * Get the next wait of a backoff that doubles on every failure
+ *
+ * @param delay Current wait (0 after a success)
+ * @param initial First wait
+ * @param maximum Longest wait
+ * @return Wait before the next attempt in ms
+ */
+static unsigned long nextRetryDelay(unsigned long delay, unsigned long initial, unsigned long maximum) {
+    delay = (delay == 0) ? initial : delay * 2;
+    return (delay > maximum) ? maximum : delay;
+}
 
-    // Create message payload with sensor data
-    String payload = createMessagePayload(ALERT, distance, durationSeconds, firstDetectedTimestamp);
+/**
+ * Stop opening connections for a while after the server could not be reached
+ * Each connect attempt can stall every task for HTTP_CONNECT_TIMEOUT; while
+ * the server is down only one attempt is made per SERVER_RETRY_INTERVAL
+ * (doubled after each further failure). Alerts go to the offline store and
+ * heartbeats are skipped in between.
+ */
+static void holdServerConnections() {
+    serverRetryDelay = nextRetryDelay(serverRetryDelay, SERVER_RETRY_INTERVAL, SERVER_RETRY_MAX_INTERVAL);
+    serverRetryStart = millis();
+    LOG_INFO("[MSG] Server unreachable - next connection attempt in %lu s", serverRetryDelay / 1000);
+}
 
-    // Sign the payload
-    String signature = signMessage(payload);
+/**
+ * Check whether a new connection would be refused by holdServerConnections()
+ * An open connection can still be used.
+ *
+ * @return true while waiting out the backoff without an open connection
+ */
+static bool isServerOnHold() {
+    return !serverClient.connected() && serverRetryDelay > 0 && millis() - serverRetryStart < serverRetryDelay;
+}
 
-    if (signature.length() == 0) {
-        Serial.println("[MSG] Failed to sign message!");
-        return false;
+/**
+ * Print connect-vs-request timing for the last request and running averages
+ *
+ * @param reused Whether the request was sent on an existing socket
+ * @param connectMs Time spent opening the TCP connection
+ * @param requestMs Time from sending the request to receiving the response
+ */
+static void printConnectionTiming(bool reused, unsigned long connectMs, unsigned long requestMs) {
+    if (reused) {
+        LOG_INFO("[MSG] Connection: reused (request #%lu on this socket) | request %lu ms",
+                 requestsOnConnection, requestMs);
+    } else {
+        LOG_INFO("[MSG] Connection: new (connect %lu ms) | request %lu ms",
+                 connectMs, requestMs);
     }
 
-    // Send HTTP request
-    bool success = sendHTTPRequest(payload, signature);
-
-    return success;
+    LOG_DEBUG("[MSG] Totals: %lu requests over %lu connections | avg connect %lu ms | avg request %lu ms",
+              requestCount, connectCount,
+              connectCount > 0 ? totalConnectMs / connectCount : 0,
+              requestCount > 0 ? totalRequestMs / requestCount : 0);
 }
 
-bool isHeartbeatDue() {
-    return (millis() - lastHeartbeatTime) >= HEARTBEAT_INTERVAL;
+// ============================================================================
+// SESSION MANAGEMENT
+// ============================================================================
+
+/**
+ * Check if a session ID is available to replace the certificate header
+ * Sessions are dropped shortly before the server-side TTL runs out, so a
+ * request rarely has to be repeated after a 401.
+ *
+ * @return true if sessionId can be used for the next request
+ */
+static bool hasValidSession() {
+    if (sessionId[0] == '\0') {
+        return false;
+    }
+    if (millis() - sessionIssuedAt >= sessionLifetimeMs) {
+        LOG_DEBUG("[MSG] Session expired - next request sends certificate");
+        sessionId[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Forget the current session (next request sends the certificate)
+ */
+static void clearSession() {
+    sessionId[0] = '\0';
+}
+
+/**
+ * Take the session ID from a successful response body
+ * Only session_id and session_ttl are extracted (filtered parse).
+ */
+static void updateSessionFromResponse() {
+    if (responseBodyLength == 0) {
+        return;  // No body (or an MQTT acknowledgement)
+    }
+
+    StaticJsonDocument<64> filter;
+    filter["session_id"] = true;
+    filter["session_ttl"] = true;
+
+    StaticJsonDocument<RESPONSE_JSON_DOC_SIZE> doc;
+    DeserializationError error = deserializeJson(doc, (const char*)responseBody,
+                                                 DeserializationOption::Filter(filter));
+    if (error) {
+        LOG_DEBUG("[MSG] Could not parse response body: %s", error.c_str());
+        return;
+    }
+
+    const char* newSessionId = doc["session_id"] | "";
+    unsigned long ttlSeconds = doc["session_ttl"] | 0UL;
+    if (newSessionId[0] == '\0' || ttlSeconds == 0) {
+        return;
+    }
+
+    if (strcmp(newSessionId, sessionId) != 0) {
+        if (strlen(newSessionId) >= sizeof(sessionId)) {
+            LOG_ERROR("[MSG] Session ID too long - keeping certificate authentication");
+            return;
+        }
+        strlcpy(sessionId, newSessionId, sizeof(sessionId));
+        sessionIssuedAt = millis();
+        sessionLifetimeMs = ttlSeconds * 1000UL / 10UL * 9UL;  // Renew at 90% of the TTL
+        LOG_INFO("[MSG] Session established (valid %lu s)", ttlSeconds);
+    }
+}
+
+// ============================================================================
+// OUTBOUND QUEUE
+// ============================================================================
+
+/**
+ * Get the next free queue slot so a message can be built in place
+ * The slot only becomes part of the queue after commitQueueSlot().
+ *
+ * @param type Message type to record in the slot
+ * @return Pointer to free slot, or nullptr if the queue is full
+ */
+static OutboundMessage* reserveQueueSlot(MessageType type) {
+    if (queueCount >= OUTBOUND_QUEUE_SIZE) {
+        LOG_ERROR("[MSG] Outbound queue full - message dropped");
+        return nullptr;
+    }
+
+    OutboundMessage* slot = &outboundQueue[(queueHead + queueCount) % OUTBOUND_QUEUE_SIZE];
+    slot->type = type;
+    slot->payloadLength = 0;
+    slot->payload[0] = '\0';
+    slot->fromOfflineStore = false;
+    slot->signature[0] = '\0';
+    return slot;
+}
+
+/**
+ * Add the slot returned by reserveQueueSlot() to the outbound queue
+ */
+static void commitQueueSlot() {
+    queueCount++;
+    LOG_DEBUG("[MSG] Message queued (%d/%d in queue)", queueCount, OUTBOUND_QUEUE_SIZE);
+}
+
+/**
+ * Sign a message whose payload has been built in place
+ *
+ * @param message Queue slot or offline message with payload filled in
+ * @return true if signed, false otherwise
+ */
+static bool signOutboundMessage(OutboundMessage* message) {
+    if (message->payloadLength == 0) {
+        LOG_ERROR("[MSG] Failed to create message payload!");
+        return false;
+    }
+
+    // Digest was computed while the payload was serialized
+    bool signedOk = message->hasDigest
+        ? signDigest(message->digest, message->signature, sizeof(message->signature))
+        : signMessage(message->payload, message->payloadLength, message->signature, sizeof(message->signature));
+
+    if (!signedOk) {
+        LOG_ERROR("[MSG] Failed to sign message!");
+        return false;
+    }
+
+    logPayload(message->payload, message->payloadLength);
+    return true;
+}
+
+/**
+ * Add a message built in a reserved slot to the queue
+ * Signing is deferred until the message is sent, so messages that go out
+ * together share one signature.
+ *
+ * @param slot Slot returned by reserveQueueSlot() with payload filled in
+ * @return true if queued, false if the payload could not be built
+ */
+static bool commitBuiltMessage(OutboundMessage* slot) {
+    if (slot->payloadLength == 0) {
+        LOG_ERROR("[MSG] Failed to create message payload!");
+        return false;
+    }
+
+    logPayload(slot->payload, slot->payloadLength);
+
+    commitQueueSlot();
+    return true;
+}
+
+/**
+ * Keep an alert in the offline store until the server can be reached
+ * Never signs: an alert that was only covered by a batch signature is
+ * stored unsigned and signed when it is resent (once per batch, like a
+ * live message), so a failed batch costs no uECC_sign() calls.
+ *
+ * @param message Alert to store
+ * @return true if stored, false otherwise
+ */
+static bool storeForLater(OutboundMessage& message) {
+    if (!storeOfflineMessage(message.payload, message.payloadLength, message.signature)) {
+        return false;
+    }
+
+    LOG_INFO("[MSG] Alert stored offline (%u pending)", (unsigned int)getOfflineMessageCount());
+    return true;
+}
+
+/**
+ * Check whether a failed send should be kept for a later retry
+ * Network errors and 5xx responses are retried; 4xx means the server
+ * rejected the message itself, so resending would not help.
+ *
+ * @param result HTTP status code or SEND_ERROR_* code
+ * @return true if the message should go to the offline store
+ */
+static bool isRetryableResult(int result) {
+    return result <= 0 || result >= 500;
+}
+
+/**
+ * Settle the stored alerts of a finished batch
+ * Delivered (or rejected with a 4xx, which a resend would not change):
+ * the drain cursor is persisted. Otherwise the records stay in flash
+ * and the next drain waits OFFLINE_DRAIN_RETRY_INTERVAL, doubled after
+ * each further failure.
+ *
+ * @param result HTTP status code or SEND_ERROR_* code
+ */
+static void finishOfflineDrain(int result) {
+    if (!isRetryableResult(result)) {
+        commitOfflineDrain();
+        offlineRetryDelay = 0;
+        return;
+    }
+
+    rewindOfflineDrain();
+    offlineRetryDelay = nextRetryDelay(offlineRetryDelay, OFFLINE_DRAIN_RETRY_INTERVAL, OFFLINE_DRAIN_RETRY_MAX_INTERVAL);
+    offlineRetryStart = millis();
+    LOG_INFO("[MSG] Resend failed - stored alerts kept, next attempt in %lu s", offlineRetryDelay / 1000);
+}
+
+/**
+ * Release the oldest queue slot after its message has been handled
+ */
+static void dequeueMessage() {
+    queueHead = (queueHead + 1) % OUTBOUND_QUEUE_SIZE;
+    queueCount--;
+}
+
+// ============================================================================
+// SEND PIPELINE
+// ============================================================================
+
+/**
+ * Move the send pipeline to a new state
+ *
+ * @param state Next pipeline state
+ */
+static void enterSendState(SendState state) {
+    sendState = state;
+    stateStartTime = millis();
+}
+
+/**
+ * Finish the current message with a result code
+ *
+ * @param result HTTP status code or SEND_ERROR_* code
+ */
+static void finishSend(int result) {
+    sendResult = result;
+    enterSendState(SEND_DONE);
+}
+
+/**
+ * Get a message of the batch being sent
+ *
+ * @param index Position in the batch (0 = oldest)
+ * @return Queued message
+ */
+static OutboundMessage& batchMessage(uint8_t index) {
+    return outboundQueue[(queueHead + index) % OUTBOUND_QUEUE_SIZE];
+}
+
+/**
+ * Drop the profiling samples reported by a delivered heartbeat
+ * A heartbeat still queued reported the same samples (closeProfileWindow()
+ * merges them), so they are kept until it is delivered as well.
+ */
+static void finishProfileReport() {
+    for (uint8_t i = 0; i < queueCount; i++) {
+        if (batchMessage(i).type == HEARTBEAT) {
+            return;
+        }
+    }
+    confirmProfileReport();
+}
+
+/**
+ * Select the oldest queued messages as the next batch and sign its body
+ * A single message is sent on its own with its own signature; several
+ * messages are sent as one JSON (or CBOR) array with a single signature,
+ * so uECC_sign() runs once per request instead of once per message.
+ *
+ * @return true if the batch body is signed, false on signing failure
+ */
+static bool prepareBatch() {
+    batchCount = (queueCount < MESSAGE_BATCH_MAX_SIZE) ? queueCount : MESSAGE_BATCH_MAX_SIZE;
+    if (batchCount == 0) {
+        batchCount = 1;  // MESSAGE_BATCH_MAX_SIZE set to 0 - send one at a time
+    }
+
+    bodySegmentCount = 0;
+    bodyLength = 0;
+
+    if (batchCount == 1) {
+        OutboundMessage& message = batchMessage(0);
+        bodySegments[0] = message.payload;
+        bodySegmentLengths[0] = message.payloadLength;
+        bodySegmentCount = 1;
+        bodyLength = message.payloadLength;
+
+        // Stored messages sent on their own may already be signed
+        if (message.signature[0] == '\0' && !signOutboundMessage(&message)) {
+            return false;
+        }
+        batchSignaturePtr = message.signature;
+        return true;
+    }
+
+#if MESSAGE_WIRE_FORMAT == WIRE_FORMAT_CBOR
+    // CBOR array: header with item count, then the encoded messages back to back
+    CborWriter header;
+    cborBegin(header, batchArrayHeader, sizeof(batchArrayHeader));
+    cborWriteArrayHeader(header, batchCount);
+    bodySegments[bodySegmentCount] = (const char*)batchArrayHeader;
+    bodySegmentLengths[bodySegmentCount++] = header.length;
+    bodyLength += header.length;
+
+    for (uint8_t i = 0; i < batchCount; i++) {
+        OutboundMessage& message = batchMessage(i);
+        bodySegments[bodySegmentCount] = message.payload;
+        bodySegmentLengths[bodySegmentCount++] = message.payloadLength;
+        bodyLength += message.payloadLength;
+    }
+#else
+    for (uint8_t i = 0; i < batchCount; i++) {
+        OutboundMessage& message = batchMessage(i);
+        bodySegments[bodySegmentCount] = (i == 0) ? "[" : ",";
+        bodySegmentLengths[bodySegmentCount++] = 1;
+        bodySegments[bodySegmentCount] = message.payload;
+        bodySegmentLengths[bodySegmentCount++] = message.payloadLength;
+        bodyLength += 1 + message.payloadLength;
+    }
+    bodySegments[bodySegmentCount] = "]";
+    bodySegmentLengths[bodySegmentCount++] = 1;
+    bodyLength += 1;
+#endif
+
+    LOG_DEBUG("[MSG] Batching %u messages (%u bytes, one signature)", batchCount, (unsigned int)bodyLength);
+
+    if (!signMessageSegments(bodySegments, bodySegmentLengths, bodySegmentCount,
+                             batchSignature, sizeof(batchSignature))) {
+        LOG_ERROR("[MSG] Failed to sign message batch!");
+        return false;
+    }
+    batchSignaturePtr = batchSignature;
+    return true;
+}
+
+/**
+ * Prepare request segments for the current batch
+ * The head contains everything up to the credential header value; the
+ * certificate (or session ID), signature and payloads are written straight
+ * from their own buffers.
+ */
+static void prepareRequest() {
+    sendWithSession = hasValidSession();
+
+    int headLength = snprintf(requestHead, sizeof(requestHead),
+                              "POST %s HTTP/1.1\r\n"
+                              "Host: %s:%u\r\n"
+                              "Connection: keep-alive\r\n"
+                              "Content-Type: %s\r\n"
+                              "Content-Length: %u\r\n"
+                              "%s: ",
+                              serverPath, serverHost, (unsigned int)serverPort,
+                              MESSAGE_CONTENT_TYPE, (unsigned int)bodyLength,
+                              sendWithSession ? "X-Device-Session" : "X-Device-Certificate");
+
+    // Session ID after first contact, full certificate otherwise
+    const char* credential = sendWithSession ? sessionId : getCredentials().certificateB64;
+
+    requestSegments[0] = requestHead;
+    requestSegmentLengths[0] = (headLength > 0) ? (size_t)headLength : 0;
+    requestSegments[1] = credential;
+    requestSegmentLengths[1] = strlen(credential);
+    requestSegments[2] = "\r\nX-Device-Signature: ";
+    requestSegmentLengths[2] = strlen(requestSegments[2]);
+    requestSegments[3] = batchSignaturePtr;
+    requestSegmentLengths[3] = strlen(batchSignaturePtr);
+    requestSegments[4] = "\r\n\r\n";
+    requestSegmentLengths[4] = 4;
+
+    requestSegmentCount = HEADER_SEGMENT_COUNT;
+    for (uint8_t i = 0; i < bodySegmentCount; i++) {
+        requestSegments[requestSegmentCount] = bodySegments[i];
+        requestSegmentLengths[requestSegmentCount++] = bodySegmentLengths[i];
+    }
+
+    requestSegmentIndex = 0;
+    requestSegmentOffset = 0;
+
+    // Reset response parser
+    responseLineLength = 0;
+    responseHeadersDone = false;
+    responseContentLength = -1;
+    responseBodyReceived = 0;
+    responseKeepAlive = true;
+    responseChunked = false;
+    responseChunkState = CHUNK_SIZE_LINE;
+    responseChunkRemaining = 0;
+    responseBodyLength = 0;
+    responseBody[0] = '\0';
+    sendResult = 0;
+}
+
+/**
+ * Write as much of the request as fits in the TCP send buffer
+ * Never waits for buffer space - remaining bytes go out on later calls.
+ *
+ * @return true once the whole request has been written
+ */
+static bool writeRequestChunk() {
+    while (requestSegmentIndex < requestSegmentCount) {
+        size_t remaining = requestSegmentLengths[requestSegmentIndex] - requestSegmentOffset;
+        if (remaining == 0) {
+            requestSegmentIndex++;
+            requestSegmentOffset = 0;
+            continue;
+        }
+
+        size_t space = (size_t)serverClient.availableForWrite();
+        if (space == 0) {
+            return false;  // Send buffer full - continue on next pass
+        }
+
+        size_t chunk = (remaining < space) ? remaining : space;
+        const uint8_t* data = (const uint8_t*)requestSegments[requestSegmentIndex] + requestSegmentOffset;
+        size_t written = serverClient.write(data, chunk);
+        if (written == 0) {
+            return false;
+        }
+        requestSegmentOffset += written;
+    }
+    return true;
+}
+
+/**
+ * Parse one complete status or header line of the response
+ *
+ * @param line Null-terminated line without CR/LF
+ */
+static void parseResponseLine(const char* line) {
+    if (sendResult == 0) {
+        // Status line: "HTTP/1.1 201 Created"
+        const char* code = strchr(line, ' ');
+        sendResult = (code != nullptr) ? atoi(code + 1) : SEND_ERROR_CONNECTION_LOST;
+        if (strncmp(line, "HTTP/1.0", 8) == 0) {
+            responseKeepAlive = false;  // HTTP/1.0 closes by default
+        }
+        return;
+    }
+
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+        responseContentLength = atol(line + 15);
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+        const char* value = line + 11;
+        while (*value == ' ') value++;
+        responseKeepAlive = strncasecmp(value, "close", 5) != 0;
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+        // Chunked framing (always the last coding) takes precedence over any Content-Length
+        size_t length = strlen(line);
+        responseChunked = length >= 18 + 7 && strcasecmp(line + length - 7, "chunked") == 0;
+    }
+}
+
+/**
+ * Keep a body byte for session/diagnostics, count the rest
+ *
+ * @param c Body byte (after chunked framing was removed)
+ */
+static void storeResponseBodyByte(char c) {
+    if (responseBodyLength < sizeof(responseBody) - 1) {
+        responseBody[responseBodyLength++] = c;
+        responseBody[responseBodyLength] = '\0';
+    }
+    responseBodyReceived++;
+}
+
+/**
+ * Consume one byte of a chunked response body
+ * Size and trailer lines are collected in responseLine.
+ *
+ * @param c Raw body byte
+ * @return true once the terminating chunk and trailer have been received
+ */
+static bool readChunkedBodyByte(char c) {
+    switch (responseChunkState) {
+        case CHUNK_SIZE_LINE:
+        case CHUNK_TRAILER: {
+            if (c == '\r') {
+                return false;
+            }
+            if (c != '\n') {
+                if (responseLineLength < sizeof(responseLine) - 1) {
+                    responseLine[responseLineLength++] = c;
+                }
+                return false;
+            }
+
+            responseLine[responseLineLength] = '\0';
+            bool blankLine = responseLineLength == 0;
+            responseLineLength = 0;
+
+            if (responseChunkState == CHUNK_TRAILER) {
+                return blankLine;  // Blank line ends the message
+            }
+            responseChunkRemaining = strtol(responseLine, nullptr, 16);
+            responseChunkState = (responseChunkRemaining > 0) ? CHUNK_DATA : CHUNK_TRAILER;
+            return false;
+        }
+
+        case CHUNK_DATA:
+            storeResponseBodyByte(c);
+            if (--responseChunkRemaining == 0) {
+                responseChunkState = CHUNK_DATA_END;
+            }
+            return false;
+
+        case CHUNK_DATA_END:
+            if (c == '\n') {
+                responseChunkState = CHUNK_SIZE_LINE;
+            }
+            return false;
+    }
+    return false;
+}
+
+/**
+ * Consume response bytes that have already arrived
+ * Never waits for more data.
+ *
+ * @return true once the full response (headers + body) has been received
+ */
+static bool readResponseChunk() {
+    while (serverClient.available() > 0) {
+        int c = serverClient.read();
+        if (c < 0) {
+            break;
+        }
+
+        if (!responseHeadersDone) {
+            if (c == '\r') {
+                continue;
+            }
+            if (c != '\n') {
+                if (responseLineLength < sizeof(responseLine) - 1) {
+                    responseLine[responseLineLength++] = (char)c;
+                }
+                continue;
+            }
+
+            // End of line
+            responseLine[responseLineLength] = '\0';
+            if (responseLineLength == 0 && sendResult != 0) {
+                responseHeadersDone = true;  // Blank line ends headers
+                if (responseContentLength == 0 && !responseChunked) {
+                    return true;
+                }
+            } else {
+                parseResponseLine(responseLine);
+            }
+            responseLineLength = 0;
+            continue;
+        }
+
+        if (responseChunked) {
+            if (readChunkedBodyByte((char)c)) {
+                return true;
+            }
+            continue;
+        }
+
+        // Body - keep what fits for diagnostics, count the rest
+        storeResponseBodyByte((char)c);
+
+        if (responseContentLength >= 0 && responseBodyReceived >= responseContentLength) {
+            return true;
+        }
+    }
+
+    // Without Content-Length or chunked framing the body ends when the server closes the socket
+    if (responseHeadersDone && responseContentLength < 0 && !responseChunked && !serverClient.connected()) {
+        responseKeepAlive = false;
+        return true;
+    }
+
+    return false;
+}
+
+// ============================================================================
+// HTTP TRANSPORT
+// ============================================================================
+
+/**
+ * Parse SERVER_URL for the HTTP transport
+ *
+ * @return true if the URL is valid, false otherwise
+ */
+static bool beginHttpTransport() {
+    if (!parseServerURL()) {
+        LOG_ERROR("[MSG] Invalid SERVER_URL!");
+        return false;
+    }
+
+    LOG_INFO("[MSG] Server: %s:%u%s", serverHost, (unsigned int)serverPort, serverPath);
+    return true;
+}
+
+/**
+ * Check whether any of the HTTP response has arrived
+ *
+ * @return true once the status line (or part of it) was received
+ */
+static bool httpReplyStarted() {
+    return sendResult != 0 || responseLineLength != 0;
+}
+
+// ============================================================================
+// MQTT TRANSPORT
+// ============================================================================
+
+#if MESSAGE_TRANSPORT == TRANSPORT_MQTT
+
+#if MESSAGE_WIRE_FORMAT == WIRE_FORMAT_CBOR
+static const char* MQTT_MESSAGE_TOPIC_SUFFIX = "messages/cbor";
+#else
+static const char* MQTT_MESSAGE_TOPIC_SUFFIX = "messages/json";
+#endif
+
+/**
+ * Get the next MQTT packet identifier (1-65535, 0 is not allowed)
+ *
+ * @return Packet identifier
+ */
+static uint16_t nextMqttPacketId() {
+    mqttLastPacketId++;
+    if (mqttLastPacketId == 0) {
+        mqttLastPacketId = 1;
+    }
+    return mqttLastPacketId;
+}
+
+/**
+ * Set the broker address and build the device's topics
+ *
+ * @return true if the configuration is valid, false otherwise
+ */
+static bool beginMqttTransport() {
+    if (strlen(MQTT_BROKER_HOST) == 0 || strlen(MQTT_BROKER_HOST) >= sizeof(serverHost) ||
+        MQTT_BROKER_PORT == 0) {
+        LOG_ERROR("[MSG] Invalid MQTT_BROKER_HOST/MQTT_BROKER_PORT!");
+        return false;
+    }
+    strlcpy(serverHost, MQTT_BROKER_HOST, sizeof(serverHost));
+    serverPort = MQTT_BROKER_PORT;
+
+    int messageTopicLength = snprintf(mqttMessageTopic, sizeof(mqttMessageTopic), "%s/%s/%s",
+                                      MQTT_TOPIC_PREFIX, getCredentials().deviceId, MQTT_MESSAGE_TOPIC_SUFFIX);
+    int certificateTopicLength = snprintf(mqttCertificateTopic, sizeof(mqttCertificateTopic), "%s/%s/certificate",
+                                          MQTT_TOPIC_PREFIX, getCredentials().deviceId);
+    if (messageTopicLength < 0 || messageTopicLength >= (int)sizeof(mqttMessageTopic) ||
+        certificateTopicLength < 0 || certificateTopicLength >= (int)sizeof(mqttCertificateTopic)) {
+        LOG_ERROR("[MSG] MQTT topic too long - increase MQTT_TOPIC_BUFFER_SIZE");
+        return false;
+    }
+
+    mqttResetReader(mqttReader);
+    LOG_INFO("[MSG] MQTT broker: %s:%u, topic %s", serverHost, (unsigned int)serverPort, mqttMessageTopic);
+    return true;
+}
+
+/**
+ * Point the request segments at handshake packet bytes
+ * The pipeline writes them with writeRequestChunk() as buffer space allows.
+ *
+ * @param head Packet head (built in requestHead)
+ * @param headLength Length of head
+ * @param payload Packet payload (nullptr if none)
+ * @param payloadLength Length of payload
+ */
+static void setMqttHandshakeSegments(const char* head, size_t headLength, const char* payload, size_t payloadLength) {
+    requestSegments[0] = head;
+    requestSegmentLengths[0] = headLength;
+    requestSegmentCount = 1;
+    if (payload != nullptr) {
+        requestSegments[1] = payload;
+        requestSegmentLengths[1] = payloadLength;
+        requestSegmentCount = 2;
+    }
+    requestSegmentIndex = 0;
+    requestSegmentOffset = 0;
+}
+
+/**
+ * Consume handshake packets that have already arrived
+ * Never waits for more data.
+ *
+ * @param type MQTT_PACKET_* type expected (others are skipped)
+ * @return SESSION_OPEN once the packet arrived (body in mqttReader),
+ *         SESSION_PENDING while incomplete, SESSION_FAILED otherwise
+ */
+static SessionStatus readMqttHandshake(uint8_t type) {
+    while (serverClient.available() > 0) {
+        int c = serverClient.read();
+        if (c < 0) {
+            break;
+        }
+        if (mqttReadByte(mqttReader, (uint8_t)c) && mqttPacketType(mqttReader) == type) {
+            return SESSION_OPEN;
+        }
+        if (mqttReader.malformed) {
+            return SESSION_FAILED;
+        }
+    }
+    return serverClient.connected() ? SESSION_PENDING : SESSION_FAILED;
+}
+
+/**
+ * Advance the session handshake on a new socket by at most one step
+ * CONNECT keeps the broker-side session (clean session off), then the
+ * certificate is published as a retained message so the backend can
+ * verify the signatures of the messages that follow - the MQTT
+ * counterpart of the certificate header on first contact. Only writes
+ * what fits in the send buffer and reads what has arrived; the pipeline
+ * gives up after HTTP_CONNECT_TIMEOUT.
+ *
+ * @return SESSION_OPEN once the session is ready for publishing
+ */
+static SessionStatus advanceMqttSession() {
+    switch (mqttSessionStep) {
+        case MQTT_SESSION_CONNECT:
+            if (!serverClient.connected()) {
+                LOG_ERROR("[MSG] MQTT CONNECT failed");
+                return SESSION_FAILED;
+            }
+            if (writeRequestChunk()) {
+                mqttResetReader(mqttReader);
+                mqttSessionStep = MQTT_SESSION_CONNACK;
+            }
+            return SESSION_PENDING;
+
+        case MQTT_SESSION_CONNACK: {
+            SessionStatus status = readMqttHandshake(MQTT_PACKET_CONNACK);
+            if (status == SESSION_FAILED) {
+                LOG_ERROR("[MSG] No CONNACK from MQTT broker");
+            }
+            if (status != SESSION_OPEN) {
+                return status;
+            }
+            if (mqttReader.body[1] != MQTT_CONNACK_ACCEPTED) {
+                LOG_ERROR("[MSG] MQTT broker refused connection (code %u)", (unsigned int)mqttReader.body[1]);
+                return SESSION_FAILED;
+            }
+
+            mqttCertificateId = nextMqttPacketId();
+            const char* certificate = getCredentials().certificateB64;
+            size_t certificateLength = strlen(certificate);
+            size_t length = mqttEncodePublishHeader((uint8_t*)requestHead, sizeof(requestHead), mqttCertificateTopic,
+                                                    mqttCertificateId, certificateLength, true, false);
+            if (length == 0) {
+                LOG_ERROR("[MSG] MQTT certificate publish failed");
+                return SESSION_FAILED;
+            }
+            setMqttHandshakeSegments(requestHead, length, certificate, certificateLength);
+            mqttSessionStep = MQTT_SESSION_CERTIFICATE;
+            return SESSION_PENDING;
+        }
+
+        case MQTT_SESSION_CERTIFICATE:
+            if (!serverClient.connected()) {
+                LOG_ERROR("[MSG] MQTT certificate publish failed");
+                return SESSION_FAILED;
+            }
+            if (writeRequestChunk()) {
+                mqttResetReader(mqttReader);
+                mqttSessionStep = MQTT_SESSION_PUBACK;
+            }
+            return SESSION_PENDING;
+
+        case MQTT_SESSION_PUBACK: {
+            SessionStatus status = readMqttHandshake(MQTT_PACKET_PUBACK);
+            if (status == SESSION_OPEN && mqttPacketId(mqttReader) != mqttCertificateId) {
+                status = SESSION_FAILED;
+            }
+            if (status == SESSION_FAILED) {
+                LOG_ERROR("[MSG] MQTT certificate not acknowledged");
+            }
+            if (status != SESSION_OPEN) {
+                return status;
+            }
+
+            mqttResetReader(mqttReader);
+            mqttLastSendTime = millis();
+            mqttPingOutstanding = false;
+            LOG_INFO("[MSG] MQTT session open (certificate published)");
+            return SESSION_OPEN;
+        }
+    }
+    return SESSION_FAILED;
+}
+
+/**
+ * Make sure a connected MQTT socket is available
+ * Like the HTTP socket, the session stays open between messages. A new
+ * socket starts the session handshake, which the pipeline then drives
+ * with advanceMqttSession() (a failed handshake closes the socket, so a
+ * connected socket always has an open session).
+ *
+ * @param connectMs Output: time spent connecting (0 if the session was reused)
+ * @return true if the socket is connected, false otherwise
+ */
+static bool connectMqttTransport(unsigned long& connectMs) {
+    if (serverClient.connected()) {
+        connectMs = 0;
+        return true;
+    }
+
+    if (!ensureServerConnection(connectMs)) {
+        return false;
+    }
+
+    size_t length = mqttEncodeConnect((uint8_t*)requestHead, sizeof(requestHead), getCredentials().deviceId,
+                                      MQTT_KEEPALIVE_SECONDS, false);
+    if (length == 0) {
+        LOG_ERROR("[MSG] MQTT CONNECT failed");
+        closeServerConnection();
+        return false;
+    }
+    setMqttHandshakeSegments(requestHead, length, nullptr, 0);
+    mqttSessionStep = MQTT_SESSION_CONNECT;
+    return true;
+}
+
+/**
+ * Prepare a QoS 1 PUBLISH of the current batch
+ * Payload: the base64 signature, a newline, then the same body the HTTP
+ * transport would POST, written straight from the queue slots.
+ */
+static void prepareMqttPublish() {
+    sendWithSession = false;
+
+    // Re-sent after the kept-alive connection dropped: same identifier, DUP flag
+    bool duplicate = sendRetried && mqttPublishId != 0;
+    if (!duplicate) {
+        mqttPublishId = nextMqttPacketId();
+    }
+
+    size_t signatureLength = strlen(batchSignaturePtr);
+    size_t payloadLength = signatureLength + 1 + bodyLength;
+    size_t headLength = mqttEncodePublishHeader((uint8_t*)requestHead, sizeof(requestHead), mqttMessageTopic,
+                                                mqttPublishId, payloadLength, false, duplicate);
+
+    requestSegments[0] = requestHead;
+    requestSegmentLengths[0] = headLength;
+    requestSegments[1] = batchSignaturePtr;
+    requestSegmentLengths[1] = signatureLength;
+    requestSegments[2] = "\n";
+    requestSegmentLengths[2] = 1;
+
+    requestSegmentCount = 3;
+    for (uint8_t i = 0; i < bodySegmentCount; i++) {
+        requestSegments[requestSegmentCount] = bodySegments[i];
+        requestSegmentLengths[requestSegmentCount++] = bodySegmentLengths[i];
+    }
+
+    requestSegmentIndex = 0;
+    requestSegmentOffset = 0;
+
+    mqttResetReader(mqttReader);
+    mqttLastSendTime = millis();
+    responseKeepAlive = true;
+    responseBodyLength = 0;
+    responseBody[0] = '\0';
+    sendResult = 0;
+}
+
+/**
+ * Consume broker packets that have already arrived
+ * Never waits for more data.
+ *
+ * @return true once the PUBACK for the batch (or a protocol error) arrived
+ */
+static bool readMqttReply() {
+    while (serverClient.available() > 0) {
+        int c = serverClient.read();
+        if (c < 0) {
+            break;
+        }
+
+        if (!mqttReadByte(mqttReader, (uint8_t)c)) {
+            if (mqttReader.malformed) {
+                responseKeepAlive = false;
+                sendResult = SEND_ERROR_CONNECTION_LOST;
+                return true;
+            }
+            continue;
+        }
+
+        uint8_t type = mqttPacketType(mqttReader);
+        if (type == MQTT_PACKET_PUBACK && mqttPacketId(mqttReader) == mqttPublishId) {
+            mqttPublishId = 0;
+            sendResult = SEND_RESULT_PUBLISHED;
+            return true;
+        }
+        if (type == MQTT_PACKET_PINGRESP) {
+            mqttPingOutstanding = false;
+        }
+    }
+    return false;
+}
+
+static bool mqttReplyStarted() {
+    return sendResult != 0 || mqttReaderStarted(mqttReader);
+}
+
+/**
+ * Keep the idle MQTT session alive
+ * Sends PINGREQ after half the keep-alive interval without traffic and
+ * closes the socket if the broker does not answer within HTTP_TIMEOUT
+ * (the next message reconnects).
+ */
+static void maintainMqttSession() {
+    if (!serverClient.connected()) {
+        return;
+    }
+
+    while (serverClient.available() > 0) {
+        int c = serverClient.read();
+        if (c < 0) {
+            break;
+        }
+        if (mqttReadByte(mqttReader, (uint8_t)c) && mqttPacketType(mqttReader) == MQTT_PACKET_PINGRESP) {
+            mqttPingOutstanding = false;
+        }
+        if (mqttReader.malformed) {
+            closeServerConnection();
+            return;
+        }
+    }
+
+    unsigned long now = millis();
+    if (mqttPingOutstanding) {
+        if (now - mqttPingSentTime >= HTTP_TIMEOUT) {
+            LOG_INFO("[MSG] MQTT broker not answering - reconnecting for the next message");
+            closeServerConnection();
+            mqttPingOutstanding = false;
+        }
+        return;
+    }
+
+    if (now - mqttLastSendTime >= MQTT_KEEPALIVE_SECONDS * 1000UL / 2) {
+        uint8_t ping[2];
+        size_t length = mqttEncodePingRequest(ping, sizeof(ping));
+        if ((size_t)serverClient.availableForWrite() >= length && serverClient.write(ping, length) == length) {
+            mqttPingOutstanding = true;
+            mqttPingSentTime = now;
+            mqttLastSendTime = now;
+        }
+    }
+}
+
+static const MessageTransport transport = {
+    "MQTT", beginMqttTransport, connectMqttTransport, advanceMqttSession, prepareMqttPublish,
+    readMqttReply, mqttReplyStarted, maintainMqttSession
+};
+
+#else
+
+static const MessageTransport transport = {
+    "HTTP", beginHttpTransport, ensureServerConnection, nullptr, prepareRequest,
+    readResponseChunk, httpReplyStarted, nullptr
+};
+
+#endif
+
+// ============================================================================
+// SEND RESULT HANDLING
+// ============================================================================
+
+/**
+ * Report the outcome of the current batch
+ *
+ * @param result HTTP status code or SEND_ERROR_* code
+ */
+static void reportSendResult(int result) {
+    const char* label = (batchCount > 1) ? "Batch"
+                        : (batchMessage(0).type == HEARTBEAT ? "Heartbeat" : "Alert");
+
+    LOG_DEBUG("\n[MSG] ───────────────────────────────────");
+    LOG_DEBUG("[MSG] Server Response (%s)", label);
+    LOG_DEBUG("[MSG] ───────────────────────────────────");
+
+    if (result > 0) {
+        unsigned long requestMs = millis() - sendRequestStart;
+        profileEnd(PROFILE_HTTP_ROUND_TRIP, sendRequestCycles);
+
+        if (batchCount > 1) {
+            LOG_INFO("[MSG] %s of %u messages: %s %d", label, batchCount, transport.name, result);
+        } else {
+            LOG_INFO("[MSG] %s: %s %d", label, transport.name, result);
+        }
+
+        requestCount++;
+        requestsOnConnection++;
+        totalRequestMs += requestMs;
+        printConnectionTiming(sendOnReusedSocket, sendConnectMs, requestMs);
+
+        LOG_DEBUG("[MSG] Response Body: %s", responseBody);
+
+        // Handle response based on status code category
+        if (result >= 200 && result < 300) {
+            handleHTTPSuccess(result);
+        } else if (result >= 400 && result < 500) {
+            handleHTTPClientError(result);
+        } else if (result >= 500) {
+            handleHTTPServerError(result);
+        } else {
+            LOG_ERROR("[MSG] UNEXPECTED RESPONSE: %d", result);
+            showErrorPattern(6);
+        }
+    } else {
+        // Request failed - network error
+        handleNetworkError(result);
+    }
+
+    LOG_DEBUG("[MSG] ═══════════════════════════════════\n");
+}
+
+/**
+ * Handle failure of a request written to a reused socket
+ * If the server closed the kept-alive connection before answering, the
+ * request was never processed and is retried once on a new socket.
+ *
+ * @param errorCode SEND_ERROR_* code to report if no retry is possible
+ */
+static void handleSocketFailure(int errorCode) {
+    closeServerConnection();
+
+    if (sendOnReusedSocket && !sendRetried && !transport.replyStarted()) {
+        LOG_INFO("[MSG] Server closed kept-alive connection, reconnecting...");
+        sendRetried = true;
+        enterSendState(SEND_CONNECTING);
+        return;
+    }
+
+    finishSend(errorCode);
+}
+
+/**
+ * Build the request for the current batch and start writing it
+ * Called once the connection (and transport session) is ready.
+ */
+static void startRequest() {
+    serverRetryDelay = 0;  // Server reachable again
+    transport.prepare();
+    sendRequestStart = millis();
+    sendRequestCycles = profileStart();
+    enterSendState(SEND_SENDING);
+}
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+bool initializeMessaging() {
+    LOG_INFO("[MSG] Initializing messaging subsystem...");
+    
+    if (!isCryptoReady()) {
+        LOG_ERROR("[MSG] Crypto not ready!");
+        messagingReady = false;
+        return false;
+    }
+    
+    // No time check - messages carry time_synced = false until SNTP answers
+    if (!isTimeSynced()) {
+        LOG_INFO("[MSG] Time not yet synchronized - messages flagged as unsynced");
+    }
+    
+    if (!transport.begin()) {
+        messagingReady = false;
+        return false;
+    }
+
+    // Offline buffering is optional - messaging still works without it
+    initializeOfflineStore();
+
+    LOG_INFO("[MSG] Messaging subsystem ready");
+    messagingReady = true;
+    lastHeartbeatTime = millis();
+    
+    return true;
+}
+
+bool sendHeartbeat() {
+    if (!messagingReady) {
+        LOG_ERROR("[MSG] Messaging not initialized!");
+        return false;
+    }
+    
+    if (!isWiFiConnected()) {
+        LOG_ERROR("[MSG] WiFi not connected!");
+        return false;
+    }
+    
+    LOG_DEBUG("\n[MSG] ╔═══════════════════════════════════╗");
+    LOG_DEBUG("[MSG] ║      HEARTBEAT MESSAGE            ║");
+    LOG_DEBUG("[MSG] ╚═══════════════════════════════════╝");
+    
+    // Record the attempt even if queueing fails (see getLastHeartbeatTime())
+    lastHeartbeatTime = millis();
+
+    // Heartbeats only report the current state - not worth a connect attempt while the server is down
+    if (isServerOnHold()) {
+        LOG_INFO("[MSG] Server unreachable - heartbeat skipped");
+        return false;
+    }
+
+    OutboundMessage* slot = reserveQueueSlot(HEARTBEAT);
+    if (slot == nullptr) {
+        return false;
+    }
+
+    // Build payload in the queue slot, hand over to the send pipeline (signed when sent)
+    createMessagePayload(slot, HEARTBEAT);
+    return commitBuiltMessage(slot);
+}
+
+bool sendAlert(DetectionEvent event, uint16_t distanceMm, unsigned long durationSeconds,
+               const char* firstDetectedTimestamp) {
+    if (!messagingReady) {
+        LOG_ERROR("[MSG] Messaging not initialized!");
+        return false;
+    }
+
+    LOG_DEBUG("\n[MSG] ╔═══════════════════════════════════╗");
+    LOG_DEBUG("[MSG] ║       ALERT MESSAGE               ║");
+    LOG_DEBUG("[MSG] ╚═══════════════════════════════════╝");
+    LOG_INFO("[MSG] Detection %s | Distance: %u mm | Duration: %lu seconds",
+             getDetectionStateName(event), distanceMm, durationSeconds);
+    LOG_DEBUG("[MSG] First detected: %s", firstDetectedTimestamp);
+
+    // Offline, server unreachable or queue full: build the alert for the offline store instead
+    bool storeOffline = !isWiFiConnected() || isServerOnHold() || queueCount >= OUTBOUND_QUEUE_SIZE;
+    OutboundMessage* slot = storeOffline ? &offlineMessage : reserveQueueSlot(ALERT);
+    slot->type = ALERT;
+    slot->signature[0] = '\0';
+
+    // Build payload with sensor data in place
+    createMessagePayload(slot, ALERT, distanceMm, durationSeconds, firstDetectedTimestamp, event);
+
+    if (storeOffline) {
+        if (slot->payloadLength == 0) {
+            LOG_ERROR("[MSG] Failed to create message payload!");
+            return false;
+        }
+        logPayload(slot->payload, slot->payloadLength);
+        return storeForLater(*slot);  // Signed when resent
+    }
+
+    // Hand over to the send pipeline (signed when sent)
+    return commitBuiltMessage(slot);
+}
+
+void processOutboundQueue() {
+    switch (sendState) {
+        case SEND_IDLE:
+            if (queueCount == 0) {
+                if (transport.maintain != nullptr) {
+                    transport.maintain();
+                }
+            } else if (isServerOnHold()) {
+                // Queued before the connect failed - settle them all without another attempt
+                batchCount = queueCount;
+                finishSend(SEND_ERROR_SERVER_BACKOFF);
+            } else {
+                sendRetried = false;
+                sessionRetried = false;
+                if (prepareBatch()) {
+                    enterSendState(SEND_CONNECTING);
+                } else {
+                    finishSend(SEND_ERROR_SIGNING_FAILED);
+                }
+            }
+            break;
+
+        case SEND_CONNECTING: {
+            if (!isWiFiConnected()) {
+                finishSend(SEND_ERROR_NOT_CONNECTED);
+                break;
+            }
+
+            sendOnReusedSocket = serverClient.connected();
+            if (!transport.connect(sendConnectMs)) {
+                holdServerConnections();
+                finishSend(SEND_ERROR_CONNECTION_FAILED);
+                break;
+            }
+
+            if (!sendOnReusedSocket && transport.openSession != nullptr) {
+                enterSendState(SEND_OPENING_SESSION);
+            } else {
+                startRequest();
+            }
+            break;
+        }
+
+        case SEND_OPENING_SESSION: {
+            SessionStatus status = transport.openSession();
+            if (status == SESSION_PENDING && millis() - stateStartTime >= HTTP_CONNECT_TIMEOUT) {
+                LOG_ERROR("[MSG] %s session handshake timed out", transport.name);
+                status = SESSION_FAILED;
+            }
+
+            if (status == SESSION_OPEN) {
+                sendConnectMs += millis() - stateStartTime;
+                startRequest();
+            } else if (status == SESSION_FAILED) {
+                closeServerConnection();
+                holdServerConnections();
+                finishSend(SEND_ERROR_CONNECTION_FAILED);
+            }
+            break;
+        }
+
+        case SEND_SENDING:
+            if (!serverClient.connected()) {
+                handleSocketFailure(SEND_ERROR_SEND_FAILED);
+            } else if (writeRequestChunk()) {
+                enterSendState(SEND_AWAITING_RESPONSE);
+            } else if (millis() - stateStartTime >= HTTP_TIMEOUT) {
+                handleSocketFailure(SEND_ERROR_SEND_FAILED);
+            }
+            break;
+
+        case SEND_AWAITING_RESPONSE:
+            if (transport.readReply()) {
+                if (!responseKeepAlive) {
+                    closeServerConnection();  // Server will close - reconnect next time
+                }
+                finishSend(sendResult);
+            } else if (!serverClient.connected() && serverClient.available() == 0) {
+                handleSocketFailure(SEND_ERROR_CONNECTION_LOST);
+            } else if (millis() - stateStartTime >= HTTP_TIMEOUT) {
+                closeServerConnection();
+                finishSend(SEND_ERROR_READ_TIMEOUT);
+            }
+            break;
+
+        case SEND_DONE:
+            // Server no longer knows the session - repeat the request with the certificate
+            if (sendResult == 401 && sendWithSession && !sessionRetried) {
+                LOG_INFO("[MSG] Session rejected, re-sending with certificate...");
+                clearSession();
+                sessionRetried = true;
+                enterSendState(SEND_CONNECTING);
+                break;
+            }
+
+            if (sendResult >= 200 && sendResult < 300) {
+                updateSessionFromResponse();
+            }
+
+            reportSendResult(sendResult);
+            bool batchHadStored = false;
+            bool heartbeatDelivered = false;
+            for (uint8_t i = 0; i < batchCount; i++) {
+                OutboundMessage& message = outboundQueue[queueHead];
+                if (message.type == HEARTBEAT && sendResult >= 200 && sendResult < 300) {
+                    heartbeatDelivered = true;
+                } else if (message.fromOfflineStore) {
+                    batchHadStored = true;
+                } else if (message.type == ALERT && isRetryableResult(sendResult)) {
+                    storeForLater(message);
+                }
+                dequeueMessage();
+            }
+            if (batchHadStored) {
+                finishOfflineDrain(sendResult);
+            }
+            if (heartbeatDelivered) {
+                finishProfileReport();
+            }
+            batchCount = 0;
+            enterSendState(SEND_IDLE);
+            break;
+    }
+}
+
+void drainOfflineStore() {
+    if (!messagingReady || !isWiFiConnected() || getOfflineMessageCount() == 0) {
+        return;
+    }
+
+    // Only refill an idle pipeline, and leave a slot free for live messages
+    if (sendState != SEND_IDLE || queueCount > 0) {
+        return;
+    }
+
+    // Back off after a failed resend, or while the server is unreachable
+    if ((offlineRetryDelay > 0 && millis() - offlineRetryStart < offlineRetryDelay) || isServerOnHold()) {
+        return;
+    }
+
+    // Staged records are written first so everything is read back from flash
+    flushOfflineStore();
+
+    uint8_t batchLimit = OFFLINE_DRAIN_BATCH_SIZE;
+    if (batchLimit > OUTBOUND_QUEUE_SIZE - 1) {
+        batchLimit = OUTBOUND_QUEUE_SIZE - 1;
+    }
+    if (MESSAGE_BATCH_MAX_SIZE > 0 && batchLimit > MESSAGE_BATCH_MAX_SIZE) {
+        batchLimit = MESSAGE_BATCH_MAX_SIZE;  // One request, so one result settles all of them
+    }
+    if (batchLimit == 0) {
+        batchLimit = 1;
+    }
+
+    uint8_t drained = 0;
+    while (drained < batchLimit) {
+        OutboundMessage* slot = reserveQueueSlot(ALERT);
+        if (slot == nullptr ||
+            !takeOfflineMessage(slot->payload, sizeof(slot->payload), slot->payloadLength,
+                                slot->signature, sizeof(slot->signature))) {
+            break;
+        }
+        slot->hasDigest = false;  // Digest is not stored - hashed again if signed on its own
+        slot->fromOfflineStore = true;
+        commitQueueSlot();
+        drained++;
+    }
+
+    // The cursor is persisted (or rewound) once the server answered - see finishOfflineDrain()
+    if (drained > 0) {
+        LOG_INFO("[MSG] Resending %u stored alerts (%u still pending)",
+                 drained, (unsigned int)getOfflineMessageCount());
+    } else {
+        commitOfflineDrain();  // Only skipped records were read - don't read them again after a reboot
+    }
+}
+
+bool isSendInProgress() {
+    return sendState != SEND_IDLE || queueCount > 0;
+}
+
+uint8_t getOutboundQueueCount() {
+    return queueCount;
 }
 
 unsigned long getLastHeartbeatTime() {
     return lastHeartbeatTime;
-}
\ No newline at end of file
+}
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "hardware.h"  // DetectionEvent
 
 // ============================================================================
 // MESSAGING MODULE
@@ -10,7 +11,8 @@
 // This module handles:
 // - Creating heartbeat and alert messages
 // - Signing messages with ECDSA
-// - Sending messages to Django API
+// - Queueing messages and sending them to Django API (non-blocking)
+// - Storing alerts offline while the server cannot be reached
 // - Processing server responses
 // ============================================================================
 
@@ -31,30 +33,64 @@ enum MessageType {
 bool initializeMessaging();
 
 /**
- * Send a heartbeat message to the server
- * Contains device status information
+ * Queue a heartbeat message for the server
+ * Contains device status information. The message is sent (and signed)
+ * in the background by processOutboundQueue().
  * 
- * @return true if message sent successfully, false otherwise
+ * @return true if message was queued, false otherwise
  */
 bool sendHeartbeat();
 
 /**
- * Send an alert message to the server
- * Triggered by ultrasonic sensor - indicates object detection event
+ * Queue an alert message for the server
+ * Triggered by ultrasonic sensor - one detection is reported as a session:
+ * an opened alert with the full context, compact updates while the object
+ * stays, and a closed summary (see getDueDetectionEvent()).
+ * The message is sent (and signed) in the background by
+ * processOutboundQueue().
+ * While WiFi is down (or the queue is full) the signed alert is kept in the
+ * offline store instead and sent later by drainOfflineStore().
  *
- * @param distance Distance of detected object in cm
+ * @param event DETECTION_OPENED, DETECTION_UPDATE or DETECTION_CLOSED
+ * @param distanceMm Distance of detected object in mm (closest distance when closed)
  * @param durationSeconds How long object has been detected (in seconds)
  * @param firstDetectedTimestamp ISO timestamp when object was first detected
- * @return true if message sent successfully, false otherwise
+ * @return true if message was queued or stored, false otherwise
  */
-bool sendAlert(float distance, unsigned long durationSeconds, const String& firstDetectedTimestamp);
+bool sendAlert(DetectionEvent event, uint16_t distanceMm, unsigned long durationSeconds,
+               const char* firstDetectedTimestamp);
 
 /**
- * Check if it's time to send a heartbeat message
- * 
- * @return true if heartbeat is due, false otherwise
+ * Advance the outbound send pipeline by one step
+ * sign → connect → send → await response → done
+ * Up to MESSAGE_BATCH_MAX_SIZE queued messages are sent together as one
+ * JSON array covered by a single signature.
+ * Call this on every loop() iteration; it never waits on the network
+ * (except for opening a new socket, bounded by HTTP_CONNECT_TIMEOUT).
+ */
+void processOutboundQueue();
+
+/**
+ * Move a batch of stored offline alerts into the outbound queue
+ * Does nothing while offline, while the pipeline is busy or when the store
+ * is empty. Call this on every loop() iteration.
+ */
+void drainOfflineStore();
+
+/**
+ * Check if messages are queued or a request is in flight
+ *
+ * @return true if the send pipeline is busy, false if idle
+ */
+bool isSendInProgress();
+
+/**
+ * Get number of messages waiting in the outbound queue
+ * (including the one currently being sent)
+ *
+ * @return Number of queued messages
  */
-bool isHeartbeatDue();
+uint8_t getOutboundQueueCount();
 
 /**
  * Get the last heartbeat time
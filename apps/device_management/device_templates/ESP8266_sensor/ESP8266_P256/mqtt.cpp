@@ -0,0 +1,190 @@
+#include "config.h"
+#include "mqtt.h"
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+// Largest remaining length MQTT can encode (4 length bytes)
+static const uint32_t MQTT_MAX_REMAINING_LENGTH = 268435455UL;
+
+// CONNECT flags
+static const uint8_t MQTT_CONNECT_CLEAN_SESSION = 0x02;
+
+// PUBLISH flags (low nibble of the first byte)
+static const uint8_t MQTT_PUBLISH_RETAIN = 0x01;
+static const uint8_t MQTT_PUBLISH_QOS1 = 0x02;
+static const uint8_t MQTT_PUBLISH_DUP = 0x08;
+
+/**
+ * Write the fixed header: packet type/flags and the variable-length
+ * remaining length (7 bits per byte, high bit = more bytes follow)
+ *
+ * @param buffer Output buffer
+ * @param size Buffer size in bytes
+ * @param header First byte (type << 4 | flags)
+ * @param remainingLength Bytes after the fixed header
+ * @return Fixed header length, or 0 if it does not fit
+ */
+static size_t writeFixedHeader(uint8_t* buffer, size_t size, uint8_t header, uint32_t remainingLength) {
+    if (remainingLength > MQTT_MAX_REMAINING_LENGTH || size < 2) {
+        return 0;
+    }
+
+    size_t length = 0;
+    buffer[length++] = header;
+    do {
+        uint8_t encoded = remainingLength % 128;
+        remainingLength /= 128;
+        if (remainingLength > 0) {
+            encoded |= 0x80;
+        }
+        if (length >= size) {
+            return 0;
+        }
+        buffer[length++] = encoded;
+    } while (remainingLength > 0);
+
+    return length;
+}
+
+/**
+ * Write a length-prefixed UTF-8 string
+ *
+ * @param buffer Output buffer, positioned at the string
+ * @param text String to write
+ * @param textLength Length of text in bytes
+ */
+static void writeString(uint8_t* buffer, const char* text, size_t textLength) {
+    buffer[0] = (uint8_t)(textLength >> 8);
+    buffer[1] = (uint8_t)(textLength & 0xFF);
+    memcpy(buffer + 2, text, textLength);
+}
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+void mqttResetReader(MqttReader& reader) {
+    reader.header = 0;
+    reader.hasHeader = false;
+    reader.remainingLength = 0;
+    reader.lengthBytes = 0;
+    reader.lengthDone = false;
+    reader.bodyReceived = 0;
+    reader.malformed = false;
+}
+
+bool mqttReadByte(MqttReader& reader, uint8_t c) {
+    if (reader.malformed) {
+        return false;
+    }
+
+    if (!reader.hasHeader) {
+        reader.header = c;
+        reader.hasHeader = true;
+        reader.remainingLength = 0;
+        reader.bodyReceived = 0;
+        return false;
+    }
+
+    if (!reader.lengthDone) {
+        // Remaining length: little-endian groups of 7 bits
+        reader.remainingLength |= (uint32_t)(c & 0x7F) << (7 * reader.lengthBytes);
+        reader.lengthBytes++;
+        if ((c & 0x80) == 0) {
+            reader.lengthDone = true;
+        } else if (reader.lengthBytes >= 4) {
+            reader.malformed = true;
+            return false;
+        }
+        if (!reader.lengthDone || reader.remainingLength > 0) {
+            return false;
+        }
+    } else {
+        if (reader.bodyReceived < MQTT_READER_BODY_SIZE) {
+            reader.body[reader.bodyReceived] = c;
+        }
+        reader.bodyReceived++;
+        if (reader.bodyReceived < reader.remainingLength) {
+            return false;
+        }
+    }
+
+    // Packet complete - keep type and body until the next packet starts
+    reader.hasHeader = false;
+    reader.lengthDone = false;
+    reader.lengthBytes = 0;
+    return true;
+}
+
+bool mqttReaderStarted(const MqttReader& reader) {
+    return reader.hasHeader;
+}
+
+uint8_t mqttPacketType(const MqttReader& reader) {
+    return reader.header >> 4;
+}
+
+uint16_t mqttPacketId(const MqttReader& reader) {
+    if (reader.remainingLength < 2) {
+        return 0;
+    }
+    return (uint16_t)((reader.body[0] << 8) | reader.body[1]);
+}
+
+size_t mqttEncodeConnect(uint8_t* buffer, size_t size, const char* clientId,
+                         uint16_t keepAliveSeconds, bool cleanSession) {
+    size_t clientIdLength = strlen(clientId);
+
+    // Variable header: protocol name "MQTT", level 4, flags, keep-alive
+    static const uint8_t PROTOCOL[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04};
+    uint32_t remainingLength = sizeof(PROTOCOL) + 1 + 2 + 2 + clientIdLength;
+
+    size_t length = writeFixedHeader(buffer, size, MQTT_PACKET_CONNECT << 4, remainingLength);
+    if (length == 0 || length + remainingLength > size) {
+        return 0;
+    }
+
+    memcpy(buffer + length, PROTOCOL, sizeof(PROTOCOL));
+    length += sizeof(PROTOCOL);
+    buffer[length++] = cleanSession ? MQTT_CONNECT_CLEAN_SESSION : 0x00;
+    buffer[length++] = (uint8_t)(keepAliveSeconds >> 8);
+    buffer[length++] = (uint8_t)(keepAliveSeconds & 0xFF);
+
+    // Payload: client identifier
+    writeString(buffer + length, clientId, clientIdLength);
+    length += 2 + clientIdLength;
+
+    return length;
+}
+
+size_t mqttEncodePublishHeader(uint8_t* buffer, size_t size, const char* topic, uint16_t packetId,
+                               size_t payloadLength, bool retain, bool duplicate) {
+    size_t topicLength = strlen(topic);
+    uint32_t remainingLength = 2 + topicLength + 2 + payloadLength;
+
+    uint8_t header = (MQTT_PACKET_PUBLISH << 4) | MQTT_PUBLISH_QOS1;
+    if (retain) {
+        header |= MQTT_PUBLISH_RETAIN;
+    }
+    if (duplicate) {
+        header |= MQTT_PUBLISH_DUP;
+    }
+
+    size_t length = writeFixedHeader(buffer, size, header, remainingLength);
+    if (length == 0 || length + 2 + topicLength + 2 > size) {
+        return 0;
+    }
+
+    writeString(buffer + length, topic, topicLength);
+    length += 2 + topicLength;
+    buffer[length++] = (uint8_t)(packetId >> 8);
+    buffer[length++] = (uint8_t)(packetId & 0xFF);
+
+    return length;
+}
+
+size_t mqttEncodePingRequest(uint8_t* buffer, size_t size) {
+    return writeFixedHeader(buffer, size, MQTT_PACKET_PINGREQ << 4, 0);
+}
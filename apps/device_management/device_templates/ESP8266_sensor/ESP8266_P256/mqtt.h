@@ -0,0 +1,144 @@
+#ifndef MQTT_H
+#define MQTT_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// MQTT MODULE
+// ============================================================================
+// This module handles:
+// - Encoding the MQTT 3.1.1 packets the firmware sends (CONNECT, QoS 1
+//   PUBLISH, PINGREQ) into a caller-provided buffer (no heap allocation)
+// - Parsing packets from the broker one byte at a time (CONNACK, PUBACK,
+//   PINGRESP), so the send pipeline never waits for a whole packet
+//
+// The socket itself belongs to the MQTT transport in messaging.cpp, used
+// when MESSAGE_TRANSPORT is TRANSPORT_MQTT. Topics and payloads (must match
+// apps/data_processing/management/commands/mqtt_subscriber.py):
+//   <MQTT_TOPIC_PREFIX>/<device_id>/certificate
+//       Device certificate (Base64 PEM), retained, published once per connection
+//   <MQTT_TOPIC_PREFIX>/<device_id>/messages/json (or .../messages/cbor)
+//       "<base64 signature>\n<body>" - body is exactly what the HTTP
+//       transport POSTs (one message or a batch array)
+// ============================================================================
+
+// Transports for MESSAGE_TRANSPORT
+#define TRANSPORT_HTTP 0
+#define TRANSPORT_MQTT 1
+
+#ifndef MESSAGE_TRANSPORT
+#define MESSAGE_TRANSPORT TRANSPORT_HTTP
+#endif
+
+// Control packet types (high nibble of the first byte)
+#define MQTT_PACKET_CONNECT 1
+#define MQTT_PACKET_CONNACK 2
+#define MQTT_PACKET_PUBLISH 3
+#define MQTT_PACKET_PUBACK 4
+#define MQTT_PACKET_PINGREQ 12
+#define MQTT_PACKET_PINGRESP 13
+
+// CONNACK return code for an accepted connection
+#define MQTT_CONNACK_ACCEPTED 0
+
+// Longest packet body kept by the reader (CONNACK and PUBACK have 2 bytes)
+#define MQTT_READER_BODY_SIZE 4
+
+/**
+ * Incoming packet parser
+ * Bodies longer than MQTT_READER_BODY_SIZE (e.g. a PUBLISH the broker
+ * should not send us) are consumed but not kept.
+ */
+struct MqttReader {
+    uint8_t header;            // First byte of the packet (type << 4 | flags)
+    bool hasHeader;
+    uint32_t remainingLength;
+    uint8_t lengthBytes;       // Remaining-length bytes read so far
+    bool lengthDone;
+    uint32_t bodyReceived;
+    uint8_t body[MQTT_READER_BODY_SIZE];
+    bool malformed;            // Invalid remaining length - the connection must be closed
+};
+
+/**
+ * Start parsing a new packet
+ *
+ * @param reader Parser state
+ */
+void mqttResetReader(MqttReader& reader);
+
+/**
+ * Feed one received byte to the parser
+ * After a complete packet, the next byte starts a new one.
+ *
+ * @param reader Parser state
+ * @param c Received byte
+ * @return true if this byte completed a packet (see mqttPacketType())
+ */
+bool mqttReadByte(MqttReader& reader, uint8_t c);
+
+/**
+ * Check whether part of a packet has been received
+ *
+ * @param reader Parser state
+ * @return true if the parser is inside a packet
+ */
+bool mqttReaderStarted(const MqttReader& reader);
+
+/**
+ * Get the type of the packet just completed
+ *
+ * @param reader Parser state after mqttReadByte() returned true
+ * @return MQTT_PACKET_* value
+ */
+uint8_t mqttPacketType(const MqttReader& reader);
+
+/**
+ * Get the packet identifier of a completed PUBACK
+ *
+ * @param reader Parser state after mqttReadByte() returned true
+ * @return Packet identifier
+ */
+uint16_t mqttPacketId(const MqttReader& reader);
+
+/**
+ * Encode a CONNECT packet (protocol level 4, no username/password)
+ *
+ * @param buffer Output buffer
+ * @param size Buffer size in bytes
+ * @param clientId Client identifier (the device ID)
+ * @param keepAliveSeconds Keep-alive interval announced to the broker
+ * @param cleanSession false to keep the session (and QoS 1 state) across reconnects
+ * @return Packet length, or 0 if it does not fit
+ */
+size_t mqttEncodeConnect(uint8_t* buffer, size_t size, const char* clientId,
+                         uint16_t keepAliveSeconds, bool cleanSession);
+
+/**
+ * Encode the start of a QoS 1 PUBLISH packet
+ * Everything up to the payload: fixed header, topic and packet identifier.
+ * The payload bytes are written by the caller straight from their buffers.
+ *
+ * @param buffer Output buffer
+ * @param size Buffer size in bytes
+ * @param topic Topic name
+ * @param packetId Packet identifier (1-65535), echoed in the PUBACK
+ * @param payloadLength Length of the payload that follows
+ * @param retain Ask the broker to keep the message for new subscribers
+ * @param duplicate Re-delivery of a packet that may have been received
+ * @return Header length, or 0 if it does not fit
+ */
+size_t mqttEncodePublishHeader(uint8_t* buffer, size_t size, const char* topic, uint16_t packetId,
+                               size_t payloadLength, bool retain, bool duplicate);
+
+/**
+ * Encode a PINGREQ packet (keeps an idle connection alive)
+ *
+ * @param buffer Output buffer (at least 2 bytes)
+ * @param size Buffer size in bytes
+ * @return Packet length, or 0 if it does not fit
+ */
+size_t mqttEncodePingRequest(uint8_t* buffer, size_t size);
+
+#endif // MQTT_H
@@ -1,170 +1,549 @@
 #include "config.h"
 #include "network.h"
 #include "hardware.h"
+#include "memstats.h"
+#include "credentials.h"
+#include "logging.h"
 #include <ESP8266WiFi.h>
 #include <time.h>
+#include <sys/time.h>
+#include <coredecls.h>  // settimeofday_cb()
+#include <stddef.h>
 
 // ============================================================================
 // INTERNAL STATE VARIABLES
 // ============================================================================
 
-static bool timeInitialized = false;
+static bool timeInitialized = false;      // Clock holds a usable time (synced or cached)
+static bool timeSynced = false;           // Clock has been set by SNTP since boot
+static volatile bool sntpTimeSet = false; // Set by the SNTP callback, handled in serviceTime()
 static unsigned long bootTime = 0;  // Time when device booted
 
+/**
+ * WiFi connection attempt states (see pollWiFiConnect())
+ */
+enum WiFiConnectState {
+    WIFI_CONNECT_IDLE,        // No attempt running
+    WIFI_CONNECT_FAST,        // Associating with the cached BSSID/channel/IP
+    WIFI_CONNECT_FULL         // Scanning, associating and waiting for DHCP
+};
+
+static WiFiConnectState connectState = WIFI_CONNECT_IDLE;
+static unsigned long connectAttemptStart = 0;   // millis() when the attempt started
+static unsigned long connectStepStart = 0;      // millis() when the current path started
+static unsigned long connectLedToggle = 0;
+static bool connectLedOn = false;
+
+// Clock reference used to measure drift when SNTP corrects the time
+static time_t referenceEpoch = 0;
+static unsigned long referenceMillis = 0;
+static unsigned long lastTimeCacheSave = 0;
+
+// Last formatted timestamp (see getCurrentTimestamp()): the date part is
+// only rebuilt when the day changes, the time fields when the second does
+static const time_t SECONDS_PER_DAY = 86400;
+static const uint8_t TIMESTAMP_HOUR_OFFSET = 11;     // "YYYY-MM-DDT" precedes hh:mm:ss
+static char cachedTimestamp[TIMESTAMP_BUFFER_SIZE] = "";
+static time_t cachedTimestampDay = -1;                // Epoch of 00:00:00 on the cached date
+static time_t cachedTimestampSecond = -1;             // Epoch the cached string shows
+
 // ============================================================================
-// PUBLIC FUNCTIONS
+// FAST-CONNECT CACHE (RTC USER MEMORY)
 // ============================================================================
 
-bool initializeWiFi() {
-    Serial.println("\n[NET] ═══════════════════════════════════");
-    Serial.println("[NET] Initializing WiFi Connection");
-    Serial.println("[NET] ═══════════════════════════════════");
-    
-    // Set WiFi mode to station (client)
-    WiFi.mode(WIFI_STA);
-    
-    // Disconnect any previous connection
+// RTC user memory survives soft resets and deep sleep (not power loss).
+// Offsets are in 4-byte blocks; the first 128 bytes (blocks 0-31) are used
+// by the core for OTA, so the cache starts after them.
+static const uint32_t RTC_WIFI_CACHE_OFFSET = 32;
+static const uint32_t RTC_WIFI_CACHE_MAGIC = 0xC3D5F1C1;
+static const uint32_t RTC_TIME_CACHE_OFFSET = 40;   // After the WiFi cache (8 blocks)
+static const uint32_t RTC_TIME_CACHE_MAGIC = 0xC3D5713E;
+
+/**
+ * Connection parameters saved after a successful full connect
+ * Lets the next connect skip the channel scan and DHCP.
+ */
+struct WiFiFastConnectCache {
+    uint32_t magic;
+    uint32_t crc;               // CRC-32 over the fields below
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+/**
+ * Last known epoch time, refreshed every TIME_CACHE_SAVE_INTERVAL
+ * Restored at boot so timestamps continue (unsynced) across soft resets.
+ */
+struct TimeCache {
+    uint32_t magic;
+    uint32_t epoch;
+    uint32_t check;             // ~epoch, detects corrupted RTC memory
+};
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+/**
+ * Compute CRC-32 (IEEE, bitwise - only used on a few bytes)
+ *
+ * @param data Bytes to checksum
+ * @param length Number of bytes
+ * @return CRC-32 value
+ */
+static uint32_t crc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * Compute the CRC of a cache record (everything after the crc field)
+ *
+ * @param cache Cache record
+ * @return CRC-32 value
+ */
+static uint32_t fastConnectCacheCRC(const WiFiFastConnectCache& cache) {
+    const uint8_t* start = (const uint8_t*)&cache.bssid;
+    size_t length = sizeof(cache) - offsetof(WiFiFastConnectCache, bssid);
+    return crc32(start, length);
+}
+
+/**
+ * Load the fast-connect cache from RTC memory
+ *
+ * @param cache Output: cached connection parameters
+ * @return true if a valid cache was found, false otherwise
+ */
+static bool loadFastConnectCache(WiFiFastConnectCache& cache) {
+    if (!ESP.rtcUserMemoryRead(RTC_WIFI_CACHE_OFFSET, (uint32_t*)&cache, sizeof(cache))) {
+        return false;
+    }
+    return cache.magic == RTC_WIFI_CACHE_MAGIC && cache.crc == fastConnectCacheCRC(cache);
+}
+
+/**
+ * Save the current connection (BSSID, channel, DHCP lease) to RTC memory
+ */
+static void saveFastConnectCache() {
+    WiFiFastConnectCache cache;
+    memset(&cache, 0, sizeof(cache));
+
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid == nullptr) {
+        return;
+    }
+
+    cache.magic = RTC_WIFI_CACHE_MAGIC;
+    memcpy(cache.bssid, bssid, sizeof(cache.bssid));
+    cache.channel = (uint8_t)WiFi.channel();
+    cache.ip = (uint32_t)WiFi.localIP();
+    cache.gateway = (uint32_t)WiFi.gatewayIP();
+    cache.subnet = (uint32_t)WiFi.subnetMask();
+    cache.dns = (uint32_t)WiFi.dnsIP(0);
+    cache.crc = fastConnectCacheCRC(cache);
+
+    ESP.rtcUserMemoryWrite(RTC_WIFI_CACHE_OFFSET, (uint32_t*)&cache, sizeof(cache));
+    LOG_DEBUG("[NET] Fast-connect parameters saved (channel %u)", cache.channel);
+}
+
+/**
+ * Invalidate the fast-connect cache (e.g. after the access point changed)
+ */
+static void clearFastConnectCache() {
+    WiFiFastConnectCache cache;
+    memset(&cache, 0, sizeof(cache));
+    ESP.rtcUserMemoryWrite(RTC_WIFI_CACHE_OFFSET, (uint32_t*)&cache, sizeof(cache));
+}
+
+/**
+ * Start a connection with the parameters cached in RTC memory
+ * Associates directly with the known BSSID on the known channel and
+ * reuses the previous DHCP lease as a static configuration, skipping
+ * the channel scan and the DHCP exchange.
+ *
+ * @return true if the fast path was started, false if there is no cache
+ */
+static bool beginFastConnect() {
+    WiFiFastConnectCache cache;
+    if (!loadFastConnectCache(cache)) {
+        LOG_DEBUG("[NET] No fast-connect cache - full connect");
+        return false;
+    }
+
+    LOG_INFO("[NET] Fast connect: channel %u, cached IP", cache.channel);
+
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+    const DeviceCredentials& credentials = getCredentials();
+    WiFi.begin(credentials.wifiSsid, credentials.wifiPassword, cache.channel, cache.bssid, true);
+    return true;
+}
+
+/**
+ * Start a full connection: scan, associate, DHCP
+ */
+static void beginFullConnect() {
     WiFi.disconnect();
-    delay(100);
-    
-    // Start connection
-    Serial.print("[NET] Connecting to: ");
-    Serial.println(WIFI_SSID);
-    Serial.print("[NET] ");
-    
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    
-    // Wait for connection with timeout
-    unsigned long startAttempt = millis();
-    
-    while (WiFi.status() != WL_CONNECTED) {
-        // Check for timeout
-        if (millis() - startAttempt >= WIFI_TIMEOUT) {
-            Serial.println("\n[NET] WiFi connection timeout!");
-            setWiFiLED(false);
-            return false;
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));  // Back to DHCP
+
+    const DeviceCredentials& credentials = getCredentials();
+    WiFi.begin(credentials.wifiSsid, credentials.wifiPassword);
+}
+
+/**
+ * Start a connection attempt (fast connect if cached, full otherwise)
+ * Returns right away - pollWiFiConnect() follows the attempt.
+ */
+static void startWiFiConnect() {
+    // Credentials come from the credentials sector - don't rewrite them to the SDK's flash area on every connect
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+
+    LOG_INFO("[NET] Connecting to: %s", getCredentials().wifiSsid);
+
+    connectAttemptStart = millis();
+    connectStepStart = connectAttemptStart;
+    connectLedToggle = connectAttemptStart;
+    if (beginFastConnect()) {
+        connectState = WIFI_CONNECT_FAST;
+    } else {
+        beginFullConnect();
+        connectState = WIFI_CONNECT_FULL;
+    }
+}
+
+/**
+ * Advance the running connection attempt, never waits
+ * Blinks the WiFi LED while connecting. A fast connect that has not
+ * succeeded within WIFI_FAST_CONNECT_TIMEOUT falls back to a full connect,
+ * which gives up after WIFI_TIMEOUT.
+ *
+ * @return true once connected, false while connecting or after the attempt failed
+ */
+static bool pollWiFiConnect() {
+    unsigned long now = millis();
+
+    if (WiFi.status() == WL_CONNECTED) {
+        bool fastConnected = (connectState == WIFI_CONNECT_FAST);
+        if (connectState == WIFI_CONNECT_FULL) {
+            // Remember BSSID, channel and lease for the next (re)connect
+            saveFastConnectCache();
         }
-        
-        // Visual progress indicator
-        Serial.print(".");
+        connectState = WIFI_CONNECT_IDLE;
+
+        LOG_INFO("[NET] WiFi connected in %lu ms (%s)", now - connectAttemptStart,
+                 fastConnected ? "fast connect" : "full scan");
+        LOG_INFO("[NET] IP Address: %s", WiFi.localIP().toString().c_str());
+        LOG_DEBUG("[NET] MAC Address: %s", WiFi.macAddress().c_str());
+        LOG_INFO("[NET] Signal Strength: %d dBm", (int)WiFi.RSSI());
+
+        // Keep WiFi LED on when connected
         setWiFiLED(true);
-        delay(250);
+        return true;
+    }
+
+    // Visual progress indicator
+    if (now - connectLedToggle >= 250) {
+        connectLedOn = !connectLedOn;
+        setWiFiLED(connectLedOn);
+        connectLedToggle = now;
+    }
+
+    if (connectState == WIFI_CONNECT_FAST && now - connectStepStart >= WIFI_FAST_CONNECT_TIMEOUT) {
+        // Access point or lease changed - forget the cache and do a full connect
+        LOG_INFO("[NET] Fast connect failed - falling back to full scan");
+        clearFastConnectCache();
+        beginFullConnect();
+        connectState = WIFI_CONNECT_FULL;
+        connectStepStart = now;
+    } else if (connectState == WIFI_CONNECT_FULL && now - connectStepStart >= WIFI_TIMEOUT) {
+        LOG_ERROR("[NET] WiFi connection timeout!");
         setWiFiLED(false);
-        delay(250);
+        connectState = WIFI_CONNECT_IDLE;
     }
-    
-    Serial.println("\n[NET] WiFi connected!");
-    Serial.print("[NET] IP Address: ");
-    Serial.println(WiFi.localIP());
-    Serial.print("[NET] MAC Address: ");
-    Serial.println(WiFi.macAddress());
-    Serial.print("[NET] Signal Strength: ");
-    Serial.print(WiFi.RSSI());
-    Serial.println(" dBm");
-    
-    // Keep WiFi LED on when connected
-    setWiFiLED(true);
-    
-    return true;
+    return false;
+}
+
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+bool initializeWiFi() {
+    LOG_DEBUG("\n[NET] ═══════════════════════════════════");
+    LOG_INFO("[NET] Initializing WiFi Connection");
+    LOG_DEBUG("[NET] ═══════════════════════════════════");
+
+    // Nothing else runs yet at boot - follow the attempt until it ends
+    startWiFiConnect();
+    while (connectState != WIFI_CONNECT_IDLE) {
+        if (pollWiFiConnect()) {
+            return true;
+        }
+        delay(10);
+    }
+    return false;
 }
 
 bool isWiFiConnected() {
     return WiFi.status() == WL_CONNECTED;
 }
 
+bool isWiFiConnecting() {
+    return connectState != WIFI_CONNECT_IDLE;
+}
+
 bool reconnectWiFi() {
-    if (isWiFiConnected()) {
-        return true;  // Already connected
+    if (connectState == WIFI_CONNECT_IDLE) {
+        if (isWiFiConnected()) {
+            return true;  // Already connected
+        }
+
+        LOG_INFO("[NET] WiFi connection lost! Attempting reconnection...");
+        setWiFiLED(false);
+        startWiFiConnect();
     }
-    
-    Serial.println("\n[NET] WiFi connection lost! Attempting reconnection...");
-    setWiFiLED(false);
-    
-    return initializeWiFi();
+
+    return pollWiFiConnect();
 }
 
-bool initializeNTP() {
-    if (!isWiFiConnected()) {
-        Serial.println("[NET] Cannot initialize NTP - WiFi not connected");
-        return false;
+// ============================================================================
+// TIME SYNCHRONIZATION (BACKGROUND SNTP)
+// ============================================================================
+
+/**
+ * SNTP callback - runs in the network stack context, so only set a flag
+ * and let serviceTime() do the work from loop().
+ *
+ * @param fromSntp true if the time was set by SNTP (not settimeofday())
+ */
+static void onTimeSet(bool fromSntp) {
+    if (fromSntp) {
+        sntpTimeSet = true;
     }
-    
-    Serial.println("\n[NET] ═══════════════════════════════════");
-    Serial.println("[NET] Synchronizing Time with NTP");
-    Serial.println("[NET] ═══════════════════════════════════");
-    Serial.print("[NET] NTP Server: ");
-    Serial.println(NTP_SERVER);
-    
-    // Configure NTP
-    configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
-    
-    // Wait for time to be set (with timeout)
-    Serial.print("[NET] Waiting for time sync");
-    int attempts = 0;
+}
 
-    while (time(nullptr) < MIN_VALID_UNIX_TIMESTAMP && attempts < NTP_MAX_SYNC_ATTEMPTS) {
-        Serial.print(".");
-        delay(500);
-        attempts++;
+/**
+ * Set the clock reference (used for uptime and drift measurement)
+ *
+ * @param now Current epoch time
+ */
+static void setTimeReference(time_t now) {
+    referenceEpoch = now;
+    referenceMillis = millis();
+    bootTime = now - (time_t)(referenceMillis / 1000);
+}
+
+/**
+ * Save the current epoch time to RTC memory
+ *
+ * @param now Current epoch time
+ */
+static void saveTimeCache(time_t now) {
+    TimeCache cache;
+    cache.magic = RTC_TIME_CACHE_MAGIC;
+    cache.epoch = (uint32_t)now;
+    cache.check = ~cache.epoch;
+    ESP.rtcUserMemoryWrite(RTC_TIME_CACHE_OFFSET, (uint32_t*)&cache, sizeof(cache));
+    lastTimeCacheSave = millis();
+}
+
+/**
+ * Restore the clock from RTC memory after a soft reset
+ * The restored time lags real time by up to TIME_CACHE_SAVE_INTERVAL plus
+ * the reset duration, until SNTP corrects it.
+ *
+ * @return true if a cached time was restored, false otherwise
+ */
+static bool restoreTimeCache() {
+    TimeCache cache;
+    if (!ESP.rtcUserMemoryRead(RTC_TIME_CACHE_OFFSET, (uint32_t*)&cache, sizeof(cache))) {
+        return false;
     }
-    
-    if (attempts >= NTP_MAX_SYNC_ATTEMPTS) {
-        Serial.println("\n[NET] NTP synchronization timeout!");
-        timeInitialized = false;
+    if (cache.magic != RTC_TIME_CACHE_MAGIC || cache.check != ~cache.epoch ||
+        cache.epoch < MIN_VALID_UNIX_TIMESTAMP) {
         return false;
     }
-    
-    Serial.println("\n[NET] Time synchronized!");
-    
-    // Get current time
-    time_t now = time(nullptr);
-    struct tm* timeinfo = gmtime(&now);
-    
-    Serial.print("[NET] Current UTC time: ");
-    Serial.printf("%04d-%02d-%02d %02d:%02d:%02d\n",
-                  timeinfo->tm_year + 1900,
-                  timeinfo->tm_mon + 1,
-                  timeinfo->tm_mday,
-                  timeinfo->tm_hour,
-                  timeinfo->tm_min,
-                  timeinfo->tm_sec);
-    
-    timeInitialized = true;
-    bootTime = now;
-    
+
+    struct timeval tv = { (time_t)cache.epoch, 0 };
+    settimeofday(&tv, nullptr);
+    setTimeReference((time_t)cache.epoch);
+    return true;
+}
+
+/**
+ * Write a two-digit decimal field (00-99)
+ *
+ * @param out Output position (2 bytes)
+ * @param value Field value
+ */
+static void writeTwoDigits(char* out, uint8_t value) {
+    out[0] = '0' + value / 10;
+    out[1] = '0' + value % 10;
+}
+
+/**
+ * Bring cachedTimestamp up to the given time
+ * gmtime() and snprintf() only run for the first timestamp of a day (or
+ * after the clock was set to another day); within the day only the
+ * changed hh:mm:ss fields are rewritten.
+ *
+ * @param now Current epoch time
+ * @return true if cachedTimestamp is valid, false if gmtime() failed
+ */
+static bool updateCachedTimestamp(time_t now) {
+    if (now == cachedTimestampSecond) {
+        return true;
+    }
+
+    time_t previous = cachedTimestampSecond;
+    if (cachedTimestampDay < 0 || now < cachedTimestampDay || now >= cachedTimestampDay + SECONDS_PER_DAY) {
+        struct tm* timeinfo = gmtime(&now);
+
+        // Check for NULL (invalid time)
+        if (timeinfo == nullptr) {
+            LOG_ERROR("[NET] ERROR: gmtime() returned NULL - invalid time");
+            cachedTimestampDay = -1;
+            cachedTimestampSecond = -1;
+            return false;
+        }
+
+        // Format: 2025-01-18T14:30:45Z (ISO 8601)
+        snprintf(cachedTimestamp, sizeof(cachedTimestamp),
+                 "%04d-%02d-%02dT%02d:%02d:%02dZ",
+                 timeinfo->tm_year + 1900,
+                 timeinfo->tm_mon + 1,
+                 timeinfo->tm_mday,
+                 timeinfo->tm_hour,
+                 timeinfo->tm_min,
+                 timeinfo->tm_sec);
+        cachedTimestampDay = now - now % SECONDS_PER_DAY;
+        cachedTimestampSecond = now;
+        return true;
+    }
+
+    // Same day: rewrite from the largest field that changed
+    uint32_t secondOfDay = (uint32_t)(now - cachedTimestampDay);
+    uint32_t previousSecondOfDay = (uint32_t)(previous - cachedTimestampDay);
+    char* timeFields = cachedTimestamp + TIMESTAMP_HOUR_OFFSET;
+
+    if (secondOfDay / 3600 != previousSecondOfDay / 3600) {
+        writeTwoDigits(timeFields, secondOfDay / 3600);
+    }
+    if (secondOfDay / 60 != previousSecondOfDay / 60) {
+        writeTwoDigits(timeFields + 3, (secondOfDay / 60) % 60);
+    }
+    writeTwoDigits(timeFields + 6, secondOfDay % 60);
+
+    cachedTimestampSecond = now;
+    return true;
+}
+
+/**
+ * Log the current UTC time
+ *
+ * @param prefix Message prefix
+ */
+static void logCurrentTime(const char* prefix) {
+    char timestamp[TIMESTAMP_BUFFER_SIZE];
+    getCurrentTimestamp(timestamp, sizeof(timestamp));
+    LOG_INFO("[NET] %s: %s", prefix, timestamp);
+}
+
+bool initializeTime() {
+    LOG_DEBUG("\n[NET] ═══════════════════════════════════");
+    LOG_INFO("[NET] Starting Time Synchronization");
+    LOG_DEBUG("[NET] ═══════════════════════════════════");
+    LOG_INFO("[NET] NTP Server: %s", NTP_SERVER);
+
+    // Continue from the cached time until SNTP answers
+    if (restoreTimeCache()) {
+        timeInitialized = true;
+        logCurrentTime("Restored cached time (unsynced)");
+    } else {
+        LOG_INFO("[NET] No cached time - timestamps invalid until first sync");
+    }
+
+    // SNTP runs in the background and re-syncs periodically (drift correction)
+    settimeofday_cb(onTimeSet);
+    configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
+
     return true;
 }
 
+void serviceTime() {
+    if (sntpTimeSet) {
+        sntpTimeSet = false;
+
+        time_t now = time(nullptr);
+        if (now < (time_t)MIN_VALID_UNIX_TIMESTAMP) {
+            return;  // Ignore a bogus answer
+        }
+
+        if (timeInitialized) {
+            // Where the old clock would be now vs. what SNTP says
+            time_t expected = referenceEpoch + (time_t)((millis() - referenceMillis) / 1000);
+            long correction = (long)(now - expected);
+            if (correction != 0) {
+                LOG_INFO("[NET] Clock corrected by %ld s", correction);
+            }
+        }
+
+        if (!timeSynced) {
+            logCurrentTime("Time synchronized");
+        }
+
+        timeInitialized = true;
+        timeSynced = true;
+        setTimeReference(now);
+        saveTimeCache(now);
+        return;
+    }
+
+    // Keep the RTC copy recent so a reset loses little time
+    if (timeInitialized && millis() - lastTimeCacheSave >= TIME_CACHE_SAVE_INTERVAL) {
+        saveTimeCache(time(nullptr));
+    }
+}
+
 bool isTimeInitialized() {
     return timeInitialized;
 }
 
-String getCurrentTimestamp() {
+bool isTimeSynced() {
+    return timeSynced;
+}
+
+void getCurrentTimestamp(char* buffer, size_t bufferSize) {
+    static const char* EPOCH_TIMESTAMP = "1970-01-01T00:00:00Z";  // Indicates not initialized
+
     if (!timeInitialized) {
-        return "1970-01-01T00:00:00Z";  // Epoch time (indicates not initialized)
+        strlcpy(buffer, EPOCH_TIMESTAMP, bufferSize);
+        return;
     }
     
-    time_t now = time(nullptr);
-    struct tm* timeinfo = gmtime(&now);
-
-    // Check for NULL (invalid time)
-    if (timeinfo == nullptr) {
-        Serial.println("[NET] ERROR: gmtime() returned NULL - invalid time");
-        return "1970-01-01T00:00:00Z";
+    if (!updateCachedTimestamp(time(nullptr))) {
+        strlcpy(buffer, EPOCH_TIMESTAMP, bufferSize);
+        return;
     }
+    strlcpy(buffer, cachedTimestamp, bufferSize);
+}
 
-    // Format: 2025-01-18T14:30:45Z (ISO 8601)
-    char timestamp[TIMESTAMP_BUFFER_SIZE];
-    snprintf(timestamp, sizeof(timestamp),
-             "%04d-%02d-%02dT%02d:%02d:%02dZ",
-             timeinfo->tm_year + 1900,
-             timeinfo->tm_mon + 1,
-             timeinfo->tm_mday,
-             timeinfo->tm_hour,
-             timeinfo->tm_min,
-             timeinfo->tm_sec);
-    
-    return String(timestamp);
+unsigned long getCurrentEpochSeconds() {
+    if (!timeInitialized) {
+        return 0;  // Indicates not initialized (same as the 1970 ISO fallback)
+    }
+    return (unsigned long)time(nullptr);
 }
 
 int getWiFiRSSI() {
@@ -184,46 +563,42 @@ unsigned long getUptimeSeconds() {
 }
 
 void printNetworkDiagnostics() {
-    Serial.println("\n[NET] ═══════════════════════════════════");
-    Serial.println("[NET] Network Diagnostics");
-    Serial.println("[NET] ═══════════════════════════════════");
+    LOG_INFO("\n[NET] ═══════════════════════════════════");
+    LOG_INFO("[NET] Network Diagnostics");
+    LOG_INFO("[NET] ═══════════════════════════════════");
     
     // WiFi status
-    Serial.print("[NET] WiFi Status: ");
     if (isWiFiConnected()) {
-        Serial.println("Connected");
-        Serial.print("[NET] SSID: ");
-        Serial.println(WiFi.SSID());
-        Serial.print("[NET] IP Address: ");
-        Serial.println(WiFi.localIP());
-        Serial.print("[NET] MAC Address: ");
-        Serial.println(WiFi.macAddress());
-        Serial.print("[NET] Signal Strength: ");
-        Serial.print(WiFi.RSSI());
-        Serial.println(" dBm");
+        LOG_INFO("[NET] WiFi Status: Connected");
+        LOG_INFO("[NET] SSID: %s", WiFi.SSID().c_str());
+        LOG_INFO("[NET] IP Address: %s", WiFi.localIP().toString().c_str());
+        LOG_INFO("[NET] MAC Address: %s", WiFi.macAddress().c_str());
+        LOG_INFO("[NET] Signal Strength: %d dBm", (int)WiFi.RSSI());
     } else {
-        Serial.println("Disconnected");
+        LOG_INFO("[NET] WiFi Status: Disconnected");
     }
     
     // Time synchronization
-    Serial.print("[NET] Time Sync: ");
     if (timeInitialized) {
-        Serial.println("Synchronized");
-        Serial.print("[NET] Current Time: ");
-        Serial.println(getCurrentTimestamp());
+        char timestamp[TIMESTAMP_BUFFER_SIZE];
+        getCurrentTimestamp(timestamp, sizeof(timestamp));
+        LOG_INFO("[NET] Time Sync: %s", timeSynced ? "Synchronized" : "Cached (not yet synchronized)");
+        LOG_INFO("[NET] Current Time: %s", timestamp);
     } else {
-        Serial.println("Not synchronized");
+        LOG_INFO("[NET] Time Sync: Not synchronized");
     }
     
     // Uptime
-    Serial.print("[NET] Uptime: ");
-    Serial.print(getUptimeSeconds());
-    Serial.println(" seconds");
+    LOG_INFO("[NET] Uptime: %lu seconds", getUptimeSeconds());
     
     // Memory
-    Serial.print("[NET] Free Heap: ");
-    Serial.print(ESP.getFreeHeap());
-    Serial.println(" bytes");
+    MemoryStats memory;
+    getMemoryStats(memory);
+    LOG_INFO("[NET] Free Heap: %u bytes (lowest %u since boot)",
+             (unsigned int)memory.freeHeap, (unsigned int)memory.minFreeHeap);
+    LOG_INFO("[NET] Largest Free Block: %u bytes | Fragmentation: %u%%",
+             (unsigned int)memory.maxFreeBlock, (unsigned int)memory.heapFragmentation);
+    LOG_INFO("[NET] Free Stack: %u bytes (lowest since boot)", (unsigned int)memory.minFreeStack);
     
-    Serial.println("[NET] ═══════════════════════════════════\n");
-}
\ No newline at end of file
+    LOG_INFO("[NET] ═══════════════════════════════════\n");
+}
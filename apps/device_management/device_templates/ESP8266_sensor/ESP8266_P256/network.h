@@ -9,14 +9,15 @@
 // ============================================================================
 // This module handles:
 // - WiFi connection and reconnection
-// - NTP time synchronization
+// - NTP time synchronization (background SNTP, RTC-cached time)
 // - Network status monitoring
 // ============================================================================
 
 /**
  * Initialize WiFi connection
  * Connects to WiFi network specified in config.h
- * Blocks until connection is established or timeout occurs
+ * Blocks until connection is established or timeout occurs (boot only -
+ * use reconnectWiFi() once the scheduler runs)
  * 
  * @return true if connected successfully, false on timeout
  */
@@ -29,37 +30,73 @@ bool initializeWiFi();
  */
 bool isWiFiConnected();
 
+/**
+ * Check if a connection attempt is running (see reconnectWiFi())
+ * 
+ * @return true while connecting, false otherwise
+ */
+bool isWiFiConnecting();
+
 /**
  * Reconnect to WiFi if connection was lost
- * Non-blocking - returns immediately
+ * Non-blocking: the first call starts an attempt (fast connect with the
+ * cached parameters, full scan after WIFI_FAST_CONNECT_TIMEOUT), later
+ * calls advance it. Call it again soon while isWiFiConnecting() is true.
  * 
- * @return true if reconnection successful, false otherwise
+ * @return true once connected, false while connecting or after the attempt timed out
  */
 bool reconnectWiFi();
 
 /**
- * Initialize NTP (Network Time Protocol) time synchronization
- * Gets current time from internet time servers
- * Must be called after WiFi is connected
+ * Start time synchronization (non-blocking)
+ * Restores the last known time from RTC memory (survives soft resets) and
+ * starts SNTP in the background. Timestamps use the cached time, flagged
+ * as unsynced, until the first SNTP answer arrives.
+ * Does not need WiFi to be connected.
  * 
- * @return true if time synchronized successfully, false otherwise
+ * @return true once synchronization has been started
  */
-bool initializeNTP();
+bool initializeTime();
 
 /**
- * Check if time has been synchronized with NTP server
+ * Handle SNTP updates and refresh the cached time in RTC memory
+ * Call this on every loop() iteration; it never blocks.
+ */
+void serviceTime();
+
+/**
+ * Check if the clock holds a usable time (synchronized or cached)
  * 
  * @return true if time is valid, false otherwise
  */
 bool isTimeInitialized();
 
+/**
+ * Check if the clock has been set by SNTP since boot
+ * 
+ * @return true if synchronized, false if running on cached time (or none)
+ */
+bool isTimeSynced();
+
 /**
  * Get current timestamp in ISO 8601 format (UTC)
  * Format: "2025-01-18T14:30:45Z"
+ * Writes into the caller's buffer - no heap allocation. The string is
+ * cached: within a day only the changed time fields are rewritten, so a
+ * call is mostly a copy (the date is formatted once per day).
+ * 
+ * @param buffer Output buffer (TIMESTAMP_BUFFER_SIZE bytes recommended)
+ * @param bufferSize Size of output buffer in bytes
+ */
+void getCurrentTimestamp(char* buffer, size_t bufferSize);
+
+/**
+ * Get current time as Unix epoch seconds (UTC)
+ * Used by the compact CBOR wire format instead of an ISO string.
  * 
- * @return String containing formatted timestamp
+ * @return Seconds since 1970-01-01, or 0 if time is not synchronized
  */
-String getCurrentTimestamp();
+unsigned long getCurrentEpochSeconds();
 
 /**
  * Get WiFi signal strength (RSSI)
@@ -0,0 +1,99 @@
+#include "config.h"
+#include "ota.h"
+#include "credentials.h"
+#include "storage.h"
+#include "logging.h"
+#include <ESP8266WiFi.h>
+#include <ESP8266httpUpdate.h>
+
+#if OTA_UPDATES_ENABLED
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static bool updatesReady = false;
+
+// The Updater keeps pointers to the hash and the verifier, so they live for
+// the whole run. Installing them makes it reject unsigned or altered images.
+static BearSSL::PublicKey signingKey;
+static BearSSL::HashSHA256 imageHash;
+static BearSSL::SigningVerifier imageVerifier(&signingKey);
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+bool initializeFirmwareUpdates() {
+    if (!signingKey.parse(FIRMWARE_SIGNING_PUBLIC_KEY, strlen(FIRMWARE_SIGNING_PUBLIC_KEY)) ||
+        !signingKey.isEC()) {
+        LOG_ERROR("[OTA] Invalid FIRMWARE_SIGNING_PUBLIC_KEY - firmware updates disabled");
+        updatesReady = false;
+        return false;
+    }
+
+    // Restart only after the offline store is flushed (see checkForFirmwareUpdate())
+    ESPhttpUpdate.rebootOnUpdate(false);
+
+    LOG_INFO("[OTA] Firmware %s, checking %s every %lu minutes",
+             FIRMWARE_VERSION, FIRMWARE_UPDATE_URL, FIRMWARE_UPDATE_CHECK_INTERVAL / 60000);
+    updatesReady = true;
+    return true;
+}
+
+bool checkForFirmwareUpdate() {
+    if (!updatesReady) {
+        return false;
+    }
+
+    // The server reports per device which version it runs
+    char url[FIRMWARE_URL_BUFFER_SIZE];
+    int length = snprintf(url, sizeof(url), "%s?device_id=%s", FIRMWARE_UPDATE_URL, getCredentials().deviceId);
+    if (length < 0 || (size_t)length >= sizeof(url)) {
+        LOG_ERROR("[OTA] FIRMWARE_UPDATE_URL too long");
+        return false;
+    }
+
+    LOG_DEBUG("[OTA] Checking for a firmware update (running %s)", FIRMWARE_VERSION);
+
+    // Must be in place before the download starts (Update.begin())
+    Update.installSignature(&imageHash, &imageVerifier);
+
+    // Sends FIRMWARE_VERSION in x-ESP8266-version: 304 = up to date,
+    // 200 = image follows. Closes the other connections before writing.
+    WiFiClient client;
+    t_httpUpdate_return result = ESPhttpUpdate.update(client, url, FIRMWARE_VERSION);
+
+    switch (result) {
+        case HTTP_UPDATE_NO_UPDATES:
+            LOG_DEBUG("[OTA] Firmware is up to date");
+            return false;
+
+        case HTTP_UPDATE_FAILED:
+            LOG_ERROR("[OTA] Firmware update failed (%d): %s",
+                      ESPhttpUpdate.getLastError(), ESPhttpUpdate.getLastErrorString().c_str());
+            return false;
+
+        case HTTP_UPDATE_OK:
+            break;
+    }
+
+    // Staged alerts only exist in RAM - write them out before restarting
+    LOG_INFO("[OTA] Firmware update installed - restarting");
+    flushOfflineStore();
+    ESP.restart();
+    return true;
+}
+
+#else
+
+bool initializeFirmwareUpdates() {
+    LOG_INFO("[OTA] Firmware updates disabled (OTA_UPDATES_ENABLED 0)");
+    return false;
+}
+
+bool checkForFirmwareUpdate() {
+    return false;
+}
+
+#endif // OTA_UPDATES_ENABLED
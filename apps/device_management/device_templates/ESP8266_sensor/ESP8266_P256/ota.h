@@ -0,0 +1,37 @@
+#ifndef OTA_H
+#define OTA_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// OTA UPDATE MODULE
+// ============================================================================
+// This module handles:
+// - Asking FIRMWARE_UPDATE_URL for the active firmware release
+// - Installing the signed, gzip-compressed image with the core's Updater
+// - Restarting into the new image once the offline store is flushed
+//
+// Images are built by "python manage.py build_firmware" without credentials
+// (see credentials.h), so the same image serves every device. The Updater
+// rejects an image whose ECDSA P-256 signature does not match
+// FIRMWARE_SIGNING_PUBLIC_KEY; the bootloader decompresses it at the restart.
+// ============================================================================
+
+/**
+ * Prepare firmware updates (parses the signing public key)
+ *
+ * @return true if updates can be installed, false if disabled or the key is invalid
+ */
+bool initializeFirmwareUpdates();
+
+/**
+ * Ask the server for a newer image and install it
+ * Blocks while the image downloads (several seconds) and restarts the
+ * device after a successful install - call only while nothing is pending.
+ *
+ * @return false if the firmware is up to date or the update failed
+ */
+bool checkForFirmwareUpdate();
+
+#endif // OTA_H
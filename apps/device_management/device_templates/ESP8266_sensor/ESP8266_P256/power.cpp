@@ -0,0 +1,119 @@
+#include "config.h"
+#include "power.h"
+#include "logging.h"
+#include <ESP8266WiFi.h>
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static bool radioHeldAwake = false;
+
+// Energy estimate window
+static unsigned long windowStart = 0;
+static unsigned long windowSleepMs = 0;   // Idle time the SDK may sleep (associated, radio not held awake)
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+/**
+ * Get the WiFi sleep type for the configured power mode
+ *
+ * @return SDK sleep type
+ */
+static WiFiSleepType_t getConfiguredSleepType() {
+#if POWER_MODE == POWER_MODE_LIGHT_SLEEP
+    return WIFI_LIGHT_SLEEP;
+#elif POWER_MODE == POWER_MODE_MODEM_SLEEP
+    return WIFI_MODEM_SLEEP;
+#else
+    return WIFI_NONE_SLEEP;
+#endif
+}
+
+/**
+ * Get the average current while the radio is allowed to sleep
+ *
+ * @return Current in mA
+ */
+static float getSleepCurrent() {
+#if POWER_MODE == POWER_MODE_LIGHT_SLEEP
+    return POWER_CURRENT_LIGHT_SLEEP_MA;
+#elif POWER_MODE == POWER_MODE_MODEM_SLEEP
+    return POWER_CURRENT_MODEM_SLEEP_MA;
+#else
+    return POWER_CURRENT_AWAKE_MA;
+#endif
+}
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+void initializePower() {
+    windowStart = millis();
+    windowSleepMs = 0;
+
+    LOG_INFO("[POWER] Power mode: %s", getPowerModeName());
+
+#if POWER_MODE != POWER_MODE_ACTIVE
+    // Station stays associated; wakes every POWER_LISTEN_INTERVAL beacons
+    if (!WiFi.setSleepMode(getConfiguredSleepType(), POWER_LISTEN_INTERVAL)) {
+        LOG_ERROR("[POWER] Failed to set WiFi sleep mode");
+    }
+#endif
+}
+
+void setRadioAwake(bool awake) {
+#if POWER_MODE != POWER_MODE_ACTIVE
+    if (awake == radioHeldAwake) {
+        return;
+    }
+
+    radioHeldAwake = awake;
+    WiFi.setSleepMode(awake ? WIFI_NONE_SLEEP : getConfiguredSleepType(), awake ? 0 : POWER_LISTEN_INTERVAL);
+    LOG_DEBUG("[POWER] Radio %s", awake ? "held awake" : "may sleep");
+#else
+    (void)awake;
+#endif
+}
+
+void powerIdle(unsigned long durationMs) {
+#if POWER_MODE != POWER_MODE_ACTIVE
+    // The SDK only sleeps while associated - idle time while (re)connecting runs awake
+    if (!radioHeldAwake && WiFi.status() == WL_CONNECTED) {
+        windowSleepMs += durationMs;
+    }
+#endif
+    delay(durationMs);
+}
+
+const char* getPowerModeName() {
+#if POWER_MODE == POWER_MODE_LIGHT_SLEEP
+    return "light_sleep";
+#elif POWER_MODE == POWER_MODE_MODEM_SLEEP
+    return "modem_sleep";
+#else
+    return "active";
+#endif
+}
+
+uint32_t takeEstimatedEnergyPerHour() {
+    unsigned long now = millis();
+    unsigned long elapsed = now - windowStart;
+    unsigned long sleepMs = (windowSleepMs < elapsed) ? windowSleepMs : elapsed;
+
+    windowStart = now;
+    windowSleepMs = 0;
+
+    if (elapsed == 0) {
+        return 0;
+    }
+
+    // Average current weighted by time awake / asleep → average power (mW),
+    // which is the energy used per hour in mWh
+    float charge = (elapsed - sleepMs) * POWER_CURRENT_AWAKE_MA + sleepMs * getSleepCurrent();
+    float averageCurrent = charge / elapsed;
+    return (uint32_t)(averageCurrent * POWER_SUPPLY_VOLTAGE + 0.5f);
+}
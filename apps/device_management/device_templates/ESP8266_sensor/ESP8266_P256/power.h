@@ -0,0 +1,75 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// POWER MODULE
+// ============================================================================
+// This module handles:
+// - WiFi sleep mode selection (POWER_MODE in config.h)
+// - Keeping the radio awake only while a request is in flight
+// - Idle sleep between scheduler tasks
+// - Estimating energy use from the time the SDK was allowed to sleep
+//
+// Power modes:
+// - POWER_MODE_ACTIVE:      SDK defaults, radio and CPU awake (default)
+// - POWER_MODE_MODEM_SLEEP: radio off between beacons, CPU keeps running
+// - POWER_MODE_LIGHT_SLEEP: radio and CPU suspended while the scheduler idles
+// In both sleep modes the station stays associated (no reconnect) and skips
+// POWER_LISTEN_INTERVAL beacons; the radio is held awake while sending.
+// ============================================================================
+
+// Power modes for POWER_MODE
+#define POWER_MODE_ACTIVE 0
+#define POWER_MODE_MODEM_SLEEP 1
+#define POWER_MODE_LIGHT_SLEEP 2
+
+#ifndef POWER_MODE
+#define POWER_MODE POWER_MODE_ACTIVE
+#endif
+
+/**
+ * Apply the configured power mode
+ * Call this once in setup(), after WiFi is initialized
+ */
+void initializePower();
+
+/**
+ * Keep the radio fully awake (e.g. while a request is in flight)
+ * Sleeping between beacons delays server responses by up to
+ * POWER_LISTEN_INTERVAL beacon periods. No effect in POWER_MODE_ACTIVE.
+ *
+ * @param awake true to disable radio sleep, false to allow it again
+ */
+void setRadioAwake(bool awake);
+
+/**
+ * Idle until the next task is due (called by the scheduler)
+ * Yields to the WiFi stack; in the sleep modes the SDK powers down the
+ * radio (and CPU) during this time.
+ *
+ * @param durationMs Time to idle in milliseconds
+ */
+void powerIdle(unsigned long durationMs);
+
+/**
+ * Get the configured power mode name (reported in heartbeats)
+ *
+ * @return "active", "modem_sleep" or "light_sleep"
+ */
+const char* getPowerModeName();
+
+/**
+ * Get estimated energy use since the previous call and start a new window
+ * A modelled duty-cycle figure, not a measurement: idle time while
+ * associated counts as asleep at the datasheet POWER_CURRENT_* figures
+ * (the SDK does not report how long it actually slept), everything else
+ * as awake. In POWER_MODE_ACTIVE it is the constant awake figure.
+ *
+ * @return Estimated energy in mWh per hour (= average power in mW)
+ */
+uint32_t takeEstimatedEnergyPerHour();
+
+#endif // POWER_H
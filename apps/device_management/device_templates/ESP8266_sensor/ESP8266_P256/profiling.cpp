@@ -0,0 +1,199 @@
+#include "config.h"
+#include "profiling.h"
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static const char* const PROFILE_POINT_NAMES[PROFILE_POINT_COUNT] = {
+    "measure_distance",
+    "create_payload",
+    "sha256",
+    "ecdsa_sign",
+    "der_base64",
+    "http_connect",
+    "http_round_trip"
+};
+
+#if PROFILING_ENABLED
+
+// Log-linear buckets: values 0-3 us get their own bucket, every power of two
+// above is split into 4 buckets. 23 octaves cover up to 2^24 us (16.7 s);
+// longer values land in the last bucket.
+static const uint8_t HISTOGRAM_SUB_BUCKETS = 4;
+static const uint8_t HISTOGRAM_BUCKETS = 92;
+
+/**
+ * Counters of one profile point
+ */
+struct ProfileHistogram {
+    uint32_t count;
+    uint32_t totalMicros;
+    uint32_t minMicros;
+    uint32_t maxMicros;
+    uint16_t buckets[HISTOGRAM_BUCKETS];
+};
+
+static ProfileHistogram histograms[PROFILE_POINT_COUNT];        // Samples since the last heartbeat was built
+static ProfileHistogram reportHistograms[PROFILE_POINT_COUNT];  // Samples reported by heartbeats not yet delivered
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+/**
+ * Get the histogram bucket of a duration
+ *
+ * @param micros Duration in microseconds
+ * @return Bucket index
+ */
+static uint8_t getBucketIndex(uint32_t micros) {
+    if (micros < HISTOGRAM_SUB_BUCKETS) {
+        return (uint8_t)micros;
+    }
+
+    uint8_t octave = 31 - __builtin_clz(micros);           // >= 2
+    uint8_t sub = (micros >> (octave - 2)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    uint16_t index = (octave - 1) * HISTOGRAM_SUB_BUCKETS + sub;
+
+    return (index < HISTOGRAM_BUCKETS) ? (uint8_t)index : HISTOGRAM_BUCKETS - 1;
+}
+
+/**
+ * Get the largest duration that falls into a bucket
+ *
+ * @param index Bucket index
+ * @return Upper bound in microseconds
+ */
+static uint32_t getBucketUpperBound(uint8_t index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+
+    uint8_t octave = index / HISTOGRAM_SUB_BUCKETS + 1;
+    uint8_t sub = index % HISTOGRAM_SUB_BUCKETS;
+    return ((uint32_t)(HISTOGRAM_SUB_BUCKETS + 1 + sub) << (octave - 2)) - 1;
+}
+
+/**
+ * Add the samples of one histogram to another
+ *
+ * @param into Histogram to add to
+ * @param from Histogram to add
+ */
+static void mergeHistogram(ProfileHistogram& into, const ProfileHistogram& from) {
+    if (from.count == 0) {
+        return;
+    }
+
+    if (into.count == 0 || from.minMicros < into.minMicros) {
+        into.minMicros = from.minMicros;
+    }
+    if (from.maxMicros > into.maxMicros) {
+        into.maxMicros = from.maxMicros;
+    }
+    into.count += from.count;
+    into.totalMicros += from.totalMicros;
+
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        uint32_t bucket = (uint32_t)into.buckets[i] + from.buckets[i];
+        into.buckets[i] = (bucket < UINT16_MAX) ? (uint16_t)bucket : UINT16_MAX;
+    }
+}
+
+#endif // PROFILING_ENABLED
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+void profileEnd(ProfilePoint point, uint32_t startCycles) {
+    profileRecordCycles(point, ESP.getCycleCount() - startCycles);
+}
+
+void profileRecordCycles(ProfilePoint point, uint32_t cycles) {
+#if PROFILING_ENABLED
+    if (point >= PROFILE_POINT_COUNT) {
+        return;
+    }
+
+    uint32_t micros = cycles / ESP.getCpuFreqMHz();
+    ProfileHistogram& histogram = histograms[point];
+
+    if (histogram.count == 0 || micros < histogram.minMicros) {
+        histogram.minMicros = micros;
+    }
+    if (micros > histogram.maxMicros) {
+        histogram.maxMicros = micros;
+    }
+    histogram.count++;
+    histogram.totalMicros += micros;
+
+    uint16_t& bucket = histogram.buckets[getBucketIndex(micros)];
+    if (bucket < UINT16_MAX) {
+        bucket++;
+    }
+#else
+    (void)point;
+    (void)cycles;
+#endif
+}
+
+bool getProfileSummary(ProfilePoint point, ProfileSummary& summary) {
+    memset(&summary, 0, sizeof(summary));
+
+#if PROFILING_ENABLED
+    if (point >= PROFILE_POINT_COUNT || reportHistograms[point].count == 0) {
+        return false;
+    }
+
+    const ProfileHistogram& histogram = reportHistograms[point];
+    summary.count = histogram.count;
+    summary.minMicros = histogram.minMicros;
+    summary.avgMicros = histogram.totalMicros / histogram.count;
+    summary.maxMicros = histogram.maxMicros;
+
+    // Smallest bucket that holds at least 99% of the samples
+    uint32_t rank = (histogram.count * 99 + 99) / 100;
+    uint32_t seen = 0;
+    summary.p99Micros = histogram.maxMicros;
+    for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram.buckets[i];
+        if (seen >= rank) {
+            summary.p99Micros = getBucketUpperBound(i);
+            break;
+        }
+    }
+
+    // Bucket bounds can overshoot the samples actually seen
+    if (summary.p99Micros > summary.maxMicros) {
+        summary.p99Micros = summary.maxMicros;
+    }
+    if (summary.p99Micros < summary.minMicros) {
+        summary.p99Micros = summary.minMicros;
+    }
+    return true;
+#else
+    (void)point;
+    return false;
+#endif
+}
+
+const char* getProfilePointName(ProfilePoint point) {
+    return (point < PROFILE_POINT_COUNT) ? PROFILE_POINT_NAMES[point] : "unknown";
+}
+
+void closeProfileWindow() {
+#if PROFILING_ENABLED
+    for (uint8_t i = 0; i < PROFILE_POINT_COUNT; i++) {
+        mergeHistogram(reportHistograms[i], histograms[i]);
+    }
+    memset(histograms, 0, sizeof(histograms));
+#endif
+}
+
+void confirmProfileReport() {
+#if PROFILING_ENABLED
+    memset(reportHistograms, 0, sizeof(reportHistograms));
+#endif
+}
@@ -0,0 +1,103 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// PROFILING MODULE
+// ============================================================================
+// This module handles:
+// - Timing hot paths with the CPU cycle counter (ESP.getCycleCount())
+// - Fixed-size histograms per profile point (no allocation)
+// - Min/avg/max/p99 summaries for the heartbeat "performance" object
+//
+// Counters cover the window since the previous delivered heartbeat: a
+// heartbeat that is not acknowledged leaves its window to the next one.
+// The cycle counter wraps after 2^32 cycles (53 s at 80 MHz), far longer
+// than any timed step.
+// PROFILING_ENABLED 0 (config.h) compiles the counters out.
+// ============================================================================
+
+/**
+ * Timed operations
+ */
+enum ProfilePoint {
+    PROFILE_MEASURE_DISTANCE = 0,  // HC-SR04 trigger until the reading is collected
+    PROFILE_CREATE_PAYLOAD,        // Payload serialization (includes hashing while writing)
+    PROFILE_SHA256,                // SHA-256 of one message
+    PROFILE_ECDSA_SIGN,            // ECDSA signature (precomputed nonce or full uECC_sign)
+    PROFILE_SIGNATURE_ENCODE,      // DER + Base64 encoding of the signature
+    PROFILE_HTTP_CONNECT,          // Opening a new TCP connection
+    PROFILE_HTTP_ROUND_TRIP,       // Request sent until the response is complete
+    PROFILE_POINT_COUNT
+};
+
+/**
+ * Summary of one profile point (microseconds)
+ */
+struct ProfileSummary {
+    uint32_t count;
+    uint32_t minMicros;
+    uint32_t avgMicros;
+    uint32_t maxMicros;
+    uint32_t p99Micros;   // Upper bound of the histogram bucket (within ~25%)
+};
+
+/**
+ * Read the cycle counter at the start of a timed operation
+ *
+ * @return Start value for profileEnd()
+ */
+inline uint32_t profileStart() {
+    return ESP.getCycleCount();
+}
+
+/**
+ * Record a timed operation that started at profileStart()
+ *
+ * @param point Operation that was timed
+ * @param startCycles Value returned by profileStart()
+ */
+void profileEnd(ProfilePoint point, uint32_t startCycles);
+
+/**
+ * Record an operation measured in CPU cycles (e.g. accumulated over
+ * several calls)
+ *
+ * @param point Operation that was timed
+ * @param cycles Duration in CPU cycles
+ */
+void profileRecordCycles(ProfilePoint point, uint32_t cycles);
+
+/**
+ * Get the summary of a profile point for the window closed by
+ * closeProfileWindow()
+ *
+ * @param point Profile point
+ * @param summary Output: count, min, avg, max, p99 in microseconds
+ * @return true if there were samples, false otherwise (or profiling disabled)
+ */
+bool getProfileSummary(ProfilePoint point, ProfileSummary& summary);
+
+/**
+ * Get the telemetry name of a profile point (e.g. "ecdsa_sign")
+ *
+ * @param point Profile point
+ * @return Name string (static)
+ */
+const char* getProfilePointName(ProfilePoint point);
+
+/**
+ * Close the current window for the heartbeat being built and start a new one
+ * The closed samples join those of earlier heartbeats that were not
+ * delivered; getProfileSummary() reports them until confirmProfileReport().
+ */
+void closeProfileWindow();
+
+/**
+ * Drop the reported samples once their heartbeat was acknowledged
+ */
+void confirmProfileReport();
+
+#endif // PROFILING_H
@@ -0,0 +1,283 @@
+#include "config.h"
+#include "scheduler.h"
+#include "power.h"
+#include "logging.h"
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+/**
+ * Registered task
+ * nextRun is the next deadline; periodStart is the deadline of the last
+ * regular run, so early runs (scheduleTaskIn) don't shift the period.
+ */
+struct Task {
+    TaskCallback callback;
+    unsigned long intervalMs;
+    unsigned long nextRun;
+    unsigned long periodStart;
+    TaskPriority priority;
+    bool enabled;
+    bool earlyRun;      // nextRun was requested by scheduleTaskIn()
+    bool rescheduled;   // scheduleTaskIn() was called while the task ran
+    TaskStats stats;
+};
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+static uint8_t taskCount = 0;
+static int8_t runningTask = -1;
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+/**
+ * Check if a task handle refers to a registered task
+ */
+static bool isValidTask(TaskId task) {
+    return task >= 0 && task < taskCount;
+}
+
+/**
+ * Check if a deadline has been reached (wrap-safe)
+ *
+ * @param deadline millis() value of the deadline
+ * @param now Current millis()
+ * @return true if due
+ */
+static bool isDue(unsigned long deadline, unsigned long now) {
+    return (long)(now - deadline) >= 0;
+}
+
+/**
+ * Find the due task to run next: highest priority, then earliest deadline
+ *
+ * @param now Current millis()
+ * @return Task index, or -1 if no task is due
+ */
+static int8_t findNextDueTask(unsigned long now) {
+    int8_t best = -1;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const Task& task = tasks[i];
+        if (!task.enabled || !isDue(task.nextRun, now)) {
+            continue;
+        }
+        if (best < 0 ||
+            task.priority < tasks[best].priority ||
+            (task.priority == tasks[best].priority &&
+             (long)(task.nextRun - tasks[best].nextRun) < 0)) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Run one task and update its statistics and next deadline
+ *
+ * @param index Task index
+ * @param now millis() when the task was selected
+ */
+static void runTask(int8_t index, unsigned long now) {
+    Task& task = tasks[index];
+    unsigned long deadline = task.nextRun;
+
+    // Lateness only means something for regular (periodic) runs
+    if (!task.earlyRun) {
+        task.periodStart = deadline;
+        task.stats.periodicRuns++;
+
+        unsigned long lateness = now - deadline;
+        task.stats.totalLatenessMs += lateness;
+        if (lateness > task.stats.maxLatenessMs) {
+            task.stats.maxLatenessMs = lateness;
+        }
+        if (lateness > SCHEDULER_LATE_THRESHOLD) {
+            task.stats.lateRuns++;
+        }
+    }
+
+    task.rescheduled = false;
+    runningTask = index;
+
+    unsigned long startMicros = micros();
+    task.callback();
+    unsigned long runMicros = micros() - startMicros;
+
+    runningTask = -1;
+
+    task.stats.runCount++;
+    task.stats.totalRunMicros += runMicros;
+    if (runMicros > task.stats.maxRunMicros) {
+        task.stats.maxRunMicros = runMicros;
+    }
+
+    if (task.rescheduled) {
+        return;  // Task asked for an early run - nextRun already set
+    }
+
+    // Fixed rate: next deadline is one period after the last regular one.
+    // If the task overran a whole period, skip the missed runs.
+    task.earlyRun = false;
+    task.nextRun = task.periodStart + task.intervalMs;
+    unsigned long finished = millis();
+    if (isDue(task.nextRun, finished)) {
+        task.nextRun = finished + task.intervalMs;
+        task.periodStart = finished;
+    }
+}
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+TaskId addTask(const char* name, TaskCallback callback, unsigned long intervalMs, TaskPriority priority) {
+    if (taskCount >= SCHEDULER_MAX_TASKS || callback == nullptr) {
+        LOG_ERROR("[SCHED] Cannot add task %s (max %u tasks)", name, (unsigned int)SCHEDULER_MAX_TASKS);
+        return -1;
+    }
+
+    Task& task = tasks[taskCount];
+    memset(&task, 0, sizeof(task));
+    task.callback = callback;
+    task.intervalMs = intervalMs;
+    task.priority = priority;
+    task.enabled = true;
+    task.periodStart = millis();
+    task.nextRun = task.periodStart + intervalMs;
+    task.stats.name = name;
+
+    LOG_DEBUG("[SCHED] Task %s: every %lu ms, priority %d", name, intervalMs, (int)priority);
+
+    return (TaskId)taskCount++;
+}
+
+void setTaskInterval(TaskId task, unsigned long intervalMs) {
+    if (isValidTask(task)) {
+        tasks[task].intervalMs = intervalMs;
+    }
+}
+
+void setTaskEnabled(TaskId task, bool enabled) {
+    if (!isValidTask(task) || tasks[task].enabled == enabled) {
+        return;
+    }
+
+    tasks[task].enabled = enabled;
+    if (enabled) {
+        tasks[task].nextRun = millis();
+        tasks[task].earlyRun = false;
+    }
+}
+
+void scheduleTaskIn(TaskId task, unsigned long delayMs) {
+    if (!isValidTask(task)) {
+        return;
+    }
+
+    Task& entry = tasks[task];
+    unsigned long requested = millis() + delayMs;
+
+    // Only ever move a pending run earlier (unless the task reschedules itself)
+    bool isRunning = runningTask == task;
+    if (!isRunning && (long)(requested - entry.nextRun) >= 0) {
+        return;
+    }
+
+    entry.nextRun = requested;
+    entry.earlyRun = true;
+    if (isRunning) {
+        entry.rescheduled = true;
+    }
+}
+
+void triggerTask(TaskId task) {
+    scheduleTaskIn(task, 0);
+}
+
+void runScheduler() {
+    // Run everything that is due (bounded, so a task that keeps
+    // triggering itself cannot starve the WiFi stack)
+    for (uint8_t runs = 0; runs < taskCount * 2; runs++) {
+        unsigned long now = millis();
+        int8_t index = findNextDueTask(now);
+        if (index < 0) {
+            break;
+        }
+        runTask(index, now);
+        yield();
+    }
+
+    unsigned long sleepMs = getTimeUntilNextTask();
+    if (sleepMs > SCHEDULER_MAX_IDLE_SLEEP) {
+        sleepMs = SCHEDULER_MAX_IDLE_SLEEP;
+    }
+
+    if (sleepMs > 0) {
+        powerIdle(sleepMs);  // Radio/CPU may sleep here (POWER_MODE)
+    } else {
+        yield();
+    }
+}
+
+unsigned long getTimeUntilNextTask() {
+    unsigned long now = millis();
+    unsigned long soonest = SCHEDULER_MAX_IDLE_SLEEP;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        if (!tasks[i].enabled) {
+            continue;
+        }
+        if (isDue(tasks[i].nextRun, now)) {
+            return 0;
+        }
+        unsigned long remaining = tasks[i].nextRun - now;
+        if (remaining < soonest) {
+            soonest = remaining;
+        }
+    }
+
+    return soonest;
+}
+
+bool getTaskStats(TaskId task, TaskStats& stats) {
+    if (!isValidTask(task)) {
+        return false;
+    }
+    stats = tasks[task].stats;
+    return true;
+}
+
+void resetTaskStats() {
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const char* name = tasks[i].stats.name;
+        memset(&tasks[i].stats, 0, sizeof(TaskStats));
+        tasks[i].stats.name = name;
+    }
+}
+
+void printSchedulerStats() {
+    LOG_INFO("\n[SCHED] ═══════════════════════════════════");
+    LOG_INFO("[SCHED] Task Statistics");
+    LOG_INFO("[SCHED] ═══════════════════════════════════");
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const TaskStats& stats = tasks[i].stats;
+        unsigned long averageMicros = stats.runCount ? stats.totalRunMicros / stats.runCount : 0;
+        unsigned long averageLateness = stats.periodicRuns ? stats.totalLatenessMs / stats.periodicRuns : 0;
+
+        LOG_INFO("[SCHED] %-10s runs %lu | run avg %lu us max %lu us | late avg %lu ms max %lu ms (%lu late)",
+                 stats.name,
+                 (unsigned long)stats.runCount,
+                 averageMicros,
+                 (unsigned long)stats.maxRunMicros,
+                 averageLateness,
+                 (unsigned long)stats.maxLatenessMs,
+                 (unsigned long)stats.lateRuns);
+    }
+
+    LOG_INFO("[SCHED] ═══════════════════════════════════\n");
+}
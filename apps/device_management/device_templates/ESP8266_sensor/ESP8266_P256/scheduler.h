@@ -0,0 +1,131 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// SCHEDULER MODULE
+// ============================================================================
+// This module handles:
+// - Cooperative periodic tasks (sensor, LED, heartbeat, network)
+// - Running due tasks in priority order, earliest deadline first
+// - Sleeping until the next task is due instead of spinning in loop()
+// - Per-task run time and lateness statistics
+//
+// Tasks run to completion and must not block; a task that needs to check
+// back soon (e.g. waiting for an echo) asks for an early run with
+// scheduleTaskIn(). Its regular period is kept.
+// ============================================================================
+
+/**
+ * Task function - runs to completion, no arguments
+ */
+typedef void (*TaskCallback)();
+
+/**
+ * Task priorities (when several tasks are due, higher runs first)
+ */
+enum TaskPriority {
+    TASK_PRIORITY_HIGH = 0,    // Timing-sensitive (sensor measurement)
+    TASK_PRIORITY_NORMAL = 1,  // Messaging, network housekeeping
+    TASK_PRIORITY_LOW = 2      // Indicators, diagnostics
+};
+
+/**
+ * Task handle returned by addTask() (-1 = not registered)
+ */
+typedef int8_t TaskId;
+
+/**
+ * Per-task statistics (since boot or resetTaskStats())
+ */
+struct TaskStats {
+    const char* name;
+    uint32_t runCount;
+    uint32_t periodicRuns;     // Regular runs (not requested with scheduleTaskIn)
+    uint32_t totalRunMicros;   // Time spent inside the task function
+    uint32_t maxRunMicros;
+    uint32_t totalLatenessMs;  // How long periodic runs started after their deadline
+    uint32_t maxLatenessMs;
+    uint32_t lateRuns;         // Periodic runs later than SCHEDULER_LATE_THRESHOLD
+};
+
+/**
+ * Register a periodic task
+ * The first run is due one interval after registration.
+ *
+ * @param name Task name for statistics (must stay valid, e.g. a literal)
+ * @param callback Task function
+ * @param intervalMs Period in milliseconds
+ * @param priority Priority when several tasks are due
+ * @return Task handle, or -1 if SCHEDULER_MAX_TASKS is reached
+ */
+TaskId addTask(const char* name, TaskCallback callback, unsigned long intervalMs, TaskPriority priority);
+
+/**
+ * Change the period of a task (takes effect after its next run)
+ *
+ * @param task Task handle
+ * @param intervalMs New period in milliseconds
+ */
+void setTaskInterval(TaskId task, unsigned long intervalMs);
+
+/**
+ * Enable or disable a task (an enabled task is due immediately)
+ *
+ * @param task Task handle
+ * @param enabled true to run the task, false to suspend it
+ */
+void setTaskEnabled(TaskId task, bool enabled);
+
+/**
+ * Run a task once after a short delay, then continue its regular period
+ * Can be called from inside the task itself.
+ *
+ * @param task Task handle
+ * @param delayMs Delay in milliseconds (0 = on the next scheduler pass)
+ */
+void scheduleTaskIn(TaskId task, unsigned long delayMs);
+
+/**
+ * Run a task on the next scheduler pass (e.g. after queueing work for it)
+ *
+ * @param task Task handle
+ */
+void triggerTask(TaskId task);
+
+/**
+ * Run all due tasks, then sleep until the next one is due
+ * (at most SCHEDULER_MAX_IDLE_SLEEP). Call this from loop().
+ * Idling yields to the WiFi stack and lets the radio sleep (see power.h).
+ */
+void runScheduler();
+
+/**
+ * Get the time until the next task is due
+ *
+ * @return Milliseconds until the next deadline (0 if a task is due now)
+ */
+unsigned long getTimeUntilNextTask();
+
+/**
+ * Get the statistics of a task
+ *
+ * @param task Task handle
+ * @param stats Output: task statistics
+ * @return true if the task exists, false otherwise
+ */
+bool getTaskStats(TaskId task, TaskStats& stats);
+
+/**
+ * Clear the statistics of all tasks
+ */
+void resetTaskStats();
+
+/**
+ * Print run time and lateness of all tasks to the serial monitor
+ */
+void printSchedulerStats();
+
+#endif // SCHEDULER_H
@@ -0,0 +1,409 @@
+#include "config.h"
+#include "storage.h"
+#include "cbor.h"
+#include "logging.h"
+#include <LittleFS.h>
+
+// ============================================================================
+// RECORD LAYOUT
+// ============================================================================
+
+// Files on the LittleFS partition
+static const char* RING_FILE_PATH = "/offline.bin";     // OFFLINE_STORE_CAPACITY fixed-size slots
+static const char* CURSOR_FILE_PATH = "/offline.idx";   // Sequence of the last drained record
+
+static const uint32_t CURSOR_MAGIC = 0xC3D50001;
+
+/**
+ * One message in the ring file (with its signature, if it had one)
+ * Record with sequence N lives in slot N % OFFLINE_STORE_CAPACITY, so writing
+ * a new record automatically evicts the oldest one once the ring is full.
+ * Sequence 0 marks an empty slot.
+ */
+struct StoredRecord {
+    uint32_t sequence;
+    uint32_t checksum;                          // FNV-1a over sequence, format, length, payload, signature
+    uint8_t wireFormat;                         // MESSAGE_WIRE_FORMAT the payload was encoded in
+    uint16_t payloadLength;
+    char payload[MESSAGE_PAYLOAD_BUFFER_SIZE];
+    char signature[SIGNATURE_BUFFER_SIZE];
+};
+
+struct CursorRecord {
+    uint32_t magic;
+    uint32_t drainedSequence;
+};
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static bool storeReady = false;
+
+static uint32_t newestSequence = 0;     // Newest record written to flash (0 = none)
+static uint32_t drainedSequence = 0;    // Last record handed back (persisted in cursor file)
+static uint32_t takeSequence = 0;       // Last record read by takeOfflineMessage() (RAM only)
+
+// RAM staging area - records are written to flash together
+static StoredRecord stagedRecords[OFFLINE_STORE_STAGING_SIZE];
+static uint8_t stagedCount = 0;
+static unsigned long firstStagedTime = 0;
+
+// Flash write statistics (for serial diagnostics)
+static unsigned long flushCount = 0;
+static unsigned long evictedCount = 0;
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+/**
+ * Add bytes to a running FNV-1a hash
+ *
+ * @param hash Current hash value
+ * @param data Bytes to add
+ * @param length Number of bytes
+ * @return Updated hash value
+ */
+static uint32_t fnv1aUpdate(uint32_t hash, const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+/**
+ * Compute the integrity checksum of a record
+ * Detects slots left half-written by a power loss during a flush.
+ *
+ * @param record Record to checksum (checksum field itself is ignored)
+ * @return 32-bit FNV-1a hash
+ */
+static uint32_t computeChecksum(const StoredRecord& record) {
+    uint32_t hash = 2166136261UL;
+    hash = fnv1aUpdate(hash, &record.sequence, sizeof(record.sequence));
+    hash = fnv1aUpdate(hash, &record.wireFormat, sizeof(record.wireFormat));
+    hash = fnv1aUpdate(hash, &record.payloadLength, sizeof(record.payloadLength));
+    hash = fnv1aUpdate(hash, record.payload, record.payloadLength);
+    hash = fnv1aUpdate(hash, record.signature, strnlen(record.signature, sizeof(record.signature)));
+    return hash;
+}
+
+/**
+ * Get the byte offset of the slot holding a sequence number
+ *
+ * @param sequence Record sequence number
+ * @return Offset in the ring file
+ */
+static size_t slotOffset(uint32_t sequence) {
+    return (size_t)(sequence % OFFLINE_STORE_CAPACITY) * sizeof(StoredRecord);
+}
+
+/**
+ * Get the oldest sequence that is still stored and not yet drained
+ *
+ * @return First pending sequence (greater than newestSequence if none pending)
+ */
+static uint32_t firstPendingSequence() {
+    uint32_t oldestStored = (newestSequence >= OFFLINE_STORE_CAPACITY)
+                                ? newestSequence - OFFLINE_STORE_CAPACITY + 1
+                                : 1;
+    uint32_t afterDrained = takeSequence + 1;
+    return (afterDrained > oldestStored) ? afterDrained : oldestStored;
+}
+
+/**
+ * Create the ring file with all slots empty
+ * Done once, so later flushes only overwrite slots in place.
+ *
+ * @return true if created, false on filesystem error
+ */
+static bool createRingFile() {
+    File file = LittleFS.open(RING_FILE_PATH, "w");
+    if (!file) {
+        return false;
+    }
+
+    StoredRecord empty;
+    memset(&empty, 0, sizeof(empty));
+    for (uint16_t i = 0; i < OFFLINE_STORE_CAPACITY; i++) {
+        if (file.write((const uint8_t*)&empty, sizeof(empty)) != sizeof(empty)) {
+            file.close();
+            return false;
+        }
+    }
+    file.close();
+    return true;
+}
+
+/**
+ * Load the drain cursor
+ *
+ * @return Last drained sequence (0 if no valid cursor file)
+ */
+static uint32_t loadDrainCursor() {
+    File file = LittleFS.open(CURSOR_FILE_PATH, "r");
+    if (!file) {
+        return 0;
+    }
+
+    CursorRecord cursor;
+    size_t bytesRead = file.read((uint8_t*)&cursor, sizeof(cursor));
+    file.close();
+
+    if (bytesRead != sizeof(cursor) || cursor.magic != CURSOR_MAGIC) {
+        return 0;
+    }
+    return cursor.drainedSequence;
+}
+
+/**
+ * Find the newest record in the ring file by reading every slot header
+ *
+ * @return Highest valid sequence number (0 if the ring is empty)
+ */
+static uint32_t scanNewestSequence() {
+    File file = LittleFS.open(RING_FILE_PATH, "r");
+    if (!file) {
+        return 0;
+    }
+
+    uint32_t newest = 0;
+    for (uint16_t i = 0; i < OFFLINE_STORE_CAPACITY; i++) {
+        uint32_t sequence = 0;
+        file.seek((size_t)i * sizeof(StoredRecord));
+        if (file.read((uint8_t*)&sequence, sizeof(sequence)) == sizeof(sequence) && sequence > newest) {
+            newest = sequence;
+        }
+    }
+    file.close();
+    return newest;
+}
+
+// ============================================================================
+// PUBLIC FUNCTIONS
+// ============================================================================
+
+bool initializeOfflineStore() {
+    LOG_INFO("[STORE] Initializing offline store...");
+
+    if (!LittleFS.begin()) {
+        LOG_ERROR("[STORE] LittleFS mount failed - offline buffering disabled");
+        LOG_ERROR("[STORE] Select a Flash Size with a filesystem (FS) partition");
+        storeReady = false;
+        return false;
+    }
+
+    // (Re)create ring file if missing or built for a different capacity
+    File file = LittleFS.open(RING_FILE_PATH, "r");
+    size_t expectedSize = (size_t)OFFLINE_STORE_CAPACITY * sizeof(StoredRecord);
+    bool sizeMatches = file && file.size() == expectedSize;
+    if (file) {
+        file.close();
+    }
+
+    if (!sizeMatches) {
+        LOG_INFO("[STORE] Creating ring file (%u slots, %u bytes)",
+                 (unsigned int)OFFLINE_STORE_CAPACITY, (unsigned int)expectedSize);
+        LittleFS.remove(CURSOR_FILE_PATH);
+        if (!createRingFile()) {
+            LOG_ERROR("[STORE] Failed to create ring file - offline buffering disabled");
+            storeReady = false;
+            return false;
+        }
+    }
+
+    newestSequence = scanNewestSequence();
+    drainedSequence = loadDrainCursor();
+    if (drainedSequence > newestSequence) {
+        drainedSequence = newestSequence;  // Cursor from an older ring file
+    }
+    takeSequence = drainedSequence;
+    stagedCount = 0;
+
+    storeReady = true;
+    LOG_INFO("[STORE] Offline store ready (%u pending alerts)", (unsigned int)getOfflineMessageCount());
+    return true;
+}
+
+bool isOfflineStoreReady() {
+    return storeReady;
+}
+
+bool storeOfflineMessage(const char* payload, size_t payloadLength, const char* signature) {
+    if (!storeReady) {
+        LOG_ERROR("[STORE] Offline store not available - message dropped");
+        return false;
+    }
+
+    if (payloadLength >= MESSAGE_PAYLOAD_BUFFER_SIZE || strlen(signature) >= SIGNATURE_BUFFER_SIZE) {
+        LOG_ERROR("[STORE] Message too large for offline record");
+        return false;
+    }
+
+    if (stagedCount >= OFFLINE_STORE_STAGING_SIZE) {
+        flushOfflineStore();
+    }
+
+    if (stagedCount == 0) {
+        firstStagedTime = millis();
+    }
+
+    StoredRecord& record = stagedRecords[stagedCount];
+    memset(&record, 0, sizeof(record));
+    record.sequence = newestSequence + stagedCount + 1;
+    record.wireFormat = MESSAGE_WIRE_FORMAT;
+    record.payloadLength = (uint16_t)payloadLength;
+    memcpy(record.payload, payload, payloadLength);
+    strlcpy(record.signature, signature, sizeof(record.signature));
+    record.checksum = computeChecksum(record);
+    stagedCount++;
+
+    LOG_DEBUG("[STORE] Staged record #%lu (%u staged)", (unsigned long)record.sequence, stagedCount);
+    return true;
+}
+
+void serviceOfflineStore() {
+    if (stagedCount == 0) {
+        return;
+    }
+
+    if (stagedCount >= OFFLINE_STORE_STAGING_SIZE ||
+        millis() - firstStagedTime >= OFFLINE_STORE_FLUSH_INTERVAL) {
+        flushOfflineStore();
+    }
+}
+
+void flushOfflineStore() {
+    if (stagedCount == 0) {
+        return;
+    }
+
+    File file = LittleFS.open(RING_FILE_PATH, "r+");
+    if (!file) {
+        LOG_ERROR("[STORE] Failed to open ring file - %u staged records lost", stagedCount);
+        stagedCount = 0;
+        return;
+    }
+
+    // All staged records are written through one open file, so LittleFS
+    // commits them together instead of once per record
+    uint8_t written = 0;
+    for (uint8_t i = 0; i < stagedCount; i++) {
+        const StoredRecord& record = stagedRecords[i];
+        if (!file.seek(slotOffset(record.sequence)) ||
+            file.write((const uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+            LOG_ERROR("[STORE] Flash write failed for record #%lu", (unsigned long)record.sequence);
+            break;
+        }
+        written++;
+    }
+    file.close();
+
+    if (written > 0) {
+        uint32_t previousFirst = firstPendingSequence();
+        newestSequence += written;
+
+        // Records overwritten before they were drained (oldest-first eviction)
+        uint32_t newFirst = firstPendingSequence();
+        if (newFirst > previousFirst && previousFirst <= newestSequence - written) {
+            unsigned long evicted = newFirst - previousFirst;
+            evictedCount += evicted;
+            LOG_INFO("[STORE] Store full - evicted %lu oldest alerts (%lu since boot)", evicted, evictedCount);
+        }
+    }
+
+    flushCount++;
+    LOG_DEBUG("[STORE] Flushed %u records to flash (flush #%lu, %u pending)",
+              written, flushCount, (unsigned int)getOfflineMessageCount());
+
+    stagedCount = 0;
+}
+
+uint16_t getOfflineMessageCount() {
+    uint32_t first = firstPendingSequence();
+    uint32_t onFlash = (newestSequence >= first) ? newestSequence - first + 1 : 0;
+    uint32_t pending = onFlash + stagedCount;
+
+    // Staged records beyond capacity evict the oldest ones when flushed
+    return (uint16_t)((pending > OFFLINE_STORE_CAPACITY) ? OFFLINE_STORE_CAPACITY : pending);
+}
+
+bool takeOfflineMessage(char* payload, size_t payloadSize, size_t& payloadLength,
+                        char* signature, size_t signatureSize) {
+    if (!storeReady) {
+        return false;
+    }
+
+    File file = LittleFS.open(RING_FILE_PATH, "r");
+    if (!file) {
+        return false;
+    }
+
+    StoredRecord record;
+    bool found = false;
+
+    while (!found && firstPendingSequence() <= newestSequence) {
+        uint32_t sequence = firstPendingSequence();
+        takeSequence = sequence;
+
+        file.seek(slotOffset(sequence));
+        if (file.read((uint8_t*)&record, sizeof(record)) != sizeof(record) ||
+            record.sequence != sequence ||
+            record.payloadLength >= sizeof(record.payload) ||
+            record.checksum != computeChecksum(record)) {
+            LOG_ERROR("[STORE] Skipping corrupt record #%lu", (unsigned long)sequence);
+            continue;
+        }
+
+        // Built before MESSAGE_WIRE_FORMAT was changed - would be sent with the wrong Content-Type
+        if (record.wireFormat != MESSAGE_WIRE_FORMAT) {
+            LOG_ERROR("[STORE] Record #%lu uses the other wire format - skipped", (unsigned long)sequence);
+            continue;
+        }
+
+        if (record.payloadLength >= payloadSize) {
+            LOG_ERROR("[STORE] Record #%lu larger than output buffer - skipped", (unsigned long)sequence);
+            continue;
+        }
+
+        memcpy(payload, record.payload, record.payloadLength);
+        payload[record.payloadLength] = '\0';
+        payloadLength = record.payloadLength;
+        strlcpy(signature, record.signature, signatureSize);
+        found = true;
+    }
+
+    file.close();
+    return found;
+}
+
+void commitOfflineDrain() {
+    if (!storeReady || takeSequence == drainedSequence) {
+        return;
+    }
+
+    File file = LittleFS.open(CURSOR_FILE_PATH, "w");
+    if (!file) {
+        LOG_ERROR("[STORE] Failed to save drain cursor");
+        return;
+    }
+
+    CursorRecord cursor = { CURSOR_MAGIC, takeSequence };
+    file.write((const uint8_t*)&cursor, sizeof(cursor));
+    file.close();
+
+    drainedSequence = takeSequence;
+    LOG_DEBUG("[STORE] Drain cursor saved at #%lu", (unsigned long)drainedSequence);
+}
+
+void rewindOfflineDrain() {
+    if (takeSequence == drainedSequence) {
+        return;
+    }
+
+    LOG_DEBUG("[STORE] Drain cursor rewound to #%lu", (unsigned long)drainedSequence);
+    takeSequence = drainedSequence;
+}
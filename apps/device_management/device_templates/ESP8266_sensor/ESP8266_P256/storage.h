@@ -0,0 +1,95 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// OFFLINE STORE MODULE
+// ============================================================================
+// This module handles:
+// - Persistent store-and-forward buffer for alerts (LittleFS)
+// - Fixed-size ring of records with oldest-first eviction
+// - Write coalescing: records are staged in RAM and flushed together
+// - Draining stored alerts back to the messaging module after reconnect
+// ============================================================================
+
+/**
+ * Mount LittleFS and recover the ring buffer state from flash
+ * Call this once in setup() (done by initializeMessaging())
+ *
+ * @return true if the offline store is usable, false otherwise
+ */
+bool initializeOfflineStore();
+
+/**
+ * Check if the offline store was mounted successfully
+ *
+ * @return true if ready, false otherwise
+ */
+bool isOfflineStoreReady();
+
+/**
+ * Add a message to the offline store
+ * The record is staged in RAM and written to flash together with other
+ * staged records (see serviceOfflineStore()).
+ *
+ * @param payload Message payload, encoded in MESSAGE_WIRE_FORMAT (JSON or CBOR)
+ * @param payloadLength Length of payload in bytes
+ * @param signature Base64 signature of the payload, "" if signed when resent (null-terminated)
+ * @return true if stored, false if the store is unavailable or record too large
+ */
+bool storeOfflineMessage(const char* payload, size_t payloadLength, const char* signature);
+
+/**
+ * Flush staged records to flash when the staging area is full or the
+ * flush interval has elapsed. Call this regularly from loop().
+ */
+void serviceOfflineStore();
+
+/**
+ * Write all staged records to flash immediately
+ */
+void flushOfflineStore();
+
+/**
+ * Get number of stored messages not yet handed back for sending
+ * (includes records still staged in RAM)
+ *
+ * @return Number of pending messages
+ */
+uint16_t getOfflineMessageCount();
+
+/**
+ * Read the oldest pending message from flash
+ * Advances the drain cursor in RAM only. Once the server has answered,
+ * call commitOfflineDrain() to persist it with one write, or
+ * rewindOfflineDrain() to keep the records for another attempt.
+ * Records stored in a different MESSAGE_WIRE_FORMAT (before the setting
+ * was changed) are skipped. Staged records must be flushed first
+ * (flushOfflineStore()).
+ *
+ * @param payload Output buffer for payload (MESSAGE_WIRE_FORMAT, null-terminated)
+ * @param payloadSize Size of payload buffer
+ * @param payloadLength Output: payload length in bytes
+ * @param signature Output buffer for Base64 signature ("" if not signed yet)
+ * @param signatureSize Size of signature buffer
+ * @return true if a message was read, false if none pending
+ */
+bool takeOfflineMessage(char* payload, size_t payloadSize, size_t& payloadLength,
+                        char* signature, size_t signatureSize);
+
+/**
+ * Persist the drain cursor after the messages read by takeOfflineMessage()
+ * were delivered - they are not sent again
+ */
+void commitOfflineDrain();
+
+/**
+ * Undo the takeOfflineMessage() calls since the last commitOfflineDrain()
+ * The records stay in flash and are read again on the next drain, so a
+ * failed resend costs no flash write.
+ */
+void rewindOfflineDrain();
+
+#endif // STORAGE_H
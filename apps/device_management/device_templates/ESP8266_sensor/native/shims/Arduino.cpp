@@ -0,0 +1,175 @@
+#include "Arduino.h"
+#include <stdarg.h>
+#include <chrono>
+#include <random>
+#include <thread>
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static const uint8_t PIN_COUNT = 17;  // GPIO0-GPIO16
+static int pinLevels[PIN_COUNT];
+static void (*pinHandlers[PIN_COUNT])(void);
+static int pinHandlerModes[PIN_COUNT];
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+static uint64_t nanosSinceStart() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+/**
+ * Format into a stack buffer and write it (Print::printf / printf_P)
+ */
+static size_t writeFormatted(Print& out, const char* format, va_list args) {
+    char buffer[512];
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    if (length < 0) {
+        return 0;
+    }
+    size_t count = ((size_t)length < sizeof(buffer)) ? (size_t)length : sizeof(buffer) - 1;
+    return out.write((const uint8_t*)buffer, count);
+}
+
+// ============================================================================
+// PRINT / SERIAL
+// ============================================================================
+
+size_t Print::write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    for (size_t i = 0; i < length; i++) {
+        written += write(data[i]);
+    }
+    return written;
+}
+
+size_t Print::println(const char* text) {
+    return write(text) + write((const uint8_t*)"\n", 1);
+}
+
+size_t Print::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t written = writeFormatted(*this, format, args);
+    va_end(args);
+    return written;
+}
+
+size_t Print::printf_P(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t written = writeFormatted(*this, format, args);
+    va_end(args);
+    return written;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fputc(c, stderr) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {
+    return fwrite(data, 1, length, stderr);
+}
+
+// ============================================================================
+// TIMING
+// ============================================================================
+
+unsigned long millis() {
+    return (unsigned long)(nanosSinceStart() / 1000000ULL);
+}
+
+unsigned long micros() {
+    return (unsigned long)(nanosSinceStart() / 1000ULL);
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    // Busy-wait like the core does (sleeping overshoots short delays)
+    uint64_t end = nanosSinceStart() + (uint64_t)us * 1000ULL;
+    while (nanosSinceStart() < end) {
+    }
+}
+
+void yield() {
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(nanosSinceStart() * getCpuFreqMHz() / 1000ULL);
+}
+
+uint32_t nativeRandom32() {
+    // Per thread: the load generator signs on several threads at once
+    static thread_local std::mt19937 generator(std::random_device{}());
+    return (uint32_t)generator();
+}
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    if (pin < PIN_COUNT) {
+        pinLevels[pin] = level ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return (pin < PIN_COUNT) ? pinLevels[pin] : LOW;
+}
+
+uint8_t digitalPinToInterrupt(uint8_t pin) {
+    return pin;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode) {
+    if (interrupt < PIN_COUNT) {
+        pinHandlers[interrupt] = handler;
+        pinHandlerModes[interrupt] = mode;
+    }
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt < PIN_COUNT) {
+        pinHandlers[interrupt] = nullptr;
+    }
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+void nativeSetPinLevel(uint8_t pin, int level) {
+    if (pin >= PIN_COUNT) {
+        return;
+    }
+
+    int previous = pinLevels[pin];
+    pinLevels[pin] = level ? HIGH : LOW;
+    if (previous == pinLevels[pin] || pinHandlers[pin] == nullptr) {
+        return;
+    }
+
+    int mode = pinHandlerModes[pin];
+    bool rising = pinLevels[pin] == HIGH;
+    if (mode == CHANGE || (mode == RISING && rising) || (mode == FALLING && !rising)) {
+        pinHandlers[pin]();
+    }
+}
@@ -0,0 +1,158 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// ============================================================================
+// NATIVE ARDUINO SHIM
+// ============================================================================
+// Host (x86/Linux) stand-in for the parts of the ESP8266 Arduino core that
+// the firmware modules use:
+// - String (thin wrapper around std::string)
+// - Serial (printed to stderr, so benchmark results on stdout stay clean)
+// - millis()/micros()/delay() backed by the host's monotonic clock
+// - GPIO with pin levels that tests can drive (fires attached interrupts)
+// - ESP (cycle counter at a simulated 80 MHz), RANDOM_REG32 (host RNG)
+// ============================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+
+// newlib provides strlcpy(); older glibc does not
+inline size_t nativeStrlcpy(char* dest, const char* src, size_t size) {
+    size_t length = strlen(src);
+    if (size > 0) {
+        size_t count = (length < size - 1) ? length : size - 1;
+        memcpy(dest, src, count);
+        dest[count] = '\0';
+    }
+    return length;
+}
+#define strlcpy nativeStrlcpy
+
+// Hardware random number generator register
+uint32_t nativeRandom32();
+#define RANDOM_REG32 nativeRandom32()
+
+// ============================================================================
+// STRING AND SERIAL
+// ============================================================================
+
+class String {
+public:
+    String(const char* text = "") : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return (unsigned int)value.size(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* text) { value += text; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+    bool operator==(const char* text) const { return value == text; }
+    char operator[](unsigned int index) const { return index < value.size() ? value[index] : 0; }
+
+private:
+    std::string value;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t length);
+
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t println(const char* text = "");
+    size_t println(const String& text) { return println(text.c_str()); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t printf_P(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t length) override;
+};
+
+extern HardwareSerial Serial;
+
+// ============================================================================
+// TIMING
+// ============================================================================
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+uint8_t digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts();
+void interrupts();
+
+/**
+ * Drive an input pin from a test (calls the attached interrupt on a change)
+ *
+ * @param pin GPIO number
+ * @param level HIGH or LOW
+ */
+void nativeSetPinLevel(uint8_t pin, int level);
+
+// ============================================================================
+// ESP CLASS
+// ============================================================================
+
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 40000; }   // Typical free heap on the device
+    void getHeapStats(uint32_t* free, uint32_t* max, uint8_t* frag) {
+        *free = 40000;
+        *max = 32000;
+        *frag = 12;
+    }
+    uint32_t getFreeContStack() { return 1800; }
+    uint32_t getCycleCount();                  // Host clock scaled to getCpuFreqMHz()
+    uint8_t getCpuFreqMHz() { return 80; }
+    uint32_t getChipId() { return 0x00C3D5; }
+    void restart() { exit(0); }
+};
+
+extern EspClass ESP;
+
+#endif // NATIVE_ARDUINO_H
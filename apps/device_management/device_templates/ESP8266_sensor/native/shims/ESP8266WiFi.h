@@ -0,0 +1,35 @@
+#ifndef NATIVE_ESP8266WIFI_H
+#define NATIVE_ESP8266WIFI_H
+
+// ============================================================================
+// NATIVE WIFI SHIM
+// ============================================================================
+// Only the radio calls made by power.cpp. network.cpp (association, SNTP,
+// RTC cache) is replaced by src/network_native.cpp and never compiled here.
+// ============================================================================
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+enum WiFiSleepType_t {
+    WIFI_NONE_SLEEP = 0,
+    WIFI_LIGHT_SLEEP = 1,
+    WIFI_MODEM_SLEEP = 2
+};
+
+class ESP8266WiFiClass {
+public:
+    bool setSleepMode(WiFiSleepType_t type, uint8_t listenInterval = 0) {
+        sleepType = type;
+        (void)listenInterval;
+        return true;
+    }
+    WiFiSleepType_t getSleepMode() { return sleepType; }
+
+private:
+    WiFiSleepType_t sleepType = WIFI_NONE_SLEEP;
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif // NATIVE_ESP8266WIFI_H
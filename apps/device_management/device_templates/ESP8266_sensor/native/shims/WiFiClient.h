@@ -0,0 +1,49 @@
+#ifndef NATIVE_WIFICLIENT_H
+#define NATIVE_WIFICLIENT_H
+
+// ============================================================================
+// NATIVE HTTP SHIM
+// ============================================================================
+// Loopback TCP client: connect() always succeeds, written bytes are kept
+// for inspection and, once a request has been written, the canned response
+// set with nativeSetResponse() is served back byte by byte.
+// ============================================================================
+
+#include <Arduino.h>
+#include <string>
+
+class WiFiClient {
+public:
+    int connect(const char* host, uint16_t port);
+    uint8_t connected();
+    void stop();
+    void setTimeout(unsigned long timeout) { (void)timeout; }
+    void setNoDelay(bool noDelay) { (void)noDelay; }
+
+    int availableForWrite() { return 1460; }   // One TCP segment, like lwIP
+    size_t write(const uint8_t* data, size_t length);
+    int available();
+    int read();
+
+    /**
+     * Set the response served after the next request
+     * (default: "HTTP/1.1 200 OK" with an empty JSON body)
+     *
+     * @param response Raw HTTP response (status line, headers, body)
+     */
+    static void nativeSetResponse(const char* response);
+
+    /**
+     * Get everything written since the last connect()
+     *
+     * @return Raw request bytes
+     */
+    const std::string& nativeWritten() const { return written; }
+
+private:
+    bool open = false;
+    std::string written;
+    size_t responseOffset = 0;
+};
+
+#endif // NATIVE_WIFICLIENT_H
@@ -0,0 +1,26 @@
+#ifndef NATIVE_BEARSSL_HASH_H
+#define NATIVE_BEARSSL_HASH_H
+
+// ============================================================================
+// NATIVE BEARSSL SHIM
+// ============================================================================
+// The SHA-256 subset of BearSSL used by crypto.cpp (same names and
+// context layout), implemented in shims/sha256.c.
+// ============================================================================
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    unsigned char buf[64];
+    uint64_t count;
+    uint32_t val[8];
+} br_sha256_context;
+
+#define br_sha256_SIZE 32
+
+void br_sha256_init(br_sha256_context* ctx);
+void br_sha256_update(br_sha256_context* ctx, const void* data, size_t len);
+void br_sha256_out(const br_sha256_context* ctx, void* out);
+
+#endif // NATIVE_BEARSSL_HASH_H
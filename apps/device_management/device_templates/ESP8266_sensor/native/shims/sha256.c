@@ -0,0 +1,102 @@
+/*
+ * SHA-256 (FIPS 180-4) behind the BearSSL API used by the firmware
+ */
+
+#include "bearssl/bearssl_hash.h"
+#include <string.h>
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void compress(uint32_t* val, const unsigned char* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | ((uint32_t)block[4 * i + 1] << 16)
+             | ((uint32_t)block[4 * i + 2] << 8) | (uint32_t)block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = val[0], b = val[1], c = val[2], d = val[3];
+    uint32_t e = val[4], f = val[5], g = val[6], h = val[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    val[0] += a; val[1] += b; val[2] += c; val[3] += d;
+    val[4] += e; val[5] += f; val[6] += g; val[7] += h;
+}
+
+void br_sha256_init(br_sha256_context* ctx) {
+    static const uint32_t IV[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->val, IV, sizeof(IV));
+    ctx->count = 0;
+}
+
+void br_sha256_update(br_sha256_context* ctx, const void* data, size_t len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t used = (size_t)(ctx->count & 63);
+    ctx->count += len;
+
+    while (len > 0) {
+        size_t take = 64 - used;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(ctx->buf + used, bytes, take);
+        used += take;
+        bytes += take;
+        len -= take;
+        if (used == 64) {
+            compress(ctx->val, ctx->buf);
+            used = 0;
+        }
+    }
+}
+
+void br_sha256_out(const br_sha256_context* ctx, void* out) {
+    // Pad a copy so the context can keep absorbing data (BearSSL semantics)
+    unsigned char buf[64];
+    uint32_t val[8];
+    size_t used = (size_t)(ctx->count & 63);
+    uint64_t bits = ctx->count << 3;
+
+    memcpy(buf, ctx->buf, used);
+    memcpy(val, ctx->val, sizeof(val));
+    buf[used++] = 0x80;
+    if (used > 56) {
+        memset(buf + used, 0, 64 - used);
+        compress(val, buf);
+        used = 0;
+    }
+    memset(buf + used, 0, 56 - used);
+    for (int i = 0; i < 8; i++) {
+        buf[56 + i] = (unsigned char)(bits >> (56 - 8 * i));
+    }
+    compress(val, buf);
+
+    unsigned char* digest = (unsigned char*)out;
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = (unsigned char)(val[i] >> 24);
+        digest[4 * i + 1] = (unsigned char)(val[i] >> 16);
+        digest[4 * i + 2] = (unsigned char)(val[i] >> 8);
+        digest[4 * i + 3] = (unsigned char)val[i];
+    }
+}
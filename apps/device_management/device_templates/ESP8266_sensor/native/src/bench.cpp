@@ -0,0 +1,288 @@
+// ============================================================================
+// NATIVE MICRO-BENCHMARKS
+// ============================================================================
+// Times the firmware hot paths on the host:
+// - base64Encode() of a maximum-length DER signature
+// - encodeSignatureToDER()
+// - signMessage() with a full uECC_sign() and with a precomputed nonce
+// - createMessagePayload() for a heartbeat and an alert
+//
+// Usage: bench [--output FILE] [--baseline FILE] [--tolerance PERCENT]
+//   --output     Write the results (one "name ns_per_op" line each)
+//   --baseline   Compare against a file written by --output; exit 1 if a
+//                benchmark got slower by more than the tolerance (default 25%)
+//
+// Host numbers are not device numbers - compare runs on the same machine.
+// ============================================================================
+
+#include <Arduino.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "crypto.h"
+#include "messaging.h"
+#include "native_access.h"
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static const double MIN_RUN_SECONDS = 0.2;       // Per benchmark, after warm-up
+static const double DEFAULT_TOLERANCE_PERCENT = 25.0;
+
+static const char BENCH_MESSAGE[] =
+    "{\"device_id\":\"bench\",\"message_type\":\"alert\",\"data\":{\"distance_cm\":42.5}}";
+
+/**
+ * One benchmark
+ * setup() (optional) runs before every operation and is not timed.
+ * run() returns false if the operation failed.
+ */
+struct Benchmark {
+    const char* name;
+    void (*setup)();
+    bool (*run)();
+};
+
+struct Result {
+    std::string name;
+    double nsPerOp;
+    unsigned long iterations;
+};
+
+static uint8_t rawSignature[64];
+static uint8_t derSignature[72];
+static char signatureText[SIGNATURE_BUFFER_SIZE];
+
+// ============================================================================
+// BENCHMARKS
+// ============================================================================
+
+static bool runBase64() {
+    return base64Encode(derSignature, sizeof(derSignature), signatureText, sizeof(signatureText)) > 0;
+}
+
+static bool runDER() {
+    return nativeEncodeSignatureToDER(rawSignature, derSignature) > 0;
+}
+
+static bool runSignCold() {
+    return signMessage(BENCH_MESSAGE, sizeof(BENCH_MESSAGE) - 1, signatureText, sizeof(signatureText));
+}
+
+static void setupSignWarm() {
+    precomputeSigningNonce();
+}
+
+static bool runSignWarm() {
+    return signMessage(BENCH_MESSAGE, sizeof(BENCH_MESSAGE) - 1, signatureText, sizeof(signatureText));
+}
+
+static bool runHeartbeatPayload() {
+    return nativeCreateMessagePayload(HEARTBEAT) > 0;
+}
+
+static bool runAlertPayload() {
+    return nativeCreateMessagePayload(ALERT) > 0;
+}
+
+// Cold signing runs first: it must not find precomputed nonces in the pool
+static const Benchmark BENCHMARKS[] = {
+    {"base64_encode_72B", nullptr, runBase64},
+    {"encode_signature_der", nullptr, runDER},
+    {"sign_message_full", nullptr, runSignCold},
+    {"sign_message_precomputed", setupSignWarm, runSignWarm},
+    {"create_payload_heartbeat", nullptr, runHeartbeatPayload},
+    {"create_payload_alert", nullptr, runAlertPayload},
+};
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Run one benchmark until MIN_RUN_SECONDS of timed operations are collected
+ *
+ * @param benchmark Benchmark to run
+ * @param result Output: time per operation
+ * @return true on success, false if an operation failed
+ */
+static bool runBenchmark(const Benchmark& benchmark, Result& result) {
+    result.name = benchmark.name;
+    result.nsPerOp = 0;
+    result.iterations = 0;
+
+    // Warm-up (caches, lazy initialization)
+    for (int i = 0; i < 3; i++) {
+        if (benchmark.setup) {
+            benchmark.setup();
+        }
+        if (!benchmark.run()) {
+            return false;
+        }
+    }
+
+    double timedSeconds = 0;
+    unsigned long batch = 1;
+    while (timedSeconds < MIN_RUN_SECONDS) {
+        if (benchmark.setup) {
+            // Untimed setup: time each operation on its own
+            benchmark.setup();
+            auto start = std::chrono::steady_clock::now();
+            bool ok = benchmark.run();
+            timedSeconds += secondsSince(start);
+            result.iterations++;
+            if (!ok) {
+                return false;
+            }
+            continue;
+        }
+
+        // Fast operations: time whole batches, doubling until long enough
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long i = 0; i < batch; i++) {
+            if (!benchmark.run()) {
+                return false;
+            }
+        }
+        timedSeconds += secondsSince(start);
+        result.iterations += batch;
+        if (batch < (1UL << 20)) {
+            batch *= 2;
+        }
+    }
+
+    result.nsPerOp = timedSeconds * 1e9 / result.iterations;
+    return true;
+}
+
+/**
+ * Read a results file written with --output
+ *
+ * @param path File path
+ * @param baseline Output: ns/op by benchmark name
+ * @return true if the file was read, false otherwise
+ */
+static bool readResults(const char* path, std::map<std::string, double>& baseline) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return false;
+    }
+
+    char name[64];
+    double nsPerOp;
+    while (fscanf(file, "%63s %lf", name, &nsPerOp) == 2) {
+        baseline[name] = nsPerOp;
+    }
+    fclose(file);
+    return true;
+}
+
+static bool writeResults(const char* path, const std::vector<Result>& results) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    for (const Result& result : results) {
+        fprintf(file, "%s %.1f\n", result.name.c_str(), result.nsPerOp);
+    }
+    fclose(file);
+    return true;
+}
+
+static void printUsage() {
+    fprintf(stderr, "Usage: bench [--output FILE] [--baseline FILE] [--tolerance PERCENT]\n");
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char** argv) {
+    const char* outputPath = nullptr;
+    const char* baselinePath = nullptr;
+    double tolerancePercent = DEFAULT_TOLERANCE_PERCENT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerancePercent = atof(argv[++i]);
+        } else {
+            printUsage();
+            return 2;
+        }
+    }
+
+    if (!initializeCrypto() || !initializeMessaging()) {
+        fprintf(stderr, "bench: firmware initialization failed\n");
+        return 2;
+    }
+
+    // Checks the precomputed-nonce signature against uECC_verify()
+    if (!benchmarkSigning()) {
+        fprintf(stderr, "bench: signing self-test failed\n");
+        return 2;
+    }
+
+    // Encoder input: high bits set in r and s give the longest DER encoding
+    for (size_t i = 0; i < sizeof(rawSignature); i++) {
+        rawSignature[i] = (uint8_t)(0x80 | (i * 37));
+    }
+    nativeEncodeSignatureToDER(rawSignature, derSignature);
+
+    std::vector<Result> results;
+    printf("%-28s %14s %12s\n", "benchmark", "ns/op", "iterations");
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        Result result;
+        if (!runBenchmark(benchmark, result)) {
+            fprintf(stderr, "bench: %s failed\n", benchmark.name);
+            return 2;
+        }
+        printf("%-28s %14.1f %12lu\n", result.name.c_str(), result.nsPerOp, result.iterations);
+        results.push_back(result);
+    }
+
+    if (outputPath != nullptr && !writeResults(outputPath, results)) {
+        fprintf(stderr, "bench: cannot write %s\n", outputPath);
+        return 2;
+    }
+
+    if (baselinePath == nullptr) {
+        return 0;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!readResults(baselinePath, baseline)) {
+        fprintf(stderr, "bench: cannot read baseline %s\n", baselinePath);
+        return 2;
+    }
+
+    int regressions = 0;
+    printf("\nCompared with %s (tolerance %.0f%%):\n", baselinePath, tolerancePercent);
+    for (const Result& result : results) {
+        auto entry = baseline.find(result.name);
+        if (entry == baseline.end() || entry->second <= 0) {
+            printf("%-28s %14s\n", result.name.c_str(), "new");
+            continue;
+        }
+
+        double changePercent = (result.nsPerOp / entry->second - 1.0) * 100.0;
+        bool regressed = changePercent > tolerancePercent;
+        printf("%-28s %+13.1f%% %s\n", result.name.c_str(), changePercent, regressed ? "REGRESSION" : "ok");
+        if (regressed) {
+            regressions++;
+        }
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
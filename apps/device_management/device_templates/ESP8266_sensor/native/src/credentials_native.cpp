@@ -0,0 +1,44 @@
+#include "config.h"
+#include "credentials.h"
+#include "native_access.h"
+
+// ============================================================================
+// NATIVE CREDENTIALS MODULE
+// ============================================================================
+// Stand-in for credentials.cpp on the host: there is no credentials sector,
+// the values come straight from config.h.
+//
+// The credentials are per thread: the benchmark uses the config.h device,
+// the load generator switches device ID and key to sign as many devices.
+// ============================================================================
+
+struct NativeCredentials {
+    DeviceCredentials credentials;
+
+    NativeCredentials() {
+        memset(&credentials, 0, sizeof(credentials));
+        strlcpy(credentials.deviceId, DEVICE_ID, sizeof(credentials.deviceId));
+        strlcpy(credentials.wifiSsid, WIFI_SSID, sizeof(credentials.wifiSsid));
+        strlcpy(credentials.wifiPassword, WIFI_PASSWORD, sizeof(credentials.wifiPassword));
+        strlcpy(credentials.certificateB64, DEVICE_CERTIFICATE_B64, sizeof(credentials.certificateB64));
+        memcpy(credentials.privateKey, ECDSA_PRIVATE_KEY, sizeof(credentials.privateKey));
+    }
+};
+
+static thread_local NativeCredentials threadCredentials;
+
+bool initializeCredentials() {
+    return true;
+}
+
+const DeviceCredentials& getCredentials() {
+    return threadCredentials.credentials;
+}
+
+void nativeSetSigningKey(const uint8_t* key) {
+    memcpy(threadCredentials.credentials.privateKey, key, sizeof(threadCredentials.credentials.privateKey));
+}
+
+void nativeSetDeviceId(const char* deviceId) {
+    strlcpy(threadCredentials.credentials.deviceId, deviceId, sizeof(threadCredentials.credentials.deviceId));
+}
@@ -0,0 +1,17 @@
+// ============================================================================
+// CRYPTO MODULE (NATIVE BUILD)
+// ============================================================================
+// Compiles crypto.cpp unchanged and exposes its file-local helpers to the
+// benchmarks. Build this file instead of crypto.cpp.
+//
+// The signing key is per thread (see src/credentials_native.cpp).
+// ============================================================================
+
+#include "config.h"
+#include "native_access.h"
+
+#include "crypto.cpp"
+
+size_t nativeEncodeSignatureToDER(const uint8_t* rawSignature, uint8_t* derSignature) {
+    return encodeSignatureToDER(rawSignature, derSignature);
+}
@@ -0,0 +1,606 @@
+// ============================================================================
+// FLEET LOAD GENERATOR
+// ============================================================================
+// Simulates many devices against /api/device/message/ with the firmware's
+// own payload and signing code (createMessagePayload(), signOutboundMessage()):
+// - One device per fleet file line (manage.py create_load_test_devices)
+// - One persistent HTTP/1.1 connection per device, reopened when the server
+//   closes it
+// - Certificate on first contact, X-Device-Session afterwards (as the firmware)
+// - Configurable heartbeat/alert mix and send interval
+//
+// Usage: loadgen --fleet FILE [options]
+//   --host HOST          Server host (default 127.0.0.1)
+//   --port PORT          Server port (default 8000)
+//   --path PATH          Message endpoint (default /api/device/message/)
+//   --devices N          Use the first N devices of the fleet (default: all)
+//   --threads N          Worker threads (default 8), devices are split evenly
+//   --duration SECONDS   Test duration (default 30)
+//   --interval SECONDS   Per-device send interval, 0 = back-to-back (default 0)
+//   --alert-ratio R      Share of alerts among messages, 0-1 (default 0.1)
+//   --no-session         Send the certificate with every request
+//
+// Each thread serves its devices one request at a time, so at most
+// --threads requests are in flight.
+// ============================================================================
+
+#include <Arduino.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "config.h"
+#include "crypto.h"
+#include "messaging.h"
+#include "native_access.h"
+
+// ============================================================================
+// INTERNAL STATE VARIABLES
+// ============================================================================
+
+static const unsigned long SOCKET_TIMEOUT_SECONDS = 10;
+static const size_t RESPONSE_BUFFER_SIZE = 4096;
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Command line options
+ */
+struct Options {
+    std::string host = "127.0.0.1";
+    std::string port = "8000";
+    std::string path = "/api/device/message/";
+    std::string fleetPath;
+    size_t devices = 0;            // 0 = whole fleet
+    unsigned threads = 8;
+    double durationSeconds = 30;
+    double intervalSeconds = 0;
+    double alertRatio = 0.1;
+    bool useSession = true;
+};
+
+/**
+ * One simulated device
+ */
+struct SimulatedDevice {
+    std::string id;
+    uint8_t key[32];
+    std::string certificateB64;
+    std::string sessionId;
+    int socket = -1;
+    Clock::time_point nextSend;
+};
+
+/**
+ * Counters of one worker thread (merged at the end)
+ */
+struct WorkerStats {
+    unsigned long requests = 0;
+    unsigned long heartbeats = 0;
+    unsigned long alerts = 0;
+    unsigned long errors = 0;           // No (complete) response
+    unsigned long connects = 0;
+    unsigned long connectFailures = 0;
+    unsigned long sessionFallbacks = 0; // 401 session_expired → certificate again
+    unsigned long signFailures = 0;
+    double signSeconds = 0;
+    double lagSeconds = 0;              // How far behind --interval sends started
+    std::map<int, unsigned long> statusCodes;
+    std::vector<uint32_t> latencyMicros;
+};
+
+static Options options;
+static struct addrinfo* serverAddress = nullptr;
+static std::atomic<bool> stopRequested(false);
+
+// ============================================================================
+// INTERNAL HELPER FUNCTIONS
+// ============================================================================
+
+static void onSignal(int) {
+    stopRequested = true;
+}
+
+static double secondsBetween(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+static bool parseHexKey(const std::string& hex, uint8_t* key) {
+    if (hex.size() != 64) {
+        return false;
+    }
+    for (size_t i = 0; i < 32; i++) {
+        char byte[3] = {hex[2 * i], hex[2 * i + 1], 0};
+        char* end = nullptr;
+        key[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (end != byte + 2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Read the fleet file ("device_id private_key_hex certificate_b64" lines,
+ * '#' starts a comment)
+ *
+ * @param path Fleet file path
+ * @param fleet Output: devices
+ * @return true if at least one device was read, false otherwise
+ */
+static bool readFleet(const std::string& path, std::vector<SimulatedDevice>& fleet) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        fprintf(stderr, "loadgen: cannot open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    std::string line;
+    unsigned long lineNumber = 0;
+    int c;
+    do {
+        c = fgetc(file);
+        if (c != '\n' && c != EOF) {
+            line += (char)c;
+            continue;
+        }
+        lineNumber++;
+
+        char id[64];
+        char keyHex[80];
+        std::vector<char> certificate(line.size() + 1);
+        if (!line.empty() && line[0] != '#') {
+            SimulatedDevice device;
+            if (sscanf(line.c_str(), "%63s %79s %s", id, keyHex, certificate.data()) != 3 ||
+                !parseHexKey(keyHex, device.key)) {
+                fprintf(stderr, "loadgen: %s:%lu: invalid fleet line\n", path.c_str(), lineNumber);
+                fclose(file);
+                return false;
+            }
+            device.id = id;
+            device.certificateB64 = certificate.data();
+            fleet.push_back(device);
+        }
+        line.clear();
+    } while (c != EOF);
+
+    fclose(file);
+    if (fleet.empty()) {
+        fprintf(stderr, "loadgen: no devices in %s\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void closeDeviceSocket(SimulatedDevice& device) {
+    if (device.socket >= 0) {
+        close(device.socket);
+        device.socket = -1;
+    }
+}
+
+static bool openDeviceSocket(SimulatedDevice& device, WorkerStats& stats) {
+    int fd = socket(serverAddress->ai_family, serverAddress->ai_socktype, serverAddress->ai_protocol);
+    if (fd < 0) {
+        stats.connectFailures++;
+        return false;
+    }
+
+    struct timeval timeout = {(time_t)SOCKET_TIMEOUT_SECONDS, 0};
+    int noDelay = 1;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    if (connect(fd, serverAddress->ai_addr, serverAddress->ai_addrlen) != 0) {
+        close(fd);
+        stats.connectFailures++;
+        return false;
+    }
+
+    device.socket = fd;
+    stats.connects++;
+    return true;
+}
+
+static bool sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
+
+/**
+ * Get a header value from a response head (case-insensitive name)
+ */
+static std::string findHeader(const std::string& head, const char* name) {
+    size_t nameLength = strlen(name);
+    size_t lineStart = head.find("\r\n");
+    while (lineStart != std::string::npos && lineStart + 2 < head.size()) {
+        lineStart += 2;
+        size_t lineEnd = head.find("\r\n", lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = head.size();
+        }
+        if (lineEnd - lineStart > nameLength && head[lineStart + nameLength] == ':' &&
+            strncasecmp(head.c_str() + lineStart, name, nameLength) == 0) {
+            size_t valueStart = head.find_first_not_of(' ', lineStart + nameLength + 1);
+            return (valueStart < lineEnd) ? head.substr(valueStart, lineEnd - valueStart) : "";
+        }
+        lineStart = lineEnd;
+    }
+    return "";
+}
+
+/**
+ * Get a string field from a flat JSON response body
+ */
+static std::string findJsonString(const std::string& body, const char* field) {
+    std::string key = std::string("\"") + field + "\"";
+    size_t position = body.find(key);
+    if (position == std::string::npos) {
+        return "";
+    }
+    position = body.find_first_not_of(" :", position + key.size());
+    if (position == std::string::npos || body[position] != '"') {
+        return "";
+    }
+    size_t end = body.find('"', position + 1);
+    return (end == std::string::npos) ? "" : body.substr(position + 1, end - position - 1);
+}
+
+/**
+ * Read one HTTP response
+ *
+ * @param fd Socket
+ * @param statusCode Output: HTTP status
+ * @param body Output: response body
+ * @param keepAlive Output: false if the server closes the connection
+ * @param receivedAny Output: true if any byte arrived (false = stale socket)
+ * @return true if a complete response was read, false otherwise
+ */
+static bool readResponse(int fd, int& statusCode, std::string& body, bool& keepAlive, bool& receivedAny) {
+    std::string data;
+    char buffer[RESPONSE_BUFFER_SIZE];
+    size_t headEnd = std::string::npos;
+    long contentLength = -1;
+    receivedAny = false;
+
+    while (true) {
+        if (headEnd != std::string::npos && contentLength >= 0 &&
+            data.size() >= headEnd + 4 + (size_t)contentLength) {
+            break;
+        }
+
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0) {
+            return false;
+        }
+        if (received == 0) {
+            // Without Content-Length the body ends when the server closes
+            if (headEnd != std::string::npos && contentLength < 0) {
+                keepAlive = false;
+                break;
+            }
+            return false;
+        }
+        receivedAny = true;
+        data.append(buffer, (size_t)received);
+
+        if (headEnd == std::string::npos) {
+            headEnd = data.find("\r\n\r\n");
+            if (headEnd != std::string::npos) {
+                std::string head = data.substr(0, headEnd);
+                if (sscanf(head.c_str(), "HTTP/%*s %d", &statusCode) != 1) {
+                    return false;
+                }
+                std::string length = findHeader(head, "Content-Length");
+                contentLength = length.empty() ? -1 : atol(length.c_str());
+                std::string connection = findHeader(head, "Connection");
+                keepAlive = strncasecmp(head.c_str(), "HTTP/1.0", 8) != 0
+                    ? strcasecmp(connection.c_str(), "close") != 0
+                    : strcasecmp(connection.c_str(), "keep-alive") == 0;
+            }
+        }
+    }
+
+    body = data.substr(headEnd + 4, contentLength >= 0 ? (size_t)contentLength : std::string::npos);
+    return true;
+}
+
+/**
+ * Build, sign and send one message as a device, and wait for the answer
+ */
+static void sendMessage(SimulatedDevice& device, std::mt19937& random, WorkerStats& stats) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    bool alert = unit(random) < options.alertRatio;
+
+    // Same steps as the firmware before a send
+    nativeSetSigningKey(device.key);
+    nativeSetDeviceId(device.id.c_str());
+    NativeSignedMessage message;
+    Clock::time_point signStart = Clock::now();
+    bool built = alert
+        ? nativeBuildSignedMessage(ALERT, (uint16_t)(50 + 200 * unit(random)), 1 + random() % 60, message)
+        : nativeBuildSignedMessage(HEARTBEAT, 0, 0, message);
+    stats.signSeconds += secondsBetween(signStart, Clock::now());
+    if (!built) {
+        stats.signFailures++;
+        return;
+    }
+
+    bool withSession = options.useSession && !device.sessionId.empty();
+    std::string request = "POST " + options.path + " HTTP/1.1\r\n"
+        "Host: " + options.host + ":" + options.port + "\r\n"
+        "Connection: keep-alive\r\n"
+        "Content-Type: " + nativeMessageContentType() + "\r\n"
+        "Content-Length: " + std::to_string(message.payloadLength) + "\r\n" +
+        (withSession ? "X-Device-Session: " + device.sessionId
+                     : "X-Device-Certificate: " + device.certificateB64) + "\r\n"
+        "X-Device-Signature: " + message.signature + "\r\n\r\n";
+    request.append(message.payload, message.payloadLength);
+
+    // A reused socket may have been closed by the server meanwhile - retry
+    // once on a new connection if nothing came back (like the firmware)
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = device.socket >= 0;
+        if (!reused && !openDeviceSocket(device, stats)) {
+            stats.errors++;
+            return;
+        }
+
+        Clock::time_point start = Clock::now();
+        int statusCode = 0;
+        std::string body;
+        bool keepAlive = true;
+        bool receivedAny = false;
+        bool ok = sendAll(device.socket, request.data(), request.size()) &&
+                  readResponse(device.socket, statusCode, body, keepAlive, receivedAny);
+
+        if (!ok) {
+            closeDeviceSocket(device);
+            if (reused && !receivedAny) {
+                continue;
+            }
+            stats.errors++;
+            return;
+        }
+
+        stats.latencyMicros.push_back((uint32_t)(secondsBetween(start, Clock::now()) * 1e6));
+        stats.requests++;
+        stats.statusCodes[statusCode]++;
+        (alert ? stats.alerts : stats.heartbeats)++;
+
+        std::string sessionId = findJsonString(body, "session_id");
+        if (!sessionId.empty()) {
+            device.sessionId = sessionId;
+        } else if (statusCode == 401 && body.find("session_expired") != std::string::npos) {
+            device.sessionId.clear();
+            stats.sessionFallbacks++;
+        }
+
+        if (!keepAlive) {
+            closeDeviceSocket(device);
+        }
+        return;
+    }
+    stats.errors++;
+}
+
+/**
+ * Worker thread: serve the devices [first, last) until the test ends
+ */
+static void runWorker(std::vector<SimulatedDevice>* fleet, size_t first, size_t last,
+                      Clock::time_point end, unsigned seed, WorkerStats* stats) {
+    std::mt19937 random(seed);
+
+    // Spread the first sends over one interval (devices do not boot together)
+    Clock::time_point now = Clock::now();
+    std::uniform_real_distribution<double> phase(0.0, options.intervalSeconds);
+    for (size_t i = first; i < last; i++) {
+        (*fleet)[i].nextSend = now + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(phase(random)));
+    }
+
+    while (!stopRequested && Clock::now() < end) {
+        // Device due first
+        size_t due = first;
+        for (size_t i = first + 1; i < last; i++) {
+            if ((*fleet)[i].nextSend < (*fleet)[due].nextSend) {
+                due = i;
+            }
+        }
+
+        SimulatedDevice& device = (*fleet)[due];
+        now = Clock::now();
+        if (device.nextSend > now) {
+            std::this_thread::sleep_until(std::min(device.nextSend, end));
+            continue;
+        }
+        stats->lagSeconds += secondsBetween(device.nextSend, now);
+
+        sendMessage(device, random, *stats);
+        device.nextSend = (options.intervalSeconds > 0)
+            ? device.nextSend + std::chrono::duration_cast<Clock::duration>(
+                  std::chrono::duration<double>(options.intervalSeconds))
+            : Clock::now();
+    }
+
+    for (size_t i = first; i < last; i++) {
+        closeDeviceSocket((*fleet)[i]);
+    }
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void printUsage() {
+    fprintf(stderr,
+            "Usage: loadgen --fleet FILE [--host HOST] [--port PORT] [--path PATH]\n"
+            "               [--devices N] [--threads N] [--duration SECONDS]\n"
+            "               [--interval SECONDS] [--alert-ratio R] [--no-session]\n");
+}
+
+static bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--no-session") {
+            options.useSession = false;
+        } else if (option == "--fleet" && hasValue) {
+            options.fleetPath = argv[++i];
+        } else if (option == "--host" && hasValue) {
+            options.host = argv[++i];
+        } else if (option == "--port" && hasValue) {
+            options.port = argv[++i];
+        } else if (option == "--path" && hasValue) {
+            options.path = argv[++i];
+        } else if (option == "--devices" && hasValue) {
+            options.devices = strtoul(argv[++i], nullptr, 10);
+        } else if (option == "--threads" && hasValue) {
+            options.threads = (unsigned)strtoul(argv[++i], nullptr, 10);
+        } else if (option == "--duration" && hasValue) {
+            options.durationSeconds = atof(argv[++i]);
+        } else if (option == "--interval" && hasValue) {
+            options.intervalSeconds = atof(argv[++i]);
+        } else if (option == "--alert-ratio" && hasValue) {
+            options.alertRatio = atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+
+    return !options.fleetPath.empty() && options.threads > 0 && options.durationSeconds > 0 &&
+           options.intervalSeconds >= 0 && options.alertRatio >= 0 && options.alertRatio <= 1;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<SimulatedDevice> fleet;
+    if (!readFleet(options.fleetPath, fleet)) {
+        return 2;
+    }
+    if (options.devices > 0 && options.devices < fleet.size()) {
+        fleet.resize(options.devices);
+    }
+    if (options.threads > fleet.size()) {
+        options.threads = (unsigned)fleet.size();
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int lookup = getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &serverAddress);
+    if (lookup != 0) {
+        fprintf(stderr, "loadgen: cannot resolve %s: %s\n", options.host.c_str(), gai_strerror(lookup));
+        return 2;
+    }
+
+    if (!initializeCrypto()) {
+        fprintf(stderr, "loadgen: crypto initialization failed\n");
+        return 2;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    printf("Load test: %zu devices, %u threads, %.0f s, interval %.1f s, %.0f%% alerts, %s\n",
+           fleet.size(), options.threads, options.durationSeconds, options.intervalSeconds,
+           options.alertRatio * 100, options.useSession ? "sessions" : "certificate every request");
+    printf("Target: http://%s:%s%s (%s)\n", options.host.c_str(), options.port.c_str(),
+           options.path.c_str(), nativeMessageContentType());
+
+    std::vector<WorkerStats> stats(options.threads);
+    std::vector<std::thread> workers;
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.durationSeconds));
+    std::random_device seedSource;
+
+    for (unsigned t = 0; t < options.threads; t++) {
+        size_t first = fleet.size() * t / options.threads;
+        size_t last = fleet.size() * (t + 1) / options.threads;
+        workers.emplace_back(runWorker, &fleet, first, last, end, seedSource(), &stats[t]);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double elapsed = secondsBetween(start, Clock::now());
+    freeaddrinfo(serverAddress);
+
+    // Merge
+    WorkerStats total;
+    for (const WorkerStats& s : stats) {
+        total.requests += s.requests;
+        total.heartbeats += s.heartbeats;
+        total.alerts += s.alerts;
+        total.errors += s.errors;
+        total.connects += s.connects;
+        total.connectFailures += s.connectFailures;
+        total.sessionFallbacks += s.sessionFallbacks;
+        total.signFailures += s.signFailures;
+        total.signSeconds += s.signSeconds;
+        total.lagSeconds += s.lagSeconds;
+        for (const auto& entry : s.statusCodes) {
+            total.statusCodes[entry.first] += entry.second;
+        }
+        total.latencyMicros.insert(total.latencyMicros.end(), s.latencyMicros.begin(), s.latencyMicros.end());
+    }
+    std::sort(total.latencyMicros.begin(), total.latencyMicros.end());
+
+    unsigned long attempts = total.requests + total.errors + total.signFailures;
+    printf("\nResponses:   %lu in %.1f s (%lu heartbeats, %lu alerts)\n",
+           total.requests, elapsed, total.heartbeats, total.alerts);
+    printf("Throughput:  %.1f responses/s\n", total.requests / elapsed);
+    printf("Status:     ");
+    for (const auto& entry : total.statusCodes) {
+        printf(" %d=%lu", entry.first, entry.second);
+    }
+    printf("\nErrors:      %lu without response, %lu connect failures, %lu signing failures\n",
+           total.errors, total.connectFailures, total.signFailures);
+    printf("Connections: %lu opened, %lu session fallbacks\n", total.connects, total.sessionFallbacks);
+    printf("Latency ms:  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+           percentile(total.latencyMicros, 0.50) / 1000.0, percentile(total.latencyMicros, 0.90) / 1000.0,
+           percentile(total.latencyMicros, 0.99) / 1000.0,
+           total.latencyMicros.empty() ? 0.0 : total.latencyMicros.back() / 1000.0);
+    if (attempts > 0) {
+        printf("Client:      %.0f us build+sign per message", total.signSeconds * 1e6 / attempts);
+        if (options.intervalSeconds > 0) {
+            printf(", %.1f ms average send lag", total.lagSeconds * 1e3 / attempts);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
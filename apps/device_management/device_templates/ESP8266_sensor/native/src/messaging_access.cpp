@@ -0,0 +1,55 @@
+// ============================================================================
+// MESSAGING MODULE (NATIVE BUILD)
+// ============================================================================
+// Compiles messaging.cpp unchanged and exposes its file-local helpers to
+// the benchmarks. Build this file instead of messaging.cpp.
+//
+// Like the signing key, the device ID written into payloads is per thread
+// (see src/credentials_native.cpp).
+// ============================================================================
+
+#include <mutex>
+#include "config.h"
+#include "native_access.h"
+
+#include "messaging.cpp"
+
+static OutboundMessage nativeMessage;
+
+// Payload creation reads (and closes) the power and profiling windows
+static std::mutex payloadMutex;
+
+size_t nativeCreateMessagePayload(MessageType type) {
+    return createMessagePayload(&nativeMessage, type, 425, 12, "2026-01-01T00:00:00Z");
+}
+
+const char* nativeLastPayload() {
+    return nativeMessage.payload;
+}
+
+const char* nativeMessageContentType() {
+    return MESSAGE_CONTENT_TYPE;
+}
+
+bool nativeBuildSignedMessage(MessageType type, uint16_t distanceMm, unsigned long durationSeconds,
+                              NativeSignedMessage& out) {
+    static thread_local OutboundMessage message;
+
+    char firstDetectedTimestamp[TIMESTAMP_BUFFER_SIZE];
+    getCurrentTimestamp(firstDetectedTimestamp, sizeof(firstDetectedTimestamp));
+
+    {
+        std::lock_guard<std::mutex> lock(payloadMutex);
+        createMessagePayload(&message, type, distanceMm, durationSeconds, firstDetectedTimestamp);
+    }
+
+    // Signing only touches the caller's key and the stack - runs in parallel
+    if (!signOutboundMessage(&message)) {
+        return false;
+    }
+
+    memcpy(out.payload, message.payload, message.payloadLength);
+    out.payloadLength = message.payloadLength;
+    strlcpy(out.signature, message.signature, sizeof(out.signature));
+    return true;
+}
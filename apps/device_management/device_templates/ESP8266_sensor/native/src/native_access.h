@@ -0,0 +1,87 @@
+#ifndef NATIVE_ACCESS_H
+#define NATIVE_ACCESS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "messaging.h"
+
+// ============================================================================
+// NATIVE ACCESS
+// ============================================================================
+// Entry points into static (file-local) firmware functions, defined by the
+// *_access.cpp files that compile the firmware sources on the host.
+// ============================================================================
+
+/**
+ * A signed message ready to be sent
+ */
+struct NativeSignedMessage {
+    char payload[MESSAGE_PAYLOAD_BUFFER_SIZE];
+    size_t payloadLength;
+    char signature[SIGNATURE_BUFFER_SIZE];   // Base64 DER signature
+};
+
+/**
+ * encodeSignatureToDER() from crypto.cpp
+ *
+ * @param rawSignature Raw signature r || s (64 bytes)
+ * @param derSignature Output buffer (72 bytes)
+ * @return Length of the DER signature
+ */
+size_t nativeEncodeSignatureToDER(const uint8_t* rawSignature, uint8_t* derSignature);
+
+/**
+ * Set the private key the calling thread signs with
+ * (default: ECDSA_PRIVATE_KEY from config.h)
+ *
+ * @param key P-256 private key (32 bytes, big-endian)
+ */
+void nativeSetSigningKey(const uint8_t* key);
+
+/**
+ * Set the device ID the calling thread writes into payloads
+ * (default: DEVICE_ID from config.h)
+ *
+ * @param deviceId Device ID string (copied, at most 36 characters)
+ */
+void nativeSetDeviceId(const char* deviceId);
+
+/**
+ * createMessagePayload() from messaging.cpp, into an internal message
+ * (alerts use a fixed distance, duration and first-detection timestamp)
+ * Not thread-safe - benchmark use only.
+ *
+ * @param type HEARTBEAT or ALERT
+ * @return Payload length, or 0 if it did not fit
+ */
+size_t nativeCreateMessagePayload(MessageType type);
+
+/**
+ * Get the payload written by the last nativeCreateMessagePayload()
+ *
+ * @return Payload (null-terminated for JSON)
+ */
+const char* nativeLastPayload();
+
+/**
+ * Build and sign a message the way the firmware does before sending it
+ * (createMessagePayload() + signOutboundMessage()), as the calling
+ * thread's device. Thread-safe.
+ *
+ * @param type HEARTBEAT or ALERT
+ * @param distanceMm Distance in mm (only for ALERT type)
+ * @param durationSeconds Detection duration (only for ALERT type)
+ * @param out Output: payload and signature
+ * @return true on success, false if the payload could not be built or signed
+ */
+bool nativeBuildSignedMessage(MessageType type, uint16_t distanceMm, unsigned long durationSeconds,
+                              NativeSignedMessage& out);
+
+/**
+ * Get the Content-Type of the configured wire format
+ *
+ * @return "application/json" or "application/cbor"
+ */
+const char* nativeMessageContentType();
+
+#endif // NATIVE_ACCESS_H
@@ -0,0 +1,62 @@
+#include "config.h"
+#include "network.h"
+
+// ============================================================================
+// NATIVE NETWORK MODULE
+// ============================================================================
+// Stand-in for network.cpp on the host: WiFi is always associated and the
+// clock is synchronized to a fixed time, so payloads are reproducible.
+// ============================================================================
+
+static const unsigned long NATIVE_EPOCH_SECONDS = 1767225600UL;  // 2026-01-01T00:00:00Z
+static const char* NATIVE_TIMESTAMP = "2026-01-01T00:00:00Z";
+
+bool initializeWiFi() {
+    return true;
+}
+
+bool isWiFiConnected() {
+    return true;
+}
+
+bool isWiFiConnecting() {
+    return false;
+}
+
+bool reconnectWiFi() {
+    return true;
+}
+
+bool initializeTime() {
+    return true;
+}
+
+void serviceTime() {
+}
+
+bool isTimeInitialized() {
+    return true;
+}
+
+bool isTimeSynced() {
+    return true;
+}
+
+void getCurrentTimestamp(char* buffer, size_t bufferSize) {
+    snprintf(buffer, bufferSize, "%s", NATIVE_TIMESTAMP);
+}
+
+unsigned long getCurrentEpochSeconds() {
+    return NATIVE_EPOCH_SECONDS;
+}
+
+int getWiFiRSSI() {
+    return -60;
+}
+
+unsigned long getUptimeSeconds() {
+    return millis() / 1000;
+}
+
+void printNetworkDiagnostics() {
+}
@@ -0,0 +1,37 @@
+#include "config.h"
+#include "profiling.h"
+
+// ============================================================================
+// PROFILING MODULE (DISABLED)
+// ============================================================================
+// Replaces profiling.cpp in the load generator: its histograms are shared
+// state, and many threads signing at once would race on them. Behaves like
+// PROFILING_ENABLED 0 (heartbeats carry no performance object).
+// ============================================================================
+
+void profileEnd(ProfilePoint point, uint32_t startCycles) {
+    (void)point;
+    (void)startCycles;
+}
+
+void profileRecordCycles(ProfilePoint point, uint32_t cycles) {
+    (void)point;
+    (void)cycles;
+}
+
+bool getProfileSummary(ProfilePoint point, ProfileSummary& summary) {
+    (void)point;
+    memset(&summary, 0, sizeof(summary));
+    return false;
+}
+
+const char* getProfilePointName(ProfilePoint point) {
+    (void)point;
+    return "unknown";
+}
+
+void closeProfileWindow() {
+}
+
+void confirmProfileReport() {
+}
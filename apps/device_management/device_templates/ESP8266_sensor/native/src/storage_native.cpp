@@ -0,0 +1,50 @@
+#include "config.h"
+#include "storage.h"
+
+// ============================================================================
+// NATIVE STORAGE MODULE
+// ============================================================================
+// Stand-in for storage.cpp on the host: there is no flash, so the offline
+// store is always empty and refuses new messages.
+// ============================================================================
+
+bool initializeOfflineStore() {
+    return false;
+}
+
+bool isOfflineStoreReady() {
+    return false;
+}
+
+bool storeOfflineMessage(const char* payload, size_t payloadLength, const char* signature) {
+    (void)payload;
+    (void)payloadLength;
+    (void)signature;
+    return false;
+}
+
+void serviceOfflineStore() {
+}
+
+void flushOfflineStore() {
+}
+
+uint16_t getOfflineMessageCount() {
+    return 0;
+}
+
+bool takeOfflineMessage(char* payload, size_t payloadSize, size_t& payloadLength,
+                        char* signature, size_t signatureSize) {
+    (void)payload;
+    (void)payloadSize;
+    (void)signature;
+    (void)signatureSize;
+    payloadLength = 0;
+    return false;
+}
+
+void commitOfflineDrain() {
+}
+
+void rewindOfflineDrain() {
+}
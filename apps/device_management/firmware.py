@@ -0,0 +1,73 @@
+"""
+OTA firmware images for the ESP8266 sensor.
+File: apps/device_management/firmware.py
+
+A release image is what the device downloads with ESP8266httpUpdate
+(see ota.h in the firmware):
+
+    gzip(firmware.bin) || signature || signature length (uint32, little-endian)
+
+The signature is ECDSA P-256 over SHA-256 of the compressed bytes, raw
+r || s (64 bytes) - the format BearSSL::SigningVerifier checks before the
+image is activated. The bootloader decompresses it when the device restarts.
+"""
+import gzip
+import os
+import struct
+
+from django.conf import settings
+from cryptography.hazmat.primitives import hashes, serialization
+from cryptography.hazmat.primitives.asymmetric import ec
+from cryptography.hazmat.primitives.asymmetric.utils import decode_dss_signature
+
+FIRMWARE_SIGNATURE_SIZE = 64  # r || s, 32 bytes each
+
+
+def load_signing_key():
+    """
+    Load the firmware signing key (FIRMWARE_SIGNING_KEY_PATH).
+
+    Returns:
+        EllipticCurvePrivateKey: Signing key, or None if it was not created yet
+    """
+    if not os.path.exists(settings.FIRMWARE_SIGNING_KEY_PATH):
+        return None
+
+    with open(settings.FIRMWARE_SIGNING_KEY_PATH, 'rb') as f:
+        return serialization.load_pem_private_key(f.read(), password=None)
+
+
+def signing_public_key_pem(private_key) -> str:
+    """
+    Public key compiled into the firmware (FIRMWARE_SIGNING_PUBLIC_KEY).
+
+    Args:
+        private_key: Firmware signing key
+
+    Returns:
+        str: PEM SubjectPublicKeyInfo
+    """
+    return private_key.public_key().public_bytes(
+        encoding=serialization.Encoding.PEM,
+        format=serialization.PublicFormat.SubjectPublicKeyInfo
+    ).decode('utf-8')
+
+
+def package_firmware_image(firmware: bytes, private_key) -> bytes:
+    """
+    Compress and sign a compiled sketch.
+
+    Args:
+        firmware: Sketch binary (<sketch>.ino.bin)
+        private_key: Firmware signing key
+
+    Returns:
+        bytes: Release image
+    """
+    # mtime=0: the same binary always gives the same image
+    compressed = gzip.compress(firmware, compresslevel=9, mtime=0)
+
+    r, s = decode_dss_signature(private_key.sign(compressed, ec.ECDSA(hashes.SHA256())))
+    signature = r.to_bytes(32, 'big') + s.to_bytes(32, 'big')
+
+    return compressed + signature + struct.pack('<I', FIRMWARE_SIGNATURE_SIZE)
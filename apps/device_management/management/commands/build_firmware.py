@@ -0,0 +1,125 @@
+import hashlib
+import re
+import shutil
+import subprocess
+import tempfile
+from pathlib import Path
+from django.conf import settings
+from django.core.management.base import BaseCommand, CommandError
+from apps.device_management.firmware import load_signing_key, package_firmware_image
+from apps.device_management.models import FirmwareRelease
+from apps.device_management.views import (
+    DEVELOPMENT_FIRMWARE_VERSION,
+    DEVICE_TEMPLATES_DIR,
+    _generate_config_h,
+)
+
+# The version is sent in an HTTP header and compiled into a C string
+FIRMWARE_VERSION_PATTERN = re.compile(r'^[0-9A-Za-z][0-9A-Za-z._+-]{0,31}$')
+
+
+class Command(BaseCommand):
+    help = (
+        'Build an OTA firmware release: compile the sketch without device credentials, '
+        'gzip-compress and sign it, and offer it to every device'
+    )
+
+    def add_arguments(self, parser):
+        parser.add_argument('version', help='FIRMWARE_VERSION of the release, e.g. 1.1.0')
+        parser.add_argument(
+            '--binary',
+            help='Sketch binary (.ino.bin) compiled elsewhere with the config.h from --config-only, '
+                 'instead of running arduino-cli',
+        )
+        parser.add_argument(
+            '--config-only',
+            metavar='PATH',
+            help='Only write the release config.h to PATH (to compile the binary elsewhere)',
+        )
+        parser.add_argument(
+            '--inactive',
+            action='store_true',
+            help='Store the release without offering it yet (activate it in the admin)',
+        )
+
+    def handle(self, *args, **options):
+        version = options['version']
+        if not FIRMWARE_VERSION_PATTERN.match(version) or version == DEVELOPMENT_FIRMWARE_VERSION:
+            raise CommandError(
+                f'Invalid version "{version}" - use up to 32 letters, digits and ._+- '
+                f'(not "{DEVELOPMENT_FIRMWARE_VERSION}")'
+            )
+        if FirmwareRelease.objects.filter(version=version).exists():
+            raise CommandError(f'Release "{version}" already exists')
+
+        signing_key = load_signing_key()
+        if signing_key is None:
+            raise CommandError('No firmware signing key - run "python manage.py create_firmware_key" first')
+
+        config_content = _generate_config_h(firmware_version=version)
+
+        if options['config_only']:
+            Path(options['config_only']).write_text(config_content)
+            self.stdout.write(self.style.SUCCESS(f'Release config.h written to {options["config_only"]}'))
+            return
+
+        if options['binary']:
+            firmware = Path(options['binary']).read_bytes()
+        else:
+            firmware = self._compile(config_content)
+
+        # A device running another version would download the image at every check
+        if version.encode('ascii') + b'\0' not in firmware:
+            raise CommandError(f'The binary was not built with FIRMWARE_VERSION "{version}"')
+
+        image = package_firmware_image(firmware, signing_key)
+
+        FirmwareRelease.objects.create(
+            version=version,
+            image=image,
+            image_md5=hashlib.md5(image).hexdigest(),
+            firmware_size=len(firmware),
+            is_active=not options['inactive'],
+        )
+
+        self.stdout.write(self.style.SUCCESS(
+            f'Release {version} stored: {len(firmware)} bytes, {len(image)} bytes compressed and signed '
+            f'({100 * len(image) // len(firmware)}%)'
+        ))
+        if options['inactive']:
+            self.stdout.write('Release is inactive - activate it in the admin to start the rollout')
+
+    def _compile(self, config_content):
+        """
+        Compile the sketch with the release config.h.
+
+        Args:
+            config_content: config.h without device credentials
+
+        Returns:
+            bytes: Sketch binary
+        """
+        with tempfile.TemporaryDirectory() as build_dir:
+            sketch_dir = Path(build_dir) / DEVICE_TEMPLATES_DIR.name
+            shutil.copytree(DEVICE_TEMPLATES_DIR, sketch_dir)
+            (sketch_dir / 'config.h').write_text(config_content)
+            output_dir = Path(build_dir) / 'output'
+
+            self.stdout.write(f'Compiling {sketch_dir.name} for {settings.FIRMWARE_BUILD_FQBN}...')
+            command = [
+                settings.FIRMWARE_ARDUINO_CLI, 'compile',
+                '--fqbn', settings.FIRMWARE_BUILD_FQBN,
+                '--output-dir', str(output_dir),
+                str(sketch_dir),
+            ]
+            try:
+                result = subprocess.run(command, capture_output=True, text=True)
+            except FileNotFoundError:
+                raise CommandError(
+                    f'"{settings.FIRMWARE_ARDUINO_CLI}" not found - install arduino-cli '
+                    f'(FIRMWARE_ARDUINO_CLI) or pass --binary'
+                )
+            if result.returncode != 0:
+                raise CommandError(f'Compilation failed:\n{result.stderr or result.stdout}')
+
+            return (output_dir / f'{sketch_dir.name}.ino.bin').read_bytes()
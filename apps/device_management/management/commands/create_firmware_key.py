@@ -0,0 +1,44 @@
+import os
+from django.core.management.base import BaseCommand
+from django.conf import settings
+from cryptography.hazmat.primitives.asymmetric import ec
+from cryptography.hazmat.primitives import serialization
+
+
+class Command(BaseCommand):
+    help = (
+        'Create the ECDSA P-256 key OTA firmware images are signed with '
+        '(devices get the public key in config.h and reject images signed with any other key)'
+    )
+
+    def handle(self, *args, **options):
+        key_path = settings.FIRMWARE_SIGNING_KEY_PATH
+
+        # Replacing the key would lock out every device built with the old public key
+        if os.path.exists(key_path):
+            self.stdout.write(self.style.WARNING('Firmware signing key already exists. Skipping creation.'))
+            return
+
+        os.makedirs(os.path.dirname(key_path), exist_ok=True)
+
+        private_key = ec.generate_private_key(ec.SECP256R1())
+
+        with open(key_path, 'wb') as f:
+            f.write(private_key.private_bytes(
+                encoding=serialization.Encoding.PEM,
+                format=serialization.PrivateFormat.TraditionalOpenSSL,
+                encryption_algorithm=serialization.NoEncryption()
+            ))
+
+        self.stdout.write(self.style.SUCCESS(f'Firmware signing key saved to {key_path}'))
+
+        try:
+            os.chmod(key_path, 0o600)
+            self.stdout.write(self.style.SUCCESS('Set permissions of firmware signing key to 600'))
+        except Exception as e:
+            self.stdout.write(self.style.WARNING(f'Could not set permissions of firmware signing key: {e}'))
+
+        self.stdout.write(
+            'Code bundles downloaded from now on enable OTA updates; '
+            'devices flashed before need one more USB upload.'
+        )
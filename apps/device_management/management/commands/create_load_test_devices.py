@@ -0,0 +1,86 @@
+import base64
+from django.core.management.base import BaseCommand, CommandError
+from django.contrib.auth.models import User
+from django.db import transaction
+from django.utils import timezone
+from apps.device_management.models import CertificateAlgorithm, Device, DeviceStatus
+from apps.device_management.utils import generate_device_certificate
+from apps.device_management.views import _extract_private_key_bytes
+
+# Load-test devices are recognised (and removed again) by this name prefix
+LOAD_TEST_NAME_PREFIX = 'loadtest-'
+
+
+class Command(BaseCommand):
+    help = (
+        'Create ACTIVE ECDSA P-256 devices for load testing and write a fleet file '
+        '(one "device_id private_key_hex certificate_b64" line per device) '
+        'for the native load generator'
+    )
+
+    def add_arguments(self, parser):
+        parser.add_argument('--count', type=int, default=100, help='Number of devices to create')
+        parser.add_argument('--output', default='fleet.txt', help='Fleet file to write')
+        parser.add_argument('--owner', help='Username to set as created_by (optional)')
+        parser.add_argument(
+            '--delete',
+            action='store_true',
+            help=f'Delete all "{LOAD_TEST_NAME_PREFIX}*" devices and their messages instead',
+        )
+
+    def handle(self, *args, **options):
+        if options['delete']:
+            deleted, _ = Device.objects.filter(name__startswith=LOAD_TEST_NAME_PREFIX).delete()
+            self.stdout.write(self.style.SUCCESS(f'Deleted {deleted} load-test objects'))
+            return
+
+        count = options['count']
+        if count < 1:
+            raise CommandError('--count must be at least 1')
+
+        owner = None
+        if options['owner']:
+            try:
+                owner = User.objects.get(username=options['owner'])
+            except User.DoesNotExist:
+                raise CommandError(f'User "{options["owner"]}" does not exist')
+
+        # Continue numbering after existing load-test devices
+        start = Device.objects.filter(name__startswith=LOAD_TEST_NAME_PREFIX).count() + 1
+
+        self.stdout.write(f'Generating {count} device certificates...')
+        devices = []
+        fleet_lines = []
+        for number in range(start, start + count):
+            device = Device(
+                name=f'{LOAD_TEST_NAME_PREFIX}{number:05d}',
+                description='Simulated device for load testing',
+                status=DeviceStatus.ACTIVE,
+                certificate_algorithm=CertificateAlgorithm.ECDSA_P256,
+                created_by=owner,
+            )
+            cert_pem, key_pem, serial_hex, expiry_date = generate_device_certificate(device)
+
+            # Private key only goes to the fleet file, never into the database
+            device.certificate_pem = cert_pem
+            device.certificate_serial = serial_hex
+            device.certificate_expiry = expiry_date
+            device.certificate_generated_at = timezone.now()
+            devices.append(device)
+
+            key_hex = bytes(_extract_private_key_bytes(key_pem)).hex()
+            cert_b64 = base64.b64encode(cert_pem.encode('utf-8')).decode('utf-8')
+            fleet_lines.append(f'{device.id} {key_hex} {cert_b64}\n')
+
+            if len(devices) % 100 == 0:
+                self.stdout.write(f'  {len(devices)}/{count}')
+
+        with transaction.atomic():
+            Device.objects.bulk_create(devices, batch_size=500)
+
+        with open(options['output'], 'w') as f:
+            f.write('# device_id private_key_hex certificate_b64 (load testing only - contains private keys)\n')
+            f.writelines(fleet_lines)
+
+        self.stdout.write(self.style.SUCCESS(f'Created {count} load-test devices'))
+        self.stdout.write(self.style.SUCCESS(f'Fleet file written to {options["output"]}'))
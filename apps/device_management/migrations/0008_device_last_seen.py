@@ -0,0 +1,21 @@
+# Generated by Django 4.2.7 on 2026-10-14 12:00
+
+from django.db import migrations, models
+
+
+class Migration(migrations.Migration):
+    dependencies = [
+        ("device_management", "0007_alter_device_certificate_algorithm"),
+    ]
+
+    operations = [
+        migrations.AddField(
+            model_name="device",
+            name="last_seen",
+            field=models.DateTimeField(
+                blank=True,
+                help_text="When the device last sent an accepted message",
+                null=True,
+            ),
+        ),
+    ]
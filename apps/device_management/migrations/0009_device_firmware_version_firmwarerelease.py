@@ -0,0 +1,76 @@
+# Generated by Django 4.2.7 on 2026-10-14 12:00
+
+from django.db import migrations, models
+
+
+class Migration(migrations.Migration):
+    dependencies = [
+        ("device_management", "0008_device_last_seen"),
+    ]
+
+    operations = [
+        migrations.AddField(
+            model_name="device",
+            name="firmware_version",
+            field=models.CharField(
+                blank=True,
+                default="",
+                help_text="Firmware version reported in the last heartbeat",
+                max_length=32,
+            ),
+        ),
+        migrations.CreateModel(
+            name="FirmwareRelease",
+            fields=[
+                (
+                    "id",
+                    models.BigAutoField(
+                        auto_created=True,
+                        primary_key=True,
+                        serialize=False,
+                        verbose_name="ID",
+                    ),
+                ),
+                (
+                    "version",
+                    models.CharField(
+                        help_text="FIRMWARE_VERSION compiled into the image",
+                        max_length=32,
+                        unique=True,
+                    ),
+                ),
+                (
+                    "image",
+                    models.BinaryField(
+                        help_text="Gzip-compressed firmware with the ECDSA P-256 signature appended"
+                    ),
+                ),
+                (
+                    "image_md5",
+                    models.CharField(
+                        help_text="MD5 of the image (x-MD5 header, checked by the device after download)",
+                        max_length=32,
+                    ),
+                ),
+                (
+                    "firmware_size",
+                    models.PositiveIntegerField(
+                        help_text="Size of the uncompressed firmware in bytes"
+                    ),
+                ),
+                (
+                    "is_active",
+                    models.BooleanField(
+                        default=True,
+                        help_text="Offered to devices (deactivate to roll back to the previous active release)",
+                    ),
+                ),
+                ("created_at", models.DateTimeField(auto_now_add=True)),
+            ],
+            options={
+                "verbose_name": "Firmware Release",
+                "verbose_name_plural": "Firmware Releases",
+                "ordering": ["-created_at"],
+            },
+        ),
+    ]
@@ -92,6 +92,19 @@ class Device(models.Model):
         default=DeviceStatus.PENDING
     )
 
+    last_seen = models.DateTimeField(
+        null=True,
+        blank=True,
+        help_text="When the device last sent an accepted message"
+    )
+
+    firmware_version = models.CharField(
+        max_length=32,
+        blank=True,
+        default='',
+        help_text="Firmware version reported in the last heartbeat"
+    )
+
      # Certificate information
 
 
@@ -177,4 +190,39 @@ class Device(models.Model):
         from datetime import timedelta
 
         expiry_time = self.certificate_generated_at + timedelta(hours=24)
-        return timezone.now() <= expiry_time
\ No newline at end of file
+        return timezone.now() <= expiry_time
+
+
+class FirmwareRelease(models.Model):
+    """
+    OTA firmware image built by "python manage.py build_firmware".
+    The newest active release is offered to every device running another version.
+    """
+    version = models.CharField(
+        max_length=32,
+        unique=True,
+        help_text="FIRMWARE_VERSION compiled into the image"
+    )
+    image = models.BinaryField(
+        help_text="Gzip-compressed firmware with the ECDSA P-256 signature appended"
+    )
+    image_md5 = models.CharField(
+        max_length=32,
+        help_text="MD5 of the image (x-MD5 header, checked by the device after download)"
+    )
+    firmware_size = models.PositiveIntegerField(
+        help_text="Size of the uncompressed firmware in bytes"
+    )
+    is_active = models.BooleanField(
+        default=True,
+        help_text="Offered to devices (deactivate to roll back to the previous active release)"
+    )
+    created_at = models.DateTimeField(auto_now_add=True)
+
+    class Meta:
+        ordering = ['-created_at']
+        verbose_name = "Firmware Release"
+        verbose_name_plural = "Firmware Releases"
+
+    def __str__(self):
+        return f"{self.version} ({'active' if self.is_active else 'inactive'})"
@@ -29,6 +29,7 @@ class DeviceListSerializer(serializers.ModelSerializer):
         "device_type": {"id": 1, "name": "ESP32"},
         "status": "ACTIVE",
         "status_display": "Active",
+        "last_seen": "2024-01-14T10:05:00Z",
         "certificate_algorithm": "ECDSA_P256",
         "certificate_expiry": "2025-01-14T10:00:00Z",
         "created_at": "2024-01-14T10:00:00Z",
@@ -51,6 +52,7 @@ class DeviceListSerializer(serializers.ModelSerializer):
             'longitude',
             'status',
             'status_display',
+            'last_seen',
             'certificate_algorithm',
             'certificate_expiry',
             'certificate_pem',
@@ -89,6 +91,7 @@ class DeviceDetailSerializer(serializers.ModelSerializer):
         "device_type": {"id": 1, "name": "ESP32"},
         "status": "ACTIVE",
         "status_display": "Active",
+        "last_seen": "2024-01-14T10:05:00Z",
         "certificate_algorithm": "ECDSA_P256",
         "certificate_expiry": "2025-01-14T10:00:00Z",
         "created_by": {
@@ -120,6 +123,7 @@ class DeviceDetailSerializer(serializers.ModelSerializer):
             'longitude',
             'status',
             'status_display',
+            'last_seen',
             'certificate_algorithm',
             'certificate_expiry',
             'certificate_pem',
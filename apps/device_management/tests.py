@@ -645,3 +645,260 @@ class DownloadPrivateKeyViewTest(TestCase):
         self.client.login(username='keyuser', password='testpass')
         response = self.client.get(self.url)
         self.assertEqual(response.status_code, 302)
+
+
+class CreateLoadTestDevicesCommandTest(TestCase):
+    """Tests for the create_load_test_devices management command"""
+
+    @classmethod
+    def setUpTestData(cls):
+        """Set up CA certificate for certificate generation"""
+        from django.core.management import call_command
+        from django.conf import settings
+        import os
+
+        if not os.path.exists(settings.CA_CERTIFICATE_PATH):
+            call_command('create_ca')
+
+    def setUp(self):
+        import tempfile
+        import os
+
+        self.user = User.objects.create_user(username='loaduser', password='testpass')
+        handle, self.fleet_path = tempfile.mkstemp(suffix='.txt')
+        os.close(handle)
+        self.addCleanup(os.remove, self.fleet_path)
+
+    def _create_devices(self, count):
+        from io import StringIO
+        from django.core.management import call_command
+
+        call_command('create_load_test_devices', count=count, output=self.fleet_path,
+                     owner='loaduser', stdout=StringIO())
+        with open(self.fleet_path) as f:
+            return [line.split() for line in f if not line.startswith('#')]
+
+    def test_creates_active_devices_and_fleet_file(self):
+        """Test devices are created ACTIVE with P-256 certificates and listed in the fleet file"""
+        import base64
+        from cryptography import x509
+        from cryptography.hazmat.primitives.asymmetric import ec
+        from cryptography.hazmat.primitives import serialization
+        from .models import CertificateAlgorithm
+
+        fleet = self._create_devices(2)
+
+        devices = Device.objects.filter(name__startswith='loadtest-')
+        self.assertEqual(devices.count(), 2)
+        self.assertEqual(len(fleet), 2)
+
+        for device_id, key_hex, cert_b64 in fleet:
+            device = devices.get(id=device_id)
+            self.assertEqual(device.status, DeviceStatus.ACTIVE)
+            self.assertEqual(device.certificate_algorithm, CertificateAlgorithm.ECDSA_P256)
+            self.assertEqual(device.created_by, self.user)
+            self.assertIsNone(device.private_key_pem)
+
+            # Certificate header value matches the stored certificate
+            cert_pem = base64.b64decode(cert_b64).decode('utf-8')
+            self.assertEqual(cert_pem, device.certificate_pem)
+
+            # Private key belongs to the certificate
+            cert = x509.load_pem_x509_certificate(cert_pem.encode('utf-8'))
+            private_key = ec.derive_private_key(int(key_hex, 16), ec.SECP256R1())
+            public_format = serialization.PublicFormat.SubjectPublicKeyInfo
+            self.assertEqual(
+                private_key.public_key().public_bytes(serialization.Encoding.PEM, public_format),
+                cert.public_key().public_bytes(serialization.Encoding.PEM, public_format),
+            )
+
+    def test_numbering_continues_and_delete_removes_devices(self):
+        """Test a second run continues numbering and --delete removes only load-test devices"""
+        from io import StringIO
+        from django.core.management import call_command
+
+        Device.objects.create(name='Regular Device', created_by=self.user)
+        self._create_devices(1)
+        self._create_devices(1)
+
+        names = sorted(Device.objects.filter(name__startswith='loadtest-').values_list('name', flat=True))
+        self.assertEqual(names, ['loadtest-00001', 'loadtest-00002'])
+
+        call_command('create_load_test_devices', delete=True, stdout=StringIO())
+        self.assertFalse(Device.objects.filter(name__startswith='loadtest-').exists())
+        self.assertTrue(Device.objects.filter(name='Regular Device').exists())
+
+
+class FirmwareUpdateTest(TestCase):
+    """Tests for OTA release images, the build_firmware command and the device update check"""
+
+    def setUp(self):
+        import os
+        import shutil
+        import tempfile
+        from django.core.management import call_command
+        from io import StringIO
+
+        self.key_dir = tempfile.mkdtemp()
+        self.addCleanup(shutil.rmtree, self.key_dir)
+        self.key_path = os.path.join(self.key_dir, 'firmware_signing_key.pem')
+        settings_override = self.settings(FIRMWARE_SIGNING_KEY_PATH=self.key_path)
+        settings_override.enable()
+        self.addCleanup(settings_override.disable)
+        call_command('create_firmware_key', stdout=StringIO())
+
+        self.device = Device.objects.create(name='OTA Test Device', status=DeviceStatus.ACTIVE)
+        self.url = reverse('device-firmware')
+
+    def _create_release(self, version, is_active=True):
+        import hashlib
+        from .firmware import load_signing_key, package_firmware_image
+        from .models import FirmwareRelease
+
+        firmware = b'\xe9' + bytes(4096) + version.encode('ascii') + b'\0'
+        image = package_firmware_image(firmware, load_signing_key())
+        return FirmwareRelease.objects.create(
+            version=version, image=image, image_md5=hashlib.md5(image).hexdigest(),
+            firmware_size=len(firmware), is_active=is_active,
+        )
+
+    def _check(self, version, device_id=None):
+        return self.client.get(
+            self.url, {'device_id': device_id or str(self.device.id)}, HTTP_X_ESP8266_VERSION=version
+        )
+
+    def test_release_config_has_no_credentials(self):
+        """Test the release config.h reads credentials from flash and carries the signing key"""
+        from .firmware import load_signing_key, signing_public_key_pem
+        from .views import _generate_config_h
+
+        config = _generate_config_h(firmware_version='1.2.0')
+
+        self.assertIn('#define CREDENTIALS_EMBEDDED 0', config)
+        self.assertIn('#define OTA_UPDATES_ENABLED 1', config)
+        self.assertIn('static const char* FIRMWARE_VERSION = "1.2.0";', config)
+        self.assertIn('static const char* DEVICE_ID = "";', config)
+        self.assertIn('static const char* DEVICE_CERTIFICATE_B64 ="";', config)
+        public_key = signing_public_key_pem(load_signing_key()).replace('\n', '\\n')
+        self.assertIn(f'FIRMWARE_SIGNING_PUBLIC_KEY = "{public_key}";', config)
+
+    def test_config_without_signing_key_disables_updates(self):
+        """Test code bundles built before create_firmware_key have OTA updates disabled"""
+        import os
+        from .views import _generate_config_h
+
+        os.remove(self.key_path)
+        config = _generate_config_h()
+
+        self.assertIn('#define OTA_UPDATES_ENABLED 0', config)
+        self.assertIn('FIRMWARE_SIGNING_PUBLIC_KEY = "";', config)
+
+    def test_image_is_compressed_and_signed(self):
+        """Test the image layout checked by the device: gzip || r || s || length"""
+        import gzip
+        import struct
+        from cryptography.hazmat.primitives import hashes
+        from cryptography.hazmat.primitives.asymmetric import ec
+        from cryptography.hazmat.primitives.asymmetric.utils import encode_dss_signature
+        from .firmware import load_signing_key, package_firmware_image
+
+        firmware = b'\xe9' + bytes(range(256)) * 64
+        image = package_firmware_image(firmware, load_signing_key())
+
+        signature_length = struct.unpack('<I', image[-4:])[0]
+        self.assertEqual(signature_length, 64)
+        compressed = image[:-4 - signature_length]
+        signature = image[-4 - signature_length:-4]
+
+        self.assertEqual(gzip.decompress(compressed), firmware)
+        self.assertLess(len(image), len(firmware))
+        der_signature = encode_dss_signature(
+            int.from_bytes(signature[:32], 'big'), int.from_bytes(signature[32:], 'big')
+        )
+        # Raises InvalidSignature if the image does not verify
+        load_signing_key().public_key().verify(der_signature, compressed, ec.ECDSA(hashes.SHA256()))
+
+    def test_update_check_serves_active_release(self):
+        """Test devices on another version get the newest active release, up-to-date ones 304"""
+        self._create_release('1.0.0')
+        release = self._create_release('1.1.0')
+        self._create_release('1.2.0', is_active=False)
+
+        response = self._check('development')
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(response['Content-Type'], 'application/octet-stream')
+        self.assertEqual(response.content, bytes(release.image))
+        self.assertEqual(response['x-MD5'], release.image_md5)
+
+        response = self._check('1.1.0')
+        self.assertEqual(response.status_code, 304)
+
+    def test_update_check_does_not_record_version(self):
+        """Test an unauthenticated check cannot change the version shown for a device"""
+        self.device.firmware_version = '1.0.0'
+        self.device.save()
+        self._create_release('1.1.0')
+
+        self.assertEqual(self._check('6.6.6').status_code, 200)
+
+        self.device.refresh_from_db()
+        self.assertEqual(self.device.firmware_version, '1.0.0')
+
+    def test_update_check_without_release(self):
+        """Test 304 when no release is active"""
+        self._create_release('1.0.0', is_active=False)
+
+        response = self._check('development')
+        self.assertEqual(response.status_code, 304)
+
+    def test_update_check_rejects_unknown_and_inactive_devices(self):
+        """Test only ACTIVE devices are offered updates"""
+        self._create_release('1.0.0')
+
+        self.assertEqual(self._check('development', device_id='not-a-uuid').status_code, 403)
+        self.assertEqual(self._check('development', device_id='00000000-0000-0000-0000-000000000000').status_code, 403)
+
+        self.device.status = DeviceStatus.REVOKED
+        self.device.save()
+        self.assertEqual(self._check('development').status_code, 403)
+
+    def test_build_firmware_command_with_binary(self):
+        """Test build_firmware stores a prebuilt binary and checks its FIRMWARE_VERSION"""
+        import os
+        import tempfile
+        from io import StringIO
+        from django.core.management import call_command
+        from django.core.management.base import CommandError
+        from .models import FirmwareRelease
+
+        handle, binary_path = tempfile.mkstemp(suffix='.ino.bin')
+        os.close(handle)
+        self.addCleanup(os.remove, binary_path)
+        with open(binary_path, 'wb') as f:
+            f.write(b'\xe9' + bytes(8192) + b'2.0.0\0')
+
+        call_command('build_firmware', '2.0.0', binary=binary_path, stdout=StringIO())
+        release = FirmwareRelease.objects.get(version='2.0.0')
+        self.assertTrue(release.is_active)
+        self.assertEqual(release.firmware_size, 8198)
+
+        # Built with another FIRMWARE_VERSION, duplicate and reserved versions
+        with self.assertRaises(CommandError):
+            call_command('build_firmware', '2.0.1', binary=binary_path, stdout=StringIO())
+        with self.assertRaises(CommandError):
+            call_command('build_firmware', '2.0.0', binary=binary_path, stdout=StringIO())
+        with self.assertRaises(CommandError):
+            call_command('build_firmware', 'development', binary=binary_path, stdout=StringIO())
+
+    def test_admin_lists_image_size_without_loading_image(self):
+        """Test the release changelist gets the image size from the database, not the BLOB"""
+        from django.contrib import admin
+        from django.test import RequestFactory
+        from .models import FirmwareRelease
+
+        release = self._create_release('1.0.0')
+        release_admin = admin.site._registry[FirmwareRelease]
+
+        listed = release_admin.get_queryset(RequestFactory().get('/')).get(id=release.id)
+        self.assertIn('image', listed.get_deferred_fields())
+        self.assertEqual(release_admin.image_size(listed), len(release.image))
@@ -6,19 +6,26 @@ from cryptography.hazmat.primitives import serialization
 from cryptography.hazmat.primitives.asymmetric import ec
 from django.shortcuts import render, redirect, get_object_or_404
 from django.contrib import messages
+from django.core.exceptions import ValidationError
 from django.http import HttpResponseForbidden, HttpResponse
+from django.views.decorators.http import require_GET
 from django.utils import timezone
 from datetime import timedelta
 from apps.core.permissions import participant_required
-from .models import Device, DeviceStatus
+from .models import Device, DeviceStatus, FirmwareRelease
 from .forms import DeviceRegistrationForm, DeviceConfigForm
 from .utils import generate_device_certificate
+from .firmware import load_signing_key, signing_public_key_pem
 
 
 # Path to device template files
 ESP8266_SENSOR_BASE_DIR = Path(__file__).parent / 'device_templates' / 'ESP8266_sensor'
 DEVICE_TEMPLATES_DIR = ESP8266_SENSOR_BASE_DIR / 'ESP8266_P256'
 
+# FIRMWARE_VERSION of code bundles built by the participant - devices install
+# the active release at their first update check
+DEVELOPMENT_FIRMWARE_VERSION = 'development'
+
 
 @participant_required
 def participant_dashboard(request):
@@ -253,12 +260,26 @@ def _extract_private_key_bytes(private_key_pem: str) -> list[int]:
     return list(private_bytes)
 
 
-def _generate_config_h(device, wifi_ssid: str, wifi_password: str) -> str:
+def _generate_config_h(device=None, wifi_ssid: str = '', wifi_password: str = '',
+                       firmware_version: str = DEVELOPMENT_FIRMWARE_VERSION) -> str:
     """
     Generate config.h content with device-specific credentials.
+
+    Without a device, generates the config.h of an OTA release image: no
+    credentials (CREDENTIALS_EMBEDDED 0), the device reads them from flash.
+    OTA updates are enabled when the firmware signing key exists.
     """
-    # Extract private key bytes for the C array
-    key_bytes = _extract_private_key_bytes(device.private_key_pem)
+    if device is not None:
+        # Extract private key bytes for the C array
+        key_bytes = _extract_private_key_bytes(device.private_key_pem)
+        # Base64 encode the certificate for HTTP header transmission
+        cert_b64 = base64.b64encode(device.certificate_pem.encode('utf-8')).decode('utf-8')
+        device_id = device.id
+    else:
+        key_bytes = [0] * 32
+        cert_b64 = ''
+        device_id = ''
+    credentials_embedded = 1 if device is not None else 0
 
     # Format key bytes as C hex array (8 per line)
     key_lines = []
@@ -268,8 +289,14 @@ def _generate_config_h(device, wifi_ssid: str, wifi_password: str) -> str:
         key_lines.append(f'    {hex_values}')
     key_array = ',\n'.join(key_lines)
 
-    # Base64 encode the certificate for HTTP header transmission
-    cert_b64 = base64.b64encode(device.certificate_pem.encode('utf-8')).decode('utf-8')
+    # Public key as a one-line C string (PEM line breaks escaped)
+    signing_key = load_signing_key()
+    if signing_key is not None:
+        public_key = signing_public_key_pem(signing_key).replace('\n', '\\n')
+        ota_enabled = 1
+    else:
+        public_key = ''
+        ota_enabled = 0
 
     config_content = f'''#ifndef CONFIG_H
 #define CONFIG_H
@@ -280,11 +307,17 @@ def _generate_config_h(device, wifi_ssid: str, wifi_password: str) -> str:
 // NETWORK CONFIGURATION
 // ============================================================================
 
-static const char* WIFI_SSID = "{wifi_ssid}";
-static const char* WIFI_PASSWORD = "{wifi_password}";
-
 static const char* SERVER_URL = "http://192.168.1.102:8000/api/device/message/";
 
+// Transport: TRANSPORT_HTTP (POST to SERVER_URL) or TRANSPORT_MQTT (QoS 1
+// publish to the broker below - no HTTP headers per message; the backend
+// runs "python manage.py mqtt_subscriber")
+#define MESSAGE_TRANSPORT TRANSPORT_HTTP
+static const char* MQTT_BROKER_HOST = "192.168.1.102";
+static const uint16_t MQTT_BROKER_PORT = 1883;
+static const char* MQTT_TOPIC_PREFIX = "c3ds/devices";     // Topics: <prefix>/<device_id>/...
+static const uint16_t MQTT_KEEPALIVE_SECONDS = 60;         // Broker drops the session after 1.5x this without traffic
+
 // NTP (Network Time Protocol) for timestamps
 static const char* NTP_SERVER = "pool.ntp.org";
 static const long GMT_OFFSET_SEC = 0;           // UTC
@@ -292,13 +325,36 @@ static const int DAYLIGHT_OFFSET_SEC = 0;
 
 // NTP Synchronization
 static const unsigned long MIN_VALID_UNIX_TIMESTAMP = 100000;  // Jan 2, 1970 threshold
-static const int NTP_MAX_SYNC_ATTEMPTS = 20;                   // Maximum retry attempts
+static const unsigned long TIME_CACHE_SAVE_INTERVAL = 60000;   // 60 seconds - How often the time is saved to RTC memory
+
+// ============================================================================
+// OTA UPDATE CONFIGURATION
+// ============================================================================
+
+// Signed, gzip-compressed images built by "python manage.py build_firmware".
+// The device asks FIRMWARE_UPDATE_URL for the active release and installs it
+// when its version differs from FIRMWARE_VERSION. Needs a Flash Size option
+// with OTA space, e.g. 4MB (FS:2MB OTA:~1019KB)
+#define OTA_UPDATES_ENABLED {ota_enabled}
+static const char* FIRMWARE_VERSION = "{firmware_version}";      // Set by build_firmware for release images
+static const char* FIRMWARE_UPDATE_URL = "http://192.168.1.102:8000/api/device/firmware/";
+static const unsigned long FIRMWARE_UPDATE_CHECK_INTERVAL = 3600000; // 1 hour
+static const unsigned long FIRMWARE_UPDATE_RETRY_DELAY = 60000;      // 60 seconds - First check after boot, retry while busy
+
+// Public key (PEM, ECDSA P-256) the images must be signed with
+static const char* FIRMWARE_SIGNING_PUBLIC_KEY = "{public_key}";
 
 // ============================================================================
-// DEVICE IDENTITY
+// LOGGING CONFIGURATION
 // ============================================================================
 
-static const char* DEVICE_ID = "{device.id}";
+// Serial log level: LOG_LEVEL_NONE, LOG_LEVEL_ERROR, LOG_LEVEL_INFO or LOG_LEVEL_DEBUG
+// Messages above this level are compiled out (zero cost in production builds)
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+// Timing counters (min/avg/max/p99 of signing, HTTP, sensor...) sent in each
+// heartbeat's "performance" object. 0 compiles them out (saves ~1.4 KB RAM)
+#define PROFILING_ENABLED 1
 
 // ============================================================================
 // HARDWARE PINS (NodeMCU/Wemos D1 Mini)
@@ -308,6 +364,16 @@ static const char* DEVICE_ID = "{device.id}";
 static const int SENSOR_TRIG_PIN = 5;         // D1 - HC-SR04 Trigger pin
 static const int SENSOR_ECHO_PIN = 4;         // D2 - HC-SR04 Echo pin
 
+// Sensor array: up to 4 HC-SR04 per node, triggered one at a time.
+// For more sensors list their pins here, e.g. a second sensor on
+// D5 (GPIO14, trigger) / D7 (GPIO13, echo):
+//   #define SENSOR_COUNT 2
+//   ... SENSOR_TRIG_PINS[SENSOR_COUNT] = {{SENSOR_TRIG_PIN, 14}};
+//   ... SENSOR_ECHO_PINS[SENSOR_COUNT] = {{SENSOR_ECHO_PIN, 13}};
+#define SENSOR_COUNT 1
+static const int SENSOR_TRIG_PINS[SENSOR_COUNT] = {{SENSOR_TRIG_PIN}};
+static const int SENSOR_ECHO_PINS[SENSOR_COUNT] = {{SENSOR_ECHO_PIN}};
+
 // LED Indicators
 static const int STATUS_LED_PIN = 12;         // D6 - Status indicator
 static const int BUILTIN_LED_PIN = 2;         // D4 - WiFi indicator (inverted logic)
@@ -317,26 +383,82 @@ static const int BUILTIN_LED_PIN = 2;         // D4 - WiFi indicator (inverted l
 // ============================================================================
 
 static const unsigned long HEARTBEAT_INTERVAL = 20000;    // 20 seconds
-static const unsigned long SENSOR_POLL_INTERVAL = 500;    // 500ms - Check sensor twice per second
-static const unsigned long ALERT_INTERVAL = 10000;        // 10 seconds - Send alert every 10s while detecting
+static const unsigned long SENSOR_POLL_INTERVAL = 500;    // 500ms - Check sensor twice per second (recent motion)
+static const unsigned long SENSOR_POLL_INTERVAL_FAST = 60;   // 60ms - Object approaching or detected
+static const unsigned long SENSOR_POLL_INTERVAL_SLOW = 1000; // 1 second - No motion for SENSOR_IDLE_TIMEOUT
+static const unsigned long SENSOR_IDLE_TIMEOUT = 30000;      // 30 seconds - Quiet time before polling slowly
+static const unsigned long SENSOR_FAST_POLL_HOLD = 3000;     // 3 seconds - Stay fast after the last approach
+static const unsigned long ALERT_INTERVAL = 10000;        // 10 seconds - Minimum time between detection updates
+static const unsigned long ALERT_KEEPALIVE_INTERVAL = 60000; // 60 seconds - Detection update even if the distance is unchanged
+static const uint8_t ALERT_CLOSED_MAX_ATTEMPTS = 3;       // Tries to queue a detection's closed summary (ALERT_INTERVAL apart) before it is dropped
+static const unsigned long LED_BLINK_INTERVAL = 300;      // 300ms on/off - Status LED blink while detecting
+
+static const unsigned long WIFI_TIMEOUT = 20000;          // 20 seconds - Full connect (scan, associate, DHCP) before giving up
+static const unsigned long WIFI_RECONNECT_INTERVAL = 5000; // 5 seconds - Wait between reconnection attempts
+static const unsigned long WIFI_FAST_CONNECT_TIMEOUT = 3000; // 3 seconds - Direct association with cached BSSID/channel/IP before full scan
+static const unsigned long WIFI_CONNECT_POLL_INTERVAL = 100; // 100ms - WiFi task checks a running connection attempt this often
+static const unsigned long HTTP_TIMEOUT = 10000;          // 10 seconds - Max wait for send/response (or MQTT PUBACK)
+static const unsigned long HTTP_CONNECT_TIMEOUT = 3000;   // 3 seconds - Max wait when opening a new socket (incl. MQTT handshake)
+static const unsigned long SERVER_RETRY_INTERVAL = 10000; // 10 seconds - No new connection after a failed connect, doubled on each further failure
+static const unsigned long SERVER_RETRY_MAX_INTERVAL = 120000; // 2 minutes - Longest wait between connection attempts
 
-static const unsigned long WIFI_TIMEOUT = 20000;          // 20 seconds
-static const unsigned long HTTP_TIMEOUT = 10000;          // 10 seconds
+// ============================================================================
+// SCHEDULER CONFIGURATION
+// ============================================================================
+
+// loop() runs periodic tasks and sleeps until the next one is due
+#define SCHEDULER_MAX_TASKS 8                     // Registered tasks (sensor, LED, heartbeat, network, ...)
+static const unsigned long SCHEDULER_MAX_IDLE_SLEEP = 1000;  // Longest sleep between scheduler passes
+static const unsigned long SCHEDULER_LATE_THRESHOLD = 20;    // A run this many ms after its deadline counts as late
+static const unsigned long SCHEDULER_STATS_INTERVAL = 60000; // 60 seconds - Task statistics log (debug level)
+static const unsigned long NETWORK_TASK_INTERVAL = 100;      // Network housekeeping while idle
+static const unsigned long NETWORK_BUSY_INTERVAL = 5;        // Send pipeline steps while a request is in flight
+static const unsigned long SENSOR_ECHO_CHECK_INTERVAL = 2;   // Check for the echo after a trigger pulse
+static const unsigned long SENSOR_PING_SPACING = 60;         // Between the pings of a burst - lets echoes die out
+static const unsigned long MEMORY_HEAP_WALK_INTERVAL = 1000; // Largest free block / fragmentation sampling (walks the heap)
+
+// ============================================================================
+// POWER CONFIGURATION
+// ============================================================================
+
+// Power mode: POWER_MODE_ACTIVE (always awake), POWER_MODE_MODEM_SLEEP
+// (radio sleeps between beacons) or POWER_MODE_LIGHT_SLEEP (radio and CPU
+// sleep between sensor polls - lowest power, for battery/solar nodes)
+#define POWER_MODE POWER_MODE_ACTIVE
+#define POWER_LISTEN_INTERVAL 3                   // Beacons (DTIM) between radio wake-ups while sleeping
+static const unsigned long POWER_SAVE_NETWORK_INTERVAL = 1000; // Network housekeeping while idle in sleep modes
+
+// Average current draw per state for the heartbeat energy estimate (datasheet values)
+#define POWER_CURRENT_AWAKE_MA 70.0f              // CPU running, radio receiving
+#define POWER_CURRENT_MODEM_SLEEP_MA 15.0f        // CPU running, radio asleep between beacons
+#define POWER_CURRENT_LIGHT_SLEEP_MA 1.0f         // CPU and radio suspended
+#define POWER_SUPPLY_VOLTAGE 3.3f                 // Volts
 
 // ============================================================================
 // SENSOR CONFIGURATION (HC-SR04)
 // ============================================================================
 
-// Distance thresholds
+// Distance thresholds (converted to integer mm at compile time)
 #define DETECTION_THRESHOLD_CM 25.0         // Alert when object <= 25cm
 #define DETECTION_HYSTERESIS_CM 2.0         // Deactivate when object > 27cm
 #define SENSOR_MAX_DISTANCE_CM 400.0        // HC-SR04 max reliable range
+#define ALERT_DELTA_DISTANCE_CM 5.0         // Send a detection update when the distance moves this much
+
+// Sampling and filtering - every poll is a burst of pings reduced to their median
+#define SENSOR_BURST_SAMPLES 3                // Pings per poll (1-5) - the median outvotes a single bad echo
+#define SENSOR_BURST_MIN_VALID 2              // Valid pings needed for a usable reading
+#define SENSOR_FILTER_EMA_ALPHA 0.5           // Weight of the newest median in the reported distance (1.0 = no smoothing)
+
+// Adaptive poll rate (intervals in TIMING CONFIGURATION)
+#define SENSOR_MOTION_THRESHOLD_CM 3.0        // Change between readings that counts as motion
+#define SENSOR_APPROACH_ZONE_CM 50.0          // Moving closer within threshold + 50cm polls fast
 
 // Error handling
-#define CONSECUTIVE_READINGS_REQUIRED 2       // Require 2 consecutive valid readings
+#define CONSECUTIVE_READINGS_REQUIRED 1       // Require 1 reading (burst median) in range to start a detection
+#define CONSECUTIVE_CLEAR_READINGS_REQUIRED 2 // Require 2 readings out of range to end it
 
 // Physics constants
-#define SPEED_OF_SOUND_CM_PER_MICROSECOND 0.0343  // Speed of sound at 20°C (343 m/s = 0.0343 cm/μs)
+#define SENSOR_AIR_TEMPERATURE_C 20                // Air temperature for the speed of sound (343 m/s at 20°C, +0.6 m/s per °C)
 #define SENSOR_PULSE_TIMEOUT_MICROSECONDS 30000   // 30ms timeout (~500cm max range)
 #define SENSOR_MIN_DISTANCE_CM 2.0                 // Minimum reliable distance for HC-SR04
 
@@ -344,16 +466,70 @@ static const unsigned long HTTP_TIMEOUT = 10000;          // 10 seconds
 // MESSAGE BUFFER CONFIGURATION
 // ============================================================================
 
+// Message wire format: WIRE_FORMAT_JSON (readable text) or WIRE_FORMAT_CBOR
+// (compact binary, integer keys, epoch timestamps - about 1/3 of the size)
+#define MESSAGE_WIRE_FORMAT WIRE_FORMAT_JSON
+
 // JSON document capacity for ArduinoJson library
-#define MESSAGE_JSON_DOC_SIZE 512                 // Bytes allocated for JSON serialization
+#define MESSAGE_JSON_DOC_SIZE 1024                // Bytes allocated for JSON serialization (heartbeat with profiling and memory)
+
+// Serialized message text (fixed buffer per outbound queue slot)
+#define MESSAGE_PAYLOAD_BUFFER_SIZE 810           // Longest JSON payload (heartbeat with profiling, memory and firmware version) + null terminator
+
+// Signature buffer size
+#define SIGNATURE_BUFFER_SIZE 97                  // Base64 of 72-byte max DER signature (96 chars) + null terminator
+#define MESSAGE_DIGEST_SIZE 32                    // SHA-256 digest (computed while the payload is serialized)
+
+// Precomputed signing nonces: the scalar multiplication (k·G) is done while
+// idle, so signing an alert only needs a few modular multiplications
+#define NONCE_POOL_SIZE 4                         // Nonces kept ready (64 bytes of RAM each, at least 1)
+static const unsigned long NONCE_POOL_REFILL_INTERVAL = 2000; // 2 seconds - One nonce computed per run while idle
 
 // Timestamp buffer size
 #define TIMESTAMP_BUFFER_SIZE 25                  // ISO 8601 format: "YYYY-MM-DDTHH:MM:SSZ" + null terminator
 
+// Server hostname buffer (parsed from SERVER_URL for the persistent connection)
+#define SERVER_HOST_BUFFER_SIZE 64                // Max hostname length + null terminator
+#define MQTT_TOPIC_BUFFER_SIZE 96                 // "<prefix>/<device_id>/messages/json" + null terminator
+#define FIRMWARE_URL_BUFFER_SIZE 160              // FIRMWARE_UPDATE_URL + "?device_id=<device_id>" + null terminator
+
+// Outbound send pipeline
+#define OUTBOUND_QUEUE_SIZE 4                     // Messages waiting to be sent
+#define MESSAGE_BATCH_MAX_SIZE 4                  // Queued messages sent as one JSON array with one signature (1 = no batching)
+#define REQUEST_HEAD_BUFFER_SIZE 256              // HTTP request line + fixed headers
+#define RESPONSE_LINE_BUFFER_SIZE 128             // Longest response header line kept
+#define RESPONSE_BODY_BUFFER_SIZE 384             // Response body kept for session ID and diagnostics
+#define RESPONSE_JSON_DOC_SIZE 128                // Parsed response fields (session_id, session_ttl)
+#define SESSION_ID_BUFFER_SIZE 48                 // Session ID returned by server + null terminator
+
 // ============================================================================
-// CRYPTOGRAPHIC CREDENTIALS
+// OFFLINE STORE CONFIGURATION (LittleFS)
 // ============================================================================
 
+// Alerts raised while WiFi is down (or that fail to send) are kept in flash
+// and sent after reconnection. Needs a Flash Size option with an FS partition.
+#define OFFLINE_STORE_CAPACITY 32                 // Max stored alerts (~860 bytes each), oldest evicted first
+#define OFFLINE_STORE_STAGING_SIZE 4              // Alerts collected in RAM before one flash write
+static const unsigned long OFFLINE_STORE_FLUSH_INTERVAL = 30000;  // 30 seconds - Max time an alert stays in RAM only
+#define OFFLINE_DRAIN_BATCH_SIZE 3                // Stored alerts queued per drain pass after reconnect
+static const unsigned long OFFLINE_DRAIN_RETRY_INTERVAL = 5000;       // 5 seconds - Wait after a failed resend, doubled on each further failure
+static const unsigned long OFFLINE_DRAIN_RETRY_MAX_INTERVAL = 300000; // 5 minutes - Longest wait between resend attempts
+
+// ============================================================================
+// DEVICE CREDENTIALS
+// ============================================================================
+
+// Per-device values, kept in the credentials sector of the flash (survives
+// sketch uploads and OTA updates, see credentials.h). With 1, the values
+// below are written there at boot if it does not hold them yet. Release
+// images for OTA updates are built with 0 and carry no credentials.
+#define CREDENTIALS_EMBEDDED {credentials_embedded}
+
+static const char* DEVICE_ID = "{device_id}";
+
+static const char* WIFI_SSID = "{wifi_ssid}";
+static const char* WIFI_PASSWORD = "{wifi_password}";
+
 // Device Certificate (Base64 encoded - sent in X-Device-Certificate header)
 // This is the PEM certificate, Base64-encoded for transmission in HTTP header
 static const char* DEVICE_CERTIFICATE_B64 ="{cert_b64}";
@@ -449,3 +625,39 @@ def download_device_code(request, device_id):
     }
 
     return render(request, 'device_management/download_device_code.html', context)
+
+
+@require_GET
+def firmware_update(request):
+    """
+    Firmware update check by devices (ESP8266httpUpdate, see ota.h in the firmware).
+
+    The device sends its device_id as a query parameter and its running
+    version in the x-ESP8266-version header. Responds with the newest active
+    FirmwareRelease if the versions differ, 304 if the device is up to date.
+
+    No login: images carry no credentials and devices only install images
+    signed with the firmware signing key. Since anyone can send the check,
+    the version is not stored here - devices report it in signed heartbeats.
+    """
+    device_id = request.GET.get('device_id', '')
+    try:
+        device = Device.objects.filter(id=device_id).only('id', 'status').first()
+    except (ValueError, ValidationError):
+        device = None
+    if device is None or device.status != DeviceStatus.ACTIVE:
+        return HttpResponseForbidden('Unknown or inactive device')
+
+    current_version = request.headers.get('x-ESP8266-version', '')
+
+    release = FirmwareRelease.objects.filter(is_active=True).defer('image').first()
+    if release is None or release.version == current_version:
+        return HttpResponse(status=304)
+
+    image = bytes(FirmwareRelease.objects.values_list('image', flat=True).get(id=release.id))
+    response = HttpResponse(image, content_type='application/octet-stream')
+    response['Content-Length'] = str(len(image))
+    response['x-MD5'] = release.image_md5
+    response['Content-Disposition'] = f'attachment; filename="c3ds_{release.version}.bin.gz"'
+
+    return response
@@ -89,6 +89,26 @@ WSGI_APPLICATION = "config.wsgi.application"
 # Database setting is removed from this file - each environment will define its own database settings.
 
 
+# Cache
+# https://docs.djangoproject.com/en/4.2/topics/cache/
+
+# Device sessions (DEVICE_SESSION_TTL) live in this cache, so it must be shared by
+# every worker process - a process-local cache (LocMemCache, the Django default)
+# rejects sessions issued by another worker. The table is created by migrate
+# (data_processing 0003). An environment can use Redis instead:
+# 'django.core.cache.backends.redis.RedisCache' (needs the redis package).
+CACHES = {
+    'default': {
+        'BACKEND': 'django.core.cache.backends.db.DatabaseCache',
+        'LOCATION': 'c3ds_cache',
+        'OPTIONS': {
+            # Culling drops live sessions - keep this above twice the fleet size
+            'MAX_ENTRIES': 20000,
+        },
+    }
+}
+
+
 # Password validation
 # https://docs.djangoproject.com/en/4.2/ref/settings/#auth-password-validators
 
@@ -140,6 +160,25 @@ CA_DIR = BASE_DIR / 'ca'
 CA_PRIVATE_KEY_PATH = CA_DIR / 'ca_private_key.pem'
 CA_CERTIFICATE_PATH = CA_DIR / 'ca_certificate.pem'
 
+# Device Message API
+DEVICE_MESSAGE_MAX_BATCH_SIZE = 50  # Max messages in one batched (JSON array) upload
+DEVICE_SESSION_TTL = 3600  # Seconds a session ID replaces the device certificate header
+DEVICE_CERT_CACHE_SIZE = 4096  # Verified device certificates kept per process (0 disables the cache)
+DEVICE_CERT_CACHE_TTL = 60  # Seconds before a cached certificate and device status are re-checked
+DEVICE_INGEST_WRITE_BEHIND = False  # True: acknowledge messages as queued (saved=False) once staged in the QueuedDeviceMessage table, written to DeviceMessage in the background
+DEVICE_INGEST_FLUSH_MESSAGES = 200  # Write-behind: flush when this many messages are queued
+DEVICE_INGEST_FLUSH_INTERVAL_MS = 250  # Write-behind: flush at least this often
+
+# MQTT transport (devices built with TRANSPORT_MQTT - run "python manage.py mqtt_subscriber")
+MQTT_BROKER_HOST = 'localhost'
+MQTT_BROKER_PORT = 1883
+MQTT_TOPIC_PREFIX = 'c3ds/devices'  # Must match MQTT_TOPIC_PREFIX in the firmware config.h
+
+# OTA firmware updates (key: "python manage.py create_firmware_key", images: "python manage.py build_firmware")
+FIRMWARE_SIGNING_KEY_PATH = CA_DIR / 'firmware_signing_key.pem'  # ECDSA P-256 key release images are signed with
+FIRMWARE_ARDUINO_CLI = 'arduino-cli'  # Compiler used by build_firmware (needs the ESP8266 core and the sketch libraries)
+FIRMWARE_BUILD_FQBN = 'esp8266:esp8266:nodemcuv2:eesz=4M2M'  # Board and Flash Size (with OTA space) of the fleet
+
 
 # REST Framework Configuration
 REST_FRAMEWORK = {